@@ -1,9 +1,8 @@
 #include "../d3dapp/D3DApp.h"
 
 class TerrainRender : public d3dapp::Render {
-  virtual void OnCreate(ID3D12Device* device, void* data) override {}
-  virtual void OnRender(int frame_index,
-                        ID3D12GraphicsCommandList* command_list) override {}
+  virtual void OnCreate(const d3dapp::CreateContext& context) override {}
+  virtual void OnRender(const d3dapp::FrameContext& frame) override {}
 };
 
 int WINAPI _tWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE,
@@ -17,6 +16,7 @@ int WINAPI _tWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE,
   desc.window_style = WS_OVERLAPPEDWINDOW & ~(WS_MAXIMIZEBOX | WS_THICKFRAME);
   desc.window_style_ex = 0;
   desc.frame_count = 3;
+  desc.back_buffer_count = 2;
   desc.clear_color = DirectX::Colors::Black;
   desc.render = &render;
   desc.data = nullptr;
@@ -0,0 +1,199 @@
+// Bakes loose files into an asset package.
+//
+//   asset_baker [--compress] <manifest> <package>
+//
+// --compress stores payloads with chunked LZ compression where it helps.
+//
+// Each manifest line adds one entry; blank lines and lines starting with #
+// are skipped:
+//
+//   buffer <name> <file>
+//   texture <name> <file> <format> <width> <height> [mips [array_size]]
+//
+// Texture files hold the texels of every subresource tightly packed, in
+// subresource order. Block compressed formats take RGBA8 texels.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../d3dapp/asset_package_writer.h"
+#include "../d3dapp/job_system.h"
+
+namespace {
+struct TextureFormat {
+  const char* name;
+  DXGI_FORMAT format;
+  // Of the source texels.
+  UINT texel_size;
+  bool compressed;
+  d3dapp::BlockCompression::Format block_format;
+};
+
+const TextureFormat kTextureFormats[] = {
+    {"r8", DXGI_FORMAT_R8_UNORM, 1, false},
+    {"rg8", DXGI_FORMAT_R8G8_UNORM, 2, false},
+    {"rgba8", DXGI_FORMAT_R8G8B8A8_UNORM, 4, false},
+    {"rgba8_srgb", DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4, false},
+    {"bgra8", DXGI_FORMAT_B8G8R8A8_UNORM, 4, false},
+    {"r16f", DXGI_FORMAT_R16_FLOAT, 2, false},
+    {"rgba16f", DXGI_FORMAT_R16G16B16A16_FLOAT, 8, false},
+    {"r32f", DXGI_FORMAT_R32_FLOAT, 4, false},
+    {"rgba32f", DXGI_FORMAT_R32G32B32A32_FLOAT, 16, false},
+    {"bc1", DXGI_FORMAT_BC1_UNORM, 4, true, d3dapp::BlockCompression::kBc1},
+    {"bc1_srgb", DXGI_FORMAT_BC1_UNORM_SRGB, 4, true,
+     d3dapp::BlockCompression::kBc1},
+    {"bc3", DXGI_FORMAT_BC3_UNORM, 4, true, d3dapp::BlockCompression::kBc3},
+    {"bc3_srgb", DXGI_FORMAT_BC3_UNORM_SRGB, 4, true,
+     d3dapp::BlockCompression::kBc3},
+    {"bc4", DXGI_FORMAT_BC4_UNORM, 4, true, d3dapp::BlockCompression::kBc4},
+    {"bc5", DXGI_FORMAT_BC5_UNORM, 4, true, d3dapp::BlockCompression::kBc5},
+    {"bc7", DXGI_FORMAT_BC7_UNORM, 4, true, d3dapp::BlockCompression::kBc7},
+    {"bc7_srgb", DXGI_FORMAT_BC7_UNORM_SRGB, 4, true,
+     d3dapp::BlockCompression::kBc7},
+};
+
+const TextureFormat* FindTextureFormat(const std::string& name) {
+  for (const TextureFormat& format : kTextureFormats) {
+    if (name == format.name) {
+      return &format;
+    }
+  }
+  return nullptr;
+}
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>* data) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file) {
+    return false;
+  }
+  data->assign(std::istreambuf_iterator<char>{file},
+               std::istreambuf_iterator<char>{});
+  return true;
+}
+
+bool AddTexture(d3dapp::AssetPackageWriter* writer, const std::string& name,
+                const std::vector<uint8_t>& texels,
+                const TextureFormat& format, UINT width, UINT height,
+                UINT16 mip_levels, UINT16 array_size) {
+  D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(
+      format.format, width, height, array_size, mip_levels);
+  std::vector<D3D12_SUBRESOURCE_DATA> data;
+  size_t offset = 0;
+  for (UINT16 slice = 0; slice < array_size; ++slice) {
+    for (UINT16 mip = 0; mip < mip_levels; ++mip) {
+      size_t row_pitch = static_cast<size_t>(std::max(width >> mip, 1u)) *
+                         format.texel_size;
+      size_t slice_pitch = row_pitch * std::max(height >> mip, 1u);
+      data.push_back(D3D12_SUBRESOURCE_DATA{
+          texels.data() + offset, static_cast<LONG_PTR>(row_pitch),
+          static_cast<LONG_PTR>(slice_pitch)});
+      offset += slice_pitch;
+    }
+  }
+  if (offset != texels.size()) {
+    std::fprintf(stderr, "%s: expected %zu bytes of texels, got %zu\n",
+                 name.c_str(), offset, texels.size());
+    return false;
+  }
+
+  d3dapp::BlockCompression compression{format.block_format,
+                                       d3dapp::BlockCompression::kHigh};
+  if (!writer->AddTexture(name.c_str(), desc, data.data(),
+                          format.compressed ? &compression : nullptr)) {
+    std::fprintf(stderr, "%s: duplicate name or unsupported format\n",
+                 name.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool AddEntry(d3dapp::AssetPackageWriter* writer, const std::string& line) {
+  std::istringstream fields{line};
+  std::string type, name, path;
+  fields >> type >> name >> path;
+  std::vector<uint8_t> contents;
+  if (name.empty() || path.empty()) {
+    std::fprintf(stderr, "bad line: %s\n", line.c_str());
+    return false;
+  }
+  if (!ReadFile(path, &contents)) {
+    std::fprintf(stderr, "%s: cannot read %s\n", name.c_str(), path.c_str());
+    return false;
+  }
+
+  if ("buffer" == type) {
+    if (!writer->AddBuffer(name.c_str(), contents.data(), contents.size())) {
+      std::fprintf(stderr, "%s: duplicate name\n", name.c_str());
+      return false;
+    }
+    return true;
+  }
+  if ("texture" == type) {
+    std::string format_name;
+    UINT width = 0, height = 0, mip_levels = 1, array_size = 1;
+    fields >> format_name >> width >> height >> std::ws;
+    if (!fields.eof()) {
+      fields >> mip_levels >> std::ws;
+    }
+    if (!fields.eof()) {
+      fields >> array_size;
+    }
+    const TextureFormat* format = FindTextureFormat(format_name);
+    if (!format || fields.fail() || 0 == width || 0 == height ||
+        0 == mip_levels || mip_levels > 16 || 0 == array_size ||
+        array_size > 2048) {
+      std::fprintf(stderr, "bad texture: %s\n", line.c_str());
+      return false;
+    }
+    return AddTexture(writer, name, contents, *format, width, height,
+                      static_cast<UINT16>(mip_levels),
+                      static_cast<UINT16>(array_size));
+  }
+  std::fprintf(stderr, "unknown entry type: %s\n", line.c_str());
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool compress = argc > 1 && 0 == std::strcmp(argv[1], "--compress");
+  if (compress) {
+    --argc;
+    ++argv;
+  }
+  if (argc != 3) {
+    std::fprintf(stderr,
+                 "usage: asset_baker [--compress] <manifest> <package>\n");
+    return 1;
+  }
+  std::ifstream manifest{argv[1]};
+  if (!manifest) {
+    std::fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  d3dapp::JobSystem job_system;
+  d3dapp::AssetPackageWriter writer{&job_system, compress};
+  std::string line;
+  while (std::getline(manifest, line)) {
+    size_t start = line.find_first_not_of(" \t\r");
+    if (std::string::npos == start || '#' == line[start]) {
+      continue;
+    }
+    if (!AddEntry(&writer, line)) {
+      return 1;
+    }
+  }
+  if (!writer.Write(argv[2])) {
+    std::fprintf(stderr, "cannot write %s\n", argv[2]);
+    return 1;
+  }
+  std::printf("%zu entries written to %s\n", writer.entry_count(), argv[2]);
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include "asset_package.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "asset_package_writer.h"
+#include "footprint_cache.h"
+#include "subresource_copy.h"
+
+namespace {
+constexpr int kTextureCount = 96;
+constexpr char kPackagePath[] = "asset_package_benchmark.pkg";
+
+std::string LoosePath(int index) {
+  return "asset_package_benchmark_" + std::to_string(index) + ".bin";
+}
+
+std::string Name(int index) { return "textures/" + std::to_string(index); }
+
+// RGBA8 textures of odd sizes with full mip chains, so that rows need
+// relayout to reach their footprints' pitch.
+D3D12_RESOURCE_DESC TextureDesc(int index) {
+  D3D12_RESOURCE_DESC desc{};
+  desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+  desc.Width = 100 + (index * 37) % 400;
+  desc.Height = 60 + (index * 53) % 300;
+  desc.DepthOrArraySize = 1;
+  desc.MipLevels = 1;
+  for (UINT64 size = std::max<UINT64>(desc.Width, desc.Height); size > 1;
+       size >>= 1) {
+    ++desc.MipLevels;
+  }
+  desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  return desc;
+}
+
+// The same textures as one package and as loose files of tightly packed
+// subresources, written once and removed at exit.
+class Assets {
+ public:
+  static const Assets& Get() {
+    static Assets assets;
+    return assets;
+  }
+
+  Assets() {
+    d3dapp::AssetPackageWriter writer;
+    for (int i = 0; i < kTextureCount; ++i) {
+      const D3D12_RESOURCE_DESC desc = TextureDesc(i);
+      std::vector<uint8_t> texels;
+      std::vector<D3D12_SUBRESOURCE_DATA> data;
+      for (UINT mip = 0; mip < desc.MipLevels; ++mip) {
+        size_t width = std::max<size_t>(desc.Width >> mip, 1);
+        size_t height = std::max<size_t>(desc.Height >> mip, 1);
+        data.push_back(D3D12_SUBRESOURCE_DATA{
+            reinterpret_cast<void*>(texels.size()),
+            static_cast<LONG_PTR>(width * 4),
+            static_cast<LONG_PTR>(width * height * 4)});
+        texels.resize(texels.size() + width * height * 4,
+                      static_cast<uint8_t>(i + mip));
+      }
+      for (D3D12_SUBRESOURCE_DATA& subresource : data) {
+        subresource.pData = texels.data() +
+                            reinterpret_cast<size_t>(subresource.pData);
+      }
+      writer.AddTexture(Name(i).c_str(), desc, data.data());
+      FILE* file = std::fopen(LoosePath(i).c_str(), "wb");
+      std::fwrite(texels.data(), 1, texels.size(), file);
+      std::fclose(file);
+      payload_size += texels.size();
+    }
+    writer.Write(kPackagePath);
+  }
+
+  ~Assets() {
+    std::remove(kPackagePath);
+    for (int i = 0; i < kTextureCount; ++i) {
+      std::remove(LoosePath(i).c_str());
+    }
+  }
+
+  size_t payload_size{0};
+};
+
+// Reads each file and lays its rows out at the footprints, as loading
+// loose files into upload memory has to.
+void BM_LoadLooseFiles(benchmark::State& state) {
+  const Assets& assets = Assets::Get();
+  std::vector<uint8_t> texels;
+  std::vector<uint8_t> upload;
+  std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(16);
+  std::vector<UINT> row_counts(16);
+  std::vector<UINT64> row_sizes(16);
+  for (auto _ : state) {
+    for (int i = 0; i < kTextureCount; ++i) {
+      FILE* file = std::fopen(LoosePath(i).c_str(), "rb");
+      std::fseek(file, 0, SEEK_END);
+      texels.resize(static_cast<size_t>(std::ftell(file)));
+      std::fseek(file, 0, SEEK_SET);
+      std::fread(texels.data(), 1, texels.size(), file);
+      std::fclose(file);
+
+      const D3D12_RESOURCE_DESC desc = TextureDesc(i);
+      UINT64 total_size = 0;
+      d3dapp::CalculateFootprints(desc, 0, desc.MipLevels, 0, layouts.data(),
+                                  row_counts.data(), row_sizes.data(),
+                                  &total_size);
+      upload.resize(static_cast<size_t>(total_size));
+      size_t offset = 0;
+      for (UINT mip = 0; mip < desc.MipLevels; ++mip) {
+        const size_t row_pitch = static_cast<size_t>(row_sizes[mip]);
+        const size_t slice_pitch = row_pitch * row_counts[mip];
+        d3dapp::CopySubresource(d3dapp::SubresourceCopy{
+            upload.data() + layouts[mip].Offset,
+            layouts[mip].Footprint.RowPitch,
+            layouts[mip].Footprint.RowPitch * row_counts[mip],
+            texels.data() + offset, row_pitch, slice_pitch, row_pitch,
+            row_counts[mip], 1});
+        offset += slice_pitch;
+      }
+      benchmark::DoNotOptimize(upload.data());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * assets.payload_size);
+}
+BENCHMARK(BM_LoadLooseFiles)->Unit(benchmark::kMillisecond);
+
+// Maps the package and copies each payload out as it is stored.
+void BM_LoadPackage(benchmark::State& state) {
+  const Assets& assets = Assets::Get();
+  std::vector<uint8_t> upload;
+  for (auto _ : state) {
+    d3dapp::AssetPackage package;
+    package.Open(kPackagePath);
+    for (int i = 0; i < kTextureCount; ++i) {
+      const d3dapp::AssetEntry* entry = package.Find(Name(i).c_str());
+      upload.resize(static_cast<size_t>(entry->data_size));
+      d3dapp::StreamRequest request =
+          d3dapp::MakeAssetRequest(package, *entry);
+      request.decode(package.data(*entry), upload.data());
+      benchmark::DoNotOptimize(upload.data());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * assets.payload_size);
+}
+BENCHMARK(BM_LoadPackage)->Unit(benchmark::kMillisecond);
+
+void BM_Find(benchmark::State& state) {
+  Assets::Get();
+  d3dapp::AssetPackage package;
+  package.Open(kPackagePath);
+  std::vector<std::string> names;
+  for (int i = 0; i < kTextureCount; ++i) {
+    names.push_back(Name(i));
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(package.Find(names[i].data(), names[i].size()));
+    i = (i + 1) % names.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Find);
+
+}  // namespace
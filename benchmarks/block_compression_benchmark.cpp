@@ -0,0 +1,68 @@
+#include "block_compression.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "block_decoder.h"
+
+namespace {
+// A 512x512 RGBA8 image of gradients and texture-like detail.
+constexpr uint32_t kWidth = 512;
+constexpr uint32_t kHeight = 512;
+
+std::vector<uint8_t> MakeImage() {
+  std::vector<uint8_t> image(kWidth * kHeight * 4);
+  for (uint32_t y = 0; y < kHeight; ++y) {
+    for (uint32_t x = 0; x < kWidth; ++x) {
+      uint8_t* texel = &image[(y * kWidth + x) * 4];
+      const uint32_t detail = (x * 13 + y * 7) % 17;
+      texel[0] = static_cast<uint8_t>(x / 2 + detail);
+      texel[1] = static_cast<uint8_t>(y / 2 + detail);
+      texel[2] = static_cast<uint8_t>(128 + 100 * std::sin(0.05 * (x + y)));
+      texel[3] = static_cast<uint8_t>(255 - (x ^ y) % 64);
+    }
+  }
+  return image;
+}
+
+// range(0) is the format and range(1) the quality. Reports the PSNR of the
+// round trip alongside the speed.
+void BM_CompressImage(benchmark::State& state) {
+  const d3dapp::BlockCompression compression{
+      static_cast<d3dapp::BlockCompression::Format>(state.range(0)),
+      static_cast<d3dapp::BlockCompression::Quality>(state.range(1))};
+  const std::vector<uint8_t> image = MakeImage();
+  const size_t row_pitch = kWidth / 4 * d3dapp::BlockSize(compression.format);
+  std::vector<uint8_t> blocks(row_pitch * (kHeight / 4));
+
+  for (auto _ : state) {
+    d3dapp::CompressImage(compression, image.data(), kWidth * 4, kWidth,
+                          kHeight, blocks.data(), row_pitch);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+  state.SetBytesProcessed(state.iterations() * image.size());
+
+  std::vector<uint8_t> decoded;
+  if (d3dapp::testing::BlockDecoder::DecodeImage(
+          compression.format, blocks.data(), row_pitch, kWidth, kHeight,
+          &decoded)) {
+    state.counters["psnr"] = d3dapp::testing::BlockDecoder::Psnr(
+        compression.format, image, decoded);
+  }
+}
+BENCHMARK(BM_CompressImage)
+    ->ArgNames({"format", "quality"})
+    ->ArgsProduct({{d3dapp::BlockCompression::kBc1,
+                    d3dapp::BlockCompression::kBc3,
+                    d3dapp::BlockCompression::kBc4,
+                    d3dapp::BlockCompression::kBc5,
+                    d3dapp::BlockCompression::kBc7},
+                   {d3dapp::BlockCompression::kFast,
+                    d3dapp::BlockCompression::kHigh}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,100 @@
+#include "buddy_allocator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr uint64_t kBlockSize = 64ull * 1024 * 1024;
+constexpr uint64_t kMinBlockSize = 64 * 1024;
+
+struct Live {
+  uint64_t offset;
+  uint32_t order;
+  uint64_t size;
+};
+
+// Resource sizes roughly as a scene streams them: mostly small buffers and
+// textures, some large ones, none a power of two.
+uint64_t RandomSize(std::mt19937& random) {
+  const uint64_t kilobytes[] = {40, 100, 180, 700, 1400, 2800, 5600, 11000};
+  const uint64_t kilobyte = kilobytes[random() % 8];
+  return kilobyte * 1024 + random() % 4096;
+}
+
+// Allocates until the block holds range(0) percent, then frees and
+// allocates at random around that fill level, reporting how scattered the
+// free space ends up and how much the power-of-two rounding wastes.
+void BM_RandomChurn(benchmark::State& state) {
+  const uint64_t target = kBlockSize * state.range(0) / 100;
+  d3dapp::BuddyAllocator buddy{kBlockSize, kMinBlockSize};
+  std::mt19937 random{42};
+  std::vector<Live> live;
+  uint64_t requested = 0;
+  int64_t failures = 0;
+
+  for (auto _ : state) {
+    if (buddy.size() - buddy.free_size() < target || live.empty()) {
+      Live allocation{0, 0, RandomSize(random)};
+      if (buddy.Allocate(allocation.size, kMinBlockSize, &allocation.offset,
+                         &allocation.order)) {
+        live.push_back(allocation);
+        requested += allocation.size;
+      } else {
+        ++failures;
+      }
+    } else {
+      const size_t index = random() % live.size();
+      buddy.Free(live[index].offset, live[index].order);
+      requested -= live[index].size;
+      live[index] = live.back();
+      live.pop_back();
+    }
+  }
+
+  const uint64_t used = buddy.size() - buddy.free_size();
+  state.SetItemsProcessed(state.iterations());
+  state.counters["fragmentation"] =
+      buddy.free_size() > 0
+          ? 1.0 - static_cast<double>(buddy.LargestFreeBlock()) /
+                      buddy.free_size()
+          : 0.0;
+  state.counters["rounding_waste"] =
+      used > 0 ? 1.0 - static_cast<double>(requested) / used : 0.0;
+  state.counters["failures"] = static_cast<double>(failures);
+}
+BENCHMARK(BM_RandomChurn)->Arg(50)->Arg(75)->Arg(90);
+
+// Fills the block with small allocations and frees every other one: the
+// worst case for the largest free block.
+void BM_Checkerboard(benchmark::State& state) {
+  const uint64_t size = static_cast<uint64_t>(state.range(0));
+  std::vector<Live> live;
+  double fragmentation = 0.0;
+  for (auto _ : state) {
+    d3dapp::BuddyAllocator buddy{kBlockSize, kMinBlockSize};
+    live.clear();
+    Live allocation{0, 0, size};
+    while (buddy.Allocate(size, kMinBlockSize, &allocation.offset,
+                          &allocation.order)) {
+      live.push_back(allocation);
+    }
+    for (size_t i = 0; i < live.size(); i += 2) {
+      buddy.Free(live[i].offset, live[i].order);
+    }
+    fragmentation =
+        1.0 - static_cast<double>(buddy.LargestFreeBlock()) /
+                  buddy.free_size();
+    for (size_t i = 1; i < live.size(); i += 2) {
+      buddy.Free(live[i].offset, live[i].order);
+    }
+    benchmark::DoNotOptimize(buddy.empty());
+  }
+  state.SetItemsProcessed(state.iterations() * live.size() * 2);
+  state.counters["fragmentation"] = fragmentation;
+}
+BENCHMARK(BM_Checkerboard)->Arg(64 * 1024)->Arg(1024 * 1024);
+
+}  // namespace
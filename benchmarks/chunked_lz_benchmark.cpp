@@ -0,0 +1,102 @@
+#include "chunked_lz.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "job_system.h"
+
+namespace {
+// 16MB of each kind of payload.
+constexpr size_t kSize = 16 * 1024 * 1024;
+
+enum Corpus { kSplatMap, kVertices, kHeightmap, kRandom };
+
+// Returns the delta stride that suits the corpus.
+uint32_t MakeCorpus(Corpus corpus, std::vector<uint8_t>* data) {
+  data->resize(kSize);
+  std::mt19937 random{1};
+  uint8_t* bytes = data->data();
+  switch (corpus) {
+    case kSplatMap:
+      // RGBA8 weights in large flat regions.
+      for (size_t i = 0; i < kSize; ++i) {
+        bytes[i] = static_cast<uint8_t>((i / 4 / 4096) % 3 == i % 4 ? 255 : 0);
+      }
+      return 0;
+    case kVertices:
+      // 32 byte vertices: noisy positions, repeated normals and uvs.
+      for (size_t i = 0; i < kSize; ++i) {
+        bytes[i] = i % 32 < 12 ? static_cast<uint8_t>(random() % 16 + i / 4099)
+                               : static_cast<uint8_t>(i % 32 * 7);
+      }
+      return 0;
+    case kHeightmap:
+      // Smooth R16 texels.
+      for (size_t i = 0; i < kSize; i += 2) {
+        const uint16_t height = static_cast<uint16_t>(
+            32768 + 20000 * std::sin(static_cast<double>(i / 2) / 900.0) +
+            random() % 8);
+        bytes[i] = static_cast<uint8_t>(height);
+        bytes[i + 1] = static_cast<uint8_t>(height >> 8);
+      }
+      return 2;
+    case kRandom:
+      for (size_t i = 0; i < kSize; ++i) {
+        bytes[i] = static_cast<uint8_t>(random());
+      }
+      return 0;
+  }
+  return 0;
+}
+
+// range(0) is the corpus and range(1) the workers. Throughput is of the
+// decompressed data; ratio is decompressed to compressed.
+void BM_CompressChunked(benchmark::State& state) {
+  std::vector<uint8_t> data;
+  const uint32_t delta_stride =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), &data);
+  d3dapp::JobSystem job_system{static_cast<int>(state.range(1))};
+  std::vector<uint8_t> compressed;
+  for (auto _ : state) {
+    d3dapp::CompressChunked(data.data(), data.size(), delta_stride,
+                            &compressed, &job_system);
+    benchmark::DoNotOptimize(compressed.data());
+  }
+  state.SetBytesProcessed(state.iterations() * kSize);
+  state.counters["ratio"] = static_cast<double>(kSize) / compressed.size();
+}
+
+void BM_DecompressChunked(benchmark::State& state) {
+  std::vector<uint8_t> data;
+  const uint32_t delta_stride =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), &data);
+  d3dapp::JobSystem job_system{static_cast<int>(state.range(1))};
+  std::vector<uint8_t> compressed;
+  d3dapp::CompressChunked(data.data(), data.size(), delta_stride,
+                          &compressed);
+  for (auto _ : state) {
+    if (!d3dapp::DecompressChunked(compressed.data(), compressed.size(),
+                                   data.data(), data.size(), &job_system)) {
+      state.SkipWithError("corrupt container");
+      break;
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * kSize);
+  state.counters["ratio"] = static_cast<double>(kSize) / compressed.size();
+}
+
+void CorpusArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"corpus", "workers"})
+      ->ArgsProduct({{kSplatMap, kVertices, kHeightmap, kRandom}, {0, 3}})
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+}
+BENCHMARK(BM_CompressChunked)->Apply(CorpusArgs);
+BENCHMARK(BM_DecompressChunked)->Apply(CorpusArgs);
+
+}  // namespace
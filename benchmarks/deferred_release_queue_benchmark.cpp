@@ -0,0 +1,66 @@
+#include "deferred_release_queue.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+
+namespace {
+// Frees nothing, so that the queue's own cost is what is measured.
+class NullObject : public IUnknown {
+ public:
+  ULONG AddRef() override { return 1; }
+  ULONG Release() override { return 1; }
+};
+
+// One frame: range(0) objects and as many deleters dropped, then the frame
+// kFramesInFlight back collected, as the render thread does.
+void BM_ReleaseCollect(benchmark::State& state) {
+  constexpr uint64_t kFramesInFlight = 3;
+  const int count = static_cast<int>(state.range(0));
+  NullObject object;
+  d3dapp::DeferredReleaseQueue queue;
+  uint64_t frame = 1;
+  int deleted = 0;
+  for (auto _ : state) {
+    queue.SetFenceValue(frame);
+    for (int i = 0; i < count; ++i) {
+      queue.Release(&object);
+      queue.Release([&deleted]() { ++deleted; });
+    }
+    if (frame > kFramesInFlight) {
+      benchmark::DoNotOptimize(queue.Collect(frame - kFramesInFlight));
+    }
+    ++frame;
+  }
+  benchmark::DoNotOptimize(deleted);
+  state.SetItemsProcessed(state.iterations() * count * 2);
+}
+BENCHMARK(BM_ReleaseCollect)->Arg(16)->Arg(256)->Arg(4096);
+
+// Releases from several threads at once while thread 0 also collects.
+void BM_ContendedRelease(benchmark::State& state) {
+  static d3dapp::DeferredReleaseQueue* queue = nullptr;
+  static std::atomic<uint64_t> frame{1};
+  static NullObject object;
+  if (0 == state.thread_index()) {
+    queue = new d3dapp::DeferredReleaseQueue;
+  }
+  for (auto _ : state) {
+    for (int i = 0; i < 64; ++i) {
+      queue->Release(&object);
+    }
+    if (0 == state.thread_index()) {
+      uint64_t next = frame.fetch_add(1) + 1;
+      queue->SetFenceValue(next);
+      benchmark::DoNotOptimize(queue->Collect(next - 1));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 64);
+  if (0 == state.thread_index()) {
+    delete queue;
+    queue = nullptr;
+  }
+}
+BENCHMARK(BM_ContendedRelease)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
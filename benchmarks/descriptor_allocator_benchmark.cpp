@@ -0,0 +1,100 @@
+#include "descriptor_allocator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr uint64_t kFramesInFlight = 3;
+
+// Each frame allocates range(0) descriptors and frees those of the frame
+// kFramesInFlight back, the way per-frame views would churn through the
+// persistent region if they did not use the ring. Capacity is range(1), to
+// show the cost does not depend on it.
+void BM_FreeListChurn(benchmark::State& state) {
+  const uint32_t per_frame = static_cast<uint32_t>(state.range(0));
+  d3dapp::DescriptorFreeList list{static_cast<uint32_t>(state.range(1))};
+  std::deque<std::vector<uint32_t>> in_flight;
+  for (auto _ : state) {
+    std::vector<uint32_t> frame;
+    frame.reserve(per_frame);
+    for (uint32_t i = 0; i < per_frame; ++i) {
+      uint32_t index = 0;
+      if (!list.Allocate(&index)) {
+        state.SkipWithError("free list exhausted");
+        return;
+      }
+      frame.push_back(index);
+    }
+    in_flight.push_back(std::move(frame));
+    if (in_flight.size() > kFramesInFlight) {
+      for (uint32_t index : in_flight.front()) {
+        list.Free(index);
+      }
+      in_flight.pop_front();
+    }
+    benchmark::DoNotOptimize(in_flight.back().data());
+  }
+  state.SetItemsProcessed(state.iterations() * per_frame);
+}
+BENCHMARK(BM_FreeListChurn)
+    ->ArgNames({"per_frame", "capacity"})
+    ->ArgsProduct({{64, 1024}, {1 << 12, 1 << 18}});
+
+// The staging heap's side of the same churn.
+void BM_BlockListChurn(benchmark::State& state) {
+  const uint32_t per_frame = static_cast<uint32_t>(state.range(0));
+  d3dapp::DescriptorBlockList list{static_cast<uint32_t>(state.range(1))};
+  std::deque<std::vector<uint32_t>> in_flight;
+  for (auto _ : state) {
+    std::vector<uint32_t> frame;
+    frame.reserve(per_frame);
+    for (uint32_t i = 0; i < per_frame; ++i) {
+      frame.push_back(list.Allocate());
+    }
+    in_flight.push_back(std::move(frame));
+    if (in_flight.size() > kFramesInFlight) {
+      for (uint32_t index : in_flight.front()) {
+        list.Free(index);
+      }
+      in_flight.pop_front();
+    }
+    benchmark::DoNotOptimize(in_flight.back().data());
+  }
+  state.SetItemsProcessed(state.iterations() * per_frame);
+  state.counters["blocks"] = list.block_count();
+}
+BENCHMARK(BM_BlockListChurn)
+    ->ArgNames({"per_frame", "block_size"})
+    ->ArgsProduct({{64, 1024}, {256, 1024}});
+
+// The same descriptors out of the ring, one range each and released a frame
+// at a time, which is what the transient region does instead.
+void BM_RingFrames(benchmark::State& state) {
+  const uint32_t per_frame = static_cast<uint32_t>(state.range(0));
+  d3dapp::DescriptorRing ring{static_cast<uint32_t>(state.range(1))};
+  uint64_t fence_value = 0;
+  for (auto _ : state) {
+    for (uint32_t i = 0; i < per_frame; ++i) {
+      uint32_t offset = 0;
+      if (!ring.Allocate(1, &offset)) {
+        state.SkipWithError("ring exhausted");
+        return;
+      }
+      benchmark::DoNotOptimize(offset);
+    }
+    ring.EndFrame(++fence_value);
+    if (fence_value > kFramesInFlight) {
+      ring.Reclaim(fence_value - kFramesInFlight);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * per_frame);
+}
+BENCHMARK(BM_RingFrames)
+    ->ArgNames({"per_frame", "capacity"})
+    ->ArgsProduct({{64, 1024}, {1 << 12, 1 << 18}});
+
+}  // namespace
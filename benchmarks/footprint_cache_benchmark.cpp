@@ -0,0 +1,77 @@
+#include "footprint_cache.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+D3D12_RESOURCE_DESC Texture2D(UINT size, UINT16 mip_levels) {
+  D3D12_RESOURCE_DESC desc{};
+  desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+  desc.Width = size;
+  desc.Height = size;
+  desc.DepthOrArraySize = 1;
+  desc.MipLevels = mip_levels;
+  desc.Format = DXGI_FORMAT_BC7_UNORM;
+  desc.SampleDesc.Count = 1;
+  return desc;
+}
+
+// What every upload pays without the cache. GetCopyableFootprints on a
+// device does the same work behind a call into the runtime.
+void BM_CalculateFootprints(benchmark::State& state) {
+  const UINT16 mip_levels = static_cast<UINT16>(state.range(0));
+  const D3D12_RESOURCE_DESC desc = Texture2D(1u << (mip_levels - 1),
+                                             mip_levels);
+  std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(mip_levels);
+  std::vector<UINT> row_counts(mip_levels);
+  std::vector<UINT64> row_sizes(mip_levels);
+  UINT64 total_size = 0;
+  for (auto _ : state) {
+    d3dapp::CalculateFootprints(desc, 0, mip_levels, 0, layouts.data(),
+                                row_counts.data(), row_sizes.data(),
+                                &total_size);
+    benchmark::DoNotOptimize(total_size);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CalculateFootprints)->Arg(1)->Arg(9)->Arg(13);
+
+void BM_GetCached(benchmark::State& state) {
+  const UINT16 mip_levels = static_cast<UINT16>(state.range(0));
+  const D3D12_RESOURCE_DESC desc = Texture2D(1u << (mip_levels - 1),
+                                             mip_levels);
+  d3dapp::FootprintCache cache{nullptr};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.Get(desc, 0, mip_levels).total_size);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["hit_rate"] = cache.stats().hit_rate();
+}
+BENCHMARK(BM_GetCached)->Arg(1)->Arg(9)->Arg(13);
+
+// Streamed terrain: range(0) tile shapes, each uploaded mip by mip, the way
+// tiles are refined as the camera moves.
+void BM_TerrainTiles(benchmark::State& state) {
+  const int shape_count = static_cast<int>(state.range(0));
+  std::vector<D3D12_RESOURCE_DESC> descs;
+  for (int i = 0; i < shape_count; ++i) {
+    descs.push_back(Texture2D(256u << (i % 4), static_cast<UINT16>(9 + i % 4)));
+    descs.back().Format =
+        i / 4 % 2 ? DXGI_FORMAT_BC7_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+  }
+  d3dapp::FootprintCache cache{nullptr};
+  size_t lookup = 0;
+  for (auto _ : state) {
+    const D3D12_RESOURCE_DESC& desc = descs[lookup % descs.size()];
+    const UINT mip = static_cast<UINT>(lookup / descs.size() % desc.MipLevels);
+    benchmark::DoNotOptimize(cache.Get(desc, mip, 1).total_size);
+    ++lookup;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["hit_rate"] = cache.stats().hit_rate();
+  state.counters["entries"] = static_cast<double>(cache.stats().entry_count);
+}
+BENCHMARK(BM_TerrainTiles)->Arg(4)->Arg(16);
+
+}  // namespace
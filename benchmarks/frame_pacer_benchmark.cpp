@@ -0,0 +1,90 @@
+#include "frame_pacer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "fake_clock.h"
+
+namespace {
+using d3dapp::testing::FakeClock;
+
+constexpr int64_t kMicrosecond = 1000;
+
+// 200 frames of simulated time at 60 fps with 5ms of work each, against
+// sleeps of range(1) us granularity and half that jitter. Reports how late
+// frames start and how many clock reads (spins) each frame costs, per spin
+// threshold range(0) in us.
+void BM_SimulatedPacing(benchmark::State& state) {
+  const int64_t spin_threshold = state.range(0) * kMicrosecond;
+  const int64_t granularity = state.range(1) * kMicrosecond;
+  int64_t total_overshoot = 0;
+  int64_t max_overshoot = 0;
+  int64_t clock_reads = 0;
+  int64_t frames = 0;
+  for (auto _ : state) {
+    FakeClock::State clock;
+    clock.now_cost = kMicrosecond;
+    clock.granularity = granularity;
+    clock.jitter = granularity / 2;
+    d3dapp::FramePacer::Desc desc{};
+    desc.target_fps = 60.0;
+    desc.spin_threshold = spin_threshold;
+    d3dapp::FramePacer pacer{desc, std::unique_ptr<d3dapp::FramePacer::Clock>{
+                                       new FakeClock{&clock}}};
+    pacer.WaitForNextFrame();
+    clock.now_count = 0;
+    for (int i = 0; i < 200; ++i) {
+      clock.now += 5000 * kMicrosecond;
+      pacer.WaitForNextFrame();
+      total_overshoot += pacer.last_overshoot();
+      max_overshoot = std::max(max_overshoot, pacer.last_overshoot());
+    }
+    clock_reads += clock.now_count;
+    frames += 200;
+  }
+  state.counters["mean_late_us"] =
+      static_cast<double>(total_overshoot) / frames / kMicrosecond;
+  state.counters["max_late_us"] =
+      static_cast<double>(max_overshoot) / kMicrosecond;
+  state.counters["reads_per_frame"] =
+      static_cast<double>(clock_reads) / frames;
+}
+BENCHMARK(BM_SimulatedPacing)
+    ->ArgNames({"spin_us", "granularity_us"})
+    ->Args({0, 1000})
+    ->Args({500, 1000})
+    ->Args({2000, 1000})
+    ->Args({0, 15600})
+    ->Args({2000, 15600})
+    ->Args({8000, 15600});
+
+// The system clock at 500 fps; each iteration is one paced frame. Reports
+// how late frames really start on this machine per spin threshold in us.
+void BM_SystemClockPacing(benchmark::State& state) {
+  d3dapp::FramePacer::Desc desc{};
+  desc.target_fps = 500.0;
+  desc.spin_threshold = state.range(0) * kMicrosecond;
+  d3dapp::FramePacer pacer{desc};
+  pacer.WaitForNextFrame();
+  int64_t total_overshoot = 0;
+  int64_t max_overshoot = 0;
+  for (auto _ : state) {
+    pacer.WaitForNextFrame();
+    total_overshoot += pacer.last_overshoot();
+    max_overshoot = std::max(max_overshoot, pacer.last_overshoot());
+  }
+  state.counters["mean_late_us"] = static_cast<double>(total_overshoot) /
+                                   state.iterations() / kMicrosecond;
+  state.counters["max_late_us"] =
+      static_cast<double>(max_overshoot) / kMicrosecond;
+}
+BENCHMARK(BM_SystemClockPacing)
+    ->ArgName("spin_us")
+    ->Arg(0)
+    ->Arg(200)
+    ->Arg(1000)
+    ->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,69 @@
+#include "job_system.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+// About 1us of arithmetic per element, so scheduling overhead shows at small
+// grains and scaling at large ones.
+float Work(size_t i) {
+  float x = static_cast<float>(i);
+  for (int k = 0; k < 200; ++k) {
+    x = std::sqrt(x * x + 1.0f);
+  }
+  return x;
+}
+
+void BM_ParallelFor(benchmark::State& state) {
+  d3dapp::JobSystem job_system{static_cast<int>(state.range(0))};
+  const size_t grain = static_cast<size_t>(state.range(1));
+  std::vector<float> out(1 << 14);
+  for (auto _ : state) {
+    job_system.ParallelFor(0, out.size(), grain,
+                           [&out](size_t begin, size_t end) {
+                             for (size_t i = begin; i < end; ++i) {
+                               out[i] = Work(i);
+                             }
+                           });
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * out.size());
+  state.counters["threads"] = job_system.thread_count();
+}
+
+// Worker counts 0 (caller only) to one per hardware thread, at the default
+// grain and at fine grains where stealing dominates.
+void WorkerCounts(benchmark::internal::Benchmark* benchmark) {
+  const int max_workers =
+      std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+  for (int grain : {0, 16, 256}) {
+    for (int workers = 0; workers <= max_workers; ++workers) {
+      benchmark->Args({workers, grain});
+    }
+  }
+}
+
+BENCHMARK(BM_ParallelFor)
+    ->Apply(WorkerCounts)
+    ->ArgNames({"workers", "grain"})
+    ->UseRealTime();
+
+// Fork/join overhead of an empty job.
+void BM_GroupRunWait(benchmark::State& state) {
+  d3dapp::JobSystem job_system{static_cast<int>(state.range(0))};
+  for (auto _ : state) {
+    d3dapp::JobSystem::Group group{&job_system};
+    for (int i = 0; i < 64; ++i) {
+      group.Run([]() {});
+    }
+    group.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_GroupRunWait)->Arg(0)->Arg(1)->Arg(3)->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,90 @@
+#include "render_gate.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+// Stands in for recording and presenting a frame.
+void RenderFrame() {
+  auto end = std::chrono::steady_clock::now() + std::chrono::microseconds{200};
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+// The render loop of an idle window for 250ms per iteration: continuous
+// rendering (on_demand 0, the old behavior) against on-demand rendering
+// with range(1) invalidations a second, e.g. input or animation. Compare
+// the CPU column, the render thread's CPU time, with Time, the wall time.
+void BM_IdleRenderLoop(benchmark::State& state) {
+  const bool on_demand = state.range(0) != 0;
+  const int invalidations_per_second = static_cast<int>(state.range(1));
+  d3dapp::RenderGate gate{on_demand};
+  std::atomic<bool> running{true};
+  std::thread input{[&]() {
+    while (running.load()) {
+      if (invalidations_per_second > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds{
+            1000000 / invalidations_per_second});
+        gate.Invalidate();
+      } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      }
+    }
+  }};
+
+  int64_t frames = 0;
+  for (auto _ : state) {
+    auto end =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds{250};
+    while (std::chrono::steady_clock::now() < end) {
+      if (gate.ShouldRender([]() { return false; })) {
+        RenderFrame();
+        ++frames;
+      } else {
+        gate.WaitForWork(std::chrono::milliseconds{100});
+      }
+    }
+  }
+  running = false;
+  input.join();
+  state.counters["fps"] = benchmark::Counter(
+      static_cast<double>(frames), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_IdleRenderLoop)
+    ->ArgNames({"on_demand", "invalidations"})
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({1, 10})
+    ->Args({1, 60})
+    ->Iterations(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// A minimized window renders nothing in either mode.
+void BM_MinimizedRenderLoop(benchmark::State& state) {
+  d3dapp::RenderGate gate{state.range(0) != 0};
+  gate.SetMinimized(true);
+  for (auto _ : state) {
+    auto end =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds{250};
+    while (std::chrono::steady_clock::now() < end) {
+      if (gate.ShouldRender([]() { return false; })) {
+        RenderFrame();
+      } else {
+        gate.WaitForWork(std::chrono::milliseconds{100});
+      }
+    }
+  }
+}
+BENCHMARK(BM_MinimizedRenderLoop)
+    ->ArgName("on_demand")
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(2)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
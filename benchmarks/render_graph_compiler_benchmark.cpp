@@ -0,0 +1,112 @@
+#include "render_graph_compiler.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr uint32_t kCommon = 0;
+constexpr uint32_t kRenderTarget = 0x4;
+constexpr uint32_t kUnorderedAccess = 0x8;
+constexpr uint32_t kNonPixelShaderResource = 0x40;
+constexpr uint32_t kPixelShaderResource = 0x80;
+
+// A frame of pass_count passes: each writes one new transient and reads a
+// few of the recent ones, as post-processing and lighting chains do, with
+// a persistent UAV buffer touched now and then and one pass in ten feeding
+// nothing, so culling has work to do.
+void BuildGraph(d3dapp::RenderGraphCompiler& compiler, int pass_count) {
+  std::mt19937 random{1};
+  compiler.Reset();
+  uint32_t back_buffer = compiler.AddResource(kCommon);
+  uint32_t history = compiler.AddResource(kUnorderedAccess);
+  compiler.Export(back_buffer, kCommon);
+  compiler.Export(history, kUnorderedAccess);
+
+  std::vector<uint32_t> outputs;
+  for (int p = 0; p < pass_count; ++p) {
+    uint32_t output = compiler.AddResource(kCommon);
+    compiler.SetTransient(output, (1 + random() % 16) * 65536, 65536,
+                          random() % 2);
+    compiler.AddPass();
+    for (int r = 0; r < 3 && r < static_cast<int>(outputs.size()); ++r) {
+      const size_t recent = std::min<size_t>(8, outputs.size());
+      uint32_t input = outputs[outputs.size() - 1 - random() % recent];
+      compiler.Read(input, random() % 2 ? kPixelShaderResource
+                                        : kNonPixelShaderResource);
+    }
+    if (0 == p % 7) {
+      compiler.Write(history, kUnorderedAccess);
+    }
+    compiler.Write(output, 0 == p % 3 ? kUnorderedAccess : kRenderTarget);
+    if (0 != p % 10) {
+      outputs.push_back(output);
+    }
+  }
+  compiler.AddPass();
+  for (size_t r = outputs.size() > 4 ? outputs.size() - 4 : 0;
+       r < outputs.size(); ++r) {
+    compiler.Read(outputs[r], kPixelShaderResource);
+  }
+  compiler.Write(back_buffer, kRenderTarget);
+}
+
+void Report(benchmark::State& state,
+            const d3dapp::RenderGraphCompiler& compiler) {
+  state.SetItemsProcessed(state.iterations() * compiler.pass_count());
+  state.counters["alive"] = static_cast<double>(compiler.order().size());
+  state.counters["barriers"] =
+      static_cast<double>(compiler.total_barrier_count());
+  uint64_t aliased = 0;
+  for (size_t group = 0; group < compiler.group_count(); ++group) {
+    aliased += compiler.group_size(static_cast<uint32_t>(group));
+  }
+  state.counters["aliased_MiB"] = aliased / (1024.0 * 1024.0);
+  state.counters["unaliased_MiB"] =
+      compiler.unaliased_size() / (1024.0 * 1024.0);
+}
+
+// Rebuilding and compiling the graph, as every frame does.
+void BM_BuildAndCompile(benchmark::State& state) {
+  d3dapp::RenderGraphCompiler compiler;
+  compiler.SetSplitBarriers(state.range(1) != 0);
+  for (auto _ : state) {
+    BuildGraph(compiler, static_cast<int>(state.range(0)));
+    compiler.Compile();
+  }
+  Report(state, compiler);
+}
+BENCHMARK(BM_BuildAndCompile)
+    ->ArgNames({"passes", "split"})
+    ->Args({100, 0})
+    ->Args({1000, 0})
+    ->Args({1000, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+// Compile alone, split into its two halves.
+void BM_Schedule(benchmark::State& state) {
+  d3dapp::RenderGraphCompiler compiler;
+  BuildGraph(compiler, static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    compiler.Schedule();
+  }
+  compiler.EmitBarriers();
+  Report(state, compiler);
+}
+BENCHMARK(BM_Schedule)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+void BM_EmitBarriers(benchmark::State& state) {
+  d3dapp::RenderGraphCompiler compiler;
+  BuildGraph(compiler, static_cast<int>(state.range(0)));
+  compiler.Schedule();
+  for (auto _ : state) {
+    compiler.EmitBarriers();
+  }
+  Report(state, compiler);
+}
+BENCHMARK(BM_EmitBarriers)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,122 @@
+#include "spsc_queue.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Message {
+  int id;
+};
+
+constexpr auto kFrameTime = std::chrono::milliseconds{4};
+// A window drag or modal loop holding the window thread.
+constexpr auto kModalStall = std::chrono::milliseconds{60};
+
+void Busy(Clock::duration duration) {
+  auto end = Clock::now() + duration;
+  while (Clock::now() < end) {
+  }
+}
+
+void ReportIntervals(benchmark::State& state,
+                     std::vector<Clock::time_point>& frames) {
+  std::vector<double> intervals;
+  for (size_t i = 1; i < frames.size(); ++i) {
+    intervals.push_back(
+        std::chrono::duration<double, std::milli>(frames[i] - frames[i - 1])
+            .count());
+  }
+  std::sort(intervals.begin(), intervals.end());
+  if (intervals.empty()) {
+    return;
+  }
+  state.counters["p50_ms"] = intervals[intervals.size() / 2];
+  state.counters["p99_ms"] = intervals[intervals.size() * 99 / 100];
+  state.counters["max_ms"] = intervals.back();
+}
+
+// Frames rendered on the window thread, as without a render thread: every
+// modal stall is a frame-time spike.
+void BM_FramesOnWindowThread(benchmark::State& state) {
+  std::vector<Clock::time_point> frames;
+  for (auto _ : state) {
+    frames.clear();
+    for (int i = 0; i < 50; ++i) {
+      if (i % 10 == 5) {
+        std::this_thread::sleep_for(kModalStall);
+      }
+      Busy(kFrameTime);
+      frames.push_back(Clock::now());
+    }
+  }
+  ReportIntervals(state, frames);
+}
+BENCHMARK(BM_FramesOnWindowThread)
+    ->Iterations(2)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// The same stalls with frames rendered on their own thread, fed messages
+// through the SPSC queue the way D3DApp forwards them.
+void BM_FramesOnRenderThread(benchmark::State& state) {
+  std::vector<Clock::time_point> frames;
+  for (auto _ : state) {
+    frames.clear();
+    d3dapp::SpscQueue<Message, 1024> queue;
+    std::atomic<bool> running{true};
+    std::thread render{[&]() {
+      Message message{};
+      while (running.load(std::memory_order_acquire)) {
+        while (queue.TryPop(message)) {
+        }
+        Busy(kFrameTime);
+        frames.push_back(Clock::now());
+      }
+    }};
+    for (int i = 0; i < 50; ++i) {
+      if (i % 10 == 5) {
+        std::this_thread::sleep_for(kModalStall);
+      }
+      queue.TryPush(Message{i});
+      std::this_thread::sleep_for(kFrameTime);
+    }
+    running = false;
+    render.join();
+  }
+  ReportIntervals(state, frames);
+}
+BENCHMARK(BM_FramesOnRenderThread)
+    ->Iterations(2)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Cost of handing one message to the other thread.
+void BM_SpscHandoff(benchmark::State& state) {
+  d3dapp::SpscQueue<Message, 1024> queue;
+  std::atomic<bool> running{true};
+  std::thread consumer{[&]() {
+    Message message{};
+    while (running.load(std::memory_order_relaxed)) {
+      queue.TryPop(message);
+    }
+  }};
+  int i = 0;
+  for (auto _ : state) {
+    while (!queue.TryPush(Message{i})) {
+    }
+    ++i;
+  }
+  running = false;
+  consumer.join();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpscHandoff);
+
+}  // namespace
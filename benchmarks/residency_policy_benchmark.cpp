@@ -0,0 +1,103 @@
+#include "residency_policy.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr uint64_t kMiB = 1024 * 1024;
+constexpr uint64_t kFramesInFlight = 2;
+
+// A recorded-looking trace: each frame uses a window of objects that drifts
+// across the scene, plus a few random ones, the way a camera pans over
+// streamed content.
+struct Trace {
+  std::vector<uint64_t> sizes;
+  std::vector<std::vector<int>> frames;
+};
+
+Trace MakeTrace(int object_count, int frame_count, int window, int drift) {
+  Trace trace;
+  std::mt19937 random{7};
+  std::uniform_int_distribution<int> size_mib{1, 16};
+  for (int i = 0; i < object_count; ++i) {
+    trace.sizes.push_back(size_mib(random) * kMiB);
+  }
+  std::uniform_int_distribution<int> any{0, object_count - 1};
+  for (int frame = 0; frame < frame_count; ++frame) {
+    std::vector<int> used;
+    const int start = frame * drift / 8;
+    for (int i = 0; i < window; ++i) {
+      used.push_back((start + i) % object_count);
+    }
+    for (int i = 0; i < window / 16; ++i) {
+      used.push_back(any(random));
+    }
+    trace.frames.push_back(std::move(used));
+  }
+  return trace;
+}
+
+// Replays the trace against a budget of range(2) percent of the total size,
+// with usage reported as what the policy keeps resident. Reports the time
+// per Plan and how many bytes each frame moved.
+void BM_TraceReplay(benchmark::State& state) {
+  const int object_count = static_cast<int>(state.range(0));
+  const int window = static_cast<int>(state.range(1));
+  const Trace trace = MakeTrace(object_count, 1024, window, 8);
+  uint64_t total_size = 0;
+  for (uint64_t size : trace.sizes) {
+    total_size += size;
+  }
+  const uint64_t budget = total_size * state.range(2) / 100;
+  std::vector<int> keys(object_count);
+
+  std::vector<const void*> make_resident;
+  std::vector<const void*> evict;
+  d3dapp::ResidencyStats stats;
+  int64_t plans = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    d3dapp::ResidencyPolicy policy{budget / 16};
+    for (int i = 0; i < object_count; ++i) {
+      policy.Register(&keys[i], trace.sizes[i]);
+    }
+    state.ResumeTiming();
+
+    uint64_t fence = 0;
+    for (const std::vector<int>& frame : trace.frames) {
+      ++fence;
+      for (int i : frame) {
+        policy.MarkUsed(&keys[i], fence);
+      }
+      make_resident.clear();
+      evict.clear();
+      const uint64_t completed =
+          fence > kFramesInFlight ? fence - kFramesInFlight : 0;
+      policy.Plan(d3dapp::ResidencyBudget{budget, policy.stats().resident_size},
+                  completed, make_resident, evict);
+      benchmark::DoNotOptimize(make_resident.data());
+      benchmark::DoNotOptimize(evict.data());
+    }
+    plans += static_cast<int64_t>(trace.frames.size());
+    stats = policy.stats();
+  }
+  const double frames = static_cast<double>(trace.frames.size());
+  state.SetItemsProcessed(plans);
+  state.counters["made_resident_mib_per_frame"] =
+      static_cast<double>(stats.made_resident_total) / kMiB / frames;
+  state.counters["evicted_mib_per_frame"] =
+      static_cast<double>(stats.evicted_total) / kMiB / frames;
+  state.counters["over_budget_frames"] =
+      static_cast<double>(stats.over_budget_count);
+}
+BENCHMARK(BM_TraceReplay)
+    ->Args({1000, 100, 75})
+    ->Args({1000, 100, 50})
+    ->Args({10000, 1000, 75})
+    ->Args({10000, 1000, 25})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,160 @@
+#include "resource_state_tracker.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+constexpr uint32_t kCommon = 0;
+constexpr uint32_t kRenderTarget = 0x4;
+constexpr uint32_t kUnorderedAccess = 0x8;
+constexpr uint32_t kDepthWrite = 0x10;
+constexpr uint32_t kDepthRead = 0x20;
+constexpr uint32_t kNonPixelShaderResource = 0x40;
+constexpr uint32_t kPixelShaderResource = 0x80;
+constexpr uint32_t kPresent = 0;
+
+constexpr uint32_t kMipCount = 8;
+
+struct Frame {
+  int back_buffer;
+  int depth;
+  int gbuffer[3];
+  int bloom;
+  int lights;
+};
+
+// A deferred frame as passes written independently would transition it:
+// every pass puts what it touches into the state it needs, whether or not
+// the previous pass already did. Returns the transitions requested.
+size_t RecordFrame(Frame& frame, d3dapp::ResourceStateTracker& tracker,
+                   std::vector<d3dapp::TrackedBarrier>& barriers,
+                   size_t* barrier_calls) {
+  size_t requested = 0;
+  auto transition = [&](const void* resource, uint32_t subresource,
+                        uint32_t state) {
+    tracker.Transition(resource, subresource, state);
+    ++requested;
+  };
+  auto flush = [&]() {
+    size_t before = barriers.size();
+    tracker.TakeBarriers(barriers);
+    *barrier_calls += barriers.size() > before;
+  };
+  const uint32_t all = d3dapp::kAllSubresources;
+
+  // Depth prepass.
+  transition(&frame.depth, all, kDepthWrite);
+  flush();
+  // G-buffer.
+  transition(&frame.depth, all, kDepthWrite);
+  for (int& target : frame.gbuffer) {
+    transition(&target, all, kRenderTarget);
+  }
+  flush();
+  // Light culling reads depth, writes the light list.
+  transition(&frame.depth, all, kDepthRead | kNonPixelShaderResource);
+  transition(&frame.lights, all, kUnorderedAccess);
+  flush();
+  tracker.UavBarrier(&frame.lights);
+  // Lighting.
+  transition(&frame.lights, all, kPixelShaderResource);
+  for (int& target : frame.gbuffer) {
+    transition(&target, all, kPixelShaderResource);
+  }
+  transition(&frame.depth, all, kDepthRead | kNonPixelShaderResource);
+  transition(&frame.back_buffer, all, kRenderTarget);
+  flush();
+  // Bloom downsample chain, one mip at a time.
+  transition(&frame.back_buffer, all, kPixelShaderResource);
+  transition(&frame.bloom, 0, kRenderTarget);
+  flush();
+  for (uint32_t mip = 1; mip < kMipCount; ++mip) {
+    transition(&frame.bloom, mip - 1, kPixelShaderResource);
+    transition(&frame.bloom, mip, kRenderTarget);
+    flush();
+  }
+  // Composite.
+  transition(&frame.bloom, all, kPixelShaderResource);
+  transition(&frame.back_buffer, all, kRenderTarget);
+  flush();
+  // Present.
+  transition(&frame.back_buffer, all, kPresent);
+  flush();
+  return requested;
+}
+
+void RegisterFrame(d3dapp::ResourceStateRegistry& registry,
+                   const Frame& frame) {
+  registry.Register(&frame.back_buffer, 1, kPresent);
+  registry.Register(&frame.depth, 1, kDepthWrite);
+  for (const int& target : frame.gbuffer) {
+    registry.Register(&target, 1, kPixelShaderResource);
+  }
+  registry.Register(&frame.bloom, kMipCount, kPixelShaderResource);
+  registry.Register(&frame.lights, 1, kCommon, true);
+}
+
+// Counts the barriers a frame ends up issuing against the transitions its
+// passes ask for, and how many ResourceBarrier calls carry them.
+void BM_DeferredFrame(benchmark::State& state) {
+  Frame frame{};
+  d3dapp::ResourceStateRegistry registry;
+  RegisterFrame(registry, frame);
+  d3dapp::ResourceStateTracker tracker{&registry};
+  std::vector<d3dapp::TrackedBarrier> barriers;
+  size_t requested = 0;
+  size_t emitted = 0;
+  size_t resolved = 0;
+  size_t barrier_calls = 0;
+  for (auto _ : state) {
+    tracker.Reset();
+    barriers.clear();
+    barrier_calls = 0;
+    requested = RecordFrame(frame, tracker, barriers, &barrier_calls);
+    emitted = barriers.size();
+    tracker.Resolve(registry, barriers);
+    registry.Decay();
+    resolved = barriers.size() - emitted;
+  }
+  state.SetItemsProcessed(state.iterations() * requested);
+  state.counters["requested"] = static_cast<double>(requested);
+  state.counters["emitted"] = static_cast<double>(emitted);
+  state.counters["resolved"] = static_cast<double>(resolved);
+  state.counters["barrier_calls"] = static_cast<double>(barrier_calls);
+}
+BENCHMARK(BM_DeferredFrame);
+
+// Frames split across lists recorded independently, as with parallel
+// recording, resolved at submit.
+void BM_DeferredFrameAcrossLists(benchmark::State& state) {
+  const int list_count = static_cast<int>(state.range(0));
+  std::vector<Frame> frames(list_count);
+  d3dapp::ResourceStateRegistry registry;
+  for (const Frame& frame : frames) {
+    RegisterFrame(registry, frame);
+  }
+  std::vector<d3dapp::ResourceStateTracker> trackers(
+      list_count, d3dapp::ResourceStateTracker{&registry});
+  std::vector<d3dapp::TrackedBarrier> barriers;
+  size_t emitted = 0;
+  for (auto _ : state) {
+    barriers.clear();
+    size_t barrier_calls = 0;
+    for (int i = 0; i < list_count; ++i) {
+      trackers[i].Reset();
+      RecordFrame(frames[i], trackers[i], barriers, &barrier_calls);
+    }
+    for (d3dapp::ResourceStateTracker& tracker : trackers) {
+      tracker.Resolve(registry, barriers);
+    }
+    registry.Decay();
+    emitted = barriers.size();
+  }
+  state.SetItemsProcessed(state.iterations() * list_count);
+  state.counters["emitted"] = static_cast<double>(emitted);
+}
+BENCHMARK(BM_DeferredFrameAcrossLists)->Arg(4)->Arg(16);
+
+}  // namespace
@@ -0,0 +1,64 @@
+#include "streaming_pipeline.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "fake_copy_queue.h"
+#include "job_system.h"
+
+namespace {
+// 64MB streamed per iteration through a 4MB staging ring.
+constexpr uint64_t kTotalSize = 64 * 1024 * 1024;
+constexpr uint64_t kStagingSize = 4 * 1024 * 1024;
+
+// range(0) is the request size; range(1) the decode workers, 0 decoding on
+// the stream thread. Decode is a copy out of memory, so this measures the
+// pipeline's own overhead and the staging ring's throughput.
+void BM_StreamRequests(benchmark::State& state) {
+  const uint64_t request_size = static_cast<uint64_t>(state.range(0));
+  const uint64_t request_count = kTotalSize / request_size;
+  d3dapp::JobSystem job_system{static_cast<int>(state.range(1))};
+  d3dapp::testing::MemoryCopyQueue* queue =
+      new d3dapp::testing::MemoryCopyQueue{kStagingSize};
+  d3dapp::StreamingPipeline pipeline{
+      std::unique_ptr<d3dapp::StreamingPipeline::CopyQueue>{queue},
+      &job_system};
+  std::vector<uint8_t> source(static_cast<size_t>(request_size), 0x5a);
+
+  for (auto _ : state) {
+    std::atomic<uint64_t> delivered{0};
+    for (uint64_t i = 0; i < request_count; ++i) {
+      d3dapp::StreamRequest request;
+      request.staging_size = request_size;
+      request.decode = [&source](const uint8_t*, uint8_t* staging) {
+        std::memcpy(staging, source.data(), source.size());
+        return true;
+      };
+      request.ready = [&delivered](bool, uint64_t) { ++delivered; };
+      pipeline.Request(std::move(request));
+    }
+    while (delivered < request_count) {
+      pipeline.DeliverReady();
+      std::this_thread::yield();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * request_count * request_size);
+  state.SetItemsProcessed(state.iterations() * request_count);
+  const d3dapp::StreamingStats stats = pipeline.stats();
+  state.counters["latency_ms"] = stats.average_latency_ms();
+  state.counters["staging_peak_mb"] =
+      static_cast<double>(stats.staging_peak) / (1024 * 1024);
+}
+BENCHMARK(BM_StreamRequests)
+    ->ArgNames({"size", "workers"})
+    ->ArgsProduct({{64 * 1024, 256 * 1024, 1024 * 1024}, {0, 3}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
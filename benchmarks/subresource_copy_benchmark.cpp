@@ -0,0 +1,140 @@
+#include "subresource_copy.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "cpu_features.h"
+#include "job_system.h"
+
+namespace {
+// 16MB of RGBA8 either way.
+enum Shape { kLarge2D, kArray };
+
+// range(0) is the shape; range(1) is 1 to pad destination rows by 256
+// bytes, as upload heap footprints of odd widths are, and 0 for matching
+// pitches, which CopySubresource copies as one run.
+struct Layout {
+  std::vector<uint8_t> source;
+  std::vector<uint8_t> dest;
+  d3dapp::SubresourceCopy copy;
+};
+
+Layout MakeLayout(const benchmark::State& state) {
+  const bool array = kArray == state.range(0);
+  const uint32_t width = array ? 512 : 2048;
+  const uint32_t slice_count = array ? 16 : 1;
+  const size_t row_size = width * 4;
+  const size_t dest_row_pitch = state.range(1) ? row_size + 256 : row_size;
+  Layout layout;
+  layout.source.resize(row_size * width * slice_count);
+  for (size_t i = 0; i < layout.source.size(); ++i) {
+    layout.source[i] = static_cast<uint8_t>(i * 7);
+  }
+  layout.dest.resize(dest_row_pitch * width * slice_count);
+  layout.copy = d3dapp::SubresourceCopy{layout.dest.data(),
+                                        dest_row_pitch,
+                                        dest_row_pitch * width,
+                                        layout.source.data(),
+                                        row_size,
+                                        row_size * width,
+                                        row_size,
+                                        width,
+                                        slice_count};
+  return layout;
+}
+
+void SetBytes(benchmark::State& state, const Layout& layout) {
+  state.SetBytesProcessed(state.iterations() * layout.source.size());
+}
+
+// range(2) is 0 for SSE2 only and 1 for AVX2, skipped where the CPU lacks
+// it. Returns false after skipping.
+bool ForceAvx2(benchmark::State& state, const d3dapp::CpuFeatures& detected) {
+  if (0 == state.range(2)) {
+    d3dapp::SetCpuFeaturesForTesting(d3dapp::CpuFeatures{});
+  } else if (!detected.avx2) {
+    state.SkipWithError("no AVX2");
+    return false;
+  }
+  return true;
+}
+
+// The baseline: what MemcpySubresource does.
+void BM_MemcpyRows(benchmark::State& state) {
+  Layout layout = MakeLayout(state);
+  const d3dapp::SubresourceCopy& copy = layout.copy;
+  for (auto _ : state) {
+    for (uint32_t slice = 0; slice < copy.slice_count; ++slice) {
+      for (uint32_t row = 0; row < copy.row_count; ++row) {
+        std::memcpy(static_cast<uint8_t*>(copy.dest) +
+                        copy.dest_slice_pitch * slice +
+                        copy.dest_row_pitch * row,
+                    static_cast<const uint8_t*>(copy.source) +
+                        copy.source_slice_pitch * slice +
+                        copy.source_row_pitch * row,
+                    copy.row_size);
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  SetBytes(state, layout);
+}
+BENCHMARK(BM_MemcpyRows)
+    ->ArgNames({"shape", "padded"})
+    ->ArgsProduct({{kLarge2D, kArray}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_StreamCopyRows(benchmark::State& state) {
+  const d3dapp::CpuFeatures detected = d3dapp::GetCpuFeatures();
+  if (!ForceAvx2(state, detected)) {
+    return;
+  }
+  Layout layout = MakeLayout(state);
+  const d3dapp::SubresourceCopy& copy = layout.copy;
+  for (auto _ : state) {
+    for (uint32_t slice = 0; slice < copy.slice_count; ++slice) {
+      for (uint32_t row = 0; row < copy.row_count; ++row) {
+        d3dapp::StreamCopy(static_cast<uint8_t*>(copy.dest) +
+                               copy.dest_slice_pitch * slice +
+                               copy.dest_row_pitch * row,
+                           static_cast<const uint8_t*>(copy.source) +
+                               copy.source_slice_pitch * slice +
+                               copy.source_row_pitch * row,
+                           copy.row_size);
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  SetBytes(state, layout);
+  d3dapp::SetCpuFeaturesForTesting(detected);
+}
+BENCHMARK(BM_StreamCopyRows)
+    ->ArgNames({"shape", "padded", "avx2"})
+    ->ArgsProduct({{kLarge2D, kArray}, {0, 1}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// range(3) is the workers; with none the copy is not split into bands.
+void BM_CopySubresource(benchmark::State& state) {
+  const d3dapp::CpuFeatures detected = d3dapp::GetCpuFeatures();
+  if (!ForceAvx2(state, detected)) {
+    return;
+  }
+  Layout layout = MakeLayout(state);
+  d3dapp::JobSystem job_system{static_cast<int>(state.range(3))};
+  for (auto _ : state) {
+    d3dapp::CopySubresource(layout.copy, &job_system);
+    benchmark::ClobberMemory();
+  }
+  SetBytes(state, layout);
+  d3dapp::SetCpuFeaturesForTesting(detected);
+}
+BENCHMARK(BM_CopySubresource)
+    ->ArgNames({"shape", "padded", "avx2", "workers"})
+    ->ArgsProduct({{kLarge2D, kArray}, {0, 1}, {0, 1}, {0, 3}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
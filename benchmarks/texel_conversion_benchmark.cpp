@@ -0,0 +1,64 @@
+#include "texel_conversion.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "cpu_features.h"
+
+namespace {
+// A 1024x1024 image, converted row by row as ConvertSubresource does.
+constexpr size_t kWidth = 1024;
+constexpr size_t kHeight = 1024;
+
+// range(0) is the conversion; range(1) is 0 for SSE2 only and 1 for what
+// the CPU has.
+void BM_ConvertTexels(benchmark::State& state) {
+  const d3dapp::CpuFeatures detected = d3dapp::GetCpuFeatures();
+  if (0 == state.range(1)) {
+    d3dapp::SetCpuFeaturesForTesting(d3dapp::CpuFeatures{});
+  }
+  d3dapp::TexelConversion conversion{
+      static_cast<d3dapp::TexelConversion::Type>(state.range(0)),
+      {2, 1, 0, 3}};
+  const size_t source_size = d3dapp::SourceTexelSize(conversion.type);
+  const size_t dest_size = d3dapp::DestTexelSize(conversion.type);
+  std::vector<uint8_t> source(kWidth * kHeight * source_size);
+  for (size_t i = 0; i < source.size(); ++i) {
+    source[i] = static_cast<uint8_t>(i * 7);
+  }
+  // Valid floats in [0, 1) for the float sources.
+  if (d3dapp::TexelConversion::kR32FloatToR16Float == conversion.type ||
+      d3dapp::TexelConversion::kRgba32FloatToRgba8Srgb == conversion.type) {
+    float* values = reinterpret_cast<float*>(source.data());
+    for (size_t i = 0; i < source.size() / 4; ++i) {
+      values[i] = static_cast<float>(i % 4096) / 4096.0f;
+    }
+  }
+  std::vector<uint8_t> dest(kWidth * kHeight * dest_size);
+
+  for (auto _ : state) {
+    for (size_t row = 0; row < kHeight; ++row) {
+      d3dapp::ConvertTexels(conversion,
+                            dest.data() + row * kWidth * dest_size,
+                            source.data() + row * kWidth * source_size,
+                            kWidth);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+  state.SetBytesProcessed(state.iterations() * kWidth * kHeight *
+                          (source_size + dest_size));
+  d3dapp::SetCpuFeaturesForTesting(detected);
+}
+BENCHMARK(BM_ConvertTexels)
+    ->ArgNames({"type", "detected"})
+    ->ArgsProduct({{d3dapp::TexelConversion::kRgb8ToRgba8,
+                    d3dapp::TexelConversion::kR32FloatToR16Float,
+                    d3dapp::TexelConversion::kR16UnormToR32Float,
+                    d3dapp::TexelConversion::kRgba32FloatToRgba8Srgb,
+                    d3dapp::TexelConversion::kSwizzleRgba8},
+                   {0, 1}});
+
+}  // namespace
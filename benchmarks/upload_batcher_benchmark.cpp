@@ -0,0 +1,184 @@
+#include "upload_batcher.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "fake_upload.h"
+
+namespace {
+constexpr UINT64 kPageSize = 64 * 1024 * 1024;
+constexpr uint64_t kFramesInFlight = 3;
+
+D3D12_RESOURCE_DESC Texture2D(UINT size, UINT16 mip_levels) {
+  D3D12_RESOURCE_DESC desc{};
+  desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+  desc.Width = size;
+  desc.Height = size;
+  desc.DepthOrArraySize = 1;
+  desc.MipLevels = mip_levels;
+  desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  return desc;
+}
+
+UINT16 MipCount(UINT size) {
+  UINT16 count = 1;
+  for (; size > 1; size /= 2) {
+    ++count;
+  }
+  return count;
+}
+
+// Tightly packed RGBA8 mips of a size x size texture.
+struct Image {
+  std::vector<std::vector<uint8_t>> mips;
+  std::vector<D3D12_SUBRESOURCE_DATA> data;
+  // Staged, with the footprints' padding.
+  UINT64 total_size{0};
+};
+
+Image MakeImage(const D3D12_RESOURCE_DESC& desc) {
+  const UINT size = desc.Height;
+  Image image;
+  d3dapp::CalculateFootprints(desc, 0, desc.MipLevels, 0, nullptr, nullptr,
+                              nullptr, &image.total_size);
+  for (UINT mip_size = size;; mip_size /= 2) {
+    image.mips.emplace_back(static_cast<size_t>(mip_size) * mip_size * 4,
+                            static_cast<uint8_t>(mip_size));
+    if (1 == mip_size) {
+      break;
+    }
+  }
+  UINT mip_size = size;
+  for (const std::vector<uint8_t>& mip : image.mips) {
+    image.data.push_back(D3D12_SUBRESOURCE_DATA{
+        mip.data(), static_cast<LONG_PTR>(mip_size) * 4,
+        static_cast<LONG_PTR>(mip.size())});
+    mip_size = mip_size > 1 ? mip_size / 2 : 1;
+  }
+  return image;
+}
+
+// Upload memory the GPU reads from, as big as the ring's pages of the
+// frames in flight, so neither side of the comparison writes into memory
+// that is still in the cache.
+class Intermediates {
+ public:
+  explicit Intermediates(UINT64 size) : memory_(size), offset_{0} {}
+
+  BYTE* Allocate(UINT64 size) {
+    size = (size + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) &
+           ~static_cast<UINT64>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+    if (offset_ + size > memory_.size()) {
+      offset_ = 0;
+    }
+    BYTE* memory = memory_.data() + offset_;
+    offset_ += size;
+    return memory;
+  }
+
+ private:
+  std::vector<BYTE> memory_;
+  UINT64 offset_;
+};
+
+// What d3dx12's heap allocating UpdateSubresources does on the CPU for each
+// texture: allocate the footprint arrays, query the footprints, copy row by
+// row into an intermediate buffer and record one copy per subresource.
+// Creating the intermediate, a committed upload buffer per texture in the
+// app, is left out, so this flatters UpdateSubresources.
+void UpdateSubresources(d3dapp::UploadBatcher::Copies* copies,
+                        Intermediates* intermediates, ID3D12Resource* dest,
+                        const D3D12_RESOURCE_DESC& desc,
+                        UINT subresource_count,
+                        const D3D12_SUBRESOURCE_DATA* data) {
+  std::unique_ptr<D3D12_PLACED_SUBRESOURCE_FOOTPRINT[]> layouts{
+      new D3D12_PLACED_SUBRESOURCE_FOOTPRINT[subresource_count]};
+  std::unique_ptr<UINT[]> row_counts{new UINT[subresource_count]};
+  std::unique_ptr<UINT64[]> row_sizes{new UINT64[subresource_count]};
+  UINT64 total_size = 0;
+  d3dapp::CalculateFootprints(desc, 0, subresource_count, 0, layouts.get(),
+                              row_counts.get(), row_sizes.get(), &total_size);
+
+  BYTE* intermediate = intermediates->Allocate(total_size);
+  for (UINT i = 0; i < subresource_count; ++i) {
+    BYTE* dest_rows = intermediate + layouts[i].Offset;
+    const BYTE* source_rows = static_cast<const BYTE*>(data[i].pData);
+    for (UINT row = 0; row < row_counts[i]; ++row) {
+      std::memcpy(dest_rows + layouts[i].Footprint.RowPitch * row,
+                  source_rows + data[i].RowPitch * row, row_sizes[i]);
+    }
+  }
+  for (UINT i = 0; i < subresource_count; ++i) {
+    copies->CopyTexture(dest, i,
+                        reinterpret_cast<ID3D12Resource*>(intermediate),
+                        layouts[i]);
+  }
+}
+
+// range(0) textures of range(1) x range(1) texels with full mip chains per
+// frame, e.g. streamed terrain tiles.
+void BM_UpdateSubresources(benchmark::State& state) {
+  const int count = static_cast<int>(state.range(0));
+  const UINT size = static_cast<UINT>(state.range(1));
+  const D3D12_RESOURCE_DESC desc = Texture2D(size, MipCount(size));
+  const Image image = MakeImage(desc);
+  Intermediates intermediates{(kFramesInFlight + 1) * count *
+                               image.total_size};
+  d3dapp::testing::RecordedCopies copies;
+  for (auto _ : state) {
+    for (int i = 0; i < count; ++i) {
+      UpdateSubresources(&copies, &intermediates, nullptr, desc,
+                         desc.MipLevels, image.data.data());
+    }
+    copies.copies.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  state.SetBytesProcessed(state.iterations() * count * size * size * 4 * 4 /
+                          3);
+}
+BENCHMARK(BM_UpdateSubresources)->Args({64, 256})->Args({4, 2048});
+
+void BM_UploadBatcher(benchmark::State& state) {
+  const int count = static_cast<int>(state.range(0));
+  const UINT size = static_cast<UINT>(state.range(1));
+  const D3D12_RESOURCE_DESC desc = Texture2D(size, MipCount(size));
+  const Image image = MakeImage(desc);
+  d3dapp::FootprintCache footprint_cache{nullptr};
+  d3dapp::UploadRing upload_ring{
+      std::unique_ptr<d3dapp::UploadRing::Pages>{
+          new d3dapp::testing::MemoryPages},
+      kPageSize};
+  d3dapp::UploadBatcher batcher{&footprint_cache, &upload_ring};
+  d3dapp::testing::RecordedCopies copies;
+  uint64_t frame = 0;
+  auto upload_frame = [&] {
+    for (int i = 0; i < count; ++i) {
+      batcher.AddTexture(nullptr, desc, 0, desc.MipLevels, image.data.data());
+    }
+    batcher.Flush(&copies);
+    copies.copies.clear();
+    upload_ring.EndFrame(++frame);
+    if (frame > kFramesInFlight) {
+      upload_ring.Reclaim(frame - kFramesInFlight);
+    }
+  };
+  // Creates and touches the pages, as Intermediates does up front.
+  for (uint64_t i = 0; i <= kFramesInFlight; ++i) {
+    upload_frame();
+  }
+  for (auto _ : state) {
+    upload_frame();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  state.SetBytesProcessed(state.iterations() * count * size * size * 4 * 4 /
+                          3);
+  state.counters["pages"] = static_cast<double>(upload_ring.page_count());
+}
+BENCHMARK(BM_UploadBatcher)->Args({64, 256})->Args({4, 2048});
+
+}  // namespace
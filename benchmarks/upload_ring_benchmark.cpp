@@ -0,0 +1,100 @@
+#include "upload_ring.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+
+namespace {
+// Pages in plain memory, so the benchmark measures the ring and the writes
+// into it rather than the driver.
+class MemoryPages : public d3dapp::UploadRing::Pages {
+ public:
+  bool Create(UINT64 size, d3dapp::UploadAllocation* page) override {
+    page->resource = nullptr;
+    page->offset = 0;
+    page->cpu_address = new BYTE[size];
+    page->gpu_address = reinterpret_cast<uintptr_t>(page->cpu_address);
+    return true;
+  }
+
+  void Destroy(const d3dapp::UploadAllocation& page) override {
+    delete[] page.cpu_address;
+  }
+};
+
+constexpr UINT64 kPageSize = 2 * 1024 * 1024;
+constexpr uint64_t kFramesInFlight = 3;
+
+std::unique_ptr<d3dapp::UploadRing> MakeRing() {
+  return std::unique_ptr<d3dapp::UploadRing>{new d3dapp::UploadRing{
+      std::unique_ptr<d3dapp::UploadRing::Pages>{new MemoryPages},
+      kPageSize}};
+}
+
+// Constant buffers of range(0) bytes, written as a frame would; a frame is
+// range(1) of them, retired kFramesInFlight frames later.
+void BM_ConstantBufferFrames(benchmark::State& state) {
+  const UINT64 size = static_cast<UINT64>(state.range(0));
+  const int per_frame = static_cast<int>(state.range(1));
+  std::unique_ptr<d3dapp::UploadRing> ring = MakeRing();
+  BYTE data[1024] = {};
+  uint64_t frame = 0;
+  for (auto _ : state) {
+    ++frame;
+    for (int i = 0; i < per_frame; ++i) {
+      d3dapp::UploadAllocation allocation = ring->Allocate(size);
+      std::memcpy(allocation.cpu_address, data, size);
+    }
+    ring->EndFrame(frame);
+    if (frame > kFramesInFlight) {
+      ring->Reclaim(frame - kFramesInFlight);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * per_frame);
+  state.SetBytesProcessed(state.iterations() * per_frame * size);
+  state.counters["pages"] = static_cast<double>(ring->page_count());
+}
+BENCHMARK(BM_ConstantBufferFrames)
+    ->Args({256, 1000})
+    ->Args({256, 10000})
+    ->Args({1024, 10000});
+
+// Allocation alone, without writing.
+void BM_Allocate(benchmark::State& state) {
+  std::unique_ptr<d3dapp::UploadRing> ring = MakeRing();
+  uint64_t frame = 0;
+  int count = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ring->Allocate(256));
+    if (++count == 4096) {
+      count = 0;
+      ring->EndFrame(++frame);
+      if (frame > kFramesInFlight) {
+        ring->Reclaim(frame - kFramesInFlight);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Allocate);
+
+// Uploads larger than a page, each with its own page.
+void BM_LargeUploads(benchmark::State& state) {
+  const UINT64 size = static_cast<UINT64>(state.range(0));
+  std::unique_ptr<d3dapp::UploadRing> ring = MakeRing();
+  uint64_t frame = 0;
+  for (auto _ : state) {
+    d3dapp::UploadAllocation allocation =
+        ring->Allocate(size, d3dapp::UploadRing::kTextureAlignment);
+    std::memset(allocation.cpu_address, 0, size);
+    ring->EndFrame(++frame);
+    if (frame > kFramesInFlight) {
+      ring->Reclaim(frame - kFramesInFlight);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_LargeUploads)->Arg(4 * 1024 * 1024)->Arg(16 * 1024 * 1024);
+
+}  // namespace
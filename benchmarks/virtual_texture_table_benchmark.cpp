@@ -0,0 +1,107 @@
+#include "virtual_texture_table.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr uint64_t kFramesInFlight = 2;
+constexpr size_t kMaxMappingsPerFrame = 256;
+
+// Mip 0 of size x size pages down to 1x1.
+std::vector<d3dapp::VirtualMipLevel> Mips(uint32_t size) {
+  std::vector<d3dapp::VirtualMipLevel> mips;
+  for (; size > 0; size /= 2) {
+    mips.push_back({size, size});
+  }
+  return mips;
+}
+
+// Feedback buffers as a camera panning across a terrain would resolve them:
+// a window of mip 0 pages near the camera, a wider ring of mip 1 pages, and
+// cleared entries where nothing was sampled.
+std::vector<std::vector<uint32_t>> MakeFeedback(uint32_t size, int frame_count,
+                                                uint32_t window) {
+  std::vector<std::vector<uint32_t>> frames;
+  std::mt19937 random{7};
+  std::uniform_int_distribution<int> empty{0, 3};
+  for (int frame = 0; frame < frame_count; ++frame) {
+    std::vector<uint32_t> feedback;
+    const uint32_t left = frame / 4 % (size - window);
+    const uint32_t top = frame / 16 % (size - window);
+    for (uint32_t y = 0; y < window; ++y) {
+      for (uint32_t x = 0; x < window; ++x) {
+        feedback.push_back(empty(random) == 0
+                               ? d3dapp::kNoFeedback
+                               : d3dapp::VirtualTextureTable::PackFeedback(
+                                     0, left + x, top + y));
+      }
+    }
+    // Twice the width of the mip 0 window, centered on it.
+    const uint32_t mip1_left =
+        left / 2 > window / 4 ? left / 2 - window / 4 : 0;
+    const uint32_t mip1_top = top / 2 > window / 4 ? top / 2 - window / 4 : 0;
+    for (uint32_t y = 0; y < window; ++y) {
+      for (uint32_t x = 0; x < window; ++x) {
+        feedback.push_back(d3dapp::VirtualTextureTable::PackFeedback(
+            1, mip1_left + x, mip1_top + y));
+      }
+    }
+    frames.push_back(std::move(feedback));
+  }
+  return frames;
+}
+
+// Replays the feedback stream into a pool of range(2) tiles, with the GPU
+// kFramesInFlight frames behind. Reports the time per frame and how many
+// tiles each frame mapped and evicted. The 32 page window needs more tiles
+// than the 1024 tile pool has, so it starves every frame.
+void BM_FeedbackReplay(benchmark::State& state) {
+  const uint32_t size = static_cast<uint32_t>(state.range(0));
+  const uint32_t window = static_cast<uint32_t>(state.range(1));
+  const uint32_t tile_count = static_cast<uint32_t>(state.range(2));
+  const std::vector<d3dapp::VirtualMipLevel> mips = Mips(size);
+  const std::vector<std::vector<uint32_t>> frames =
+      MakeFeedback(size, 1024, window);
+
+  std::vector<d3dapp::TileMapping> mappings;
+  d3dapp::VirtualTextureStats stats;
+  int64_t frames_replayed = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    d3dapp::VirtualTextureTable table{mips, tile_count};
+    state.ResumeTiming();
+
+    uint64_t fence = 0;
+    for (const std::vector<uint32_t>& feedback : frames) {
+      ++fence;
+      table.ProcessFeedback(feedback.data(), feedback.size(), fence);
+      mappings.clear();
+      const uint64_t completed =
+          fence > kFramesInFlight ? fence - kFramesInFlight : 0;
+      table.Update(completed, kMaxMappingsPerFrame, mappings);
+      benchmark::DoNotOptimize(mappings.data());
+      benchmark::DoNotOptimize(table.min_mip_map().data());
+      table.ClearMinMipDirty();
+    }
+    frames_replayed += static_cast<int64_t>(frames.size());
+    stats = table.stats();
+  }
+  const double frames_per_run = static_cast<double>(frames.size());
+  state.SetItemsProcessed(frames_replayed);
+  state.counters["mapped_per_frame"] =
+      static_cast<double>(stats.mapped_total) / frames_per_run;
+  state.counters["evicted_per_frame"] =
+      static_cast<double>(stats.evicted_total) / frames_per_run;
+  state.counters["starved_frames"] = static_cast<double>(stats.starved_count);
+}
+BENCHMARK(BM_FeedbackReplay)
+    ->ArgNames({"pages", "window", "tiles"})
+    ->Args({256, 16, 1024})
+    ->Args({256, 32, 1024})
+    ->Args({1024, 32, 4096})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,209 @@
+#include "asset_package.h"
+
+#include <cstring>
+#include <vector>
+
+#include "chunked_lz.h"
+#include "footprint_cache.h"
+#include "subresource_copy.h"
+
+namespace {
+bool InFile(uint64_t offset, uint64_t size, uint64_t file_size) {
+  return offset <= file_size && size <= file_size - offset;
+}
+
+}  // namespace
+
+namespace d3dapp {
+uint64_t HashAssetName(const char* name, size_t size) {
+  // FNV-1a.
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<uint8_t>(name[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+D3D12_RESOURCE_DESC GetAssetDesc(const AssetEntry& entry) {
+  if (AssetEntry::kTexture != entry.type) {
+    return CD3DX12_RESOURCE_DESC::Buffer(entry.data_size);
+  }
+  return CD3DX12_RESOURCE_DESC{
+      static_cast<D3D12_RESOURCE_DIMENSION>(entry.dimension),
+      0,
+      entry.width,
+      entry.height,
+      entry.depth_or_array_size,
+      entry.mip_levels,
+      static_cast<DXGI_FORMAT>(entry.format),
+      1,
+      0,
+      D3D12_TEXTURE_LAYOUT_UNKNOWN,
+      D3D12_RESOURCE_FLAG_NONE};
+}
+
+UINT GetAssetSubresourceCount(const AssetEntry& entry) {
+  if (AssetEntry::kTexture != entry.type) {
+    return 1;
+  }
+  UINT array_size =
+      D3D12_RESOURCE_DIMENSION_TEXTURE3D == entry.dimension
+          ? 1
+          : entry.depth_or_array_size;
+  return array_size * entry.mip_levels;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool AssetPackage::Open(const char* path) {
+  Close();
+  if (!file_.Open(path) || !Validate()) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void AssetPackage::Close() {
+  file_.Close();
+  entries_ = nullptr;
+  entry_count_ = 0;
+  slots_ = nullptr;
+  slot_mask_ = 0;
+  names_ = nullptr;
+}
+
+const AssetEntry* AssetPackage::Find(const char* name) const {
+  return Find(name, std::strlen(name));
+}
+
+const AssetEntry* AssetPackage::Find(const char* name, size_t size) const {
+  if (!slots_) {
+    return nullptr;
+  }
+  uint64_t hash = HashAssetName(name, size);
+  for (uint32_t slot = static_cast<uint32_t>(hash) & slot_mask_;;
+       slot = (slot + 1) & slot_mask_) {
+    uint32_t index = slots_[slot];
+    if (0 == index) {
+      return nullptr;
+    }
+    const AssetEntry& entry = entries_[index - 1];
+    if (entry.name_hash == hash && entry.name_size == size &&
+        0 == std::memcmp(names_ + entry.name_offset, name, size)) {
+      return &entry;
+    }
+  }
+}
+
+bool AssetPackage::Validate() {
+  const uint8_t* data = file_.data();
+  uint64_t file_size = file_.size();
+  if (file_size < sizeof(AssetPackageHeader)) {
+    return false;
+  }
+  AssetPackageHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (AssetPackageHeader::kMagic != header.magic ||
+      AssetPackageHeader::kVersion != header.version ||
+      header.slot_count <= header.entry_count ||
+      0 != (header.slot_count & (header.slot_count - 1)) ||
+      0 != header.entries_offset % alignof(AssetEntry) ||
+      0 != header.slots_offset % alignof(uint32_t) ||
+      !InFile(header.entries_offset,
+              uint64_t{header.entry_count} * sizeof(AssetEntry), file_size) ||
+      !InFile(header.slots_offset,
+              uint64_t{header.slot_count} * sizeof(uint32_t), file_size) ||
+      !InFile(header.names_offset, header.names_size, file_size)) {
+    return false;
+  }
+  entries_ = reinterpret_cast<const AssetEntry*>(data + header.entries_offset);
+  entry_count_ = header.entry_count;
+  slots_ = reinterpret_cast<const uint32_t*>(data + header.slots_offset);
+  slot_mask_ = header.slot_count - 1;
+  names_ = reinterpret_cast<const char*>(data + header.names_offset);
+
+  // Every entry in exactly one slot, which leaves slot_count - entry_count
+  // slots empty to end Find's probes.
+  std::vector<bool> slotted(entry_count_);
+  uint32_t slotted_count = 0;
+  for (uint32_t i = 0; i <= slot_mask_; ++i) {
+    uint32_t index = slots_[i];
+    if (0 == index) {
+      continue;
+    }
+    if (index > entry_count_ || slotted[index - 1]) {
+      return false;
+    }
+    slotted[index - 1] = true;
+    ++slotted_count;
+  }
+  if (slotted_count != entry_count_) {
+    return false;
+  }
+  for (uint32_t i = 0; i < entry_count_; ++i) {
+    const AssetEntry& entry = entries_[i];
+    // Names are followed by a terminator.
+    if (entry.name_offset >= header.names_size ||
+        entry.name_size >= header.names_size - entry.name_offset ||
+        '\0' != names_[entry.name_offset + entry.name_size] ||
+        0 != entry.data_offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT ||
+        !InFile(entry.data_offset, entry.stored_size, file_size)) {
+      return false;
+    }
+    if (AssetEntry::kChunkedLz == entry.compression) {
+      uint64_t decompressed_size = 0;
+      if (!GetDecompressedSize(data + entry.data_offset, entry.stored_size,
+                               &decompressed_size) ||
+          decompressed_size != entry.data_size) {
+        return false;
+      }
+    } else if (AssetEntry::kUncompressed != entry.compression ||
+               entry.stored_size != entry.data_size) {
+      return false;
+    }
+    if (AssetEntry::kTexture == entry.type) {
+      UINT64 total_size = 0;
+      if (0 == entry.mip_levels || 0 == entry.depth_or_array_size ||
+          !CalculateFootprints(GetAssetDesc(entry), 0,
+                               GetAssetSubresourceCount(entry), 0, nullptr,
+                               nullptr, nullptr, &total_size) ||
+          total_size > entry.data_size) {
+        return false;
+      }
+    } else if (AssetEntry::kBuffer != entry.type) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+StreamRequest MakeAssetRequest(const AssetPackage& package,
+                               const AssetEntry& entry,
+                               JobSystem* job_system) {
+  StreamRequest request;
+  request.file = &package.file();
+  request.offset = entry.data_offset;
+  request.size = entry.stored_size;
+  request.staging_size = entry.data_size;
+  uint64_t stored_size = entry.stored_size;
+  uint64_t size = entry.data_size;
+  if (AssetEntry::kChunkedLz == entry.compression) {
+    request.decode = [stored_size, size, job_system](const uint8_t* source,
+                                                     uint8_t* staging) {
+      return DecompressChunked(source, stored_size, staging, size,
+                               job_system);
+    };
+  } else {
+    request.decode = [size](const uint8_t* source, uint8_t* staging) {
+      StreamCopy(staging, source, static_cast<size_t>(size));
+      return true;
+    };
+  }
+  return request;
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,120 @@
+#pragma once
+
+#ifndef __ASSET_PACKAGE_H__
+#define __ASSET_PACKAGE_H__
+
+#include <d3dx12.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "framework.h"
+#include "mapped_file.h"
+#include "streaming_pipeline.h"
+
+namespace d3dapp {
+class JobSystem;
+
+// A package is a header, the entries, a hash table of entry indices and the
+// entry names, followed by the payloads. Payloads start at multiples of
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT. Texture payloads hold every
+// subresource placed as CalculateFootprints lays them out from offset 0,
+// so loading one is a straight copy into upload memory with the same
+// alignment. Payloads may be stored compressed with CompressChunked, in
+// which case stored_size bytes decompress to data_size.
+struct AssetPackageHeader {
+  static constexpr uint32_t kMagic = 0x4b504433;  // "3DPK"
+  static constexpr uint32_t kVersion = 2;
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entry_count;
+  // Power of two, more than entry_count.
+  uint32_t slot_count;
+  uint64_t entries_offset;
+  // uint32_t entry index + 1 per slot, 0 for empty slots. Names are found
+  // by linear probing from their hash.
+  uint64_t slots_offset;
+  uint64_t names_offset;
+  uint64_t names_size;
+};
+static_assert(sizeof(AssetPackageHeader) == 48, "packed header");
+
+struct AssetEntry {
+  enum Type { kBuffer, kTexture };
+  enum Compression { kUncompressed, kChunkedLz };
+
+  uint64_t name_hash;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t stored_size;
+  // D3D12_RESOURCE_DESC of textures.
+  uint64_t width;
+  uint32_t name_offset;
+  uint32_t name_size;
+  uint32_t type;
+  uint32_t dimension;
+  uint32_t format;
+  uint32_t height;
+  uint16_t depth_or_array_size;
+  uint16_t mip_levels;
+  uint32_t compression;
+};
+static_assert(sizeof(AssetEntry) == 72, "packed entry");
+
+uint64_t HashAssetName(const char* name, size_t size);
+
+// Buffer descs for buffers.
+D3D12_RESOURCE_DESC GetAssetDesc(const AssetEntry& entry);
+UINT GetAssetSubresourceCount(const AssetEntry& entry);
+
+// Read-only view of a mapped package. Open checks the tables and that
+// every payload lies in the file and is as large as its footprints, so
+// entries need no checks afterwards.
+class AssetPackage {
+ public:
+  AssetPackage() = default;
+  AssetPackage(const AssetPackage&) = delete;
+  AssetPackage& operator=(const AssetPackage&) = delete;
+
+  bool Open(const char* path);
+  void Close();
+
+  // nullptr if there is no such entry.
+  const AssetEntry* Find(const char* name) const;
+  const AssetEntry* Find(const char* name, size_t size) const;
+
+  const char* name(const AssetEntry& entry) const {
+    return names_ + entry.name_offset;
+  }
+  // The stored payload, compressed or not.
+  const uint8_t* data(const AssetEntry& entry) const {
+    return file_.data() + entry.data_offset;
+  }
+
+  const AssetEntry* entries() const { return entries_; }
+  uint32_t entry_count() const { return entry_count_; }
+  const MappedFile& file() const { return file_; }
+
+ private:
+  bool Validate();
+
+  MappedFile file_;
+  const AssetEntry* entries_{nullptr};
+  uint32_t entry_count_{0};
+  const uint32_t* slots_{nullptr};
+  uint32_t slot_mask_{0};
+  const char* names_{nullptr};
+};
+
+// A request staging the entry's payload, decompressing it on job_system
+// when given. Set record to copy it out with StreamingCopyQueue::CopyTexture,
+// taking the footprints of all GetAssetSubresourceCount subresources of
+// GetAssetDesc, or CopyBuffer.
+StreamRequest MakeAssetRequest(const AssetPackage& package,
+                               const AssetEntry& entry,
+                               JobSystem* job_system = nullptr);
+
+}  // namespace d3dapp
+
+#endif  // !__ASSET_PACKAGE_H__
@@ -0,0 +1,193 @@
+#include "asset_package_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "chunked_lz.h"
+#include "footprint_cache.h"
+#include "subresource_copy.h"
+
+namespace {
+// Delta strides tried for each payload: none, 16-bit and 32-bit texels.
+constexpr uint32_t kDeltaStrides[] = {0, 2, 4};
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+namespace d3dapp {
+AssetPackageWriter::AssetPackageWriter(JobSystem* job_system, bool compress)
+    : job_system_{job_system}, compress_{compress} {}
+
+bool AssetPackageWriter::AddBuffer(const char* name, const void* data,
+                                   uint64_t size) {
+  AssetEntry entry{};
+  entry.type = AssetEntry::kBuffer;
+  entry.data_size = size;
+  if (!AddEntry(name, &entry)) {
+    return false;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  AddPayload(std::vector<uint8_t>(bytes, bytes + size));
+  return true;
+}
+
+bool AssetPackageWriter::AddTexture(const char* name,
+                                    const D3D12_RESOURCE_DESC& desc,
+                                    const D3D12_SUBRESOURCE_DATA* data,
+                                    const BlockCompression* compression) {
+  AssetEntry entry{};
+  entry.type = AssetEntry::kTexture;
+  entry.dimension = desc.Dimension;
+  entry.format = desc.Format;
+  entry.width = desc.Width;
+  entry.height = desc.Height;
+  entry.depth_or_array_size = desc.DepthOrArraySize;
+  entry.mip_levels = desc.MipLevels;
+  UINT subresource_count = GetAssetSubresourceCount(entry);
+  if (D3D12_RESOURCE_DIMENSION_BUFFER == desc.Dimension ||
+      0 == subresource_count) {
+    return false;
+  }
+  std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresource_count);
+  std::vector<UINT> row_counts(subresource_count);
+  std::vector<UINT64> row_sizes(subresource_count);
+  if (!CalculateFootprints(desc, 0, subresource_count, 0, layouts.data(),
+                           row_counts.data(), row_sizes.data(),
+                           &entry.data_size) ||
+      !AddEntry(name, &entry)) {
+    return false;
+  }
+
+  std::vector<uint8_t> payload(static_cast<size_t>(entry.data_size));
+  for (UINT i = 0; i < subresource_count; ++i) {
+    const D3D12_SUBRESOURCE_FOOTPRINT& footprint = layouts[i].Footprint;
+    size_t row_pitch = footprint.RowPitch;
+    size_t slice_pitch = row_pitch * row_counts[i];
+    uint8_t* dest = payload.data() + layouts[i].Offset;
+    if (compression) {
+      // Footprints of block compressed formats round up to whole blocks.
+      UINT mip = i % desc.MipLevels;
+      UINT width = std::max(static_cast<UINT>(desc.Width >> mip), 1u);
+      UINT height = std::max(desc.Height >> mip, 1u);
+      for (UINT slice = 0; slice < footprint.Depth; ++slice) {
+        CompressImage(*compression,
+                      static_cast<const uint8_t*>(data[i].pData) +
+                          static_cast<size_t>(data[i].SlicePitch) * slice,
+                      static_cast<size_t>(data[i].RowPitch), width, height,
+                      dest + slice_pitch * slice, row_pitch, job_system_);
+      }
+    } else {
+      SubresourceCopy copy{dest,
+                           row_pitch,
+                           slice_pitch,
+                           data[i].pData,
+                           static_cast<size_t>(data[i].RowPitch),
+                           static_cast<size_t>(data[i].SlicePitch),
+                           static_cast<size_t>(row_sizes[i]),
+                           row_counts[i],
+                           footprint.Depth};
+      CopySubresource(copy, job_system_);
+    }
+  }
+  AddPayload(std::move(payload));
+  return true;
+}
+
+bool AssetPackageWriter::AddEntry(const char* name, AssetEntry* entry) {
+  size_t size = std::strlen(name);
+  uint64_t hash = HashAssetName(name, size);
+  for (const AssetEntry& other : entries_) {
+    if (other.name_hash == hash && other.name_size == size &&
+        0 == names_.compare(other.name_offset, size, name)) {
+      return false;
+    }
+  }
+  entry->name_hash = hash;
+  entry->name_offset = static_cast<uint32_t>(names_.size());
+  entry->name_size = static_cast<uint32_t>(size);
+  entry->stored_size = entry->data_size;
+  names_.append(name, size + 1);
+  entries_.push_back(*entry);
+  return true;
+}
+
+void AssetPackageWriter::AddPayload(std::vector<uint8_t> payload) {
+  AssetEntry& entry = entries_.back();
+  if (compress_) {
+    // Keeps the smallest, which must beat storing the payload as is.
+    std::vector<uint8_t> best, compressed;
+    for (uint32_t delta_stride : kDeltaStrides) {
+      CompressChunked(payload.data(), payload.size(), delta_stride,
+                      &compressed, job_system_);
+      if (compressed.size() < payload.size() &&
+          (best.empty() || compressed.size() < best.size())) {
+        best.swap(compressed);
+      }
+    }
+    if (!best.empty()) {
+      entry.compression = AssetEntry::kChunkedLz;
+      entry.stored_size = best.size();
+      payload.swap(best);
+    }
+  }
+  payloads_.push_back(std::move(payload));
+}
+
+bool AssetPackageWriter::Write(const char* path) const {
+  uint32_t entry_count = static_cast<uint32_t>(entries_.size());
+  uint32_t slot_count = 1;
+  while (slot_count < entry_count * 2 || slot_count <= entry_count) {
+    slot_count *= 2;
+  }
+  std::vector<uint32_t> slots(slot_count);
+  for (uint32_t i = 0; i < entry_count; ++i) {
+    uint32_t slot = static_cast<uint32_t>(entries_[i].name_hash);
+    while (0 != slots[slot & (slot_count - 1)]) {
+      ++slot;
+    }
+    slots[slot & (slot_count - 1)] = i + 1;
+  }
+
+  AssetPackageHeader header{};
+  header.magic = AssetPackageHeader::kMagic;
+  header.version = AssetPackageHeader::kVersion;
+  header.entry_count = entry_count;
+  header.slot_count = slot_count;
+  header.entries_offset = sizeof(AssetPackageHeader);
+  header.slots_offset =
+      header.entries_offset + uint64_t{entry_count} * sizeof(AssetEntry);
+  header.names_offset =
+      header.slots_offset + uint64_t{slot_count} * sizeof(uint32_t);
+  header.names_size = names_.size();
+
+  std::vector<AssetEntry> entries = entries_;
+  uint64_t offset = header.names_offset + header.names_size;
+  for (AssetEntry& entry : entries) {
+    entry.data_offset =
+        AlignUp(offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    offset = entry.data_offset + entry.stored_size;
+  }
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(entries.data()),
+             entries.size() * sizeof(AssetEntry));
+  file.write(reinterpret_cast<const char*>(slots.data()),
+             slots.size() * sizeof(uint32_t));
+  file.write(names_.data(), names_.size());
+  offset = header.names_offset + header.names_size;
+  const char padding[D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT] = {};
+  for (size_t i = 0; i < entries.size(); ++i) {
+    file.write(padding, entries[i].data_offset - offset);
+    file.write(reinterpret_cast<const char*>(payloads_[i].data()),
+               payloads_[i].size());
+    offset = entries[i].data_offset + entries[i].stored_size;
+  }
+  return static_cast<bool>(file.flush());
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef __ASSET_PACKAGE_WRITER_H__
+#define __ASSET_PACKAGE_WRITER_H__
+
+#include <d3dx12.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "asset_package.h"
+#include "block_compression.h"
+#include "framework.h"
+
+namespace d3dapp {
+class JobSystem;
+
+// Builds an AssetPackage in memory, laying out texture subresources at
+// their placed footprints. Needs no device.
+class AssetPackageWriter {
+ public:
+  // Compression and large copies are spread over job_system when one is
+  // given. With compress, payloads are stored with CompressChunked when
+  // that makes them smaller.
+  explicit AssetPackageWriter(JobSystem* job_system = nullptr,
+                              bool compress = false);
+  AssetPackageWriter(const AssetPackageWriter&) = delete;
+  AssetPackageWriter& operator=(const AssetPackageWriter&) = delete;
+
+  // Both return false for names already added.
+  bool AddBuffer(const char* name, const void* data, uint64_t size);
+  // data holds every subresource of desc in subresource order. With a
+  // compression, data is RGBA8 and desc.Format the matching BC format.
+  // Returns false for descs CalculateFootprints does not support.
+  bool AddTexture(const char* name, const D3D12_RESOURCE_DESC& desc,
+                  const D3D12_SUBRESOURCE_DATA* data,
+                  const BlockCompression* compression = nullptr);
+
+  bool Write(const char* path) const;
+
+  size_t entry_count() const { return entries_.size(); }
+
+ private:
+  bool AddEntry(const char* name, AssetEntry* entry);
+  // Of the last entry added.
+  void AddPayload(std::vector<uint8_t> payload);
+
+  JobSystem* job_system_{nullptr};
+  bool compress_{false};
+  std::vector<AssetEntry> entries_;
+  std::vector<std::vector<uint8_t>> payloads_;
+  std::string names_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__ASSET_PACKAGE_WRITER_H__
@@ -0,0 +1,697 @@
+#include "block_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define D3DAPP_SSE2 1
+#endif
+
+#include "job_system.h"
+
+namespace {
+constexpr int kBlockTexels = 16;
+constexpr int kPowerIterations = 8;
+constexpr int kRefineIterations = 3;
+constexpr int kSearchPasses = 4;
+
+constexpr int kBc1Levels = 4;
+constexpr int kBc4Levels = 8;
+constexpr int kBc7Levels = 16;
+constexpr int kBc7Mode6 = 1 << 6;
+
+// Texels of a block by channel.
+struct Texels {
+  alignas(16) float channel[4][kBlockTexels];
+};
+
+void LoadBlock(const uint8_t* source, size_t row_pitch, uint32_t x,
+               uint32_t y, uint32_t width, uint32_t height, Texels* texels) {
+  for (int i = 0; i < kBlockTexels; ++i) {
+    uint32_t texel_x = std::min<uint32_t>(x + (i & 3), width - 1);
+    uint32_t texel_y = std::min<uint32_t>(y + (i >> 2), height - 1);
+    const uint8_t* texel = source + row_pitch * texel_y + texel_x * 4;
+    for (int c = 0; c < 4; ++c) {
+      texels->channel[c][i] = texel[c];
+    }
+  }
+}
+
+float Clamp(float value, float low, float high) {
+  return std::min(std::max(value, low), high);
+}
+
+// Picks for each texel the nearest of levels points spread evenly from e0
+// to e1, looking at channel_count channels from first_channel. indices run
+// from 0 at e0 to levels - 1 at e1. Returns the squared error.
+float FitSegment(const Texels& texels, int first_channel, int channel_count,
+                 const float* e0, const float* e1, int levels,
+                 int* indices) {
+  float direction[4];
+  float length2 = 0.0f;
+  for (int c = 0; c < channel_count; ++c) {
+    direction[c] = e1[c] - e0[c];
+    length2 += direction[c] * direction[c];
+  }
+  float last = static_cast<float>(levels - 1);
+  float scale = length2 > 0.0f ? last / length2 : 0.0f;
+  const float(*channel)[kBlockTexels] = texels.channel + first_channel;
+
+#if D3DAPP_SSE2
+  __m128 error = _mm_setzero_ps();
+  for (int i = 0; i < kBlockTexels; i += 4) {
+    __m128 t = _mm_setzero_ps();
+    for (int c = 0; c < channel_count; ++c) {
+      __m128 offset =
+          _mm_sub_ps(_mm_load_ps(channel[c] + i), _mm_set1_ps(e0[c]));
+      t = _mm_add_ps(t, _mm_mul_ps(offset, _mm_set1_ps(direction[c])));
+    }
+    t = _mm_mul_ps(t, _mm_set1_ps(scale));
+    t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(last));
+    __m128i index = _mm_cvtps_epi32(t);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices + i), index);
+
+    __m128 weight = _mm_mul_ps(_mm_cvtepi32_ps(index),
+                               _mm_set1_ps(1.0f / last));
+    for (int c = 0; c < channel_count; ++c) {
+      __m128 value = _mm_add_ps(
+          _mm_set1_ps(e0[c]), _mm_mul_ps(weight, _mm_set1_ps(direction[c])));
+      __m128 difference = _mm_sub_ps(value, _mm_load_ps(channel[c] + i));
+      error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+    }
+  }
+  alignas(16) float sums[4];
+  _mm_store_ps(sums, error);
+  return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+  float error = 0.0f;
+  for (int i = 0; i < kBlockTexels; ++i) {
+    float t = 0.0f;
+    for (int c = 0; c < channel_count; ++c) {
+      t += (channel[c][i] - e0[c]) * direction[c];
+    }
+    indices[i] = static_cast<int>(Clamp(t * scale, 0.0f, last) + 0.5f);
+    float weight = indices[i] / last;
+    for (int c = 0; c < channel_count; ++c) {
+      float difference = e0[c] + weight * direction[c] - channel[c][i];
+      error += difference * difference;
+    }
+  }
+  return error;
+#endif
+}
+
+// Least squares endpoints for the given indices. False when every texel
+// uses the same index.
+bool RefineSegment(const Texels& texels, int first_channel,
+                   int channel_count, int levels, const int* indices,
+                   float* e0, float* e1) {
+  float a = 0.0f;
+  float b = 0.0f;
+  float c = 0.0f;
+  float x[4] = {};
+  float y[4] = {};
+  for (int i = 0; i < kBlockTexels; ++i) {
+    float w1 = static_cast<float>(indices[i]) / (levels - 1);
+    float w0 = 1.0f - w1;
+    a += w0 * w0;
+    b += w0 * w1;
+    c += w1 * w1;
+    for (int ch = 0; ch < channel_count; ++ch) {
+      float value = texels.channel[first_channel + ch][i];
+      x[ch] += w0 * value;
+      y[ch] += w1 * value;
+    }
+  }
+  float determinant = a * c - b * b;
+  if (std::fabs(determinant) < 1e-6f) {
+    return false;
+  }
+  for (int ch = 0; ch < channel_count; ++ch) {
+    e0[ch] = Clamp((x[ch] * c - y[ch] * b) / determinant, 0.0f, 255.0f);
+    e1[ch] = Clamp((y[ch] * a - x[ch] * b) / determinant, 0.0f, 255.0f);
+  }
+  return true;
+}
+
+// Ends of the texels' extent along their principal axis.
+void FindEndpoints(const Texels& texels, int first_channel,
+                   int channel_count, float* e0, float* e1) {
+  const float(*channel)[kBlockTexels] = texels.channel + first_channel;
+  float mean[4] = {};
+  float axis[4] = {};
+  for (int c = 0; c < channel_count; ++c) {
+    float low = 255.0f;
+    float high = 0.0f;
+    for (int i = 0; i < kBlockTexels; ++i) {
+      mean[c] += channel[c][i];
+      low = std::min(low, channel[c][i]);
+      high = std::max(high, channel[c][i]);
+    }
+    mean[c] /= kBlockTexels;
+    axis[c] = high - low;
+  }
+
+  float covariance[4][4] = {};
+  for (int i = 0; i < kBlockTexels; ++i) {
+    for (int c = 0; c < channel_count; ++c) {
+      for (int d = c; d < channel_count; ++d) {
+        covariance[c][d] +=
+            (channel[c][i] - mean[c]) * (channel[d][i] - mean[d]);
+      }
+    }
+  }
+  for (int c = 0; c < channel_count; ++c) {
+    for (int d = 0; d < c; ++d) {
+      covariance[c][d] = covariance[d][c];
+    }
+  }
+
+  // Power iteration from the bounding box diagonal.
+  for (int iteration = 0; iteration < kPowerIterations; ++iteration) {
+    float next[4] = {};
+    float largest = 0.0f;
+    for (int c = 0; c < channel_count; ++c) {
+      for (int d = 0; d < channel_count; ++d) {
+        next[c] += covariance[c][d] * axis[d];
+      }
+      largest = std::max(largest, std::fabs(next[c]));
+    }
+    if (largest <= 0.0f) {
+      break;
+    }
+    for (int c = 0; c < channel_count; ++c) {
+      axis[c] = next[c] / largest;
+    }
+  }
+  float length2 = 0.0f;
+  for (int c = 0; c < channel_count; ++c) {
+    length2 += axis[c] * axis[c];
+  }
+  if (length2 <= 0.0f) {
+    std::copy(mean, mean + channel_count, e0);
+    std::copy(mean, mean + channel_count, e1);
+    return;
+  }
+
+  float low = 0.0f;
+  float high = 0.0f;
+  for (int i = 0; i < kBlockTexels; ++i) {
+    float t = 0.0f;
+    for (int c = 0; c < channel_count; ++c) {
+      t += (channel[c][i] - mean[c]) * axis[c];
+    }
+    low = std::min(low, t);
+    high = std::max(high, t);
+  }
+  for (int c = 0; c < channel_count; ++c) {
+    e0[c] = Clamp(mean[c] + axis[c] * low / length2, 0.0f, 255.0f);
+    e1[c] = Clamp(mean[c] + axis[c] * high / length2, 0.0f, 255.0f);
+  }
+}
+
+uint16_t Pack565(const float* color) {
+  int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+  int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+  int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+  return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+void Unpack565(uint16_t packed, float* color) {
+  int r = packed >> 11;
+  int g = (packed >> 5) & 63;
+  int b = packed & 31;
+  color[0] = static_cast<float>(r << 3 | r >> 2);
+  color[1] = static_cast<float>(g << 2 | g >> 4);
+  color[2] = static_cast<float>(b << 3 | b >> 2);
+}
+
+// Greedy search of single steps of each endpoint channel.
+float SearchBc1(const Texels& texels, uint16_t* color0, uint16_t* color1,
+                int* indices, float error) {
+  static const int kShift[3] = {11, 5, 0};
+  static const int kMax[3] = {31, 63, 31};
+  bool improved = true;
+  for (int pass = 0; improved && pass < kSearchPasses; ++pass) {
+    improved = false;
+    for (int candidate = 0; candidate < 12; ++candidate) {
+      int c = candidate >> 2;
+      uint16_t colors[2] = {*color0, *color1};
+      uint16_t& color = colors[(candidate >> 1) & 1];
+      int value = ((color >> kShift[c]) & kMax[c]) + (candidate & 1 ? 1 : -1);
+      if (value < 0 || value > kMax[c]) {
+        continue;
+      }
+      color = static_cast<uint16_t>((color & ~(kMax[c] << kShift[c])) |
+                                    value << kShift[c]);
+      float e0[3];
+      float e1[3];
+      Unpack565(colors[0], e0);
+      Unpack565(colors[1], e1);
+      int candidate_indices[kBlockTexels];
+      float candidate_error =
+          FitSegment(texels, 0, 3, e0, e1, kBc1Levels, candidate_indices);
+      if (candidate_error < error) {
+        error = candidate_error;
+        *color0 = colors[0];
+        *color1 = colors[1];
+        std::copy(candidate_indices, candidate_indices + kBlockTexels,
+                  indices);
+        improved = true;
+      }
+    }
+  }
+  return error;
+}
+
+// Color block as used by BC1 and BC3, always in four color mode.
+void EncodeBc1(const Texels& texels, bool high, uint8_t* block) {
+  float e0[3];
+  float e1[3];
+  FindEndpoints(texels, 0, 3, e0, e1);
+  uint16_t color0 = Pack565(e0);
+  uint16_t color1 = Pack565(e1);
+  Unpack565(color0, e0);
+  Unpack565(color1, e1);
+  int indices[kBlockTexels];
+  float error = FitSegment(texels, 0, 3, e0, e1, kBc1Levels, indices);
+
+  for (int i = 0; high && i < kRefineIterations; ++i) {
+    if (!RefineSegment(texels, 0, 3, kBc1Levels, indices, e0, e1)) {
+      break;
+    }
+    uint16_t refined0 = Pack565(e0);
+    uint16_t refined1 = Pack565(e1);
+    Unpack565(refined0, e0);
+    Unpack565(refined1, e1);
+    int refined_indices[kBlockTexels];
+    float refined_error =
+        FitSegment(texels, 0, 3, e0, e1, kBc1Levels, refined_indices);
+    if (refined_error >= error) {
+      break;
+    }
+    error = refined_error;
+    color0 = refined0;
+    color1 = refined1;
+    std::copy(refined_indices, refined_indices + kBlockTexels, indices);
+  }
+  if (high) {
+    SearchBc1(texels, &color0, &color1, indices, error);
+  }
+
+  // Four color mode needs color0 > color1; swapping the ends swaps palette
+  // entries 0 and 1, and 2 and 3.
+  static const uint32_t kPalette[kBc1Levels] = {0, 2, 3, 1};
+  uint32_t flip = 0;
+  if (color0 < color1) {
+    std::swap(color0, color1);
+    flip = 1;
+  }
+  uint32_t bits = 0;
+  if (color0 != color1) {
+    for (int i = 0; i < kBlockTexels; ++i) {
+      bits |= (kPalette[indices[i]] ^ flip) << (i * 2);
+    }
+  }
+  block[0] = static_cast<uint8_t>(color0);
+  block[1] = static_cast<uint8_t>(color0 >> 8);
+  block[2] = static_cast<uint8_t>(color1);
+  block[3] = static_cast<uint8_t>(color1 >> 8);
+  memcpy(block + 4, &bits, sizeof(bits));
+}
+
+// Eight level mode keeps e0 above e1.
+float SearchBc4(const Texels& texels, int channel, int* e0, int* e1,
+                int* segment, float error) {
+  bool improved = true;
+  for (int pass = 0; improved && pass < kSearchPasses; ++pass) {
+    improved = false;
+    for (int candidate = 0; candidate < 4; ++candidate) {
+      int endpoints[2] = {*e0, *e1};
+      int& value = endpoints[candidate >> 1];
+      value += candidate & 1 ? 1 : -1;
+      if (value < 0 || value > 255 || endpoints[0] <= endpoints[1]) {
+        continue;
+      }
+      float f0 = static_cast<float>(endpoints[0]);
+      float f1 = static_cast<float>(endpoints[1]);
+      int candidate_segment[kBlockTexels];
+      float candidate_error = FitSegment(texels, channel, 1, &f0, &f1,
+                                         kBc4Levels, candidate_segment);
+      if (candidate_error < error) {
+        error = candidate_error;
+        *e0 = endpoints[0];
+        *e1 = endpoints[1];
+        std::copy(candidate_segment, candidate_segment + kBlockTexels,
+                  segment);
+        improved = true;
+      }
+    }
+  }
+  return error;
+}
+
+float Bc4Value(int e0, int e1, int index) {
+  if (index < 2) {
+    return static_cast<float>(0 == index ? e0 : e1);
+  }
+  if (e0 > e1) {
+    return static_cast<float>(((8 - index) * e0 + (index - 1) * e1 + 3) / 7);
+  }
+  if (index < 6) {
+    return static_cast<float>(((6 - index) * e0 + (index - 1) * e1 + 2) / 5);
+  }
+  return 6 == index ? 0.0f : 255.0f;
+}
+
+// Maps a segment index to a BC4 palette index.
+int Bc4Index(int index, int levels) {
+  if (0 == index) {
+    return 0;
+  }
+  return levels - 1 == index ? 1 : index + 1;
+}
+
+// Six level mode, with exact 0 and 255 for the texels at the extremes.
+float FitBc4Extremes(const Texels& texels, int channel, int* e0, int* e1,
+                     int* indices) {
+  const float* values = texels.channel[channel];
+  float low = 255.0f;
+  float high = 0.0f;
+  for (int i = 0; i < kBlockTexels; ++i) {
+    if (values[i] > 0.0f && values[i] < 255.0f) {
+      low = std::min(low, values[i]);
+      high = std::max(high, values[i]);
+    }
+  }
+  if (low > high) {
+    low = high = 0.0f;
+  }
+  *e0 = static_cast<int>(low);
+  *e1 = static_cast<int>(high);
+
+  float error = 0.0f;
+  for (int i = 0; i < kBlockTexels; ++i) {
+    float best_error = 1e30f;
+    for (int index = 0; index < kBc4Levels; ++index) {
+      float difference = Bc4Value(*e0, *e1, index) - values[i];
+      if (difference * difference < best_error) {
+        best_error = difference * difference;
+        indices[i] = index;
+      }
+    }
+    error += best_error;
+  }
+  return error;
+}
+
+void EncodeBc4(const Texels& texels, int channel, bool high,
+               uint8_t* block) {
+  const float* values = texels.channel[channel];
+  float low = 255.0f;
+  float top = 0.0f;
+  for (int i = 0; i < kBlockTexels; ++i) {
+    low = std::min(low, values[i]);
+    top = std::max(top, values[i]);
+  }
+  // Eight level mode, from e0 at the top down to e1.
+  int e0 = static_cast<int>(top);
+  int e1 = static_cast<int>(low);
+  float f0 = static_cast<float>(e0);
+  float f1 = static_cast<float>(e1);
+  int segment[kBlockTexels];
+  float error = FitSegment(texels, channel, 1, &f0, &f1, kBc4Levels, segment);
+
+  for (int i = 0; high && i < kRefineIterations && e0 > e1; ++i) {
+    if (!RefineSegment(texels, channel, 1, kBc4Levels, segment, &f0, &f1)) {
+      break;
+    }
+    int refined0 = static_cast<int>(f0 + 0.5f);
+    int refined1 = static_cast<int>(f1 + 0.5f);
+    if (refined0 < refined1) {
+      std::swap(refined0, refined1);
+    }
+    if (refined0 == refined1) {
+      break;
+    }
+    f0 = static_cast<float>(refined0);
+    f1 = static_cast<float>(refined1);
+    int refined_segment[kBlockTexels];
+    float refined_error = FitSegment(texels, channel, 1, &f0, &f1,
+                                     kBc4Levels, refined_segment);
+    if (refined_error >= error) {
+      break;
+    }
+    error = refined_error;
+    e0 = refined0;
+    e1 = refined1;
+    std::copy(refined_segment, refined_segment + kBlockTexels, segment);
+  }
+  if (high && e0 > e1) {
+    error = SearchBc4(texels, channel, &e0, &e1, segment, error);
+  }
+
+  int indices[kBlockTexels];
+  for (int i = 0; i < kBlockTexels; ++i) {
+    indices[i] = e0 > e1 ? Bc4Index(segment[i], kBc4Levels) : 0;
+  }
+  if (high && (0.0f == low || 255.0f == top) && e0 > e1) {
+    int extreme0;
+    int extreme1;
+    int extreme_indices[kBlockTexels];
+    if (FitBc4Extremes(texels, channel, &extreme0, &extreme1,
+                       extreme_indices) < error) {
+      e0 = extreme0;
+      e1 = extreme1;
+      std::copy(extreme_indices, extreme_indices + kBlockTexels, indices);
+    }
+  }
+
+  uint64_t bits = 0;
+  for (int i = 0; i < kBlockTexels; ++i) {
+    bits |= static_cast<uint64_t>(indices[i]) << (i * 3);
+  }
+  block[0] = static_cast<uint8_t>(e0);
+  block[1] = static_cast<uint8_t>(e1);
+  for (int i = 0; i < 6; ++i) {
+    block[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+  }
+}
+
+// A BC7 mode 6 endpoint: 7 bits per channel and a shared parity bit.
+struct Bc7Endpoint {
+  int channel[4];
+  int parity;
+};
+
+float QuantizeBc7(const float* color, int parity, Bc7Endpoint* endpoint) {
+  endpoint->parity = parity;
+  float error = 0.0f;
+  for (int c = 0; c < 4; ++c) {
+    int value = static_cast<int>((color[c] - parity) * 0.5f + 0.5f);
+    endpoint->channel[c] = std::min(std::max(value, 0), 127);
+    float difference = (endpoint->channel[c] << 1 | parity) - color[c];
+    error += difference * difference;
+  }
+  return error;
+}
+
+Bc7Endpoint QuantizeBc7(const float* color) {
+  Bc7Endpoint even;
+  Bc7Endpoint odd;
+  return QuantizeBc7(color, 0, &even) <= QuantizeBc7(color, 1, &odd) ? even
+                                                                     : odd;
+}
+
+void ExpandBc7(const Bc7Endpoint& endpoint, float* color) {
+  for (int c = 0; c < 4; ++c) {
+    color[c] =
+        static_cast<float>(endpoint.channel[c] << 1 | endpoint.parity);
+  }
+}
+
+float FitBc7(const Texels& texels, const Bc7Endpoint& endpoint0,
+             const Bc7Endpoint& endpoint1, int* indices) {
+  float e0[4];
+  float e1[4];
+  ExpandBc7(endpoint0, e0);
+  ExpandBc7(endpoint1, e1);
+  return FitSegment(texels, 0, 4, e0, e1, kBc7Levels, indices);
+}
+
+class BitWriter {
+ public:
+  explicit BitWriter(uint8_t* data) : data_{data} {}
+
+  void Write(uint32_t value, int count) {
+    for (int i = 0; i < count; ++i, ++position_) {
+      data_[position_ >> 3] |=
+          static_cast<uint8_t>(((value >> i) & 1) << (position_ & 7));
+    }
+  }
+
+ private:
+  uint8_t* data_;
+  int position_{0};
+};
+
+float SearchBc7(const Texels& texels, Bc7Endpoint* endpoint0,
+                Bc7Endpoint* endpoint1, int* indices, float error) {
+  bool improved = true;
+  for (int pass = 0; improved && pass < kSearchPasses; ++pass) {
+    improved = false;
+    for (int candidate = 0; candidate < 16; ++candidate) {
+      Bc7Endpoint endpoints[2] = {*endpoint0, *endpoint1};
+      int& value = endpoints[(candidate >> 1) & 1].channel[candidate >> 2];
+      value += candidate & 1 ? 1 : -1;
+      if (value < 0 || value > 127) {
+        continue;
+      }
+      int candidate_indices[kBlockTexels];
+      float candidate_error =
+          FitBc7(texels, endpoints[0], endpoints[1], candidate_indices);
+      if (candidate_error < error) {
+        error = candidate_error;
+        *endpoint0 = endpoints[0];
+        *endpoint1 = endpoints[1];
+        std::copy(candidate_indices, candidate_indices + kBlockTexels,
+                  indices);
+        improved = true;
+      }
+    }
+  }
+  return error;
+}
+
+void EncodeBc7(const Texels& texels, bool high, uint8_t* block) {
+  float e0[4];
+  float e1[4];
+  FindEndpoints(texels, 0, 4, e0, e1);
+  Bc7Endpoint endpoint0 = QuantizeBc7(e0);
+  Bc7Endpoint endpoint1 = QuantizeBc7(e1);
+  int indices[kBlockTexels];
+  float error = FitBc7(texels, endpoint0, endpoint1, indices);
+
+  for (int i = 0; high && i < kRefineIterations; ++i) {
+    if (!RefineSegment(texels, 0, 4, kBc7Levels, indices, e0, e1)) {
+      break;
+    }
+    // Every parity pair, since the nearest one per endpoint need not give
+    // the nearest segment.
+    float best_error = error;
+    for (int parity = 0; parity < 4; ++parity) {
+      Bc7Endpoint refined0;
+      Bc7Endpoint refined1;
+      QuantizeBc7(e0, parity & 1, &refined0);
+      QuantizeBc7(e1, parity >> 1, &refined1);
+      int refined_indices[kBlockTexels];
+      float refined_error =
+          FitBc7(texels, refined0, refined1, refined_indices);
+      if (refined_error < best_error) {
+        best_error = refined_error;
+        endpoint0 = refined0;
+        endpoint1 = refined1;
+        std::copy(refined_indices, refined_indices + kBlockTexels, indices);
+      }
+    }
+    if (best_error >= error) {
+      break;
+    }
+    error = best_error;
+  }
+  if (high) {
+    SearchBc7(texels, &endpoint0, &endpoint1, indices, error);
+  }
+
+  // The first texel's index drops its top bit, so it must be below 8.
+  if (indices[0] >= kBc7Levels / 2) {
+    std::swap(endpoint0, endpoint1);
+    for (int i = 0; i < kBlockTexels; ++i) {
+      indices[i] = kBc7Levels - 1 - indices[i];
+    }
+  }
+
+  memset(block, 0, 16);
+  BitWriter writer{block};
+  writer.Write(kBc7Mode6, 7);
+  for (int c = 0; c < 4; ++c) {
+    writer.Write(endpoint0.channel[c], 7);
+    writer.Write(endpoint1.channel[c], 7);
+  }
+  writer.Write(endpoint0.parity, 1);
+  writer.Write(endpoint1.parity, 1);
+  writer.Write(indices[0], 3);
+  for (int i = 1; i < kBlockTexels; ++i) {
+    writer.Write(indices[i], 4);
+  }
+}
+
+void CompressBlock(const d3dapp::BlockCompression& compression,
+                   const Texels& texels, uint8_t* block) {
+  bool high = d3dapp::BlockCompression::kHigh == compression.quality;
+  switch (compression.format) {
+    case d3dapp::BlockCompression::kBc1:
+      EncodeBc1(texels, high, block);
+      break;
+    case d3dapp::BlockCompression::kBc3:
+      EncodeBc4(texels, 3, high, block);
+      EncodeBc1(texels, high, block + 8);
+      break;
+    case d3dapp::BlockCompression::kBc4:
+      EncodeBc4(texels, 0, high, block);
+      break;
+    case d3dapp::BlockCompression::kBc5:
+      EncodeBc4(texels, 0, high, block);
+      EncodeBc4(texels, 1, high, block + 8);
+      break;
+    case d3dapp::BlockCompression::kBc7:
+      EncodeBc7(texels, high, block);
+      break;
+  }
+}
+
+}  // namespace
+
+namespace d3dapp {
+size_t BlockSize(BlockCompression::Format format) {
+  return BlockCompression::kBc1 == format || BlockCompression::kBc4 == format
+             ? 8
+             : 16;
+}
+
+void CompressImage(const BlockCompression& compression, const void* source,
+                   size_t source_row_pitch, uint32_t width, uint32_t height,
+                   void* dest, size_t dest_row_pitch,
+                   JobSystem* job_system) {
+  if (0 == width || 0 == height) {
+    return;
+  }
+  uint32_t blocks_wide = (width + 3) / 4;
+  uint32_t blocks_high = (height + 3) / 4;
+  size_t block_size = BlockSize(compression.format);
+  // Blocks are encoded on the stack since dest may be write combined.
+  auto compress_rows = [&](size_t first, size_t last) {
+    Texels texels;
+    uint8_t block[16];
+    for (size_t y = first; y < last; ++y) {
+      uint8_t* row = static_cast<uint8_t*>(dest) + dest_row_pitch * y;
+      for (uint32_t x = 0; x < blocks_wide; ++x) {
+        LoadBlock(static_cast<const uint8_t*>(source), source_row_pitch,
+                  x * 4, static_cast<uint32_t>(y) * 4, width, height,
+                  &texels);
+        CompressBlock(compression, texels, block);
+        memcpy(row + block_size * x, block, block_size);
+      }
+    }
+  };
+
+  if (job_system && job_system->thread_count() > 1 && blocks_high > 1) {
+    job_system->ParallelFor(0, blocks_high, 1, compress_rows);
+  } else {
+    compress_rows(0, blocks_high);
+  }
+}
+
+}  // namespace d3dapp
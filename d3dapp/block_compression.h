@@ -0,0 +1,50 @@
+#pragma once
+
+#ifndef __BLOCK_COMPRESSION_H__
+#define __BLOCK_COMPRESSION_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace d3dapp {
+class JobSystem;
+
+struct BlockCompression {
+  enum Format {
+    // RGB; alpha is dropped.
+    kBc1,
+    kBc3,
+    // Red only.
+    kBc4,
+    // Red and green.
+    kBc5,
+    // RGBA in mode 6, which has a single subset. Partitioned modes are not
+    // searched.
+    kBc7,
+  };
+  enum Quality {
+    // One endpoint fit per block, for tiles generated at run time.
+    kFast,
+    // Refines endpoints by least squares and searches parity bits, for
+    // baking.
+    kHigh,
+  };
+
+  Format format;
+  Quality quality{kFast};
+};
+
+// Bytes per 4x4 block.
+size_t BlockSize(BlockCompression::Format format);
+
+// Compresses width x height RGBA8 texels into rows of blocks dest_row_pitch
+// apart. Partial blocks at the right and bottom edges repeat the last
+// column and row. Block rows are spread over job_system when one is given.
+void CompressImage(const BlockCompression& compression, const void* source,
+                   size_t source_row_pitch, uint32_t width, uint32_t height,
+                   void* dest, size_t dest_row_pitch,
+                   JobSystem* job_system = nullptr);
+
+}  // namespace d3dapp
+
+#endif  // !__BLOCK_COMPRESSION_H__
@@ -0,0 +1,112 @@
+#pragma once
+
+#ifndef __BUDDY_ALLOCATOR_H__
+#define __BUDDY_ALLOCATOR_H__
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace d3dapp {
+// Power-of-two blocks out of a power-of-two range. Every block is aligned to
+// its own size, so an alignment request is met by asking for a block at
+// least that large. Offset bookkeeping only; the heap allocator maps it onto
+// ID3D12Heap blocks.
+class BuddyAllocator {
+ public:
+  // size and min_block_size must be powers of two.
+  BuddyAllocator(uint64_t size, uint64_t min_block_size);
+
+  bool Allocate(uint64_t size, uint64_t alignment, uint64_t* offset,
+                uint32_t* order);
+  void Free(uint64_t offset, uint32_t order);
+
+  uint64_t size() const { return size_; }
+  uint64_t BlockSize(uint32_t order) const { return min_block_size_ << order; }
+  uint64_t free_size() const { return free_size_; }
+  uint64_t LargestFreeBlock() const;
+  bool empty() const { return free_size_ == size_; }
+
+ private:
+  uint32_t OrderOf(uint64_t size) const;
+
+  uint64_t size_;
+  uint64_t min_block_size_;
+  uint64_t free_size_;
+  uint32_t max_order_{0};
+  // Free block offsets per order, lowest address first.
+  std::vector<std::set<uint64_t>> free_;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+inline BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t min_block_size)
+    : size_{size}, min_block_size_{min_block_size}, free_size_{size} {
+  while (BlockSize(max_order_) < size) {
+    ++max_order_;
+  }
+  free_.resize(max_order_ + 1);
+  free_[max_order_].insert(0);
+}
+
+inline bool BuddyAllocator::Allocate(uint64_t size, uint64_t alignment,
+                                     uint64_t* offset, uint32_t* order) {
+  uint32_t wanted = OrderOf(size > alignment ? size : alignment);
+  if (wanted > max_order_) {
+    return false;
+  }
+
+  uint32_t found = wanted;
+  while (found <= max_order_ && free_[found].empty()) {
+    ++found;
+  }
+  if (found > max_order_) {
+    return false;
+  }
+
+  uint64_t block = *free_[found].begin();
+  free_[found].erase(free_[found].begin());
+  while (found > wanted) {
+    --found;
+    free_[found].insert(block + BlockSize(found));
+  }
+
+  free_size_ -= BlockSize(wanted);
+  *offset = block;
+  *order = wanted;
+  return true;
+}
+
+inline void BuddyAllocator::Free(uint64_t offset, uint32_t order) {
+  free_size_ += BlockSize(order);
+  while (order < max_order_) {
+    auto buddy = free_[order].find(offset ^ BlockSize(order));
+    if (buddy == free_[order].end()) {
+      break;
+    }
+    free_[order].erase(buddy);
+    offset &= ~BlockSize(order);
+    ++order;
+  }
+  free_[order].insert(offset);
+}
+
+inline uint64_t BuddyAllocator::LargestFreeBlock() const {
+  for (uint32_t order = max_order_ + 1; order > 0; --order) {
+    if (!free_[order - 1].empty()) {
+      return BlockSize(order - 1);
+    }
+  }
+  return 0;
+}
+
+inline uint32_t BuddyAllocator::OrderOf(uint64_t size) const {
+  uint32_t order = 0;
+  while (BlockSize(order) < size) {
+    ++order;
+  }
+  return order;
+}
+
+}  // namespace d3dapp
+
+#endif  // !__BUDDY_ALLOCATOR_H__
@@ -0,0 +1,499 @@
+#include "chunked_lz.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define D3DAPP_SSE2 1
+#endif
+
+#include "job_system.h"
+#include "subresource_copy.h"
+
+namespace {
+// Chunks are sequences of a token, literals, a 16-bit match offset and
+// the match length, as in LZ4. Token nibbles hold the literal count and the
+// match length minus kMinMatch; 15 continues in bytes added up until one
+// is below 255. The last sequence has literals only.
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashBits = 13;
+// Misses before the search starts skipping ahead, by powers of two.
+constexpr int kSkipShift = 5;
+// Decoding copies in 16-byte steps and may write this far past the end.
+constexpr size_t kDecodePadding = 32;
+
+constexpr uint64_t kChunkSize = d3dapp::ChunkedLzHeader::kChunkSize;
+
+uint32_t Read32(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint64_t Read64(const uint8_t* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t value) {
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+int CountTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+  unsigned long index;
+#if defined(_M_X64)
+  _BitScanForward64(&index, value);
+#else
+  if (!_BitScanForward(&index, static_cast<unsigned long>(value))) {
+    _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+    index += 32;
+  }
+#endif
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+// Bytes from a and b that match, up to end.
+size_t MatchLength(const uint8_t* a, const uint8_t* b, const uint8_t* end) {
+  const uint8_t* start = b;
+  while (b + 8 <= end) {
+    uint64_t diff = Read64(a) ^ Read64(b);
+    if (diff) {
+      return b - start + CountTrailingZeros(diff) / 8;
+    }
+    a += 8;
+    b += 8;
+  }
+  while (b < end && *a == *b) {
+    ++a;
+    ++b;
+  }
+  return b - start;
+}
+
+uint8_t* WriteLength(uint8_t* dest, size_t length) {
+  for (; length >= 255; length -= 255) {
+    *dest++ = 255;
+  }
+  *dest++ = static_cast<uint8_t>(length);
+  return dest;
+}
+
+uint8_t* WriteSequence(uint8_t* dest, const uint8_t* literals,
+                       size_t literal_count, size_t offset,
+                       size_t match_length) {
+  uint8_t* token = dest++;
+  if (literal_count >= 15) {
+    *token = 15 << 4;
+    dest = WriteLength(dest, literal_count - 15);
+  } else {
+    *token = static_cast<uint8_t>(literal_count << 4);
+  }
+  memcpy(dest, literals, literal_count);
+  dest += literal_count;
+  if (0 == match_length) {
+    return dest;
+  }
+
+  *dest++ = static_cast<uint8_t>(offset);
+  *dest++ = static_cast<uint8_t>(offset >> 8);
+  match_length -= kMinMatch;
+  if (match_length >= 15) {
+    *token |= 15;
+    dest = WriteLength(dest, match_length - 15);
+  } else {
+    *token |= static_cast<uint8_t>(match_length);
+  }
+  return dest;
+}
+
+size_t CompressBound(size_t size) { return size + size / 255 + 16; }
+
+// Greedy parse with a single-entry hash table, skipping ahead faster the
+// longer nothing matches. Returns the compressed size.
+size_t CompressChunk(const uint8_t* source, size_t size, uint8_t* dest) {
+  uint16_t table[1 << kHashBits] = {};
+  const uint8_t* end = source + size;
+  const uint8_t* anchor = source;
+  const uint8_t* p = source + 1;
+  uint8_t* out = dest;
+  int misses = 0;
+  while (p + kMinMatch <= end) {
+    uint32_t value = Read32(p);
+    uint32_t hash = Hash(value);
+    const uint8_t* candidate = source + table[hash];
+    table[hash] = static_cast<uint16_t>(p - source);
+    if (candidate >= p || static_cast<size_t>(p - candidate) > kMaxOffset ||
+        Read32(candidate) != value) {
+      p += 1 + (misses++ >> kSkipShift);
+      continue;
+    }
+    misses = 0;
+    while (p > anchor && candidate > source && p[-1] == candidate[-1]) {
+      --p;
+      --candidate;
+    }
+    size_t length =
+        kMinMatch + MatchLength(candidate + kMinMatch, p + kMinMatch, end);
+    out = WriteSequence(out, anchor, p - anchor, p - candidate, length);
+    p += length;
+    anchor = p;
+    if (p - 2 >= source && p + kMinMatch <= end) {
+      table[Hash(Read32(p - 2))] = static_cast<uint16_t>(p - 2 - source);
+    }
+  }
+  out = WriteSequence(out, anchor, end - anchor, 0, 0);
+  return out - dest;
+}
+
+bool ReadLength(const uint8_t** source, const uint8_t* end, size_t* length) {
+  uint8_t byte;
+  do {
+    if (*source == end || *length > kChunkSize) {
+      return false;
+    }
+    byte = *(*source)++;
+    *length += byte;
+  } while (255 == byte);
+  return true;
+}
+
+void Copy16(uint8_t* dest, const uint8_t* source) {
+  uint8_t bytes[16];
+  memcpy(bytes, source, 16);
+  memcpy(dest, bytes, 16);
+}
+
+// dest has kDecodePadding bytes to spare past size.
+bool DecodeChunk(const uint8_t* source, const uint8_t* source_end,
+                 uint8_t* dest, size_t size) {
+  uint8_t* out = dest;
+  uint8_t* out_end = dest + size;
+  for (;;) {
+    if (source == source_end) {
+      return false;
+    }
+    uint8_t token = *source++;
+    size_t literal_count = token >> 4;
+    if (15 == literal_count &&
+        !ReadLength(&source, source_end, &literal_count)) {
+      return false;
+    }
+    if (literal_count > static_cast<size_t>(source_end - source) ||
+        literal_count > static_cast<size_t>(out_end - out)) {
+      return false;
+    }
+    if (literal_count <= 16 && source_end - source >= 16) {
+      Copy16(out, source);
+    } else {
+      memcpy(out, source, literal_count);
+    }
+    out += literal_count;
+    source += literal_count;
+    if (source == source_end) {
+      return out == out_end;
+    }
+
+    if (source_end - source < 2) {
+      return false;
+    }
+    size_t offset = source[0] | (source[1] << 8);
+    source += 2;
+    size_t length = token & 15;
+    if (0 == offset || offset > static_cast<size_t>(out - dest) ||
+        (15 == length && !ReadLength(&source, source_end, &length))) {
+      return false;
+    }
+    length += kMinMatch;
+    if (length > static_cast<size_t>(out_end - out)) {
+      return false;
+    }
+    // Earlier copies are done before later ones read them, so steps up to
+    // the offset are safe.
+    const uint8_t* match = out - offset;
+    uint8_t* match_end = out + length;
+    if (offset >= 16) {
+      for (; out < match_end; out += 16, match += 16) {
+        Copy16(out, match);
+      }
+    } else if (0 == 16 % offset) {
+      // Runs, which delta coding turns smooth data into: the same 16 bytes
+      // every time.
+      uint8_t pattern[16];
+      for (size_t i = 0; i < 16; ++i) {
+        pattern[i] = match[i % offset];
+      }
+      for (; out < match_end; out += 16) {
+        memcpy(out, pattern, 16);
+      }
+    } else if (offset >= 8) {
+      for (; out < match_end; out += 8, match += 8) {
+        memcpy(out, match, 8);
+      }
+    } else {
+      // Repeat the pattern bytewise once, then copy from a multiple of the
+      // offset at least 8 back.
+      for (int i = 0; i < 8; ++i) {
+        out[i] = match[i];
+      }
+      out += 8;
+      match = out - offset * ((8 + offset - 1) / offset);
+      for (; out < match_end; out += 8, match += 8) {
+        memcpy(out, match, 8);
+      }
+    }
+    out = match_end;
+  }
+}
+
+void DeltaEncode(const uint8_t* source, size_t size, size_t stride,
+                 uint8_t* dest) {
+  size_t head = std::min(stride, size);
+  memcpy(dest, source, head);
+  for (size_t i = head; i < size; ++i) {
+    dest[i] = static_cast<uint8_t>(source[i] - source[i - stride]);
+  }
+}
+
+void DeltaDecodeScalar(uint8_t* data, size_t begin, size_t size,
+                       size_t stride) {
+  for (size_t i = std::max(begin, stride); i < size; ++i) {
+    data[i] = static_cast<uint8_t>(data[i] + data[i - stride]);
+  }
+}
+
+#if defined(D3DAPP_SSE2)
+// The last kStride bytes of value repeated across the register.
+template <int kStride>
+__m128i SpreadLast(__m128i value);
+
+template <>
+__m128i SpreadLast<1>(__m128i value) {
+  value = _mm_unpackhi_epi8(value, value);
+  return _mm_shuffle_epi32(_mm_shufflehi_epi16(value, 0xff), 0xff);
+}
+
+template <>
+__m128i SpreadLast<2>(__m128i value) {
+  return _mm_shuffle_epi32(_mm_shufflehi_epi16(value, 0xff), 0xff);
+}
+
+template <>
+__m128i SpreadLast<4>(__m128i value) {
+  return _mm_shuffle_epi32(value, 0xff);
+}
+
+template <>
+__m128i SpreadLast<8>(__m128i value) {
+  return _mm_shuffle_epi32(value, 0xee);
+}
+
+// Prefix sums of each lane of 16 bytes at a time in registers, which the
+// scalar loop cannot do since every byte waits on a store kStride back.
+template <int kStride>
+void DeltaDecodeSse2(uint8_t* data, size_t size) {
+  __m128i carry = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    sum = _mm_add_epi8(sum, _mm_slli_si128(sum, kStride));
+    if (kStride < 8) {
+      sum = _mm_add_epi8(sum, _mm_slli_si128(sum, kStride * 2));
+    }
+    if (kStride < 4) {
+      sum = _mm_add_epi8(sum, _mm_slli_si128(sum, kStride * 4));
+    }
+    if (kStride < 2) {
+      sum = _mm_add_epi8(sum, _mm_slli_si128(sum, kStride * 8));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i),
+                     _mm_add_epi8(sum, carry));
+    // The carry repeats every kStride bytes, so adding the lane totals to
+    // it gives the next one. Only that add waits on the previous block.
+    carry = _mm_add_epi8(carry, SpreadLast<kStride>(sum));
+  }
+  DeltaDecodeScalar(data, i, size, kStride);
+}
+#endif
+
+void DeltaDecode(uint8_t* data, size_t size, size_t stride) {
+  if (0 == stride) {
+    return;
+  }
+#if defined(D3DAPP_SSE2)
+  switch (stride) {
+    case 1:
+      return DeltaDecodeSse2<1>(data, size);
+    case 2:
+      return DeltaDecodeSse2<2>(data, size);
+    case 4:
+      return DeltaDecodeSse2<4>(data, size);
+    case 8:
+      return DeltaDecodeSse2<8>(data, size);
+  }
+#endif
+  DeltaDecodeScalar(data, 0, size, stride);
+}
+
+}  // namespace
+
+namespace d3dapp {
+void CompressChunked(const void* source, uint64_t size, uint32_t delta_stride,
+                     std::vector<uint8_t>* dest, JobSystem* job_system) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(source);
+  size_t chunk_count = static_cast<size_t>((size + kChunkSize - 1) /
+                                           kChunkSize);
+  size_t bound = CompressBound(kChunkSize);
+  std::unique_ptr<uint8_t[]> chunks{new uint8_t[chunk_count * bound]};
+  std::vector<uint64_t> chunk_sizes(chunk_count);
+  auto compress_chunks = [&](size_t first, size_t last) {
+    std::unique_ptr<uint8_t[]> delta;
+    if (delta_stride > 0) {
+      delta.reset(new uint8_t[kChunkSize]);
+    }
+    for (size_t i = first; i < last; ++i) {
+      uint64_t offset = i * kChunkSize;
+      size_t chunk_size =
+          static_cast<size_t>(std::min(kChunkSize, size - offset));
+      const uint8_t* input = bytes + offset;
+      if (delta) {
+        DeltaEncode(input, chunk_size, delta_stride, delta.get());
+        input = delta.get();
+      }
+      uint8_t* chunk = chunks.get() + i * bound;
+      size_t compressed_size = CompressChunk(input, chunk_size, chunk);
+      if (compressed_size >= chunk_size) {
+        memcpy(chunk, bytes + offset, chunk_size);
+        compressed_size = chunk_size;
+      }
+      chunk_sizes[i] = compressed_size;
+    }
+  };
+  if (job_system && job_system->thread_count() > 1 && chunk_count > 1) {
+    job_system->ParallelFor(0, chunk_count, 1, compress_chunks);
+  } else {
+    compress_chunks(0, chunk_count);
+  }
+
+  ChunkedLzHeader header{};
+  header.magic = ChunkedLzHeader::kMagic;
+  header.chunk_size = ChunkedLzHeader::kChunkSize;
+  header.chunk_count = static_cast<uint32_t>(chunk_count);
+  header.delta_stride = delta_stride;
+  header.size = size;
+  size_t table_offset = sizeof(header);
+  size_t data_offset = table_offset + chunk_count * sizeof(uint64_t);
+  uint64_t data_size = 0;
+  for (uint64_t& chunk_size : chunk_sizes) {
+    data_size += chunk_size;
+    chunk_size = data_size;
+  }
+
+  dest->resize(data_offset + static_cast<size_t>(data_size));
+  memcpy(dest->data(), &header, sizeof(header));
+  uint64_t chunk_begin = 0;
+  for (size_t i = 0; i < chunk_count; ++i) {
+    memcpy(dest->data() + table_offset + i * sizeof(uint64_t),
+           &chunk_sizes[i], sizeof(uint64_t));
+    memcpy(dest->data() + data_offset + chunk_begin, chunks.get() + i * bound,
+           static_cast<size_t>(chunk_sizes[i] - chunk_begin));
+    chunk_begin = chunk_sizes[i];
+  }
+}
+
+bool GetDecompressedSize(const void* data, uint64_t size,
+                         uint64_t* decompressed_size) {
+  ChunkedLzHeader header;
+  if (size < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (ChunkedLzHeader::kMagic != header.magic) {
+    return false;
+  }
+  *decompressed_size = header.size;
+  return true;
+}
+
+bool DecompressChunked(const void* data, uint64_t size, void* dest,
+                       uint64_t dest_size, JobSystem* job_system) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  ChunkedLzHeader header;
+  if (size < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, bytes, sizeof(header));
+  if (ChunkedLzHeader::kMagic != header.magic ||
+      ChunkedLzHeader::kChunkSize != header.chunk_size ||
+      header.size != dest_size ||
+      header.chunk_count != (header.size + kChunkSize - 1) / kChunkSize ||
+      header.chunk_count >
+          (size - sizeof(header)) / sizeof(uint64_t)) {
+    return false;
+  }
+  size_t chunk_count = header.chunk_count;
+  if (0 == chunk_count) {
+    return true;
+  }
+  // The table may be unaligned in a mapped file.
+  std::vector<uint64_t> chunk_ends(chunk_count);
+  memcpy(chunk_ends.data(), bytes + sizeof(header),
+         chunk_count * sizeof(uint64_t));
+  const uint8_t* chunks =
+      bytes + sizeof(header) + chunk_count * sizeof(uint64_t);
+  uint64_t chunks_size = size - (chunks - bytes);
+  uint64_t chunk_begin = 0;
+  for (uint64_t chunk_end : chunk_ends) {
+    if (chunk_end < chunk_begin || chunk_end > chunks_size) {
+      return false;
+    }
+    chunk_begin = chunk_end;
+  }
+
+  std::atomic<bool> failed{false};
+  auto decompress_chunks = [&](size_t first, size_t last) {
+    std::unique_ptr<uint8_t[]> decoded;
+    for (size_t i = first; i < last && !failed.load(); ++i) {
+      uint64_t offset = i * kChunkSize;
+      size_t chunk_size =
+          static_cast<size_t>(std::min(kChunkSize, dest_size - offset));
+      uint64_t begin = i > 0 ? chunk_ends[i - 1] : 0;
+      const uint8_t* chunk = chunks + begin;
+      size_t compressed_size = static_cast<size_t>(chunk_ends[i] - begin);
+      uint8_t* out = static_cast<uint8_t*>(dest) + offset;
+      if (compressed_size == chunk_size) {
+        StreamCopy(out, chunk, chunk_size);
+        continue;
+      }
+      if (!decoded) {
+        decoded.reset(new uint8_t[kChunkSize + kDecodePadding]);
+      }
+      if (!DecodeChunk(chunk, chunk + compressed_size, decoded.get(),
+                       chunk_size)) {
+        failed = true;
+        return;
+      }
+      DeltaDecode(decoded.get(), chunk_size, header.delta_stride);
+      StreamCopy(out, decoded.get(), chunk_size);
+    }
+  };
+  if (job_system && job_system->thread_count() > 1 && chunk_count > 1) {
+    job_system->ParallelFor(0, chunk_count, 0, decompress_chunks);
+  } else {
+    decompress_chunks(0, chunk_count);
+  }
+  return !failed.load();
+}
+
+}  // namespace d3dapp
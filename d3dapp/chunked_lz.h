@@ -0,0 +1,52 @@
+#pragma once
+
+#ifndef __CHUNKED_LZ_H__
+#define __CHUNKED_LZ_H__
+
+#include <cstdint>
+#include <vector>
+
+namespace d3dapp {
+class JobSystem;
+
+// Container of LZ compressed data split into chunks that decode on their
+// own: the header, then the end offset of every chunk's data, counted from
+// the end of the table, then the chunks. Chunks that do not compress are
+// stored as they are. Smooth data such as heightmaps compresses better
+// delta coded: each byte less the one delta_stride before it in the chunk.
+struct ChunkedLzHeader {
+  static constexpr uint32_t kMagic = 0x5a4c4333;  // "3CLZ"
+  // Of the decompressed data, except for the last chunk.
+  static constexpr uint32_t kChunkSize = 64 * 1024;
+
+  uint32_t magic;
+  uint32_t chunk_size;
+  uint32_t chunk_count;
+  // 0 for none.
+  uint32_t delta_stride;
+  uint64_t size;
+};
+static_assert(sizeof(ChunkedLzHeader) == 24, "packed header");
+
+// Replaces dest with the container. delta_stride is the size of the
+// elements to delta code, e.g. 2 for R16 heightmaps, or 0. Chunks are
+// compressed on job_system when one is given.
+void CompressChunked(const void* source, uint64_t size, uint32_t delta_stride,
+                     std::vector<uint8_t>* dest,
+                     JobSystem* job_system = nullptr);
+
+// Reads the decompressed size from the header. Returns false if data does
+// not start with one.
+bool GetDecompressedSize(const void* data, uint64_t size,
+                         uint64_t* decompressed_size);
+
+// Decompresses into dest, which may be write-combined upload memory: each
+// chunk is decoded in cache and streamed out. Chunks are spread over
+// job_system when one is given. Returns false, leaving dest partly written,
+// if dest_size is not the decompressed size or data is corrupt.
+bool DecompressChunked(const void* data, uint64_t size, void* dest,
+                       uint64_t dest_size, JobSystem* job_system = nullptr);
+
+}  // namespace d3dapp
+
+#endif  // !__CHUNKED_LZ_H__
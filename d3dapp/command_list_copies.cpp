@@ -0,0 +1,20 @@
+#include "command_list_copies.h"
+
+namespace d3dapp {
+void CommandListCopies::CopyBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                                   ID3D12Resource* source,
+                                   UINT64 source_offset, UINT64 size) {
+  command_list_->CopyBufferRegion(dest, dest_offset, source, source_offset,
+                                  size);
+}
+
+void CommandListCopies::CopyTexture(
+    ID3D12Resource* dest, UINT subresource, ID3D12Resource* source,
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint) {
+  CD3DX12_TEXTURE_COPY_LOCATION dest_location{dest, subresource};
+  CD3DX12_TEXTURE_COPY_LOCATION source_location{source, footprint};
+  command_list_->CopyTextureRegion(&dest_location, 0, 0, 0, &source_location,
+                                   nullptr);
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifndef __COMMAND_LIST_COPIES_H__
+#define __COMMAND_LIST_COPIES_H__
+
+#include <d3dx12.h>
+
+#include "framework.h"
+#include "upload_batcher.h"
+
+namespace d3dapp {
+// Records UploadBatcher's copies into a command list.
+class CommandListCopies : public UploadBatcher::Copies {
+ public:
+  explicit CommandListCopies(ID3D12GraphicsCommandList* command_list)
+      : command_list_{command_list} {}
+  CommandListCopies(const CommandListCopies&) = delete;
+  CommandListCopies& operator=(const CommandListCopies&) = delete;
+
+  void CopyBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                  ID3D12Resource* source, UINT64 source_offset,
+                  UINT64 size) override;
+  void CopyTexture(
+      ID3D12Resource* dest, UINT subresource, ID3D12Resource* source,
+      const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint) override;
+
+ private:
+  ID3D12GraphicsCommandList* command_list_{nullptr};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__COMMAND_LIST_COPIES_H__
@@ -0,0 +1,151 @@
+#include "command_list_pool.h"
+
+static_assert(d3dapp::kAllSubresources ==
+                  D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+              "subresource indices must match D3D12");
+
+using Microsoft::WRL::ComPtr;
+
+namespace {
+ID3D12Resource* ToResource(const void* resource) {
+  return static_cast<ID3D12Resource*>(const_cast<void*>(resource));
+}
+
+ID3D12GraphicsCommandList* ToCommandList(void* list) {
+  return static_cast<ID3D12GraphicsCommandList*>(list);
+}
+
+D3D12_RESOURCE_BARRIER_FLAGS ToFlags(d3dapp::TrackedBarrier::Split split) {
+  switch (split) {
+    case d3dapp::TrackedBarrier::kBegin:
+      return D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+    case d3dapp::TrackedBarrier::kEnd:
+      return D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+    default:
+      return D3D12_RESOURCE_BARRIER_FLAG_NONE;
+  }
+}
+
+// Handles are the command lists themselves.
+class D3D12CommandLists : public d3dapp::CommandListSequence::Lists {
+ public:
+  D3D12CommandLists(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type)
+      : device_{device}, type_{type} {}
+
+  void* Create() override {
+    std::unique_ptr<Entry> entry{new Entry};
+    device_->CreateCommandAllocator(type_,
+                                    IID_PPV_ARGS(&entry->command_allocator));
+    device_->CreateCommandList(0, type_, entry->command_allocator.Get(),
+                               nullptr, IID_PPV_ARGS(&entry->command_list));
+    entries_.push_back(std::move(entry));
+    return entries_.back()->command_list.Get();
+  }
+
+  void Recycle(void* list) override {
+    Find(list)->command_allocator->Reset();
+  }
+
+  void Reopen(void* list) override {
+    Entry* entry = Find(list);
+    entry->command_list->Reset(entry->command_allocator.Get(), nullptr);
+  }
+
+  // Lists flush barriers on their own threads, so each has its own scratch.
+  void IssueBarriers(void* list, const d3dapp::TrackedBarrier* tracked,
+                     size_t count) override {
+    std::vector<D3D12_RESOURCE_BARRIER>& barriers = Find(list)->barriers;
+    barriers.clear();
+    for (size_t i = 0; i < count; ++i) {
+      ID3D12Resource* resource = ToResource(tracked[i].resource);
+      if (d3dapp::TrackedBarrier::kUav == tracked[i].type) {
+        barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+      } else if (d3dapp::TrackedBarrier::kAliasing == tracked[i].type) {
+        barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(
+            ToResource(tracked[i].resource_before), resource));
+      } else {
+        barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+            resource, static_cast<D3D12_RESOURCE_STATES>(tracked[i].before),
+            static_cast<D3D12_RESOURCE_STATES>(tracked[i].after),
+            tracked[i].subresource, ToFlags(tracked[i].split)));
+      }
+    }
+    ToCommandList(list)->ResourceBarrier(static_cast<UINT>(barriers.size()),
+                                         barriers.data());
+  }
+
+ private:
+  struct Entry {
+    ComPtr<ID3D12CommandAllocator> command_allocator;
+    ComPtr<ID3D12GraphicsCommandList> command_list;
+    std::vector<D3D12_RESOURCE_BARRIER> barriers;
+  };
+
+  Entry* Find(void* list) {
+    for (const std::unique_ptr<Entry>& entry : entries_) {
+      if (entry->command_list.Get() == list) {
+        return entry.get();
+      }
+    }
+    return nullptr;
+  }
+
+  ID3D12Device* device_{nullptr};
+  D3D12_COMMAND_LIST_TYPE type_{D3D12_COMMAND_LIST_TYPE_DIRECT};
+  std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+}  // namespace
+
+namespace d3dapp {
+CommandListPool::CommandListPool(ID3D12Device* device,
+                                 D3D12_COMMAND_LIST_TYPE type,
+                                 ResourceStateRegistry* registry)
+    : sequence_{std::unique_ptr<CommandListSequence::Lists>{
+                    new D3D12CommandLists{device, type}},
+                registry} {}
+
+void CommandListPool::Reset() { sequence_.Reset(); }
+
+void CommandListPool::SetPrologue(Prologue prologue) {
+  prologue_ = std::move(prologue);
+}
+
+ID3D12GraphicsCommandList* CommandListPool::Acquire() {
+  ID3D12GraphicsCommandList* command_list = ToCommandList(sequence_.Acquire());
+  if (prologue_) {
+    prologue_(command_list);
+  }
+  return command_list;
+}
+
+void CommandListPool::Acquire(int count,
+                              ID3D12GraphicsCommandList** command_lists) {
+  for (int i = 0; i < count; ++i) {
+    command_lists[i] = Acquire();
+  }
+}
+
+ResourceStateTracker* CommandListPool::state_tracker(
+    ID3D12GraphicsCommandList* command_list) {
+  return sequence_.state_tracker(command_list);
+}
+
+void CommandListPool::FlushBarriers(ID3D12GraphicsCommandList* command_list) {
+  sequence_.FlushBarriers(command_list);
+}
+
+void CommandListPool::Execute(ID3D12CommandQueue* command_queue) {
+  sequence_.Execute(order_);
+  submission_.clear();
+  for (void* list : order_) {
+    ToCommandList(list)->Close();
+    submission_.push_back(ToCommandList(list));
+  }
+  if (!submission_.empty()) {
+    command_queue->ExecuteCommandLists(static_cast<UINT>(submission_.size()),
+                                       submission_.data());
+  }
+}
+
+}  // namespace d3dapp
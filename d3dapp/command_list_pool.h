@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef __COMMAND_LIST_POOL_H__
+#define __COMMAND_LIST_POOL_H__
+
+#include <d3dx12.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "command_list_sequence.h"
+#include "framework.h"
+#include "resource_state_tracker.h"
+
+namespace d3dapp {
+// Command lists for one frame, each with its own allocator so that they can
+// be recorded on different threads. Acquire, Reset and Execute must be
+// called from the render thread; the acquired lists may be recorded
+// concurrently, one thread per list, and are closed by Execute. Ordering,
+// reuse and barrier placement are CommandListSequence's.
+class CommandListPool {
+ public:
+  using Prologue = std::function<void(ID3D12GraphicsCommandList*)>;
+
+  CommandListPool(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type,
+                  ResourceStateRegistry* registry = nullptr);
+  CommandListPool(const CommandListPool&) = delete;
+  CommandListPool& operator=(const CommandListPool&) = delete;
+
+  // Recycles every list. The GPU must be done with the previous submission.
+  void Reset();
+
+  // Called on each list right after it is opened, e.g. to bind the frame's
+  // viewport and render targets.
+  void SetPrologue(Prologue prologue);
+
+  ID3D12GraphicsCommandList* Acquire();
+  void Acquire(int count, ID3D12GraphicsCommandList** command_lists);
+
+  // Tracker of an acquired list; may be used on the thread recording it.
+  ResourceStateTracker* state_tracker(ID3D12GraphicsCommandList* command_list);
+  // Issues the barriers tracked for command_list in one ResourceBarrier call.
+  void FlushBarriers(ID3D12GraphicsCommandList* command_list);
+
+  // Closes every acquired list and submits them in one ExecuteCommandLists.
+  void Execute(ID3D12CommandQueue* command_queue);
+
+  int size() const { return sequence_.size(); }
+
+ private:
+  CommandListSequence sequence_;
+  std::vector<void*> order_;
+  std::vector<ID3D12CommandList*> submission_;
+  Prologue prologue_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__COMMAND_LIST_POOL_H__
@@ -0,0 +1,86 @@
+#include "command_list_sequence.h"
+
+namespace d3dapp {
+CommandListSequence::CommandListSequence(std::unique_ptr<Lists> lists,
+                                         ResourceStateRegistry* registry)
+    : lists_{std::move(lists)}, registry_{registry} {}
+
+void CommandListSequence::Reset() {
+  for (int i = 0; i < used_count_; ++i) {
+    lists_->Recycle(entries_[i].list);
+  }
+  used_count_ = 0;
+}
+
+void* CommandListSequence::Acquire() { return AcquireEntry().list; }
+
+ResourceStateTracker* CommandListSequence::state_tracker(const void* list) {
+  Entry* entry = Find(list);
+  return entry ? entry->state_tracker.get() : nullptr;
+}
+
+void CommandListSequence::FlushBarriers(const void* list) {
+  Entry* entry = Find(list);
+  if (entry) {
+    entry->barriers.clear();
+    entry->state_tracker->TakeBarriers(entry->barriers);
+    IssueBarriers(*entry, entry->list);
+  }
+}
+
+void CommandListSequence::Execute(std::vector<void*>& submission) {
+  submission.clear();
+  const int count = used_count_;
+  if (registry_) {
+    for (int i = 0; i < count; ++i) {
+      entries_[i].barriers.clear();
+      entries_[i].state_tracker->Resolve(*registry_, entries_[i].barriers);
+      if (entries_[i].barriers.empty()) {
+        continue;
+      }
+      // Acquiring may move the entries, so look them up afterwards.
+      void* target = i > 0 ? entries_[i - 1].list : AcquireEntry().list;
+      IssueBarriers(entries_[i], target);
+    }
+    registry_->Decay();
+  }
+
+  // A list beyond count only exists to run ahead of the first one.
+  for (int i = count; i < used_count_; ++i) {
+    submission.push_back(entries_[i].list);
+  }
+  for (int i = 0; i < count; ++i) {
+    submission.push_back(entries_[i].list);
+  }
+}
+
+CommandListSequence::Entry* CommandListSequence::Find(const void* list) {
+  for (int i = 0; i < used_count_; ++i) {
+    if (entries_[i].list == list) {
+      return &entries_[i];
+    }
+  }
+  return nullptr;
+}
+
+CommandListSequence::Entry& CommandListSequence::AcquireEntry() {
+  if (used_count_ == static_cast<int>(entries_.size())) {
+    Entry entry;
+    entry.list = lists_->Create();
+    entry.state_tracker.reset(new ResourceStateTracker{registry_});
+    entries_.push_back(std::move(entry));
+  } else {
+    Entry& entry = entries_[used_count_];
+    lists_->Reopen(entry.list);
+    entry.state_tracker->Reset();
+  }
+  return entries_[used_count_++];
+}
+
+void CommandListSequence::IssueBarriers(Entry& entry, void* list) {
+  if (!entry.barriers.empty()) {
+    lists_->IssueBarriers(list, entry.barriers.data(), entry.barriers.size());
+  }
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef __COMMAND_LIST_SEQUENCE_H__
+#define __COMMAND_LIST_SEQUENCE_H__
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "resource_state_tracker.h"
+
+namespace d3dapp {
+// Reuse and submission order of one frame's command lists. Lists are only
+// handles here, created and recorded into through Lists, so this runs
+// without a device. Lists are submitted in the order they were acquired;
+// with a registry, Execute resolves the states each list expects against it
+// and records the missing transitions at the end of the previous list, or
+// in an extra list in front of the first one.
+class CommandListSequence {
+ public:
+  // The lists being sequenced, e.g. D3D12 command lists with an allocator
+  // each.
+  class Lists {
+   public:
+    virtual ~Lists() {}
+    // A new list, opened for recording.
+    virtual void* Create() = 0;
+    // Frees the commands of a list the GPU is done with.
+    virtual void Recycle(void* list) = 0;
+    // Opens a recycled list for recording again.
+    virtual void Reopen(void* list) = 0;
+    virtual void IssueBarriers(void* list, const TrackedBarrier* barriers,
+                               size_t count) = 0;
+  };
+
+  explicit CommandListSequence(std::unique_ptr<Lists> lists,
+                               ResourceStateRegistry* registry = nullptr);
+  CommandListSequence(const CommandListSequence&) = delete;
+  CommandListSequence& operator=(const CommandListSequence&) = delete;
+
+  // Recycles every list. The GPU must be done with the previous submission.
+  void Reset();
+
+  // Reuses the oldest recycled list, or creates one.
+  void* Acquire();
+
+  // Tracker of an acquired list; may be used on the thread recording it.
+  ResourceStateTracker* state_tracker(const void* list);
+  // Issues the barriers tracked for list in one IssueBarriers call.
+  void FlushBarriers(const void* list);
+
+  // Resolves the acquired lists and fills submission with them in the order
+  // to submit them in. The caller closes and submits them in one
+  // ExecuteCommandLists call.
+  void Execute(std::vector<void*>& submission);
+
+  int size() const { return used_count_; }
+  int created_count() const { return static_cast<int>(entries_.size()); }
+
+ private:
+  struct Entry {
+    void* list;
+    std::unique_ptr<ResourceStateTracker> state_tracker;
+    std::vector<TrackedBarrier> barriers;
+  };
+
+  Entry* Find(const void* list);
+  Entry& AcquireEntry();
+  void IssueBarriers(Entry& entry, void* list);
+
+  std::unique_ptr<Lists> lists_;
+  ResourceStateRegistry* registry_{nullptr};
+  std::vector<Entry> entries_;
+  int used_count_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__COMMAND_LIST_SEQUENCE_H__
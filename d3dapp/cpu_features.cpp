@@ -0,0 +1,82 @@
+#include "cpu_features.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define D3DAPP_CPUID 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define D3DAPP_CPUID 1
+#endif
+
+namespace {
+#if D3DAPP_CPUID
+// Registers eax, ebx, ecx and edx of leaf and subleaf.
+void Cpuid(unsigned leaf, unsigned subleaf, unsigned registers[4]) {
+#if defined(_MSC_VER)
+  int values[4];
+  __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+  for (int i = 0; i < 4; ++i) {
+    registers[i] = static_cast<unsigned>(values[i]);
+  }
+#else
+  __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2],
+                registers[3]);
+#endif
+}
+
+// The register state the OS saves on context switches.
+unsigned long long Xgetbv() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  unsigned eax = 0;
+  unsigned edx = 0;
+  __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return static_cast<unsigned long long>(edx) << 32 | eax;
+#endif
+}
+#endif
+
+d3dapp::CpuFeatures Detect() {
+  d3dapp::CpuFeatures features;
+#if D3DAPP_CPUID
+  unsigned registers[4]{};
+  Cpuid(0, 0, registers);
+  const unsigned max_leaf = registers[0];
+  if (max_leaf < 1) {
+    return features;
+  }
+  Cpuid(1, 0, registers);
+  const unsigned ecx = registers[2];
+  features.ssse3 = (ecx & 1u << 9) != 0;
+
+  // AVX state must be enabled by the OS in XCR0, SSE and AVX registers both.
+  const bool osxsave = (ecx & 1u << 27) != 0;
+  const bool avx = (ecx & 1u << 28) != 0;
+  if (!osxsave || !avx || (Xgetbv() & 0x6) != 0x6) {
+    return features;
+  }
+  features.f16c = (ecx & 1u << 29) != 0;
+  if (max_leaf >= 7) {
+    Cpuid(7, 0, registers);
+    features.avx2 = (registers[1] & 1u << 5) != 0;
+  }
+#endif
+  return features;
+}
+
+d3dapp::CpuFeatures& Features() {
+  static d3dapp::CpuFeatures features = Detect();
+  return features;
+}
+
+}  // namespace
+
+namespace d3dapp {
+const CpuFeatures& GetCpuFeatures() { return Features(); }
+
+void SetCpuFeaturesForTesting(const CpuFeatures& features) {
+  Features() = features;
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifndef __CPU_FEATURES_H__
+#define __CPU_FEATURES_H__
+
+namespace d3dapp {
+// Instruction sets beyond the build's baseline that the CPU and the OS
+// both support. x64 builds may always use SSE2.
+struct CpuFeatures {
+  bool ssse3{false};
+  bool f16c{false};
+  bool avx2{false};
+};
+
+// Detected on first use.
+const CpuFeatures& GetCpuFeatures();
+
+// Replaces what was detected, e.g. to test the scalar paths on any CPU.
+// Call before other threads may read the features.
+void SetCpuFeaturesForTesting(const CpuFeatures& features);
+
+}  // namespace d3dapp
+
+// Lets one function use intrinsics of an instruction set the build does not
+// target, so it can be picked at run time with GetCpuFeatures. MSVC allows
+// them anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define D3DAPP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define D3DAPP_TARGET(isa)
+#endif
+
+#endif  // !__CPU_FEATURES_H__
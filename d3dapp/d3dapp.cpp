@@ -1,5 +1,7 @@
 #include "d3dapp.h"
 
+#include <algorithm>
+
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -7,6 +9,34 @@
 using Microsoft::WRL::ComPtr;
 
 namespace {
+constexpr int kMinBackBufferCount = 2;
+constexpr int kMaxBackBufferCount = 4;
+constexpr UINT kStagingDescriptorBlockSize = 1024;
+
+class D3D12TimelineFence : public d3dapp::FenceTimeline::Fence {
+ public:
+  explicit D3D12TimelineFence(ID3D12Fence* fence) : fence_{fence} {}
+  ~D3D12TimelineFence() override {
+    CloseHandle(fence_event_);
+    CloseHandle(wake_event_);
+  }
+
+  uint64_t GetCompletedValue() override { return fence_->GetCompletedValue(); }
+
+  void Wait(uint64_t value) override {
+    fence_->SetEventOnCompletion(value, fence_event_);
+    HANDLE events[]{fence_event_, wake_event_};
+    WaitForMultipleObjects(_countof(events), events, false, INFINITE);
+  }
+
+  void Wake() override { SetEvent(wake_event_); }
+
+ private:
+  ComPtr<ID3D12Fence> fence_;
+  HANDLE fence_event_{CreateEvent(nullptr, false, false, nullptr)};
+  HANDLE wake_event_{CreateEvent(nullptr, false, false, nullptr)};
+};
+
 HWND CreateD3DWindow(HINSTANCE instance, const TCHAR* title, int width,
                      int height, DWORD style, DWORD style_ex,
                      WNDPROC window_proc, d3dapp::D3DApp* app) {
@@ -39,6 +69,27 @@ HWND CreateD3DWindow(HINSTANCE instance, const TCHAR* title, int width,
   return window;
 }
 
+class DxgiBudgetProvider : public d3dapp::ResidencyManager::BudgetProvider {
+ public:
+  explicit DxgiBudgetProvider(IDXGIAdapter1* adapter) {
+    adapter->QueryInterface(IID_PPV_ARGS(&adapter_));
+  }
+
+  // Without IDXGIAdapter3 there is no budget to stay within.
+  d3dapp::ResidencyBudget QueryBudget() override {
+    DXGI_QUERY_VIDEO_MEMORY_INFO info{};
+    if (!adapter_ ||
+        FAILED(adapter_->QueryVideoMemoryInfo(
+            0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info))) {
+      return d3dapp::ResidencyBudget{UINT64_MAX, 0};
+    }
+    return d3dapp::ResidencyBudget{info.Budget, info.CurrentUsage};
+  }
+
+ private:
+  ComPtr<IDXGIAdapter3> adapter_;
+};
+
 bool CreateAdapter(IDXGIFactory4* dxgi_factory,
                    ComPtr<IDXGIAdapter1>& adapter) {
   for (int i = 0;; ++i) {
@@ -63,9 +114,9 @@ bool CreateAdapter(IDXGIFactory4* dxgi_factory,
 bool CreateSwapChain(ID3D12Device* device, IDXGIFactory2* dxgi_factory,
                      ID3D12CommandQueue* command_queue, HWND window,
                      unsigned width, unsigned height,
-                     ComPtr<IDXGISwapChain1>& swap_chain,
-                     ComPtr<ID3D12Resource>* render_target,
-                     int render_target_count,
+                     ComPtr<IDXGISwapChain3>& swap_chain,
+                     std::vector<ComPtr<ID3D12Resource>>& render_target,
+                     int render_target_count, bool allow_tearing,
                      ComPtr<ID3D12DescriptorHeap>& descriptor) {
   DXGI_SWAP_CHAIN_DESC1 desc{};
   desc.Width = width;
@@ -75,14 +126,19 @@ bool CreateSwapChain(ID3D12Device* device, IDXGIFactory2* dxgi_factory,
   desc.SampleDesc.Count = 1;
   desc.SampleDesc.Quality = 0;
   desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-  desc.BufferCount = 2;
+  desc.BufferCount = render_target_count;
   desc.Scaling = DXGI_SCALING_STRETCH;
   desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
   desc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
   desc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+  if (allow_tearing) {
+    desc.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+  }
 
+  ComPtr<IDXGISwapChain1> swap_chain1;
   dxgi_factory->CreateSwapChainForHwnd(command_queue, window, &desc, nullptr,
-                                       nullptr, &swap_chain);
+                                       nullptr, &swap_chain1);
+  swap_chain1.As(&swap_chain);
 
   D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc{};
   rtv_heap_desc.NumDescriptors = render_target_count;
@@ -93,6 +149,7 @@ bool CreateSwapChain(ID3D12Device* device, IDXGIFactory2* dxgi_factory,
 
   CD3DX12_CPU_DESCRIPTOR_HANDLE descriptor_handle{
       descriptor->GetCPUDescriptorHandleForHeapStart()};
+  render_target.resize(render_target_count);
   for (int i = 0; i < render_target_count; i++) {
     swap_chain->GetBuffer(i, IID_PPV_ARGS(&render_target[i]));
     device->CreateRenderTargetView(render_target[i].Get(), nullptr,
@@ -104,7 +161,19 @@ bool CreateSwapChain(ID3D12Device* device, IDXGIFactory2* dxgi_factory,
   return true;
 }
 
-bool CreateDepthStencilBuffer(ID3D12Device* device, int width, int height,
+bool CheckTearingSupport(IDXGIFactory4* dxgi_factory) {
+  ComPtr<IDXGIFactory5> dxgi_factory5;
+  BOOL allow_tearing = false;
+  if (SUCCEEDED(dxgi_factory->QueryInterface(IID_PPV_ARGS(&dxgi_factory5)))) {
+    dxgi_factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING,
+                                       &allow_tearing, sizeof(allow_tearing));
+  }
+  return allow_tearing != false;
+}
+
+bool CreateDepthStencilBuffer(ID3D12Device* device,
+                              d3dapp::HeapAllocator* heap_allocator, int width,
+                              int height,
                               ComPtr<ID3D12Resource>& depth_stencil_buffer,
                               ComPtr<ID3D12DescriptorHeap>& descriptor) {
   D3D12_RESOURCE_DESC depth_stencil_desc{};
@@ -124,10 +193,10 @@ bool CreateDepthStencilBuffer(ID3D12Device* device, int width, int height,
   clear_value.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
   clear_value.DepthStencil.Depth = 1.0f;
   clear_value.DepthStencil.Stencil = 0;
-  device->CreateCommittedResource(
-      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
-      &depth_stencil_desc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &clear_value,
-      IID_PPV_ARGS(depth_stencil_buffer.GetAddressOf()));
+  d3dapp::HeapAllocation allocation{};
+  heap_allocator->CreateResource(D3D12_HEAP_TYPE_DEFAULT, depth_stencil_desc,
+                                 D3D12_RESOURCE_STATE_DEPTH_WRITE, &clear_value,
+                                 depth_stencil_buffer, &allocation);
 
   D3D12_DESCRIPTOR_HEAP_DESC dsv_heap_desc{};
   dsv_heap_desc.NumDescriptors = 1;
@@ -148,11 +217,8 @@ bool CreateDepthStencilBuffer(ID3D12Device* device, int width, int height,
   return true;
 }
 
-bool CreateD3DResources(
-    int frame_count, ID3D12Device* device, ComPtr<ID3D12Fence>& fence,
-    ComPtr<ID3D12CommandQueue>& command_queue,
-    ComPtr<ID3D12GraphicsCommandList>& command_list,
-    std::vector<ComPtr<ID3D12CommandAllocator>>& allocators) {
+bool CreateD3DResources(ID3D12Device* device, ComPtr<ID3D12Fence>& fence,
+                        ComPtr<ID3D12CommandQueue>& command_queue) {
   device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
 
   D3D12_COMMAND_QUEUE_DESC queue_desc{D3D12_COMMAND_LIST_TYPE_DIRECT,
@@ -160,24 +226,6 @@ bool CreateD3DResources(
                                       D3D12_COMMAND_QUEUE_FLAG_NONE, 0};
   device->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(&command_queue));
 
-  ComPtr<ID3D12CommandAllocator> command_allocator;
-  device->CreateCommandAllocator(
-      D3D12_COMMAND_LIST_TYPE::D3D12_COMMAND_LIST_TYPE_DIRECT,
-      IID_PPV_ARGS(&command_allocator));
-
-  device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
-                            command_allocator.Get(), nullptr,
-                            IID_PPV_ARGS(&command_list));
-  command_list->Close();
-
-  for (int i = 0; i < frame_count; ++i) {
-    ComPtr<ID3D12CommandAllocator> allocator;
-    device->CreateCommandAllocator(
-        D3D12_COMMAND_LIST_TYPE::D3D12_COMMAND_LIST_TYPE_DIRECT,
-        IID_PPV_ARGS(&allocator));
-    allocators.push_back(allocator);
-  }
-
   return true;
 }
 
@@ -188,11 +236,21 @@ LRESULT Render::OnMessage(HWND hwnd, UINT message, WPARAM wParam,
                           LPARAM lParam) {
   return DefWindowProc(hwnd, message, wParam, lParam);
 }
-void Render::OnCreate(ID3D12Device* device, void* data) {}
-void Render::OnRender(int frame_index,
-                      ID3D12GraphicsCommandList* command_list) {}
+void Render::OnCreate(const CreateContext& context) {}
+void Render::OnRender(const FrameContext& frame) {}
+void Render::OnWindowMessage(HWND hwnd, UINT message, WPARAM wParam,
+                             LPARAM lParam) {}
 Render::~Render() {}
 
+void Render::Invalidate() {
+  if (gate_) {
+    gate_->Invalidate();
+  }
+  if (invalidate_event_) {
+    SetEvent(invalidate_event_);
+  }
+}
+
 /////////////////////////////////////////////////////////////////////////////
 thread_local std::shared_ptr<D3DApp> D3DApp::tlsAppInstance{nullptr,
                                                             D3DApp::Destroy};
@@ -220,51 +278,99 @@ std::shared_ptr<D3DApp> D3DApp::Create(const D3DApp::Desc& desc) {
   // d3d resources
   ComPtr<ID3D12Fence> fence;
   ComPtr<ID3D12CommandQueue> command_queue;
-  ComPtr<ID3D12GraphicsCommandList> command_list;
-  std::vector<ComPtr<ID3D12CommandAllocator>> allocators;
-  CreateD3DResources(desc.frame_count, device.Get(), fence, command_queue,
-                     command_list, allocators);
+  CreateD3DResources(device.Get(), fence, command_queue);
 
   std::shared_ptr<D3DApp> app{new D3DApp{}, Destroy};
   tlsAppInstance = app;
   app->render_ = desc.render;
+  app->render_gate_.reset(new RenderGate{desc.on_demand});
+  app->render_->gate_ = app->render_gate_.get();
+  app->render_->invalidate_event_ = app->invalidate_event_;
+  app->idle_timeout_ = desc.idle_timeout;
+  if (desc.render_thread) {
+    app->window_messages_.reset(
+        new SpscQueue<WindowMessage, kWindowMessageQueueSize>{});
+  }
   HWND window = CreateD3DWindow(desc.instance, desc.title, desc.width,
                                 desc.height, desc.window_style,
                                 desc.window_style_ex, WindowProc, app.get());
 
   // swap chain
-  ComPtr<IDXGISwapChain1> swap_chain;
-  ComPtr<ID3D12Resource> render_target[kRenderTargetCount];
+  int back_buffer_count = std::min(
+      std::max(desc.back_buffer_count, kMinBackBufferCount),
+      kMaxBackBufferCount);
+  bool allow_tearing =
+      desc.allow_tearing && CheckTearingSupport(dxgi_factory.Get());
+  ComPtr<IDXGISwapChain3> swap_chain;
+  std::vector<ComPtr<ID3D12Resource>> render_target;
   ComPtr<ID3D12DescriptorHeap> rtv_descriptor;
   CreateSwapChain(device.Get(), dxgi_factory.Get(), command_queue.Get(), window,
                   desc.width, desc.height, swap_chain, render_target,
-                  kRenderTargetCount, rtv_descriptor);
+                  back_buffer_count, allow_tearing, rtv_descriptor);
 
   // depth stencil
+  std::unique_ptr<HeapAllocator> heap_allocator{
+      new HeapAllocator{device.Get(), desc.heap_block_size}};
   ComPtr<ID3D12Resource> depth_stencil_buffer;
   ComPtr<ID3D12DescriptorHeap> dsv_desctriptor;
-  CreateDepthStencilBuffer(device.Get(), desc.width, desc.height,
-                           depth_stencil_buffer, dsv_desctriptor);
+  CreateDepthStencilBuffer(device.Get(), heap_allocator.get(), desc.width,
+                           desc.height, depth_stencil_buffer, dsv_desctriptor);
 
   ///////////////////////////////////////////////////////////////
   app->device_ = device;
   app->fence_ = fence;
+  app->fence_timeline_.reset(new FenceTimeline{
+      std::unique_ptr<FenceTimeline::Fence>{
+          new D3D12TimelineFence{fence.Get()}}});
+  app->release_queue_.reset(new DeferredReleaseQueue{});
+  app->frame_schedule_.reset(
+      new FrameSchedule{desc.frame_count, desc.max_queued_frames});
+  app->release_queue_->SetFenceValue(
+      app->frame_schedule_->next_fence_value());
+  app->upload_ring_.reset(new UploadRing{
+      std::unique_ptr<UploadRing::Pages>{new UploadHeapPages{device.Get()}},
+      desc.upload_page_size});
+  app->footprint_cache_.reset(new FootprintCache{device.Get()});
+  app->descriptor_heap_.reset(new ShaderVisibleDescriptorHeap{
+      device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+      desc.persistent_descriptor_count, desc.transient_descriptor_count});
+  app->staging_descriptor_heap_.reset(new StagingDescriptorHeap{
+      device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+      kStagingDescriptorBlockSize});
+  app->heap_allocator_ = std::move(heap_allocator);
+  app->render_graph_.reset(new RenderGraph{device.Get(),
+                                           app->heap_allocator_->heap_tier(),
+                                           app->release_queue_.get()});
+  app->resource_states_.reset(new ResourceStateRegistry{});
+  app->residency_manager_.reset(new ResidencyManager{
+      device.Get(),
+      std::unique_ptr<ResidencyManager::BudgetProvider>{
+          new DxgiBudgetProvider{adapter.Get()}},
+      desc.residency_headroom});
   app->command_queue_ = command_queue;
-  app->command_list_ = command_list;
 
-  for (auto& i : allocators) {
+  for (int i = 0; i < desc.frame_count; ++i) {
     app->frame_resources_.emplace_back();
-    app->frame_resources_.back().command_allocator = i;
+    app->frame_resources_.back().command_list_pool.reset(
+        new CommandListPool{device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT,
+                            app->resource_states_.get()});
   }
 
   app->swap_chain_ = swap_chain;
   app->rtv_descriptor_ = rtv_descriptor;
-  for (int i = 0; i < kRenderTargetCount; ++i) {
-    app->render_target_[i] = render_target[i];
+  app->render_target_ = render_target;
+  for (auto& buffer : render_target) {
+    app->resource_states_->Register(buffer.Get(), 1,
+                                    D3D12_RESOURCE_STATE_PRESENT);
   }
 
   app->depth_stencil_ = depth_stencil_buffer;
   app->dsv_descriptor_ = dsv_desctriptor;
+  app->resource_states_->Register(
+      depth_stencil_buffer.Get(),
+      CD3DX12_RESOURCE_DESC{depth_stencil_buffer->GetDesc()}.Subresources(
+          device.Get()),
+      D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
   app->rtv_descriptor_size_ =
       device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
@@ -286,8 +392,43 @@ std::shared_ptr<D3DApp> D3DApp::Create(const D3DApp::Desc& desc) {
   app->scissor_rect_.bottom = desc.height;
 
   app->clear_color_ = desc.clear_color;
-  app->frame_count_ = desc.frame_count;
-  desc.render->OnCreate(device.Get(), desc.data);
+
+  FramePacer::Desc pacer_desc{};
+  pacer_desc.target_fps = desc.target_fps;
+  app->frame_pacer_.reset(new FramePacer{pacer_desc});
+  app->sync_interval_ = desc.sync_interval;
+  app->present_flags_ = allow_tearing && 0 == desc.sync_interval
+                            ? DXGI_PRESENT_ALLOW_TEARING
+                            : 0;
+
+  app->job_system_.reset(new JobSystem{desc.worker_count < 0
+                                           ? JobSystem::DefaultWorkerCount()
+                                           : desc.worker_count});
+  app->streaming_copy_queue_ =
+      new StreamingCopyQueue{device.Get(), desc.streaming_staging_size};
+  // Frames deliver streamed data, so on demand one must render for it.
+  Render* render = desc.render;
+  app->streaming_.reset(new StreamingPipeline{
+      std::unique_ptr<StreamingPipeline::CopyQueue>{
+          app->streaming_copy_queue_},
+      app->job_system_.get(), [render]() { render->Invalidate(); }});
+
+  CreateContext context{};
+  context.device = device.Get();
+  context.job_system = app->job_system_.get();
+  context.fence_timeline = app->fence_timeline_.get();
+  context.release_queue = app->release_queue_.get();
+  context.upload_ring = app->upload_ring_.get();
+  context.footprint_cache = app->footprint_cache_.get();
+  context.streaming = app->streaming_.get();
+  context.streaming_copy_queue = app->streaming_copy_queue_;
+  context.descriptor_heap = app->descriptor_heap_.get();
+  context.staging_descriptor_heap = app->staging_descriptor_heap_.get();
+  context.heap_allocator = app->heap_allocator_.get();
+  context.resource_states = app->resource_states_.get();
+  context.residency = app->residency_manager_.get();
+  context.data = desc.data;
+  desc.render->OnCreate(context);
 
   return app;
 }
@@ -296,23 +437,46 @@ void D3DApp::Destroy(D3DApp* app) { delete app; }
 
 void D3DApp::Run() {
   MSG message{};
+  if (window_messages_) {
+    render_thread_running_ = true;
+    render_thread_ = std::thread{&D3DApp::RenderThreadMain, this};
+    while (GetMessage(&message, nullptr, 0, 0) > 0) {
+      TranslateMessage(&message);
+      DispatchMessage(&message);
+    }
+    StopRenderThread();
+    streaming_.reset();
+    WaitForGPU();
+    return;
+  }
+
   while (WM_QUIT != message.message) {
     if (PeekMessage(&message, 0, 0, 0, PM_REMOVE)) {
       TranslateMessage(&message);
       DispatchMessage(&message);
-    } else {
+    } else if (ShouldRender()) {
       RenderFrame();
+    } else {
+      WaitForWork();
     }
   }
 }
 
 D3DApp::D3DApp() {
-  event_handle_ = CreateEvent(nullptr, false, false, nullptr);
+  invalidate_event_ = CreateEvent(nullptr, false, false, nullptr);
+  render_thread_exited_ = CreateEvent(nullptr, true, false, nullptr);
 }
 
 D3DApp::~D3DApp() {
+  StopRenderThread();
+  // Before waiting, so that the stream thread submits nothing after it.
+  streaming_.reset();
   WaitForGPU();
-  CloseHandle(event_handle_);
+  release_queue_->Flush();
+  render_->gate_ = nullptr;
+  render_->invalidate_event_ = nullptr;
+  CloseHandle(invalidate_event_);
+  CloseHandle(render_thread_exited_);
 }
 
 LRESULT CALLBACK D3DApp::WindowProc(HWND hwnd, UINT message, WPARAM wParam,
@@ -331,60 +495,186 @@ D3D12_CPU_DESCRIPTOR_HANDLE D3DApp::CurrentDepthStencilDescriptor() {
 }
 
 void D3DApp::WaitForGPU() {
-  if (fence_->GetCompletedValue() < current_fence_value_) {
-    fence_->SetEventOnCompletion(current_fence_value_, event_handle_);
-    WaitForSingleObject(event_handle_, INFINITE);
+  fence_timeline_->Wait(frame_schedule_->fence_value());
+}
+
+bool D3DApp::ShouldRender() {
+  return render_gate_->ShouldRender([this]() {
+    return DXGI_STATUS_OCCLUDED == swap_chain_->Present(0, DXGI_PRESENT_TEST);
+  });
+}
+
+void D3DApp::WaitForWork() {
+  if (window_messages_) {
+    // Forwarded messages wake the gate too.
+    render_gate_->WaitForWork(std::chrono::milliseconds{idle_timeout_});
+    return;
   }
+  MsgWaitForMultipleObjectsEx(1, &invalidate_event_, idle_timeout_,
+                              QS_ALLINPUT, MWMO_INPUTAVAILABLE);
 }
 
-void D3DApp::RenderFrame() {
-  FrameResource* current_frame = &frame_resources_[frame_index_];
-  ID3D12Resource* back_buffer = render_target_[back_buffer_index_].Get();
+void D3DApp::RenderThreadMain() {
+  WindowMessage message{};
+  while (render_thread_running_.load(std::memory_order_acquire)) {
+    while (window_messages_->TryPop(message)) {
+      render_->OnWindowMessage(message.hwnd, message.message, message.wParam,
+                               message.lParam);
+    }
 
-  if (fence_->GetCompletedValue() < current_frame->fence_value) {
-    fence_->SetEventOnCompletion(current_frame->fence_value, event_handle_);
-    WaitForSingleObject(event_handle_, INFINITE);
+    if (ShouldRender()) {
+      RenderFrame();
+    } else {
+      WaitForWork();
+    }
   }
+  SetEvent(render_thread_exited_);
+}
 
-  current_frame->command_allocator->Reset();
-  command_list_->Reset(current_frame->command_allocator.Get(), nullptr);
-  command_list_->ResourceBarrier(1,
-                                 &CD3DX12_RESOURCE_BARRIER::Transition(
-                                     back_buffer, D3D12_RESOURCE_STATE_PRESENT,
-                                     D3D12_RESOURCE_STATE_RENDER_TARGET));
+void D3DApp::RequestRenderThreadStop() {
+  render_thread_running_.store(false, std::memory_order_release);
+  render_gate_->Wake();
+}
 
-  command_list_->RSSetViewports(1, &viewport_);
-  command_list_->RSSetScissorRects(1, &scissor_rect_);
+void D3DApp::StopRenderThread() {
+  if (!render_thread_.joinable()) {
+    return;
+  }
+  RequestRenderThreadStop();
+  // Present may send messages to the window and wait for them to be
+  // handled, so the last frame only finishes if this thread keeps pumping.
+  MSG message{};
+  while (WAIT_OBJECT_0 + 1 ==
+         MsgWaitForMultipleObjectsEx(1, &render_thread_exited_, INFINITE,
+                                     QS_ALLINPUT, MWMO_INPUTAVAILABLE)) {
+    while (PeekMessage(&message, nullptr, 0, 0, PM_REMOVE)) {
+      TranslateMessage(&message);
+      DispatchMessage(&message);
+    }
+  }
+  render_thread_.join();
+}
 
-  command_list_->ClearRenderTargetView(CurrentRenderTargetDescriptor(),
-                                       clear_color_, 0, nullptr);
-  command_list_->ClearDepthStencilView(
-      CurrentDepthStencilDescriptor(),
-      D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+void D3DApp::ForwardMessage(HWND hwnd, UINT message, WPARAM wParam,
+                            LPARAM lParam) {
+  // The render thread drains the queue every frame, so a full queue only
+  // lasts until it wakes up. Mouse moves come in bursts that the next one
+  // supersedes and are dropped right away; anything else waits for room
+  // for up to about a frame and is then dropped rather than stalling the
+  // window.
+  const WindowMessage forwarded{hwnd, message, wParam, lParam};
+  for (int retry = 0; !window_messages_->TryPush(forwarded); ++retry) {
+    if (WM_MOUSEMOVE == message || kForwardRetryCount == retry ||
+        !render_thread_running_.load(std::memory_order_acquire)) {
+      break;
+    }
+    render_gate_->Wake();
+    Sleep(1);
+  }
+  render_gate_->Wake();
+}
 
-  command_list_->OMSetRenderTargets(1, &CurrentRenderTargetDescriptor(), true,
-                                    &CurrentDepthStencilDescriptor());
+void D3DApp::BindFrameTargets(ID3D12GraphicsCommandList* command_list) {
+  ID3D12DescriptorHeap* descriptor_heaps[]{descriptor_heap_->heap()};
+  command_list->SetDescriptorHeaps(_countof(descriptor_heaps),
+                                   descriptor_heaps);
+  command_list->RSSetViewports(1, &viewport_);
+  command_list->RSSetScissorRects(1, &scissor_rect_);
+  D3D12_CPU_DESCRIPTOR_HANDLE render_target = CurrentRenderTargetDescriptor();
+  D3D12_CPU_DESCRIPTOR_HANDLE depth_stencil = CurrentDepthStencilDescriptor();
+  command_list->OMSetRenderTargets(1, &render_target, true, &depth_stencil);
+}
 
-  render_->OnRender(frame_index_, command_list_.Get());
+void D3DApp::RenderFrame() {
+  frame_pacer_->WaitForNextFrame();
 
-  command_list_->ResourceBarrier(
-      1, &CD3DX12_RESOURCE_BARRIER::Transition(
-             back_buffer, D3D12_RESOURCE_STATE_RENDER_TARGET,
-             D3D12_RESOURCE_STATE_PRESENT));
+  FrameResource* current_frame =
+      &frame_resources_[frame_schedule_->frame_index()];
+  back_buffer_index_ = swap_chain_->GetCurrentBackBufferIndex();
+  ID3D12Resource* back_buffer = render_target_[back_buffer_index_].Get();
+
+  fence_timeline_->Wait(frame_schedule_->WaitValue());
+  UINT64 completed_value = fence_timeline_->completed_value();
+  release_queue_->Collect(completed_value);
+  release_queue_->SetFenceValue(frame_schedule_->next_fence_value());
+  upload_ring_->Reclaim(completed_value);
+  descriptor_heap_->Reclaim(completed_value);
+
+  CommandListPool* command_list_pool = current_frame->command_list_pool.get();
+  command_list_pool->Reset();
+  command_list_pool->SetPrologue(nullptr);
+
+  ID3D12GraphicsCommandList* command_list = command_list_pool->Acquire();
+  ResourceStateTracker* state_tracker =
+      command_list_pool->state_tracker(command_list);
+  state_tracker->Assume(back_buffer, D3D12_RESOURCE_STATE_PRESENT);
+  state_tracker->Transition(back_buffer, kAllSubresources,
+                            D3D12_RESOURCE_STATE_RENDER_TARGET);
+  command_list_pool->FlushBarriers(command_list);
+
+  command_list->ClearRenderTargetView(CurrentRenderTargetDescriptor(),
+                                      clear_color_, 0, nullptr);
+  command_list->ClearDepthStencilView(
+      CurrentDepthStencilDescriptor(),
+      D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
-  command_list_->Close();
+  BindFrameTargets(command_list);
+  command_list_pool->SetPrologue(
+      [this](ID3D12GraphicsCommandList* list) { BindFrameTargets(list); });
+
+  FrameContext frame{};
+  frame.frame_index = frame_schedule_->frame_index();
+  frame.fence_value = frame_schedule_->next_fence_value();
+  frame.job_system = job_system_.get();
+  frame.fence_timeline = fence_timeline_.get();
+  frame.release_queue = release_queue_.get();
+  frame.upload_ring = upload_ring_.get();
+  frame.footprint_cache = footprint_cache_.get();
+  frame.streaming = streaming_.get();
+  frame.streaming_copy_queue = streaming_copy_queue_;
+  frame.descriptor_heap = descriptor_heap_.get();
+  frame.staging_descriptor_heap = staging_descriptor_heap_.get();
+  frame.heap_allocator = heap_allocator_.get();
+  frame.resource_states = resource_states_.get();
+  frame.residency = residency_manager_.get();
+  frame.command_list = command_list;
+  frame.command_list_pool = command_list_pool;
+  render_graph_->Reset();
+  frame.render_graph = render_graph_.get();
+  frame.back_buffer = render_graph_->Import(
+      back_buffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+  render_graph_->Export(frame.back_buffer, D3D12_RESOURCE_STATE_PRESENT);
+  frame.depth_stencil = render_graph_->Import(
+      depth_stencil_.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+  render_graph_->Export(frame.depth_stencil,
+                       D3D12_RESOURCE_STATE_DEPTH_WRITE);
+  // Ready callbacks run before OnRender so that this frame can use the
+  // data; its lists then wait for the copies on the GPU.
+  UINT64 copy_value = streaming_->DeliverReady();
+  if (copy_value > 0) {
+    command_queue_->Wait(streaming_copy_queue_->fence(), copy_value);
+  }
+  render_->OnRender(frame);
 
-  ID3D12CommandList* command_lists[]{command_list_.Get()};
-  command_queue_->ExecuteCommandLists(_countof(command_lists), command_lists);
+  // Parallel lists run after the head list, so the graph passes and the
+  // transition back to present need their own list at the end of the batch.
+  if (command_list_pool->size() > 1) {
+    command_list = command_list_pool->Acquire();
+  }
+  render_graph_->Execute(command_list, command_list_pool);
 
-  swap_chain_->Present(0, 0);
+  residency_manager_->Update(fence_->GetCompletedValue());
+  command_list_pool->Execute(command_queue_.Get());
 
-  ++current_fence_value_;
-  command_queue_->Signal(fence_.Get(), current_fence_value_);
-  current_frame->fence_value = current_fence_value_;
+  if (DXGI_STATUS_OCCLUDED ==
+      swap_chain_->Present(sync_interval_, present_flags_)) {
+    render_gate_->SetOccluded();
+  }
 
-  frame_index_ = (frame_index_ + 1) % frame_count_;
-  back_buffer_index_ = (back_buffer_index_ + 1) % kRenderTargetCount;
+  UINT64 fence_value = frame_schedule_->EndFrame();
+  command_queue_->Signal(fence_.Get(), fence_value);
+  upload_ring_->EndFrame(fence_value);
+  descriptor_heap_->EndFrame(fence_value);
 }
 
 LRESULT D3DApp::OnMessage(HWND hwnd, UINT message, WPARAM wParam,
@@ -394,6 +684,15 @@ LRESULT D3DApp::OnMessage(HWND hwnd, UINT message, WPARAM wParam,
       PostMessage(hwnd, WM_NCLBUTTONDOWN, HTCAPTION, lParam);
       break;
     }
+    case WM_SIZE: {
+      render_gate_->SetMinimized(SIZE_MINIMIZED == wParam);
+      render_->Invalidate();
+      break;
+    }
+    case WM_PAINT: {
+      render_->Invalidate();
+      break;
+    }
     case WM_KEYUP: {
       if (VK_ESCAPE == wParam) {
         DestroyWindow(hwnd);
@@ -401,12 +700,23 @@ LRESULT D3DApp::OnMessage(HWND hwnd, UINT message, WPARAM wParam,
       break;
     }
     case WM_DESTROY: {
-      WaitForGPU();
+      // Joining here could deadlock with a Present that waits on this
+      // thread; Run joins the render thread once the message loop is done.
+      if (window_messages_) {
+        RequestRenderThreadStop();
+      } else {
+        streaming_.reset();
+        WaitForGPU();
+      }
       PostQuitMessage(0);
       break;
     }
   }
 
+  if (window_messages_) {
+    ForwardMessage(hwnd, message, wParam, lParam);
+    return DefWindowProc(hwnd, message, wParam, lParam);
+  }
   return render_->OnMessage(hwnd, message, wParam, lParam);
 }
 
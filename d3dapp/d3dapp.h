@@ -5,22 +5,120 @@
 
 #include <DirectXColors.h>
 #include <d3dx12.h>
-#include <dxgi1_4.h>
+#include <dxgi1_5.h>
 
+#include <atomic>
 #include <memory>
+#include <thread>
 #include <vector>
 
+#include "command_list_pool.h"
+#include "deferred_release_queue.h"
+#include "descriptor_heap.h"
+#include "fence_timeline.h"
+#include "frame_pacer.h"
+#include "frame_schedule.h"
+#include "footprint_cache.h"
 #include "framework.h"
+#include "heap_allocator.h"
+#include "job_system.h"
+#include "render_gate.h"
+#include "render_graph.h"
+#include "residency_manager.h"
+#include "spsc_queue.h"
+#include "streaming_copy_queue.h"
+#include "streaming_pipeline.h"
+#include "upload_heap_pages.h"
+#include "upload_ring.h"
 
 namespace d3dapp {
+struct CreateContext {
+  ID3D12Device* device{nullptr};
+  JobSystem* job_system{nullptr};
+  // Timeline of the direct queue fence.
+  FenceTimeline* fence_timeline{nullptr};
+  DeferredReleaseQueue* release_queue{nullptr};
+  // Allocations made here are valid until the first frame completes.
+  UploadRing* upload_ring{nullptr};
+  // Copyable footprints of textures, computed once per desc.
+  FootprintCache* footprint_cache{nullptr};
+  // Streams data from mapped files through staging memory on a copy queue.
+  // Record callbacks copy with streaming_copy_queue; frames rendered after
+  // a request's ready callback may use its data.
+  StreamingPipeline* streaming{nullptr};
+  StreamingCopyQueue* streaming_copy_queue{nullptr};
+  // CBV/SRV/UAV heap bound on every frame list, and CPU-only descriptors to
+  // create views in and copy from.
+  ShaderVisibleDescriptorHeap* descriptor_heap{nullptr};
+  StagingDescriptorHeap* staging_descriptor_heap{nullptr};
+  // Places textures and buffers in shared heaps instead of committing each.
+  HeapAllocator* heap_allocator{nullptr};
+  // States resources are left in by submitted lists. Register resources
+  // here to have every list's state tracker resolve them at submit time.
+  ResourceStateRegistry* resource_states{nullptr};
+  // Register large heaps and committed resources to have the least recently
+  // used ones evicted when video memory runs over budget.
+  ResidencyManager* residency{nullptr};
+  void* data{nullptr};
+};
+
+struct FrameContext {
+  int frame_index{0};
+  // Fence value the direct queue signals once this frame's lists complete.
+  UINT64 fence_value{0};
+  JobSystem* job_system{nullptr};
+  FenceTimeline* fence_timeline{nullptr};
+  // Objects dropped here are freed once fence_value completes.
+  DeferredReleaseQueue* release_queue{nullptr};
+  // Per-frame upload memory, valid until fence_value completes.
+  UploadRing* upload_ring{nullptr};
+  FootprintCache* footprint_cache{nullptr};
+  StreamingPipeline* streaming{nullptr};
+  StreamingCopyQueue* streaming_copy_queue{nullptr};
+  // Transient ranges allocated here are valid until fence_value completes.
+  ShaderVisibleDescriptorHeap* descriptor_heap{nullptr};
+  StagingDescriptorHeap* staging_descriptor_heap{nullptr};
+  HeapAllocator* heap_allocator{nullptr};
+  ResourceStateRegistry* resource_states{nullptr};
+  // Mark registered objects used with fence_value; evicted ones are made
+  // resident again before the frame is submitted.
+  ResidencyManager* residency{nullptr};
+  // Opened with the viewport, scissor rect, render targets and descriptor
+  // heap bound.
+  ID3D12GraphicsCommandList* command_list{nullptr};
+  // Extra lists for parallel recording, bound like command_list and submitted
+  // after it in acquisition order. Each list's state tracker is reached
+  // through the pool. Acquire them before handing them to
+  // worker threads, and join the workers before OnRender returns.
+  CommandListPool* command_list_pool{nullptr};
+  // Passes added here run after everything recorded into the lists above.
+  // The back buffer and depth buffer are imported as render target and depth
+  // write and are returned to present and depth write after the last pass.
+  RenderGraph* render_graph{nullptr};
+  uint32_t back_buffer{0};
+  uint32_t depth_stencil{0};
+};
+
 class Render {
  public:
   virtual LRESULT OnMessage(HWND hwnd, UINT message, WPARAM wParam,
                             LPARAM lParam);
-  virtual void OnCreate(ID3D12Device* device, void* data);
-  virtual void OnRender(int frame_index,
-                        ID3D12GraphicsCommandList* command_list);
+  virtual void OnCreate(const CreateContext& context);
+  virtual void OnRender(const FrameContext& frame);
+  // With a render thread, messages are handled on the window thread and then
+  // replayed here on the render thread instead of going to OnMessage.
+  virtual void OnWindowMessage(HWND hwnd, UINT message, WPARAM wParam,
+                               LPARAM lParam);
   virtual ~Render();
+
+  // Asks for another frame when the app renders on demand. Safe to call from
+  // any thread.
+  void Invalidate();
+
+ private:
+  friend class D3DApp;
+  RenderGate* gate_{nullptr};
+  HANDLE invalidate_event_{nullptr};
 };
 
 class D3DApp {
@@ -32,7 +130,41 @@ class D3DApp {
     int height{600};
     DWORD window_style{WS_OVERLAPPEDWINDOW & ~(WS_MAXIMIZEBOX | WS_THICKFRAME)};
     DWORD window_style_ex{0};
+    // Frames the CPU may record ahead of the GPU.
     int frame_count{2};
+    // Swap chain buffers, clamped to [2, 4].
+    int back_buffer_count{2};
+    // Size of each page of per-frame upload memory.
+    UINT64 upload_page_size{2 * 1024 * 1024};
+    // Split of the shader-visible CBV/SRV/UAV heap.
+    UINT persistent_descriptor_count{4096};
+    UINT transient_descriptor_count{16384};
+    // Size of each ID3D12Heap that resources are placed in, rounded up to a
+    // power of two.
+    UINT64 heap_block_size{HeapAllocator::kDefaultBlockSize};
+    // Video memory evictions leave free below the budget.
+    UINT64 residency_headroom{64 * 1024 * 1024};
+    // Job system workers; -1 uses one per physical core beyond the first.
+    int worker_count{-1};
+    // Staging memory of the streaming pipeline, which bounds the data in
+    // flight and the largest request.
+    UINT64 streaming_staging_size{64 * 1024 * 1024};
+    // Frame rate limit, 0 for none.
+    double target_fps{0.0};
+    // Frames submitted but not yet finished by the GPU, including the one
+    // being submitted. 0 leaves it to frame_count.
+    int max_queued_frames{0};
+    // Present sync interval, 0 for no vsync.
+    UINT sync_interval{0};
+    // Lets unsynchronized presents tear when the display supports it.
+    bool allow_tearing{false};
+    // Only renders after Render::Invalidate; otherwise the message loop
+    // sleeps for up to idle_timeout milliseconds at a time.
+    bool on_demand{false};
+    DWORD idle_timeout{100};
+    // Renders on a dedicated thread so that window drags and modal loops on
+    // the window thread do not stall frames.
+    bool render_thread{false};
     DirectX::XMVECTORF32 clear_color{};
     Render* render;
     void* data;
@@ -43,11 +175,19 @@ class D3DApp {
 
  private:
   struct FrameResource {
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_allocator;
-    UINT64 fence_value{0};
+    std::unique_ptr<CommandListPool> command_list_pool;
+  };
+
+  struct WindowMessage {
+    HWND hwnd;
+    UINT message;
+    WPARAM wParam;
+    LPARAM lParam;
   };
 
-  static constexpr int kRenderTargetCount = 2;
+  static constexpr size_t kWindowMessageQueueSize = 1024;
+  // Milliseconds a forwarded message waits for room in a full queue.
+  static constexpr int kForwardRetryCount = 16;
 
   static void Destroy(D3DApp* app);
   D3DApp();
@@ -62,24 +202,48 @@ class D3DApp {
   D3D12_CPU_DESCRIPTOR_HANDLE CurrentDepthStencilDescriptor();
 
   void WaitForGPU();
+  bool ShouldRender();
+  void WaitForWork();
+  void RenderThreadMain();
+  void RequestRenderThreadStop();
+  // Joins the render thread, handling messages until it is out.
+  void StopRenderThread();
+  void ForwardMessage(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
+  void BindFrameTargets(ID3D12GraphicsCommandList* command_list);
   void RenderFrame();
   LRESULT OnMessage(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 
   thread_local static std::shared_ptr<D3DApp> tlsAppInstance;
+  std::unique_ptr<JobSystem> job_system_;
+  // Declared after job_system_ so its decode jobs finish before the workers
+  // are joined. Shutdown resets it before the last WaitForGPU, ahead of the
+  // device objects its copies use.
+  std::unique_ptr<StreamingPipeline> streaming_;
+  StreamingCopyQueue* streaming_copy_queue_{nullptr};
+  std::unique_ptr<FramePacer> frame_pacer_;
   Microsoft::WRL::ComPtr<ID3D12Device> device_;
   Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
+  std::unique_ptr<FenceTimeline> fence_timeline_;
+  std::unique_ptr<FrameSchedule> frame_schedule_;
+  std::unique_ptr<DeferredReleaseQueue> release_queue_;
+  std::unique_ptr<UploadRing> upload_ring_;
+  std::unique_ptr<FootprintCache> footprint_cache_;
+  std::unique_ptr<ShaderVisibleDescriptorHeap> descriptor_heap_;
+  std::unique_ptr<StagingDescriptorHeap> staging_descriptor_heap_;
+  std::unique_ptr<HeapAllocator> heap_allocator_;
+  std::unique_ptr<ResourceStateRegistry> resource_states_;
+  std::unique_ptr<ResidencyManager> residency_manager_;
   Microsoft::WRL::ComPtr<ID3D12CommandQueue> command_queue_;
-  Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> command_list_;
   std::vector<FrameResource> frame_resources_;
+  std::unique_ptr<RenderGraph> render_graph_;
 
-  Microsoft::WRL::ComPtr<IDXGISwapChain1> swap_chain_;
-  Microsoft::WRL::ComPtr<ID3D12Resource> render_target_[kRenderTargetCount];
+  Microsoft::WRL::ComPtr<IDXGISwapChain3> swap_chain_;
+  std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> render_target_;
   Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtv_descriptor_;
 
   Microsoft::WRL::ComPtr<ID3D12Resource> depth_stencil_;
   Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsv_descriptor_;
 
-  HANDLE event_handle_{CreateEvent(nullptr, false, false, nullptr)};
   Render* render_{nullptr};
   DirectX::XMVECTORF32 clear_color_{DirectX::Colors::LightCyan};
 
@@ -90,9 +254,19 @@ class D3DApp {
   D3D12_VIEWPORT viewport_{};
   D3D12_RECT scissor_rect_{};
 
-  UINT64 current_fence_value_{0};
-  int frame_count_{0};
-  int frame_index_{0};
+  UINT sync_interval_{0};
+  UINT present_flags_{0};
+
+  HANDLE invalidate_event_{nullptr};
+  DWORD idle_timeout_{0};
+  std::unique_ptr<RenderGate> render_gate_;
+
+  std::unique_ptr<SpscQueue<WindowMessage, kWindowMessageQueueSize>>
+      window_messages_;
+  std::thread render_thread_;
+  std::atomic<bool> render_thread_running_{false};
+  HANDLE render_thread_exited_{nullptr};
+
   int back_buffer_index_{0};
 };
 
@@ -0,0 +1,53 @@
+#include "deferred_release_queue.h"
+
+namespace d3dapp {
+DeferredReleaseQueue::~DeferredReleaseQueue() { Flush(); }
+
+void DeferredReleaseQueue::SetFenceValue(uint64_t fence_value) {
+  fence_value_.store(fence_value, std::memory_order_release);
+}
+
+// The fence value is read under the lock so that entries are pushed in
+// non-decreasing order even when SetFenceValue races with Release.
+void DeferredReleaseQueue::Release(IUnknown* object) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  uint64_t fence_value = fence_value_.load(std::memory_order_acquire);
+  objects_.push_back(Object{fence_value, object});
+}
+
+void DeferredReleaseQueue::Release(std::function<void()> deleter) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  uint64_t fence_value = fence_value_.load(std::memory_order_acquire);
+  deleters_.push_back(Deleter{fence_value, std::move(deleter)});
+}
+
+size_t DeferredReleaseQueue::Collect(uint64_t completed_value) {
+  {
+    // Entries are tagged in non-decreasing order, so the ready ones are
+    // always at the front.
+    std::lock_guard<std::mutex> lock{mutex_};
+    while (!objects_.empty() &&
+           objects_.front().fence_value <= completed_value) {
+      ready_objects_.push_back(objects_.front().object);
+      objects_.pop_front();
+    }
+    while (!deleters_.empty() &&
+           deleters_.front().fence_value <= completed_value) {
+      ready_deleters_.push_back(std::move(deleters_.front().deleter));
+      deleters_.pop_front();
+    }
+  }
+
+  size_t count = ready_objects_.size() + ready_deleters_.size();
+  for (IUnknown* object : ready_objects_) {
+    object->Release();
+  }
+  for (auto& deleter : ready_deleters_) {
+    deleter();
+  }
+  ready_objects_.clear();
+  ready_deleters_.clear();
+  return count;
+}
+
+}  // namespace d3dapp
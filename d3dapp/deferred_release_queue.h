@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef __DEFERRED_RELEASE_QUEUE_H__
+#define __DEFERRED_RELEASE_QUEUE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "framework.h"
+
+namespace d3dapp {
+// Holds on to GPU objects until the fence passes the value that was current
+// when they were dropped, then frees them in bulk. Release may be called from
+// any thread; Collect and Flush belong to the render thread.
+class DeferredReleaseQueue {
+ public:
+  DeferredReleaseQueue() = default;
+  DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+  DeferredReleaseQueue& operator=(const DeferredReleaseQueue&) = delete;
+  ~DeferredReleaseQueue();
+
+  // Fence value that tags everything released from now on, i.e. the value
+  // the queue will signal after the commands being recorded.
+  void SetFenceValue(uint64_t fence_value);
+
+  // Takes over the caller's reference.
+  template <typename T>
+  void Release(Microsoft::WRL::ComPtr<T>& object) {
+    if (object) {
+      Release(static_cast<IUnknown*>(object.Detach()));
+    }
+  }
+  void Release(IUnknown* object);
+
+  // For things that are not COM objects, e.g. descriptor ranges.
+  void Release(std::function<void()> deleter);
+
+  // Frees everything tagged with a value up to completed_value and returns
+  // how many entries were freed.
+  size_t Collect(uint64_t completed_value);
+
+  // Frees everything. The GPU must be idle.
+  size_t Flush() { return Collect(UINT64_MAX); }
+
+ private:
+  struct Object {
+    uint64_t fence_value;
+    IUnknown* object;
+  };
+
+  struct Deleter {
+    uint64_t fence_value;
+    std::function<void()> deleter;
+  };
+
+  std::atomic<uint64_t> fence_value_{0};
+
+  std::mutex mutex_;
+  std::deque<Object> objects_;
+  std::deque<Deleter> deleters_;
+
+  // Reused by Collect so that steady-state collection does not allocate.
+  std::vector<IUnknown*> ready_objects_;
+  std::vector<std::function<void()>> ready_deleters_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__DEFERRED_RELEASE_QUEUE_H__
@@ -0,0 +1,172 @@
+#pragma once
+
+#ifndef __DESCRIPTOR_ALLOCATOR_H__
+#define __DESCRIPTOR_ALLOCATOR_H__
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace d3dapp {
+// Index bookkeeping behind the descriptor heaps; none of these classes
+// touches the device.
+
+// Single slots out of a fixed range, O(1) both ways.
+class DescriptorFreeList {
+ public:
+  explicit DescriptorFreeList(uint32_t capacity);
+
+  bool Allocate(uint32_t* index);
+  void Free(uint32_t index);
+
+  uint32_t capacity() const { return capacity_; }
+  uint32_t free_count() const { return static_cast<uint32_t>(free_.size()); }
+
+ private:
+  uint32_t capacity_;
+  std::vector<uint32_t> free_;
+};
+
+// Single slots out of blocks of block_size, adding a block whenever none is
+// free. Slot i stays at offset(i) of block(i) for good, so the staging heap
+// can back each block with its own descriptor heap.
+class DescriptorBlockList {
+ public:
+  explicit DescriptorBlockList(uint32_t block_size);
+
+  // Grows block_count() when it had to add a block; the caller backs the
+  // new block before using the slot.
+  uint32_t Allocate();
+  void Free(uint32_t index);
+
+  uint32_t block(uint32_t index) const { return index / block_size_; }
+  uint32_t offset(uint32_t index) const { return index % block_size_; }
+  uint32_t block_size() const { return block_size_; }
+  uint32_t block_count() const { return block_count_; }
+  uint32_t free_count() const { return static_cast<uint32_t>(free_.size()); }
+
+ private:
+  uint32_t block_size_;
+  uint32_t block_count_{0};
+  std::vector<uint32_t> free_;
+};
+
+// Contiguous ranges out of a ring, released a frame at a time once the
+// frame's fence completes. A range never wraps; the tail of the ring is
+// skipped instead.
+class DescriptorRing {
+ public:
+  explicit DescriptorRing(uint32_t capacity);
+
+  // Fails when the frames still in flight leave no room.
+  bool Allocate(uint32_t count, uint32_t* offset);
+  void EndFrame(uint64_t fence_value);
+  void Reclaim(uint64_t completed_value);
+
+  uint32_t capacity() const { return capacity_; }
+  uint32_t used_count() const { return used_; }
+
+ private:
+  struct Frame {
+    uint64_t fence_value;
+    uint32_t head;
+    uint32_t used;
+  };
+
+  uint32_t capacity_;
+  uint32_t head_{0};
+  uint32_t tail_{0};
+  uint32_t used_{0};
+  uint32_t frame_used_{0};
+  std::deque<Frame> frames_;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+inline DescriptorFreeList::DescriptorFreeList(uint32_t capacity)
+    : capacity_{capacity} {
+  free_.reserve(capacity);
+  for (uint32_t i = capacity; i > 0; --i) {
+    free_.push_back(i - 1);
+  }
+}
+
+inline bool DescriptorFreeList::Allocate(uint32_t* index) {
+  if (free_.empty()) {
+    return false;
+  }
+  *index = free_.back();
+  free_.pop_back();
+  return true;
+}
+
+inline void DescriptorFreeList::Free(uint32_t index) { free_.push_back(index); }
+
+inline DescriptorBlockList::DescriptorBlockList(uint32_t block_size)
+    : block_size_{block_size} {}
+
+inline uint32_t DescriptorBlockList::Allocate() {
+  if (free_.empty()) {
+    const uint32_t first = block_count_ * block_size_;
+    ++block_count_;
+    for (uint32_t i = block_size_; i > 0; --i) {
+      free_.push_back(first + i - 1);
+    }
+  }
+  const uint32_t index = free_.back();
+  free_.pop_back();
+  return index;
+}
+
+inline void DescriptorBlockList::Free(uint32_t index) {
+  free_.push_back(index);
+}
+
+inline DescriptorRing::DescriptorRing(uint32_t capacity)
+    : capacity_{capacity} {}
+
+inline bool DescriptorRing::Allocate(uint32_t count, uint32_t* offset) {
+  if (0 == used_) {
+    // Nothing is in flight, so frames still pending are empty as well.
+    head_ = tail_ = 0;
+    for (Frame& frame : frames_) {
+      frame.head = 0;
+    }
+  }
+
+  uint32_t skipped = 0;
+  if (head_ >= tail_ && used_ < capacity_) {
+    // Free space is [head_, capacity_) followed by [0, tail_).
+    if (head_ + count > capacity_) {
+      if (count > tail_) {
+        return false;
+      }
+      skipped = capacity_ - head_;
+      head_ = 0;
+    }
+  } else if (head_ + count > tail_) {
+    return false;
+  }
+
+  *offset = head_;
+  head_ += count;
+  used_ += skipped + count;
+  frame_used_ += skipped + count;
+  return true;
+}
+
+inline void DescriptorRing::EndFrame(uint64_t fence_value) {
+  frames_.push_back(Frame{fence_value, head_, frame_used_});
+  frame_used_ = 0;
+}
+
+inline void DescriptorRing::Reclaim(uint64_t completed_value) {
+  while (!frames_.empty() && frames_.front().fence_value <= completed_value) {
+    tail_ = frames_.front().head;
+    used_ -= frames_.front().used;
+    frames_.pop_front();
+  }
+}
+
+}  // namespace d3dapp
+
+#endif  // !__DESCRIPTOR_ALLOCATOR_H__
@@ -0,0 +1,124 @@
+#include "descriptor_heap.h"
+
+namespace d3dapp {
+StagingDescriptorHeap::StagingDescriptorHeap(ID3D12Device* device,
+                                             D3D12_DESCRIPTOR_HEAP_TYPE type,
+                                             UINT block_size)
+    : device_{device},
+      type_{type},
+      block_size_{block_size},
+      descriptor_size_{device->GetDescriptorHandleIncrementSize(type)},
+      slots_{block_size} {}
+
+DescriptorHandle StagingDescriptorHeap::Allocate() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  UINT index = slots_.Allocate();
+  if (slots_.block_count() > blocks_.size()) {
+    D3D12_DESCRIPTOR_HEAP_DESC heap_desc{};
+    heap_desc.NumDescriptors = block_size_;
+    heap_desc.Type = type_;
+    heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    heap_desc.NodeMask = 0;
+
+    Block block{};
+    device_->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(&block.heap));
+    block.start = block.heap->GetCPUDescriptorHandleForHeapStart();
+    blocks_.push_back(block);
+  }
+
+  DescriptorHandle handle{};
+  handle.index = index;
+  handle.cpu = CD3DX12_CPU_DESCRIPTOR_HANDLE(
+      blocks_[slots_.block(index)].start, slots_.offset(index),
+      descriptor_size_);
+  return handle;
+}
+
+void StagingDescriptorHeap::Free(const DescriptorHandle& handle) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  slots_.Free(handle.index);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+ShaderVisibleDescriptorHeap::ShaderVisibleDescriptorHeap(
+    ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type,
+    UINT persistent_count, UINT transient_count)
+    : device_{device},
+      type_{type},
+      descriptor_size_{device->GetDescriptorHandleIncrementSize(type)},
+      persistent_count_{persistent_count},
+      persistent_{persistent_count},
+      transient_{transient_count} {
+  D3D12_DESCRIPTOR_HEAP_DESC heap_desc{};
+  heap_desc.NumDescriptors = persistent_count + transient_count;
+  heap_desc.Type = type;
+  heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+  heap_desc.NodeMask = 0;
+  device->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(&heap_));
+
+  cpu_start_ = heap_->GetCPUDescriptorHandleForHeapStart();
+  gpu_start_ = heap_->GetGPUDescriptorHandleForHeapStart();
+}
+
+DescriptorHandle ShaderVisibleDescriptorHeap::AllocatePersistent() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  uint32_t index = 0;
+  if (!persistent_.Allocate(&index)) {
+    return DescriptorHandle{};
+  }
+  return HandleAt(index);
+}
+
+void ShaderVisibleDescriptorHeap::FreePersistent(
+    const DescriptorHandle& handle) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  persistent_.Free(handle.index);
+}
+
+DescriptorHandle ShaderVisibleDescriptorHeap::AllocateTransient(UINT count) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  uint32_t offset = 0;
+  if (!transient_.Allocate(count, &offset)) {
+    return DescriptorHandle{};
+  }
+  return HandleAt(persistent_count_ + offset);
+}
+
+DescriptorHandle ShaderVisibleDescriptorHeap::CopyToTransient(
+    UINT count, const D3D12_CPU_DESCRIPTOR_HANDLE* sources) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  uint32_t offset = 0;
+  if (!transient_.Allocate(count, &offset)) {
+    return DescriptorHandle{};
+  }
+  DescriptorHandle handle = HandleAt(persistent_count_ + offset);
+
+  if (copy_range_sizes_.size() < count) {
+    copy_range_sizes_.resize(count, 1);
+  }
+  device_->CopyDescriptors(1, &handle.cpu, &count, count, sources,
+                           copy_range_sizes_.data(), type_);
+  return handle;
+}
+
+void ShaderVisibleDescriptorHeap::EndFrame(uint64_t fence_value) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  transient_.EndFrame(fence_value);
+}
+
+void ShaderVisibleDescriptorHeap::Reclaim(uint64_t completed_value) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  transient_.Reclaim(completed_value);
+}
+
+DescriptorHandle ShaderVisibleDescriptorHeap::HandleAt(UINT index) const {
+  DescriptorHandle handle{};
+  handle.index = index;
+  handle.cpu = CD3DX12_CPU_DESCRIPTOR_HANDLE(cpu_start_, index,
+                                             descriptor_size_);
+  handle.gpu = CD3DX12_GPU_DESCRIPTOR_HANDLE(gpu_start_, index,
+                                             descriptor_size_);
+  return handle;
+}
+
+}  // namespace d3dapp
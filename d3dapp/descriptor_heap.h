@@ -0,0 +1,106 @@
+#pragma once
+
+#ifndef __DESCRIPTOR_HEAP_H__
+#define __DESCRIPTOR_HEAP_H__
+
+#include <d3dx12.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "descriptor_allocator.h"
+#include "framework.h"
+
+namespace d3dapp {
+struct DescriptorHandle {
+  D3D12_CPU_DESCRIPTOR_HANDLE cpu{0};
+  D3D12_GPU_DESCRIPTOR_HANDLE gpu{0};
+  UINT index{0};
+
+  bool IsNull() const { return 0 == cpu.ptr; }
+};
+
+// CPU-only descriptors for creating views ahead of time. Grows by whole
+// blocks and never moves a descriptor once created.
+class StagingDescriptorHeap {
+ public:
+  StagingDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type,
+                        UINT block_size);
+  StagingDescriptorHeap(const StagingDescriptorHeap&) = delete;
+  StagingDescriptorHeap& operator=(const StagingDescriptorHeap&) = delete;
+
+  DescriptorHandle Allocate();
+  void Free(const DescriptorHandle& handle);
+
+ private:
+  struct Block {
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+    D3D12_CPU_DESCRIPTOR_HANDLE start;
+  };
+
+  ID3D12Device* device_{nullptr};
+  D3D12_DESCRIPTOR_HEAP_TYPE type_;
+  UINT block_size_{0};
+  UINT descriptor_size_{0};
+
+  std::mutex mutex_;
+  std::vector<Block> blocks_;
+  DescriptorBlockList slots_;
+};
+
+// The one shader-visible heap that gets bound for a frame. The front is a
+// persistent region handed out a descriptor at a time; the rest is a ring of
+// transient ranges, typically filled with CopyToTransient from staging
+// descriptors, that is released per frame by fence value.
+class ShaderVisibleDescriptorHeap {
+ public:
+  ShaderVisibleDescriptorHeap(ID3D12Device* device,
+                              D3D12_DESCRIPTOR_HEAP_TYPE type,
+                              UINT persistent_count, UINT transient_count);
+  ShaderVisibleDescriptorHeap(const ShaderVisibleDescriptorHeap&) = delete;
+  ShaderVisibleDescriptorHeap& operator=(const ShaderVisibleDescriptorHeap&) =
+      delete;
+
+  ID3D12DescriptorHeap* heap() const { return heap_.Get(); }
+  UINT descriptor_size() const { return descriptor_size_; }
+
+  // Returns a null handle when the region is exhausted. Freeing while the GPU
+  // may still read the descriptor is the caller's problem; route it through
+  // the deferred release queue.
+  DescriptorHandle AllocatePersistent();
+  void FreePersistent(const DescriptorHandle& handle);
+
+  // First of count contiguous descriptors, valid until the fence passed to
+  // the next EndFrame completes. Returns a null handle when the ring is full.
+  DescriptorHandle AllocateTransient(UINT count);
+
+  // Allocates count transient descriptors and fills them from the given
+  // CPU descriptors with a single CopyDescriptors call.
+  DescriptorHandle CopyToTransient(UINT count,
+                                   const D3D12_CPU_DESCRIPTOR_HANDLE* sources);
+
+  void EndFrame(uint64_t fence_value);
+  void Reclaim(uint64_t completed_value);
+
+ private:
+  DescriptorHandle HandleAt(UINT index) const;
+
+  ID3D12Device* device_{nullptr};
+  D3D12_DESCRIPTOR_HEAP_TYPE type_;
+  Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap_;
+  D3D12_CPU_DESCRIPTOR_HANDLE cpu_start_{0};
+  D3D12_GPU_DESCRIPTOR_HANDLE gpu_start_{0};
+  UINT descriptor_size_{0};
+  UINT persistent_count_{0};
+
+  std::mutex mutex_;
+  DescriptorFreeList persistent_;
+  DescriptorRing transient_;
+  std::vector<UINT> copy_range_sizes_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__DESCRIPTOR_HEAP_H__
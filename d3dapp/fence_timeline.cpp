@@ -0,0 +1,109 @@
+#include "fence_timeline.h"
+
+#include <vector>
+
+namespace d3dapp {
+FenceTimeline::FenceTimeline(std::unique_ptr<Fence> fence)
+    : fence_{std::move(fence)} {
+  completed_value_ = fence_->GetCompletedValue();
+  waiter_ = std::thread{&FenceTimeline::WaiterMain, this};
+}
+
+FenceTimeline::~FenceTimeline() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  pending_changed_.notify_all();
+  fence_->Wake();
+  waiter_.join();
+}
+
+bool FenceTimeline::IsComplete(uint64_t value) {
+  return value <= completed_value() || value <= Poll();
+}
+
+void FenceTimeline::WhenComplete(uint64_t value,
+                                 std::function<void()> callback) {
+  if (IsComplete(value)) {
+    callback();
+    return;
+  }
+  Enqueue(value, std::move(callback));
+}
+
+void FenceTimeline::Wait(uint64_t value) {
+  if (IsComplete(value)) {
+    return;
+  }
+  Enqueue(value, nullptr);
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  completed_.wait(lock, [this, value]() {
+    return stop_ || value <= completed_value();
+  });
+}
+
+void FenceTimeline::Enqueue(uint64_t value, std::function<void()> callback) {
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    pending_.emplace(value, std::move(callback));
+    // The waiter is blocked on a later value; restart it on this one.
+    wake = waiting_for_ != 0 && value < waiting_for_;
+  }
+  pending_changed_.notify_one();
+  if (wake) {
+    fence_->Wake();
+  }
+}
+
+uint64_t FenceTimeline::Poll() {
+  uint64_t value = fence_->GetCompletedValue();
+  uint64_t current = completed_value_.load(std::memory_order_relaxed);
+  while (current < value &&
+         !completed_value_.compare_exchange_weak(current, value,
+                                                 std::memory_order_release)) {
+  }
+  return value;
+}
+
+void FenceTimeline::WaiterMain() {
+  std::vector<std::function<void()>> ready;
+  std::unique_lock<std::mutex> lock{mutex_};
+  for (;;) {
+    pending_changed_.wait(lock,
+                          [this]() { return stop_ || !pending_.empty(); });
+    if (stop_) {
+      break;
+    }
+
+    waiting_for_ = pending_.begin()->first;
+    lock.unlock();
+    fence_->Wait(waiting_for_);
+    uint64_t completed_value = Poll();
+    lock.lock();
+    waiting_for_ = 0;
+
+    auto end = pending_.upper_bound(completed_value);
+    for (auto it = pending_.begin(); it != end; ++it) {
+      if (it->second) {
+        ready.push_back(std::move(it->second));
+      }
+    }
+    pending_.erase(pending_.begin(), end);
+    completed_.notify_all();
+
+    if (!ready.empty()) {
+      lock.unlock();
+      for (auto& callback : ready) {
+        callback();
+      }
+      ready.clear();
+      lock.lock();
+    }
+  }
+  completed_.notify_all();
+}
+
+}  // namespace d3dapp
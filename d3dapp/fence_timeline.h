@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef __FENCE_TIMELINE_H__
+#define __FENCE_TIMELINE_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace d3dapp {
+// Tracks any number of pending values on one fence from a waiter thread and
+// runs completion callbacks as the fence advances, so callers can poll or
+// react to completion instead of blocking.
+class FenceTimeline {
+ public:
+  // The fence being watched. Wait blocks until the value is reached or Wake
+  // is called, whichever comes first; spurious returns are fine.
+  class Fence {
+   public:
+    virtual ~Fence() {}
+    virtual uint64_t GetCompletedValue() = 0;
+    virtual void Wait(uint64_t value) = 0;
+    virtual void Wake() = 0;
+  };
+
+  explicit FenceTimeline(std::unique_ptr<Fence> fence);
+  FenceTimeline(const FenceTimeline&) = delete;
+  FenceTimeline& operator=(const FenceTimeline&) = delete;
+  // Callbacks still pending at destruction are dropped.
+  ~FenceTimeline();
+
+  bool IsComplete(uint64_t value);
+
+  // Runs callback on the waiter thread once value completes, or right away
+  // on the calling thread if it already has.
+  void WhenComplete(uint64_t value, std::function<void()> callback);
+
+  // Blocks the calling thread until value completes.
+  void Wait(uint64_t value);
+
+  uint64_t completed_value() const {
+    return completed_value_.load(std::memory_order_acquire);
+  }
+
+ private:
+  void Enqueue(uint64_t value, std::function<void()> callback);
+  uint64_t Poll();
+  void WaiterMain();
+
+  std::unique_ptr<Fence> fence_;
+  std::atomic<uint64_t> completed_value_{0};
+
+  std::mutex mutex_;
+  std::condition_variable pending_changed_;
+  std::condition_variable completed_;
+  std::multimap<uint64_t, std::function<void()>> pending_;
+  uint64_t waiting_for_{0};
+  bool stop_{false};
+
+  std::thread waiter_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__FENCE_TIMELINE_H__
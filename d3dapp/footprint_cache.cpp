@@ -0,0 +1,300 @@
+#include "footprint_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace {
+struct FormatInfo {
+  // Bytes per texel, or per block for block compressed formats.
+  UINT size;
+  UINT block_size;
+};
+
+bool GetFormatInfo(DXGI_FORMAT format, FormatInfo* info) {
+  switch (format) {
+    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+    case DXGI_FORMAT_R32G32B32A32_SINT:
+      *info = FormatInfo{16, 1};
+      return true;
+    case DXGI_FORMAT_R32G32B32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+    case DXGI_FORMAT_R32G32B32_UINT:
+    case DXGI_FORMAT_R32G32B32_SINT:
+      *info = FormatInfo{12, 1};
+      return true;
+    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_UINT:
+    case DXGI_FORMAT_R16G16B16A16_SNORM:
+    case DXGI_FORMAT_R16G16B16A16_SINT:
+    case DXGI_FORMAT_R32G32_TYPELESS:
+    case DXGI_FORMAT_R32G32_FLOAT:
+    case DXGI_FORMAT_R32G32_UINT:
+    case DXGI_FORMAT_R32G32_SINT:
+      *info = FormatInfo{8, 1};
+      return true;
+    case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UINT:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_R8G8B8A8_UINT:
+    case DXGI_FORMAT_R8G8B8A8_SNORM:
+    case DXGI_FORMAT_R8G8B8A8_SINT:
+    case DXGI_FORMAT_R16G16_TYPELESS:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R16G16_UINT:
+    case DXGI_FORMAT_R16G16_SNORM:
+    case DXGI_FORMAT_R16G16_SINT:
+    case DXGI_FORMAT_R32_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT:
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_R32_UINT:
+    case DXGI_FORMAT_R32_SINT:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+      *info = FormatInfo{4, 1};
+      return true;
+    case DXGI_FORMAT_R8G8_TYPELESS:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8G8_UINT:
+    case DXGI_FORMAT_R8G8_SNORM:
+    case DXGI_FORMAT_R8G8_SINT:
+    case DXGI_FORMAT_R16_TYPELESS:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_D16_UNORM:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_R16_UINT:
+    case DXGI_FORMAT_R16_SNORM:
+    case DXGI_FORMAT_R16_SINT:
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+      *info = FormatInfo{2, 1};
+      return true;
+    case DXGI_FORMAT_R8_TYPELESS:
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_R8_UINT:
+    case DXGI_FORMAT_R8_SNORM:
+    case DXGI_FORMAT_R8_SINT:
+    case DXGI_FORMAT_A8_UNORM:
+      *info = FormatInfo{1, 1};
+      return true;
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+      *info = FormatInfo{8, 4};
+      return true;
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+      *info = FormatInfo{16, 4};
+      return true;
+    default:
+      return false;
+  }
+}
+
+UINT64 AlignUp(UINT64 value, UINT64 alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void HashCombine(size_t& seed, UINT64 value) {
+  seed ^= std::hash<UINT64>{}(value) + 0x9e3779b9 + (seed << 6) +
+          (seed >> 2);
+}
+
+}  // namespace
+
+namespace d3dapp {
+bool CalculateFootprints(const D3D12_RESOURCE_DESC& desc,
+                         UINT first_subresource, UINT subresource_count,
+                         UINT64 base_offset,
+                         D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+                         UINT* row_counts, UINT64* row_sizes,
+                         UINT64* total_size) {
+  if (D3D12_RESOURCE_DIMENSION_BUFFER == desc.Dimension) {
+    if (0 != first_subresource || 1 != subresource_count) {
+      return false;
+    }
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout{};
+    layout.Offset = base_offset;
+    layout.Footprint.Format = DXGI_FORMAT_UNKNOWN;
+    layout.Footprint.Width = static_cast<UINT>(desc.Width);
+    layout.Footprint.Height = 1;
+    layout.Footprint.Depth = 1;
+    layout.Footprint.RowPitch = static_cast<UINT>(
+        AlignUp(desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+    if (layouts) {
+      layouts[0] = layout;
+    }
+    if (row_counts) {
+      row_counts[0] = 1;
+    }
+    if (row_sizes) {
+      row_sizes[0] = desc.Width;
+    }
+    if (total_size) {
+      *total_size = desc.Width;
+    }
+    return true;
+  }
+
+  FormatInfo format{};
+  if (!GetFormatInfo(desc.Format, &format) || 0 == desc.MipLevels ||
+      desc.SampleDesc.Count > 1) {
+    return false;
+  }
+  bool volume = D3D12_RESOURCE_DIMENSION_TEXTURE3D == desc.Dimension;
+  UINT array_size = volume ? 1 : desc.DepthOrArraySize;
+  if (first_subresource + subresource_count >
+      static_cast<UINT>(desc.MipLevels) * array_size) {
+    return false;
+  }
+
+  UINT64 offset = base_offset;
+  UINT64 end = base_offset;
+  for (UINT i = 0; i < subresource_count; ++i) {
+    UINT mip = (first_subresource + i) % desc.MipLevels;
+    UINT width = std::max(static_cast<UINT>(desc.Width >> mip), 1u);
+    UINT height = D3D12_RESOURCE_DIMENSION_TEXTURE1D == desc.Dimension
+                      ? 1
+                      : std::max(desc.Height >> mip, 1u);
+    UINT depth = volume ? std::max(desc.DepthOrArraySize >> mip, 1) : 1;
+    UINT blocks_wide = (width + format.block_size - 1) / format.block_size;
+    UINT blocks_high = (height + format.block_size - 1) / format.block_size;
+    UINT64 row_size = static_cast<UINT64>(blocks_wide) * format.size;
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout{};
+    offset = AlignUp(offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    layout.Offset = offset;
+    layout.Footprint.Format = desc.Format;
+    layout.Footprint.Width = blocks_wide * format.block_size;
+    layout.Footprint.Height = blocks_high * format.block_size;
+    layout.Footprint.Depth = depth;
+    layout.Footprint.RowPitch = static_cast<UINT>(
+        AlignUp(row_size, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+    if (layouts) {
+      layouts[i] = layout;
+    }
+    if (row_counts) {
+      row_counts[i] = blocks_high;
+    }
+    if (row_sizes) {
+      row_sizes[i] = row_size;
+    }
+
+    // The last row of a subresource is not padded to the pitch.
+    UINT64 rows = static_cast<UINT64>(blocks_high) * depth;
+    end = offset + layout.Footprint.RowPitch * (rows - 1) + row_size;
+    offset += static_cast<UINT64>(layout.Footprint.RowPitch) * rows;
+  }
+  if (total_size) {
+    *total_size = end - base_offset;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+FootprintCache::FootprintCache(ID3D12Device* device) : device_{device} {}
+
+const Footprints& FootprintCache::Get(const D3D12_RESOURCE_DESC& desc,
+                                      UINT first_subresource,
+                                      UINT subresource_count) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  Key key{desc, first_subresource, subresource_count};
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    ++hits_;
+    return it->second;
+  }
+
+  ++misses_;
+  Footprints footprints;
+  footprints.layouts.resize(subresource_count);
+  footprints.row_counts.resize(subresource_count);
+  footprints.row_sizes.resize(subresource_count);
+  bool valid = false;
+  if (device_) {
+    // An invalid desc or range is reported through the total size.
+    footprints.total_size = UINT64_MAX;
+    device_->GetCopyableFootprints(
+        &desc, first_subresource, subresource_count, 0,
+        footprints.layouts.data(), footprints.row_counts.data(),
+        footprints.row_sizes.data(), &footprints.total_size);
+    valid = UINT64_MAX != footprints.total_size;
+  } else {
+    valid = CalculateFootprints(desc, first_subresource, subresource_count, 0,
+                                footprints.layouts.data(),
+                                footprints.row_counts.data(),
+                                footprints.row_sizes.data(),
+                                &footprints.total_size);
+  }
+  // Failures are not kept, so a bad desc cannot fill the cache.
+  if (!valid) {
+    return empty_;
+  }
+  return entries_.emplace(key, std::move(footprints)).first->second;
+}
+
+void FootprintCache::Clear() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  entries_.clear();
+}
+
+FootprintCacheStats FootprintCache::stats() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  FootprintCacheStats stats{};
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.entry_count = entries_.size();
+  return stats;
+}
+
+size_t FootprintCache::KeyHash::operator()(const Key& key) const {
+  const D3D12_RESOURCE_DESC& desc = key.desc;
+  size_t seed = 0;
+  HashCombine(seed, desc.Dimension);
+  HashCombine(seed, desc.Alignment);
+  HashCombine(seed, desc.Width);
+  HashCombine(seed, desc.Height);
+  HashCombine(seed, static_cast<UINT64>(desc.DepthOrArraySize) << 16 |
+                        desc.MipLevels);
+  HashCombine(seed, desc.Format);
+  HashCombine(seed, static_cast<UINT64>(desc.SampleDesc.Count) << 32 |
+                        desc.SampleDesc.Quality);
+  HashCombine(seed, desc.Layout);
+  HashCombine(seed, desc.Flags);
+  HashCombine(seed, static_cast<UINT64>(key.first_subresource) << 32 |
+                        key.subresource_count);
+  return seed;
+}
+
+}  // namespace d3dapp
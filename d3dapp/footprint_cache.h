@@ -0,0 +1,93 @@
+#pragma once
+
+#ifndef __FOOTPRINT_CACHE_H__
+#define __FOOTPRINT_CACHE_H__
+
+#include <d3dx12.h>
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "framework.h"
+
+namespace d3dapp {
+// GetCopyableFootprints output for a range of subresources.
+struct Footprints {
+  std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+  std::vector<UINT> row_counts;
+  std::vector<UINT64> row_sizes;
+  UINT64 total_size{0};
+};
+
+struct FootprintCacheStats {
+  size_t hits{0};
+  size_t misses{0};
+  size_t entry_count{0};
+
+  double hit_rate() const {
+    size_t lookups = hits + misses;
+    return lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+  }
+};
+
+// GetCopyableFootprints without a device, for buffers and 1D, 2D and 3D
+// textures of single plane formats. Returns false for anything else, e.g.
+// planar depth/stencil and video formats, or when desc is invalid.
+bool CalculateFootprints(const D3D12_RESOURCE_DESC& desc,
+                         UINT first_subresource, UINT subresource_count,
+                         UINT64 base_offset,
+                         D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+                         UINT* row_counts, UINT64* row_sizes,
+                         UINT64* total_size);
+
+// Memoizes footprints by desc and subresource range, so identically shaped
+// resources such as terrain tiles query them once. Layout offsets start at
+// 0; add the offset the data is placed at. Thread safe; entries stay valid
+// until Clear.
+class FootprintCache {
+ public:
+  // Without a device, footprints come from CalculateFootprints and are
+  // empty for what it does not support.
+  explicit FootprintCache(ID3D12Device* device);
+  FootprintCache(const FootprintCache&) = delete;
+  FootprintCache& operator=(const FootprintCache&) = delete;
+
+  // Empty footprints, which are not cached, when desc or the range is
+  // invalid.
+  const Footprints& Get(const D3D12_RESOURCE_DESC& desc,
+                        UINT first_subresource, UINT subresource_count);
+  void Clear();
+
+  FootprintCacheStats stats() const;
+
+ private:
+  struct Key {
+    D3D12_RESOURCE_DESC desc;
+    UINT first_subresource;
+    UINT subresource_count;
+
+    bool operator==(const Key& other) const {
+      return desc == other.desc &&
+             first_subresource == other.first_subresource &&
+             subresource_count == other.subresource_count;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  ID3D12Device* device_{nullptr};
+  const Footprints empty_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<Key, Footprints, KeyHash> entries_;
+  size_t hits_{0};
+  size_t misses_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__FOOTPRINT_CACHE_H__
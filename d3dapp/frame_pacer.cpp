@@ -0,0 +1,97 @@
+#include "frame_pacer.h"
+
+#include <chrono>
+#include <thread>
+
+#if defined(_WIN32)
+#include "framework.h"
+#endif
+
+namespace {
+class SystemClock : public d3dapp::FramePacer::Clock {
+ public:
+  SystemClock() {
+#if defined(_WIN32)
+    timer_ = CreateWaitableTimerEx(nullptr, nullptr,
+                                   CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                   TIMER_ALL_ACCESS);
+#endif
+  }
+
+  ~SystemClock() override {
+#if defined(_WIN32)
+    if (timer_) {
+      CloseHandle(timer_);
+    }
+#endif
+  }
+
+  int64_t Now() override {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void SleepFor(int64_t duration) override {
+#if defined(_WIN32)
+    if (timer_) {
+      // Relative due times are negative, in 100ns units.
+      LARGE_INTEGER due_time{};
+      due_time.QuadPart = -(duration / 100);
+      if (SetWaitableTimer(timer_, &due_time, 0, nullptr, nullptr, false)) {
+        WaitForSingleObject(timer_, INFINITE);
+        return;
+      }
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::nanoseconds{duration});
+  }
+
+ private:
+#if defined(_WIN32)
+  HANDLE timer_{nullptr};
+#endif
+};
+
+}  // namespace
+
+namespace d3dapp {
+FramePacer::FramePacer(const Desc& desc, std::unique_ptr<Clock> clock)
+    : clock_{std::move(clock)}, spin_threshold_{desc.spin_threshold} {
+  if (!clock_) {
+    clock_.reset(new SystemClock{});
+  }
+  SetTargetFps(desc.target_fps);
+  next_frame_ = last_frame_ = clock_->Now();
+}
+
+void FramePacer::SetTargetFps(double target_fps) {
+  frame_period_ =
+      target_fps > 0.0 ? static_cast<int64_t>(1e9 / target_fps) : 0;
+}
+
+void FramePacer::WaitForNextFrame() {
+  int64_t now = clock_->Now();
+  if (frame_period_ > 0) {
+    for (int64_t remaining = next_frame_ - now; remaining > spin_threshold_;
+         remaining = next_frame_ - now) {
+      clock_->SleepFor(remaining - spin_threshold_);
+      now = clock_->Now();
+    }
+    while (now < next_frame_) {
+      std::this_thread::yield();
+      now = clock_->Now();
+    }
+  }
+
+  last_overshoot_ = frame_period_ > 0 ? now - next_frame_ : 0;
+  last_interval_ = now - last_frame_;
+  last_frame_ = now;
+
+  next_frame_ += frame_period_;
+  if (next_frame_ + frame_period_ < now) {
+    next_frame_ = now + frame_period_;
+  }
+}
+
+}  // namespace d3dapp
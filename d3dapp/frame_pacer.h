@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+#include <cstdint>
+#include <memory>
+
+namespace d3dapp {
+// Holds frame starts to a target rate. Most of each wait is spent in a coarse
+// sleep; the last stretch is spun so the frame starts on time even when the
+// OS sleep granularity is a millisecond or worse.
+class FramePacer {
+ public:
+  // Time source, in nanoseconds. SleepFor may overshoot.
+  class Clock {
+   public:
+    virtual ~Clock() {}
+    virtual int64_t Now() = 0;
+    virtual void SleepFor(int64_t duration) = 0;
+  };
+
+  struct Desc {
+    // 0 disables the limiter.
+    double target_fps{0.0};
+    // Remaining wait below which the pacer spins instead of sleeping.
+    int64_t spin_threshold{2000000};
+  };
+
+  // A null clock uses the high resolution system clock.
+  explicit FramePacer(const Desc& desc, std::unique_ptr<Clock> clock = nullptr);
+  FramePacer(const FramePacer&) = delete;
+  FramePacer& operator=(const FramePacer&) = delete;
+
+  void SetTargetFps(double target_fps);
+
+  // Blocks until the next frame is due. If the caller has fallen behind by
+  // more than a frame the schedule restarts from now rather than bursting
+  // to catch up.
+  void WaitForNextFrame();
+
+  int64_t frame_period() const { return frame_period_; }
+  // Time between the last two frame starts.
+  int64_t last_interval() const { return last_interval_; }
+  // How late the last frame started relative to its deadline.
+  int64_t last_overshoot() const { return last_overshoot_; }
+
+ private:
+  std::unique_ptr<Clock> clock_;
+  int64_t spin_threshold_{0};
+  int64_t frame_period_{0};
+  int64_t next_frame_{0};
+  int64_t last_frame_{0};
+  int64_t last_interval_{0};
+  int64_t last_overshoot_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__FRAME_PACER_H__
@@ -0,0 +1,26 @@
+#include "frame_schedule.h"
+
+#include <algorithm>
+
+namespace d3dapp {
+FrameSchedule::FrameSchedule(int frame_count, int max_queued_frames)
+    : slots_(std::max(frame_count, 1), 0),
+      max_queued_frames_{std::max(max_queued_frames, 0)} {}
+
+uint64_t FrameSchedule::WaitValue() const {
+  uint64_t value = slots_[frame_index_];
+  const uint64_t max_queued = static_cast<uint64_t>(max_queued_frames_);
+  if (max_queued > 0 && fence_value_ >= max_queued) {
+    value = std::max(value, fence_value_ - max_queued + 1);
+  }
+  return value;
+}
+
+uint64_t FrameSchedule::EndFrame() {
+  ++fence_value_;
+  slots_[frame_index_] = fence_value_;
+  frame_index_ = (frame_index_ + 1) % frame_count();
+  return fence_value_;
+}
+
+}  // namespace d3dapp
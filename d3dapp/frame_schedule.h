@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef __FRAME_SCHEDULE_H__
+#define __FRAME_SCHEDULE_H__
+
+#include <cstdint>
+#include <vector>
+
+namespace d3dapp {
+// Fence bookkeeping of the frames the CPU records ahead of the GPU. Each
+// frame records into one of frame_count slots of per-frame resources, in
+// turn, and is signaled with the next fence value. Independent of the swap
+// chain, whose back buffer index comes from the swap chain itself. Runs
+// without a device.
+class FrameSchedule {
+ public:
+  // max_queued_frames bounds the frames submitted but not finished,
+  // including the one being submitted; 0 leaves it to frame_count.
+  FrameSchedule(int frame_count, int max_queued_frames);
+
+  // Fence value to wait for before recording the next frame: the last one
+  // recorded into its slot, or the one that keeps the queue within
+  // max_queued_frames, whichever is later. 0 when there is nothing to wait
+  // for.
+  uint64_t WaitValue() const;
+
+  // Slot of the frame being recorded.
+  int frame_index() const { return frame_index_; }
+  // Value the frame being recorded is signaled with.
+  uint64_t next_fence_value() const { return fence_value_ + 1; }
+  // Value of the last submitted frame.
+  uint64_t fence_value() const { return fence_value_; }
+  int frame_count() const { return static_cast<int>(slots_.size()); }
+
+  // The frame was submitted and signaled with next_fence_value(); moves on
+  // to the next slot and returns the value.
+  uint64_t EndFrame();
+
+ private:
+  // Last fence value recorded into each slot.
+  std::vector<uint64_t> slots_;
+  int max_queued_frames_{0};
+  int frame_index_{0};
+  uint64_t fence_value_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__FRAME_SCHEDULE_H__
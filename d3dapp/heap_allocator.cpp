@@ -0,0 +1,219 @@
+#include "heap_allocator.h"
+
+#include <algorithm>
+
+namespace {
+enum ResourceClass {
+  kBufferClass,
+  kTextureClass,
+  kRenderTargetClass,
+  kResourceClassCount
+};
+
+constexpr int kHeapTypeCount = 3;
+constexpr UINT64 kMinBlockSize =
+    D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+
+ResourceClass ClassOf(const D3D12_RESOURCE_DESC& desc) {
+  if (D3D12_RESOURCE_DIMENSION_BUFFER == desc.Dimension) {
+    return kBufferClass;
+  }
+  if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET |
+                    D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) {
+    return kRenderTargetClass;
+  }
+  return kTextureClass;
+}
+
+D3D12_HEAP_FLAGS HeapFlagsOf(int resource_class) {
+  switch (resource_class) {
+    case kBufferClass:
+      return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    case kTextureClass:
+      return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+    default:
+      return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+  }
+}
+
+}  // namespace
+
+namespace d3dapp {
+HeapAllocator::HeapAllocator(ID3D12Device* device, UINT64 block_size)
+    : device_{device}, block_size_{kMinBlockSize} {
+  while (block_size_ < block_size) {
+    block_size_ <<= 1;
+  }
+
+  D3D12_FEATURE_DATA_D3D12_OPTIONS options{};
+  if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS,
+                                            &options, sizeof(options)))) {
+    heap_tier_ = options.ResourceHeapTier;
+  }
+
+  // Indexed by (heap type - 1) * kResourceClassCount + resource class. On
+  // tier 2 only the first class of each heap type is used.
+  for (int type = 0; type < kHeapTypeCount; ++type) {
+    for (int resource_class = 0; resource_class < kResourceClassCount;
+         ++resource_class) {
+      Pool pool{};
+      pool.heap_type = static_cast<D3D12_HEAP_TYPE>(type + 1);
+      pool.heap_flags = D3D12_RESOURCE_HEAP_TIER_1 == heap_tier_
+                            ? HeapFlagsOf(resource_class)
+                            : D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+      // Only default heaps that may hold render targets need room for MSAA
+      // placement.
+      bool msaa = D3D12_HEAP_TYPE_DEFAULT == pool.heap_type &&
+                  (D3D12_RESOURCE_HEAP_TIER_1 != heap_tier_ ||
+                   kRenderTargetClass == resource_class);
+      pool.alignment = msaa ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT
+                            : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+      pools_.push_back(std::move(pool));
+    }
+  }
+}
+
+bool HeapAllocator::CreateResource(
+    D3D12_HEAP_TYPE heap_type, const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initial_state, const D3D12_CLEAR_VALUE* clear_value,
+    Microsoft::WRL::ComPtr<ID3D12Resource>& resource,
+    HeapAllocation* allocation) {
+  CD3DX12_RESOURCE_ALLOCATION_INFO info =
+      device_->GetResourceAllocationInfo(0, 1, &desc);
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  uint32_t pool_index = 0;
+  Pool* pool_for = PoolFor(heap_type, desc, &pool_index);
+  if (!pool_for) {
+    return false;
+  }
+  Pool& pool = *pool_for;
+
+  *allocation = HeapAllocation{};
+  allocation->size = info.SizeInBytes;
+  if (info.SizeInBytes <= block_size_ && info.Alignment <= pool.alignment) {
+    uint64_t offset = 0;
+    uint32_t order = 0;
+    size_t block = 0;
+    for (; block < pool.blocks.size(); ++block) {
+      if (pool.blocks[block].buddy->Allocate(info.SizeInBytes, info.Alignment,
+                                             &offset, &order)) {
+        break;
+      }
+    }
+    if (block == pool.blocks.size() &&
+        (!CreateBlock(pool) ||
+         !pool.blocks[block].buddy->Allocate(info.SizeInBytes, info.Alignment,
+                                             &offset, &order))) {
+      return false;
+    }
+
+    Block& target = pool.blocks[block];
+    if (FAILED(device_->CreatePlacedResource(
+            target.heap.Get(), offset, &desc, initial_state, clear_value,
+            IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())))) {
+      target.buddy->Free(offset, order);
+      return false;
+    }
+
+    ++target.allocation_count;
+    allocation->heap = target.heap.Get();
+    allocation->offset = offset;
+    allocation->pool = pool_index;
+    allocation->block = static_cast<uint32_t>(block);
+    allocation->order = order;
+  } else {
+    if (FAILED(device_->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(heap_type), D3D12_HEAP_FLAG_NONE, &desc,
+            initial_state, clear_value,
+            IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())))) {
+      return false;
+    }
+    ++committed_count_;
+  }
+
+  ++allocation_count_;
+  requested_ += info.SizeInBytes;
+  return true;
+}
+
+void HeapAllocator::Free(const HeapAllocation& allocation) {
+  if (0 == allocation.size) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (allocation.IsNull()) {
+    --committed_count_;
+  } else {
+    Block& block = pools_[allocation.pool].blocks[allocation.block];
+    block.buddy->Free(allocation.offset, allocation.order);
+    --block.allocation_count;
+  }
+  --allocation_count_;
+  requested_ -= allocation.size;
+}
+
+void HeapAllocator::Trim() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (Pool& pool : pools_) {
+    // Allocations refer to blocks by index, so only trailing blocks can go.
+    while (!pool.blocks.empty() && 0 == pool.blocks.back().allocation_count) {
+      pool.blocks.pop_back();
+    }
+  }
+}
+
+HeapAllocatorStats HeapAllocator::stats() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  HeapAllocatorStats stats{};
+  for (const Pool& pool : pools_) {
+    for (const Block& block : pool.blocks) {
+      stats.reserved += block.buddy->size();
+      stats.used += block.buddy->size() - block.buddy->free_size();
+      stats.largest_free =
+          std::max(stats.largest_free, block.buddy->LargestFreeBlock());
+      ++stats.heap_count;
+    }
+  }
+  stats.requested = requested_;
+  stats.allocation_count = allocation_count_;
+  stats.committed_count = committed_count_;
+  return stats;
+}
+
+D3D12_HEAP_FLAGS HeapAllocator::HeapFlagsFor(
+    D3D12_RESOURCE_HEAP_TIER heap_tier, const D3D12_RESOURCE_DESC& desc) {
+  return D3D12_RESOURCE_HEAP_TIER_1 == heap_tier
+             ? HeapFlagsOf(ClassOf(desc))
+             : D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+}
+
+HeapAllocator::Pool* HeapAllocator::PoolFor(D3D12_HEAP_TYPE heap_type,
+                                            const D3D12_RESOURCE_DESC& desc,
+                                            uint32_t* index) {
+  // Custom heaps need CPU page properties a heap type alone does not give.
+  if (heap_type < D3D12_HEAP_TYPE_DEFAULT || heap_type > kHeapTypeCount) {
+    return nullptr;
+  }
+  int resource_class =
+      D3D12_RESOURCE_HEAP_TIER_1 == heap_tier_ ? ClassOf(desc) : 0;
+  *index = static_cast<uint32_t>((heap_type - 1) * kResourceClassCount +
+                                 resource_class);
+  return &pools_[*index];
+}
+
+bool HeapAllocator::CreateBlock(Pool& pool) {
+  CD3DX12_HEAP_DESC heap_desc{block_size_, pool.heap_type, pool.alignment,
+                              pool.heap_flags};
+  Block block{};
+  if (FAILED(device_->CreateHeap(&heap_desc, IID_PPV_ARGS(&block.heap)))) {
+    return false;
+  }
+  block.buddy.reset(new BuddyAllocator{
+      block_size_, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT});
+  pool.blocks.push_back(std::move(block));
+  return true;
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,112 @@
+#pragma once
+
+#ifndef __HEAP_ALLOCATOR_H__
+#define __HEAP_ALLOCATOR_H__
+
+#include <d3dx12.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buddy_allocator.h"
+#include "framework.h"
+
+namespace d3dapp {
+struct HeapAllocation {
+  ID3D12Heap* heap{nullptr};
+  UINT64 offset{0};
+  UINT64 size{0};
+  uint32_t pool{0};
+  uint32_t block{0};
+  uint32_t order{0};
+
+  // Null for resources that fell back to a committed allocation.
+  bool IsNull() const { return nullptr == heap; }
+};
+
+struct HeapAllocatorStats {
+  UINT64 reserved{0};
+  UINT64 used{0};
+  UINT64 requested{0};
+  UINT64 largest_free{0};
+  size_t heap_count{0};
+  size_t allocation_count{0};
+  size_t committed_count{0};
+
+  // 0 when all free space is one block, approaching 1 as it scatters.
+  double fragmentation() const {
+    UINT64 free = reserved - used;
+    return free > 0 ? 1.0 - static_cast<double>(largest_free) / free : 0.0;
+  }
+};
+
+// Places resources in large ID3D12Heap blocks instead of giving each its own
+// committed allocation. There is a pool per heap type, and on resource heap
+// tier 1 also per resource class, since buffers, render target/depth
+// textures and other textures cannot share a heap there. Resources larger
+// than a block are committed. Thread safe.
+class HeapAllocator {
+ public:
+  static constexpr UINT64 kDefaultBlockSize = 64 * 1024 * 1024;
+
+  HeapAllocator(ID3D12Device* device, UINT64 block_size = kDefaultBlockSize);
+  HeapAllocator(const HeapAllocator&) = delete;
+  HeapAllocator& operator=(const HeapAllocator&) = delete;
+
+  // heap_type is DEFAULT, UPLOAD or READBACK; D3D12_HEAP_TYPE_CUSTOM fails.
+  bool CreateResource(D3D12_HEAP_TYPE heap_type,
+                      const D3D12_RESOURCE_DESC& desc,
+                      D3D12_RESOURCE_STATES initial_state,
+                      const D3D12_CLEAR_VALUE* clear_value,
+                      Microsoft::WRL::ComPtr<ID3D12Resource>& resource,
+                      HeapAllocation* allocation);
+
+  // Only once the GPU is done with the resource; route it through the
+  // deferred release queue together with the resource itself.
+  void Free(const HeapAllocation& allocation);
+
+  // Releases blocks that no longer hold any resource.
+  void Trim();
+
+  HeapAllocatorStats stats() const;
+  D3D12_RESOURCE_HEAP_TIER heap_tier() const { return heap_tier_; }
+
+  // Flags of the heaps desc may be placed in on the given tier.
+  static D3D12_HEAP_FLAGS HeapFlagsFor(D3D12_RESOURCE_HEAP_TIER heap_tier,
+                                       const D3D12_RESOURCE_DESC& desc);
+
+ private:
+  struct Block {
+    Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+    std::unique_ptr<BuddyAllocator> buddy;
+    size_t allocation_count{0};
+  };
+
+  struct Pool {
+    D3D12_HEAP_TYPE heap_type;
+    D3D12_HEAP_FLAGS heap_flags;
+    UINT64 alignment;
+    std::vector<Block> blocks;
+  };
+
+  // Null for heap types without a pool.
+  Pool* PoolFor(D3D12_HEAP_TYPE heap_type, const D3D12_RESOURCE_DESC& desc,
+                uint32_t* index);
+  bool CreateBlock(Pool& pool);
+
+  ID3D12Device* device_{nullptr};
+  UINT64 block_size_{0};
+  D3D12_RESOURCE_HEAP_TIER heap_tier_{D3D12_RESOURCE_HEAP_TIER_1};
+
+  mutable std::mutex mutex_;
+  std::vector<Pool> pools_;
+  UINT64 requested_{0};
+  size_t allocation_count_{0};
+  size_t committed_count_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__HEAP_ALLOCATOR_H__
@@ -0,0 +1,202 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#include "framework.h"
+#endif
+
+namespace {
+struct WorkerSlot {
+  const d3dapp::JobSystem* owner;
+  int index;
+};
+
+thread_local WorkerSlot tlsWorkerSlot{nullptr, 0};
+
+int PhysicalCoreCount() {
+#if defined(_WIN32)
+  DWORD length = 0;
+  GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+  if (length > 0) {
+    std::vector<char> buffer(length);
+    auto* info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(
+        buffer.data());
+    if (GetLogicalProcessorInformationEx(RelationProcessorCore, info,
+                                         &length)) {
+      int cores = 0;
+      for (DWORD offset = 0; offset < length; ++cores) {
+        offset += reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(
+                      buffer.data() + offset)
+                      ->Size;
+      }
+      return cores;
+    }
+  }
+#endif
+  return static_cast<int>(std::thread::hardware_concurrency());
+}
+
+}  // namespace
+
+namespace d3dapp {
+JobSystem::Group::Group(JobSystem* job_system, Priority priority)
+    : job_system_{job_system}, priority_{priority} {}
+
+JobSystem::Group::~Group() { Wait(); }
+
+void JobSystem::Group::Run(std::function<void()> job) {
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  job_system_->Push(Job{std::move(job), this});
+}
+
+void JobSystem::Group::Wait() {
+  while (pending_.load(std::memory_order_acquire) > 0) {
+    if (!job_system_->RunOne(priority_)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+int JobSystem::DefaultWorkerCount() {
+  return std::max(PhysicalCoreCount() - 1, 0);
+}
+
+JobSystem::JobSystem(int worker_count) {
+  worker_count = std::max(worker_count, 0);
+  for (int i = 0; i < worker_count + 1; ++i) {
+    queues_.emplace_back(new Queue{});
+  }
+  for (int i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&JobSystem::WorkerMain, this, i + 1);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock{sleep_mutex_};
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grain,
+                            const std::function<void(size_t, size_t)>& body) {
+  if (begin >= end) {
+    return;
+  }
+  if (grain == 0) {
+    grain = std::max<size_t>((end - begin) / (thread_count() * 4), 1);
+  }
+
+  Group group{this};
+  for (size_t chunk = begin; chunk < end; chunk += grain) {
+    size_t chunk_end = std::min(chunk + grain, end);
+    group.Run([&body, chunk, chunk_end]() { body(chunk, chunk_end); });
+  }
+  group.Wait();
+}
+
+void JobSystem::Push(Job job) {
+  const bool background = kBackground == job.group->priority_;
+  Queue& queue = background ? background_ : *queues_[CurrentIndex()];
+  {
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    queue.jobs.push_back(std::move(job));
+  }
+  (background ? background_queued_ : queued_)
+      .fetch_add(1, std::memory_order_release);
+  {
+    // Pairs with the predicate check in WorkerMain so a wakeup is not lost.
+    std::lock_guard<std::mutex> lock{sleep_mutex_};
+  }
+  wake_.notify_one();
+}
+
+bool JobSystem::Pop(int index, Job& job) {
+  Queue& queue = *queues_[index];
+  std::lock_guard<std::mutex> lock{queue.mutex};
+  if (queue.jobs.empty()) {
+    return false;
+  }
+  job = std::move(queue.jobs.back());
+  queue.jobs.pop_back();
+  return true;
+}
+
+bool JobSystem::Steal(int index, Job& job) {
+  const int count = static_cast<int>(queues_.size());
+  for (int i = 1; i < count; ++i) {
+    Queue& queue = *queues_[(index + i) % count];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (!queue.jobs.empty()) {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool JobSystem::PopBackground(Job& job) {
+  std::lock_guard<std::mutex> lock{background_.mutex};
+  if (background_.jobs.empty()) {
+    return false;
+  }
+  job = std::move(background_.jobs.front());
+  background_.jobs.pop_front();
+  return true;
+}
+
+bool JobSystem::RunOne(Priority priority) {
+  Job job;
+  if (queued_.load(std::memory_order_acquire) > 0) {
+    const int index = CurrentIndex();
+    if (Pop(index, job) || Steal(index, job)) {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+  // Normal jobs first; background ones only when asked for.
+  if (!job.group) {
+    if (kBackground != priority ||
+        background_queued_.load(std::memory_order_acquire) == 0 ||
+        !PopBackground(job)) {
+      return false;
+    }
+    background_queued_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  job.function();
+  job.group->pending_.fetch_sub(1, std::memory_order_release);
+  return true;
+}
+
+void JobSystem::WorkerMain(int index) {
+  tlsWorkerSlot = WorkerSlot{this, index};
+  for (;;) {
+    // Only here, between jobs, does a worker pick up background work.
+    if (RunOne(kBackground)) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{sleep_mutex_};
+    wake_.wait(lock, [this]() {
+      return stop_ || queued_.load(std::memory_order_acquire) > 0 ||
+             background_queued_.load(std::memory_order_acquire) > 0;
+    });
+    if (stop_ && queued_.load(std::memory_order_acquire) == 0 &&
+        background_queued_.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+  }
+}
+
+int JobSystem::CurrentIndex() const {
+  return tlsWorkerSlot.owner == this ? tlsWorkerSlot.index : 0;
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,98 @@
+#pragma once
+
+#ifndef __JOB_SYSTEM_H__
+#define __JOB_SYSTEM_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace d3dapp {
+// Work-stealing scheduler. Every worker owns a deque: it pushes and pops at
+// the back, idle workers steal from the front of the others. Threads that
+// are not workers (e.g. the render thread) push into a shared queue and help
+// run jobs while they wait on a group. Background jobs, e.g. streaming
+// decodes, go to a queue of their own that only idle workers and waits on
+// background groups take from, so a frame never waits on one.
+class JobSystem {
+ public:
+  enum Priority { kNormal, kBackground };
+
+  // Fork/join scope. Jobs run through a group may spawn more jobs into it;
+  // Wait returns once all of them have finished.
+  class Group {
+   public:
+    explicit Group(JobSystem* job_system, Priority priority = kNormal);
+    Group(const Group&) = delete;
+    Group& operator=(const Group&) = delete;
+    ~Group();
+
+    void Run(std::function<void()> job);
+    void Wait();
+
+   private:
+    friend class JobSystem;
+    JobSystem* job_system_;
+    Priority priority_;
+    std::atomic<int> pending_{0};
+  };
+
+  // Physical cores minus one for the thread that drives the frame.
+  static int DefaultWorkerCount();
+
+  explicit JobSystem(int worker_count = DefaultWorkerCount());
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+  ~JobSystem();
+
+  // Workers plus the calling thread, which takes part in every Wait.
+  int thread_count() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Calls body(chunk_begin, chunk_end) over [begin, end) in chunks of at most
+  // grain elements, and returns when all chunks are done. A grain of 0 picks
+  // a few chunks per thread.
+  void ParallelFor(size_t begin, size_t end, size_t grain,
+                   const std::function<void(size_t, size_t)>& body);
+
+ private:
+  struct Job {
+    std::function<void()> function;
+    Group* group{nullptr};
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  void Push(Job job);
+  bool Pop(int index, Job& job);
+  bool Steal(int index, Job& job);
+  bool PopBackground(Job& job);
+  bool RunOne(Priority priority);
+  void WorkerMain(int index);
+  int CurrentIndex() const;
+
+  // queues_[0] is shared by non-worker threads, queues_[i + 1] is owned by
+  // workers_[i].
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  // FIFO, so background jobs run in the order they were submitted.
+  Queue background_;
+
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::atomic<int> queued_{0};
+  std::atomic<int> background_queued_{0};
+  bool stop_{false};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__JOB_SYSTEM_H__
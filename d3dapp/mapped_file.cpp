@@ -0,0 +1,114 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#include "framework.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace d3dapp {
+MappedFile::~MappedFile() { Close(); }
+
+#if defined(_WIN32)
+bool MappedFile::Open(const char* path) {
+  Close();
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (INVALID_HANDLE_VALUE == file) {
+    return false;
+  }
+  file_ = file;
+
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || 0 == size.QuadPart) {
+    Close();
+    return false;
+  }
+  mapping_ = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping_) {
+    Close();
+    return false;
+  }
+  data_ = static_cast<const uint8_t*>(
+      MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if (!data_) {
+    Close();
+    return false;
+  }
+  size_ = static_cast<uint64_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_) {
+    CloseHandle(mapping_);
+  }
+  if (file_) {
+    CloseHandle(file_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  mapping_ = nullptr;
+  file_ = nullptr;
+}
+
+void MappedFile::Prefetch(uint64_t offset, uint64_t size) const {
+  if (offset >= size_) {
+    return;
+  }
+  WIN32_MEMORY_RANGE_ENTRY range{};
+  range.VirtualAddress = const_cast<uint8_t*>(data_ + offset);
+  range.NumberOfBytes = static_cast<SIZE_T>(
+      size < size_ - offset ? size : size_ - offset);
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#else
+bool MappedFile::Open(const char* path) {
+  Close();
+  int file = open(path, O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+  struct stat status {};
+  void* data = MAP_FAILED;
+  if (0 == fstat(file, &status) && status.st_size > 0) {
+    data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ,
+                MAP_PRIVATE, file, 0);
+  }
+  // The mapping keeps the file open.
+  close(file);
+  if (MAP_FAILED == data) {
+    return false;
+  }
+  data_ = static_cast<const uint8_t*>(data);
+  size_ = static_cast<uint64_t>(status.st_size);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_) {
+    munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void MappedFile::Prefetch(uint64_t offset, uint64_t size) const {
+  if (offset >= size_) {
+    return;
+  }
+  uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  uint64_t begin = offset & ~(page_size - 1);
+  uint64_t end = size < size_ - offset ? offset + size : size_;
+  madvise(const_cast<uint8_t*>(data_ + begin),
+          static_cast<size_t>(end - begin), MADV_WILLNEED);
+}
+#endif
+
+}  // namespace d3dapp
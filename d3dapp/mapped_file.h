@@ -0,0 +1,40 @@
+#pragma once
+
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <cstdint>
+
+namespace d3dapp {
+// Read-only view of a whole file. Pages are read in on first touch, so
+// reads happen on whichever thread walks the data.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  // Fails for empty files.
+  bool Open(const char* path);
+  void Close();
+
+  // Asks the OS to start reading a range in so that touching it later does
+  // not block. Only a hint.
+  void Prefetch(uint64_t offset, uint64_t size) const;
+
+  const uint8_t* data() const { return data_; }
+  uint64_t size() const { return size_; }
+
+ private:
+  const uint8_t* data_{nullptr};
+  uint64_t size_{0};
+#if defined(_WIN32)
+  void* file_{nullptr};
+  void* mapping_{nullptr};
+#endif
+};
+
+}  // namespace d3dapp
+
+#endif  // !__MAPPED_FILE_H__
@@ -0,0 +1,38 @@
+#include "render_gate.h"
+
+namespace d3dapp {
+void RenderGate::Invalidate() {
+  invalidated_.store(true, std::memory_order_release);
+  Wake();
+}
+
+void RenderGate::Wake() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    wake_pending_ = true;
+  }
+  woken_.notify_one();
+}
+
+bool RenderGate::ShouldRender(const std::function<bool()>& still_occluded) {
+  if (minimized_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  if (occluded_) {
+    if (still_occluded()) {
+      return false;
+    }
+    occluded_ = false;
+    return true;
+  }
+  return !on_demand_ ||
+         invalidated_.exchange(false, std::memory_order_acq_rel);
+}
+
+void RenderGate::WaitForWork(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  woken_.wait_for(lock, timeout, [this]() { return wake_pending_; });
+  wake_pending_ = false;
+}
+
+}  // namespace d3dapp
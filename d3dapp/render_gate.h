@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef __RENDER_GATE_H__
+#define __RENDER_GATE_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace d3dapp {
+// Decides whether the app loop renders a frame or waits for work: nothing
+// renders while the window is minimized or occluded, and on demand only
+// invalidated frames render. The render thread waits here between frames.
+class RenderGate {
+ public:
+  explicit RenderGate(bool on_demand = false) : on_demand_{on_demand} {}
+  RenderGate(const RenderGate&) = delete;
+  RenderGate& operator=(const RenderGate&) = delete;
+
+  // Asks for another frame and wakes the waiter. Any thread.
+  void Invalidate();
+  // Wakes the waiter without asking for a frame, e.g. to handle a forwarded
+  // message. Any thread.
+  void Wake();
+  // Any thread.
+  void SetMinimized(bool minimized) {
+    minimized_.store(minimized, std::memory_order_release);
+  }
+  // Present reported the window occluded. Render thread.
+  void SetOccluded() { occluded_ = true; }
+
+  // Render thread. While occluded, still_occluded is asked whether the
+  // window is still hidden, e.g. with a test Present; the first frame after
+  // it shows again renders.
+  bool ShouldRender(const std::function<bool()>& still_occluded);
+
+  // Blocks until Invalidate or Wake, or for at most timeout. A wake that
+  // came in since the last wait returns right away.
+  void WaitForWork(std::chrono::milliseconds timeout);
+
+  bool on_demand() const { return on_demand_; }
+
+ private:
+  bool on_demand_{false};
+  std::atomic<bool> invalidated_{true};
+  std::atomic<bool> minimized_{false};
+  bool occluded_{false};
+
+  std::mutex mutex_;
+  std::condition_variable woken_;
+  bool wake_pending_{false};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__RENDER_GATE_H__
@@ -0,0 +1,337 @@
+#include "render_graph.h"
+
+#include <algorithm>
+
+#include "heap_allocator.h"
+
+static_assert(d3dapp::kUnorderedAccessState ==
+                  D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+              "state bits must match D3D12_RESOURCE_STATES");
+static_assert(d3dapp::kWriteStates ==
+                  (static_cast<uint32_t>(D3D12_RESOURCE_STATE_RENDER_TARGET) |
+                   D3D12_RESOURCE_STATE_UNORDERED_ACCESS |
+                   D3D12_RESOURCE_STATE_DEPTH_WRITE |
+                   D3D12_RESOURCE_STATE_STREAM_OUT |
+                   D3D12_RESOURCE_STATE_COPY_DEST |
+                   D3D12_RESOURCE_STATE_RESOLVE_DEST),
+              "state bits must match D3D12_RESOURCE_STATES");
+
+namespace {
+constexpr UINT64 kMinTransientHeapSize =
+    D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+constexpr size_t kNoCacheEntry = ~size_t{0};
+
+D3D12_RESOURCE_BARRIER_FLAGS ToFlags(d3dapp::GraphBarrier::Split split) {
+  switch (split) {
+    case d3dapp::GraphBarrier::kBegin:
+      return D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+    case d3dapp::GraphBarrier::kEnd:
+      return D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+    default:
+      return D3D12_RESOURCE_BARRIER_FLAG_NONE;
+  }
+}
+
+}  // namespace
+
+namespace d3dapp {
+RenderGraph::RenderGraph(ID3D12Device* device,
+                         D3D12_RESOURCE_HEAP_TIER heap_tier,
+                         DeferredReleaseQueue* release_queue)
+    : device_{device}, heap_tier_{heap_tier}, release_queue_{release_queue} {}
+
+void RenderGraph::Reset() {
+  compiler_.Reset();
+  resources_.clear();
+  passes_.clear();
+  transients_.clear();
+}
+
+uint32_t RenderGraph::Import(ID3D12Resource* resource,
+                             D3D12_RESOURCE_STATES state) {
+  resources_.push_back(resource);
+  return compiler_.AddResource(state);
+}
+
+void RenderGraph::Export(uint32_t resource,
+                         D3D12_RESOURCE_STATES final_state) {
+  compiler_.Export(resource, final_state);
+}
+
+uint32_t RenderGraph::CreateTransient(const D3D12_RESOURCE_DESC& desc,
+                                      const D3D12_CLEAR_VALUE* clear_value) {
+  const D3D12_RESOURCE_ALLOCATION_INFO& info = AllocationInfoFor(desc);
+  uint32_t resource = compiler_.AddResource(D3D12_RESOURCE_STATE_COMMON);
+  compiler_.SetTransient(resource, info.SizeInBytes, info.Alignment,
+                         GroupFor(desc));
+  resources_.push_back(nullptr);
+
+  Transient transient{};
+  transient.resource = resource;
+  transient.desc = desc;
+  transient.has_clear_value = nullptr != clear_value;
+  if (clear_value) {
+    transient.clear_value = *clear_value;
+  }
+  transients_.push_back(transient);
+  return resource;
+}
+
+void RenderGraph::AddPass(PassFunction execute, bool never_cull) {
+  passes_.push_back(std::move(execute));
+  compiler_.AddPass(never_cull);
+}
+
+void RenderGraph::Read(uint32_t resource, D3D12_RESOURCE_STATES state) {
+  compiler_.Read(resource, state);
+}
+
+void RenderGraph::Write(uint32_t resource, D3D12_RESOURCE_STATES state) {
+  compiler_.Write(resource, state);
+}
+
+void RenderGraph::Execute(ID3D12GraphicsCommandList* command_list,
+                          CommandListPool* command_list_pool) {
+  compiler_.Schedule();
+  AllocateTransients();
+  compiler_.EmitBarriers();
+
+  ResourceStateTracker* state_tracker =
+      command_list_pool ? command_list_pool->state_tracker(command_list)
+                        : nullptr;
+  if (state_tracker) {
+    for (uint32_t r = 0; r < resources_.size(); ++r) {
+      if (resources_[r]) {
+        state_tracker->Assume(resources_[r], compiler_.initial_state(r));
+      }
+    }
+  }
+
+  const std::vector<uint32_t>& order = compiler_.order();
+  for (size_t i = 0; i <= order.size(); ++i) {
+    if (state_tracker) {
+      TrackBarriers(command_list, command_list_pool, i);
+    } else {
+      IssueBarriers(command_list, i);
+    }
+    if (i < order.size() && passes_[order[i]]) {
+      passes_[order[i]](command_list);
+    }
+  }
+  RetireTransients();
+}
+
+TransientMemoryStats RenderGraph::transient_stats() const {
+  TransientMemoryStats stats{};
+  for (size_t group = 0; group < compiler_.group_count(); ++group) {
+    stats.peak += compiler_.group_size(static_cast<uint32_t>(group));
+  }
+  stats.unaliased = compiler_.unaliased_size();
+  for (const TransientHeap& heap : heaps_) {
+    stats.reserved += heap.size;
+  }
+  stats.resource_count = cache_.size();
+  return stats;
+}
+
+uint32_t RenderGraph::GroupFor(const D3D12_RESOURCE_DESC& desc) {
+  D3D12_HEAP_FLAGS flags = HeapAllocator::HeapFlagsFor(heap_tier_, desc);
+  for (uint32_t group = 0; group < heaps_.size(); ++group) {
+    if (heaps_[group].flags == flags) {
+      return group;
+    }
+  }
+  heaps_.push_back(TransientHeap{flags, nullptr, 0});
+  return static_cast<uint32_t>(heaps_.size() - 1);
+}
+
+const D3D12_RESOURCE_ALLOCATION_INFO& RenderGraph::AllocationInfoFor(
+    const D3D12_RESOURCE_DESC& desc) {
+  for (AllocationInfo& cached : allocation_infos_) {
+    if (cached.desc == desc) {
+      cached.used = true;
+      return cached.info;
+    }
+  }
+  AllocationInfo cached{};
+  cached.desc = desc;
+  cached.info = device_->GetResourceAllocationInfo(0, 1, &desc);
+  cached.used = true;
+  allocation_infos_.push_back(cached);
+  return allocation_infos_.back().info;
+}
+
+void RenderGraph::GrowHeap(uint32_t group, UINT64 size) {
+  TransientHeap& heap = heaps_[group];
+  UINT64 heap_size = std::max(heap.size, kMinTransientHeapSize);
+  while (heap_size < size) {
+    heap_size <<= 1;
+  }
+
+  // Everything placed in the old heap goes with it.
+  for (CachedResource& cached : cache_) {
+    if (cached.group == group) {
+      release_queue_->Release(cached.resource);
+      cached.used = false;
+    }
+  }
+  if (heap.heap) {
+    release_queue_->Release(heap.heap);
+  }
+
+  CD3DX12_HEAP_DESC heap_desc{heap_size, D3D12_HEAP_TYPE_DEFAULT,
+                              D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT,
+                              heap.flags};
+  heap.size = SUCCEEDED(device_->CreateHeap(&heap_desc,
+                                            IID_PPV_ARGS(&heap.heap)))
+                  ? heap_size
+                  : 0;
+}
+
+void RenderGraph::AllocateTransients() {
+  for (uint32_t group = 0; group < compiler_.group_count(); ++group) {
+    if (compiler_.group_size(group) > heaps_[group].size) {
+      GrowHeap(group, compiler_.group_size(group));
+    }
+  }
+  for (CachedResource& cached : cache_) {
+    cached.used = false;
+  }
+
+  for (Transient& transient : transients_) {
+    transient.cache_index = kNoCacheEntry;
+    uint32_t resource = transient.resource;
+    if (kNoGraphResource == compiler_.first_state(resource)) {
+      continue;
+    }
+    uint32_t group = compiler_.transient_group(resource);
+    UINT64 offset = compiler_.transient_offset(resource);
+
+    size_t index = 0;
+    for (; index < cache_.size(); ++index) {
+      const CachedResource& cached = cache_[index];
+      if (!cached.used && cached.resource && cached.group == group &&
+          cached.offset == offset && cached.desc == transient.desc) {
+        break;
+      }
+    }
+    if (index == cache_.size()) {
+      CachedResource cached{};
+      cached.desc = transient.desc;
+      cached.group = group;
+      cached.offset = offset;
+      cached.state = static_cast<D3D12_RESOURCE_STATES>(
+          compiler_.first_state(resource));
+      if (!heaps_[group].heap ||
+          FAILED(device_->CreatePlacedResource(
+              heaps_[group].heap.Get(), offset, &transient.desc, cached.state,
+              transient.has_clear_value ? &transient.clear_value : nullptr,
+              IID_PPV_ARGS(&cached.resource)))) {
+        // Leaves resources_[resource] null; the passes using it are skipped
+        // this frame rather than recorded against a missing resource.
+        compiler_.DropResource(resource);
+        continue;
+      }
+      cache_.push_back(std::move(cached));
+    }
+
+    cache_[index].used = true;
+    transient.cache_index = index;
+    resources_[resource] = cache_[index].resource.Get();
+    compiler_.SetInitialState(resource, cache_[index].state);
+  }
+}
+
+void RenderGraph::RetireTransients() {
+  for (const Transient& transient : transients_) {
+    if (kNoCacheEntry != transient.cache_index) {
+      cache_[transient.cache_index].state =
+          final_state(transient.resource);
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < cache_.size(); ++i) {
+    if (!cache_[i].used) {
+      if (cache_[i].resource) {
+        release_queue_->Release(cache_[i].resource);
+      }
+      continue;
+    }
+    if (kept != i) {
+      cache_[kept] = std::move(cache_[i]);
+    }
+    ++kept;
+  }
+  cache_.resize(kept);
+
+  // Sizes of descs the frame did not use go too, so resizing does not
+  // pile them up.
+  kept = 0;
+  for (size_t i = 0; i < allocation_infos_.size(); ++i) {
+    if (allocation_infos_[i].used) {
+      allocation_infos_[i].used = false;
+      allocation_infos_[kept++] = allocation_infos_[i];
+    }
+  }
+  allocation_infos_.resize(kept);
+}
+
+void RenderGraph::IssueBarriers(ID3D12GraphicsCommandList* command_list,
+                                size_t index) {
+  size_t count = compiler_.barrier_count(index);
+  if (0 == count) {
+    return;
+  }
+
+  const GraphBarrier* barriers = compiler_.barriers(index);
+  barriers_.clear();
+  for (size_t i = 0; i < count; ++i) {
+    ID3D12Resource* resource = resources_[barriers[i].resource];
+    if (GraphBarrier::kUav == barriers[i].type) {
+      barriers_.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+    } else if (GraphBarrier::kAliasing == barriers[i].type) {
+      ID3D12Resource* before = kNoGraphResource == barriers[i].before
+                                   ? nullptr
+                                   : resources_[barriers[i].before];
+      barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(before, resource));
+    } else {
+      barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+          resource, static_cast<D3D12_RESOURCE_STATES>(barriers[i].before),
+          static_cast<D3D12_RESOURCE_STATES>(barriers[i].after),
+          D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+          ToFlags(barriers[i].split)));
+    }
+  }
+  command_list->ResourceBarrier(static_cast<UINT>(barriers_.size()),
+                                barriers_.data());
+}
+
+void RenderGraph::TrackBarriers(ID3D12GraphicsCommandList* command_list,
+                                CommandListPool* command_list_pool,
+                                size_t index) {
+  ResourceStateTracker* state_tracker =
+      command_list_pool->state_tracker(command_list);
+  const GraphBarrier* barriers = compiler_.barriers(index);
+  for (size_t i = 0; i < compiler_.barrier_count(index); ++i) {
+    const void* resource = resources_[barriers[i].resource];
+    if (GraphBarrier::kUav == barriers[i].type) {
+      state_tracker->UavBarrier(resource);
+    } else if (GraphBarrier::kAliasing == barriers[i].type) {
+      state_tracker->AliasingBarrier(kNoGraphResource == barriers[i].before
+                                         ? nullptr
+                                         : resources_[barriers[i].before],
+                                     resource);
+    } else if (GraphBarrier::kBegin == barriers[i].split) {
+      state_tracker->BeginTransition(resource, barriers[i].after);
+    } else if (GraphBarrier::kEnd == barriers[i].split) {
+      state_tracker->EndTransition(resource, barriers[i].after);
+    } else {
+      state_tracker->Transition(resource, kAllSubresources,
+                                barriers[i].after);
+    }
+  }
+  command_list_pool->FlushBarriers(command_list);
+}
+
+}  // namespace d3dapp
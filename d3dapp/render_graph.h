@@ -0,0 +1,141 @@
+#pragma once
+
+#ifndef __RENDER_GRAPH_H__
+#define __RENDER_GRAPH_H__
+
+#include <d3dx12.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "command_list_pool.h"
+#include "deferred_release_queue.h"
+#include "framework.h"
+#include "render_graph_compiler.h"
+
+namespace d3dapp {
+struct TransientMemoryStats {
+  // Memory the last compiled graph needed with and without aliasing.
+  UINT64 peak{0};
+  UINT64 unaliased{0};
+  // Size of the heaps kept for transients.
+  UINT64 reserved{0};
+  size_t resource_count{0};
+};
+
+// Passes declare the resources they read and write and record into the
+// command list handed to them; the graph culls passes nobody depends on and
+// issues the transitions between them in one ResourceBarrier call per pass.
+// Rebuilt every frame. Transient resources are placed in heaps the graph
+// keeps across frames and are reused as long as their desc and placement do
+// not change.
+class RenderGraph {
+ public:
+  using PassFunction = std::function<void(ID3D12GraphicsCommandList*)>;
+
+  RenderGraph(ID3D12Device* device, D3D12_RESOURCE_HEAP_TIER heap_tier,
+              DeferredReleaseQueue* release_queue);
+  RenderGraph(const RenderGraph&) = delete;
+  RenderGraph& operator=(const RenderGraph&) = delete;
+
+  void Reset();
+
+  // The graph does not own the resource; state is the one it is in when the
+  // first pass runs.
+  uint32_t Import(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+  // Marks the resource as an output and leaves it in final_state.
+  void Export(uint32_t resource, D3D12_RESOURCE_STATES final_state);
+  // Lives from its first to its last surviving pass and shares memory with
+  // transients whose passes do not overlap, so the first pass must fully
+  // initialize it, e.g. with a clear or DiscardResource.
+  uint32_t CreateTransient(const D3D12_RESOURCE_DESC& desc,
+                           const D3D12_CLEAR_VALUE* clear_value = nullptr);
+
+  // Read and Write apply to the most recently added pass.
+  void AddPass(PassFunction execute, bool never_cull = false);
+  void Read(uint32_t resource, D3D12_RESOURCE_STATES state);
+  void Write(uint32_t resource, D3D12_RESOURCE_STATES state);
+
+  // Compiles the graph and records every surviving pass into command_list.
+  // Given the pool the list came from, barriers go through the list's state
+  // tracker, so registered resources keep their states.
+  void Execute(ID3D12GraphicsCommandList* command_list,
+               CommandListPool* command_list_pool = nullptr);
+
+  // Null for transients until the graph executes, when they are culled, or
+  // when they could not be created; the passes using those are dropped, see
+  // RenderGraphCompiler::DropResource.
+  ID3D12Resource* resource(uint32_t resource) const {
+    return resources_[resource];
+  }
+  D3D12_RESOURCE_STATES final_state(uint32_t resource) const {
+    return static_cast<D3D12_RESOURCE_STATES>(
+        compiler_.final_state(resource));
+  }
+  // Off by default. When on, transitions overlap the passes between the
+  // last use of a resource and its next one; compiler().split_stats()
+  // reports the overlap windows.
+  void SetSplitBarriers(bool enabled) { compiler_.SetSplitBarriers(enabled); }
+  const RenderGraphCompiler& compiler() const { return compiler_; }
+  TransientMemoryStats transient_stats() const;
+
+ private:
+  struct Transient {
+    uint32_t resource;
+    D3D12_RESOURCE_DESC desc;
+    D3D12_CLEAR_VALUE clear_value;
+    bool has_clear_value;
+    size_t cache_index;
+  };
+
+  struct TransientHeap {
+    D3D12_HEAP_FLAGS flags;
+    Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+    UINT64 size;
+  };
+
+  struct CachedResource {
+    Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+    D3D12_RESOURCE_DESC desc;
+    uint32_t group;
+    UINT64 offset;
+    D3D12_RESOURCE_STATES state;
+    bool used;
+  };
+
+  // GetResourceAllocationInfo is slow enough to show up per frame, so its
+  // results are kept for the descs the last frame used.
+  struct AllocationInfo {
+    D3D12_RESOURCE_DESC desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info;
+    bool used;
+  };
+
+  const D3D12_RESOURCE_ALLOCATION_INFO& AllocationInfoFor(
+      const D3D12_RESOURCE_DESC& desc);
+  uint32_t GroupFor(const D3D12_RESOURCE_DESC& desc);
+  void GrowHeap(uint32_t group, UINT64 size);
+  void AllocateTransients();
+  void RetireTransients();
+  void IssueBarriers(ID3D12GraphicsCommandList* command_list, size_t index);
+  void TrackBarriers(ID3D12GraphicsCommandList* command_list,
+                     CommandListPool* command_list_pool, size_t index);
+
+  ID3D12Device* device_{nullptr};
+  D3D12_RESOURCE_HEAP_TIER heap_tier_;
+  DeferredReleaseQueue* release_queue_{nullptr};
+
+  RenderGraphCompiler compiler_;
+  std::vector<ID3D12Resource*> resources_;
+  std::vector<PassFunction> passes_;
+  std::vector<D3D12_RESOURCE_BARRIER> barriers_;
+  std::vector<Transient> transients_;
+  std::vector<TransientHeap> heaps_;
+  std::vector<CachedResource> cache_;
+  std::vector<AllocationInfo> allocation_infos_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__RENDER_GRAPH_H__
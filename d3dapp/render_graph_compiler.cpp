@@ -0,0 +1,403 @@
+#include "render_graph_compiler.h"
+
+#include <algorithm>
+
+namespace d3dapp {
+void RenderGraphCompiler::Reset() {
+  resources_.clear();
+  passes_.clear();
+  accesses_.clear();
+  order_.clear();
+  barriers_.clear();
+  barrier_offsets_.clear();
+  group_sizes_.clear();
+  unaliased_size_ = 0;
+}
+
+uint32_t RenderGraphCompiler::AddResource(uint32_t initial_state) {
+  Resource resource{};
+  resource.initial_state = initial_state;
+  resources_.push_back(resource);
+  return static_cast<uint32_t>(resources_.size() - 1);
+}
+
+void RenderGraphCompiler::Export(uint32_t resource, uint32_t final_state) {
+  resources_[resource].exported = true;
+  resources_[resource].final_state = final_state;
+}
+
+void RenderGraphCompiler::SetTransient(uint32_t resource, uint64_t size,
+                                       uint64_t alignment, uint32_t group) {
+  Resource& tracked = resources_[resource];
+  tracked.transient = true;
+  tracked.size = size;
+  tracked.alignment = alignment;
+  tracked.group = group;
+}
+
+uint32_t RenderGraphCompiler::AddPass(bool never_cull) {
+  Pass pass{};
+  pass.first_access = static_cast<uint32_t>(accesses_.size());
+  pass.never_cull = never_cull;
+  passes_.push_back(pass);
+  return static_cast<uint32_t>(passes_.size() - 1);
+}
+
+void RenderGraphCompiler::Read(uint32_t resource, uint32_t state) {
+  AddAccess(resource, state, false);
+}
+
+void RenderGraphCompiler::Write(uint32_t resource, uint32_t state) {
+  AddAccess(resource, state, true);
+}
+
+void RenderGraphCompiler::Compile() {
+  Schedule();
+  EmitBarriers();
+}
+
+void RenderGraphCompiler::Schedule() {
+  Cull();
+  order_.clear();
+  for (uint32_t p = 0; p < passes_.size(); ++p) {
+    if (passes_[p].alive) {
+      order_.push_back(p);
+    }
+  }
+  CollectReads();
+  FindLifetimes();
+  // Transients start out in the state they are first used in unless told
+  // otherwise.
+  for (Resource& resource : resources_) {
+    resource.dropped = false;
+    if (resource.transient && kNoGraphResource != resource.first) {
+      resource.initial_state = resource.first_state;
+    }
+  }
+  PlaceTransients();
+}
+
+void RenderGraphCompiler::SetInitialState(uint32_t resource, uint32_t state) {
+  resources_[resource].initial_state = state;
+}
+
+void RenderGraphCompiler::DropResource(uint32_t resource) {
+  resources_[resource].dropped = true;
+  // In execution order, so transients a dropped pass writes are dropped
+  // before any of their readers comes up.
+  size_t kept = 0;
+  for (uint32_t p : order_) {
+    Pass& pass = passes_[p];
+    const Access* accesses = accesses_.data() + pass.first_access;
+    for (uint32_t a = 0; a < pass.access_count && pass.alive; ++a) {
+      pass.alive = !resources_[accesses[a].resource].dropped;
+    }
+    if (pass.alive) {
+      order_[kept++] = p;
+      continue;
+    }
+    for (uint32_t a = 0; a < pass.access_count; ++a) {
+      Resource& written = resources_[accesses[a].resource];
+      if (accesses[a].write && written.transient) {
+        written.dropped = true;
+      }
+    }
+  }
+  order_.resize(kept);
+  // Lifetimes only shrink, so the transients stay where they were placed.
+  FindLifetimes();
+}
+
+void RenderGraphCompiler::AddAccess(uint32_t resource, uint32_t state,
+                                    bool write) {
+  accesses_.push_back(Access{resource, state, write, state});
+  ++passes_.back().access_count;
+}
+
+bool RenderGraphCompiler::PassWrites(const Pass& pass,
+                                     uint32_t resource) const {
+  for (uint32_t i = 0; i < pass.access_count; ++i) {
+    const Access& access = accesses_[pass.first_access + i];
+    if (access.write && access.resource == resource) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RenderGraphCompiler::Cull() {
+  for (Resource& resource : resources_) {
+    resource.needed = resource.exported;
+  }
+
+  for (size_t p = passes_.size(); p > 0; --p) {
+    Pass& pass = passes_[p - 1];
+    pass.alive = pass.never_cull;
+    for (uint32_t i = 0; i < pass.access_count && !pass.alive; ++i) {
+      const Access& access = accesses_[pass.first_access + i];
+      pass.alive = access.write && resources_[access.resource].needed;
+    }
+    if (!pass.alive) {
+      continue;
+    }
+    // Writes keep earlier writers alive as well, since they build on the
+    // previous contents.
+    for (uint32_t i = 0; i < pass.access_count; ++i) {
+      resources_[accesses_[pass.first_access + i].resource].needed = true;
+    }
+  }
+}
+
+void RenderGraphCompiler::CollectReads() {
+  for (Resource& resource : resources_) {
+    resource.pending_reads = 0;
+  }
+
+  for (size_t p = passes_.size(); p > 0; --p) {
+    const Pass& pass = passes_[p - 1];
+    if (!pass.alive) {
+      continue;
+    }
+    Access* accesses = accesses_.data() + pass.first_access;
+    for (uint32_t i = 0; i < pass.access_count; ++i) {
+      if (accesses[i].write) {
+        resources_[accesses[i].resource].pending_reads = 0;
+      }
+    }
+    for (uint32_t i = 0; i < pass.access_count; ++i) {
+      if (!accesses[i].write && !PassWrites(pass, accesses[i].resource)) {
+        resources_[accesses[i].resource].pending_reads |= accesses[i].state;
+      }
+    }
+    for (uint32_t i = 0; i < pass.access_count; ++i) {
+      if (!accesses[i].write) {
+        accesses[i].read_union =
+            resources_[accesses[i].resource].pending_reads;
+      }
+    }
+  }
+}
+
+void RenderGraphCompiler::FindLifetimes() {
+  for (Resource& resource : resources_) {
+    resource.first = kNoGraphResource;
+    resource.last = kNoGraphResource;
+    resource.first_state = kNoGraphResource;
+  }
+
+  for (uint32_t i = 0; i < order_.size(); ++i) {
+    const Pass& pass = passes_[order_[i]];
+    const Access* accesses = accesses_.data() + pass.first_access;
+    for (uint32_t a = 0; a < pass.access_count; ++a) {
+      if (!accesses[a].write && PassWrites(pass, accesses[a].resource)) {
+        continue;
+      }
+      Resource& resource = resources_[accesses[a].resource];
+      if (kNoGraphResource == resource.first) {
+        resource.first = i;
+        resource.first_state =
+            accesses[a].write ? accesses[a].state : accesses[a].read_union;
+      }
+      resource.last = i;
+    }
+  }
+}
+
+void RenderGraphCompiler::PlaceTransients() {
+  group_sizes_.clear();
+  unaliased_size_ = 0;
+  for (const Resource& resource : resources_) {
+    if (resource.transient && kNoGraphResource != resource.first) {
+      if (group_sizes_.size() <= resource.group) {
+        group_sizes_.resize(resource.group + 1, 0);
+      }
+      unaliased_size_ += resource.size;
+    }
+  }
+
+  for (uint32_t group = 0; group < group_sizes_.size(); ++group) {
+    intervals_.clear();
+    interval_resources_.clear();
+    for (uint32_t r = 0; r < resources_.size(); ++r) {
+      const Resource& resource = resources_[r];
+      if (resource.transient && kNoGraphResource != resource.first &&
+          resource.group == group) {
+        intervals_.push_back(TransientInterval{resource.size,
+                                               resource.alignment,
+                                               resource.first, resource.last,
+                                               0, kNoInterval, false});
+        interval_resources_.push_back(r);
+      }
+    }
+
+    group_sizes_[group] = PackTransients(intervals_);
+    for (size_t i = 0; i < intervals_.size(); ++i) {
+      Resource& resource = resources_[interval_resources_[i]];
+      resource.offset = intervals_[i].offset;
+      resource.aliased = intervals_[i].aliased;
+      resource.alias_before =
+          kNoInterval == intervals_[i].alias_before
+              ? kNoGraphResource
+              : interval_resources_[intervals_[i].alias_before];
+    }
+  }
+}
+
+void RenderGraphCompiler::EmitBarriers() {
+  barriers_.clear();
+  barrier_offsets_.clear();
+  split_begins_.clear();
+  for (Resource& resource : resources_) {
+    resource.state = resource.initial_state;
+    resource.uav_written = false;
+    // Aliased transients may only change state once their aliasing barrier
+    // made them the active resource of their memory.
+    bool aliased = resource.transient && resource.aliased &&
+                   kNoGraphResource != resource.first;
+    resource.idle_from = aliased ? resource.first : 0;
+  }
+
+  // Transients that share memory, in the order they become live.
+  aliased_.clear();
+  for (uint32_t r = 0; r < resources_.size(); ++r) {
+    if (resources_[r].transient && kNoGraphResource != resources_[r].first &&
+        resources_[r].aliased) {
+      aliased_.push_back(r);
+    }
+  }
+  std::sort(aliased_.begin(), aliased_.end(),
+            [this](uint32_t a, uint32_t b) {
+              return resources_[a].first < resources_[b].first;
+            });
+  size_t next_alias = 0;
+
+  for (uint32_t i = 0; i < order_.size(); ++i) {
+    const Pass& pass = passes_[order_[i]];
+    barrier_offsets_.push_back(barriers_.size());
+
+    for (; next_alias < aliased_.size() &&
+           resources_[aliased_[next_alias]].first == i;
+         ++next_alias) {
+      uint32_t resource = aliased_[next_alias];
+      barriers_.push_back(GraphBarrier{GraphBarrier::kAliasing, resource,
+                                       resources_[resource].alias_before, 0});
+    }
+
+    const Access* accesses = accesses_.data() + pass.first_access;
+    for (uint32_t a = 0; a < pass.access_count; ++a) {
+      const Access& access = accesses[a];
+      Resource& resource = resources_[access.resource];
+      uint32_t target = access.state;
+      if (!access.write) {
+        if (PassWrites(pass, access.resource)) {
+          continue;
+        }
+        target = access.read_union;
+        // Already in a read state covering every read up to the next write.
+        if (0 == (resource.state & kWriteStates) &&
+            (resource.state & target) == target) {
+          continue;
+        }
+      }
+
+      if (resource.state != target) {
+        Transition(access.resource, target, i);
+      } else if (resource.uav_written) {
+        barriers_.push_back(GraphBarrier{GraphBarrier::kUav, access.resource,
+                                         target, target});
+        resource.uav_written = false;
+      }
+    }
+
+    // Set afterwards so several accesses in one pass need no UAV barrier
+    // between them.
+    for (uint32_t a = 0; a < pass.access_count; ++a) {
+      Resource& resource = resources_[accesses[a].resource];
+      if (accesses[a].write && kUnorderedAccessState == accesses[a].state) {
+        resource.uav_written = true;
+      }
+      resource.idle_from = i + 1;
+    }
+  }
+
+  uint32_t final_slot = static_cast<uint32_t>(order_.size());
+  barrier_offsets_.push_back(barriers_.size());
+  for (uint32_t r = 0; r < resources_.size(); ++r) {
+    // Dropped resources no pass uses any more may not exist at all.
+    if (resources_[r].dropped && kNoGraphResource == resources_[r].first) {
+      continue;
+    }
+    if (resources_[r].exported &&
+        resources_[r].state != resources_[r].final_state) {
+      Transition(r, resources_[r].final_state, final_slot);
+    }
+  }
+  barrier_offsets_.push_back(barriers_.size());
+  PlaceSplitBegins();
+}
+
+SplitBarrierStats RenderGraphCompiler::split_stats() const {
+  SplitBarrierStats stats{};
+  for (const GraphBarrier& barrier : barriers_) {
+    if (GraphBarrier::kEnd == barrier.split) {
+      ++stats.split_count;
+      stats.total_window += barrier.window;
+      stats.max_window = std::max<size_t>(stats.max_window, barrier.window);
+    } else if (GraphBarrier::kFull == barrier.split &&
+               GraphBarrier::kTransition == barrier.type) {
+      ++stats.full_count;
+    }
+  }
+  return stats;
+}
+
+void RenderGraphCompiler::Transition(uint32_t resource, uint32_t after,
+                                     uint32_t slot) {
+  Resource& tracked = resources_[resource];
+  GraphBarrier barrier{GraphBarrier::kTransition, resource, tracked.state,
+                       after};
+  barrier.window = slot - std::min(tracked.idle_from, slot);
+  if (split_barriers_ && barrier.window > 0) {
+    barrier.split = GraphBarrier::kBegin;
+    split_begins_.emplace_back(tracked.idle_from, barrier);
+    barrier.split = GraphBarrier::kEnd;
+  }
+  barriers_.push_back(barrier);
+  tracked.state = after;
+  tracked.uav_written = false;
+  // A further transition in the same slot, e.g. from a second access of the
+  // pass, must wait for this one rather than begin alongside it.
+  tracked.idle_from = slot;
+}
+
+void RenderGraphCompiler::PlaceSplitBegins() {
+  if (split_begins_.empty()) {
+    return;
+  }
+
+  // Begin halves go first in their slot, ahead of the barriers of the pass
+  // that slot precedes.
+  std::stable_sort(split_begins_.begin(), split_begins_.end(),
+                   [](const std::pair<uint32_t, GraphBarrier>& a,
+                      const std::pair<uint32_t, GraphBarrier>& b) {
+                     return a.first < b.first;
+                   });
+  split_scratch_.clear();
+  size_t next_begin = 0;
+  for (uint32_t slot = 0; slot + 1 < barrier_offsets_.size(); ++slot) {
+    size_t first = barrier_offsets_[slot];
+    size_t last = barrier_offsets_[slot + 1];
+    barrier_offsets_[slot] = split_scratch_.size();
+    for (; next_begin < split_begins_.size() &&
+           split_begins_[next_begin].first == slot;
+         ++next_begin) {
+      split_scratch_.push_back(split_begins_[next_begin].second);
+    }
+    split_scratch_.insert(split_scratch_.end(), barriers_.begin() + first,
+                          barriers_.begin() + last);
+  }
+  barrier_offsets_.back() = split_scratch_.size();
+  barriers_.swap(split_scratch_);
+}
+
+}  // namespace d3dapp
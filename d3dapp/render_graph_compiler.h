@@ -0,0 +1,212 @@
+#pragma once
+
+#ifndef __RENDER_GRAPH_COMPILER_H__
+#define __RENDER_GRAPH_COMPILER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "transient_packer.h"
+
+namespace d3dapp {
+// Resource states are D3D12_RESOURCE_STATES bits; the compiler only needs to
+// know which of them write, so it stays free of D3D headers.
+constexpr uint32_t kUnorderedAccessState = 0x8;
+constexpr uint32_t kWriteStates = 0x4 | 0x8 | 0x10 | 0x100 | 0x400 | 0x1000;
+constexpr uint32_t kNoGraphResource = 0xffffffff;
+
+// For aliasing barriers before is the resource whose memory is taken over,
+// or kNoGraphResource. Transitions may be split into a begin half issued
+// right after the last pass using the resource and an end half before the
+// pass that needs the new state.
+struct GraphBarrier {
+  enum Type { kTransition, kUav, kAliasing };
+  enum Split { kFull, kBegin, kEnd };
+
+  Type type;
+  uint32_t resource;
+  uint32_t before;
+  uint32_t after;
+  Split split{kFull};
+  // Transitions only: passes that run between the last use of the resource
+  // and the pass needing the new state, whether or not the barrier is split.
+  uint32_t window{0};
+};
+
+struct SplitBarrierStats {
+  size_t split_count{0};
+  size_t full_count{0};
+  // Passes the split transitions overlap, summed and at most.
+  size_t total_window{0};
+  size_t max_window{0};
+};
+
+// Orders passes, culls the ones whose outputs nobody consumes and works out
+// the barriers each surviving pass needs. Passes run in the order they were
+// added, which is a valid order as long as every read comes after the write
+// it depends on. A write is assumed to build on the previous contents, so
+// the passes writing a resource before a live writer stay alive too.
+//
+// Transient resources live only between their first and last surviving pass
+// and are packed into per-group memory blocks, sharing space with transients
+// whose passes do not overlap; each gets an aliasing barrier before its first
+// pass when it takes over memory used earlier in the graph.
+//
+// With split barriers on, transitions whose resource sits idle for at least
+// one pass begin right after its last use and end right before its next
+// one, so the GPU can overlap them with the passes in between.
+class RenderGraphCompiler {
+ public:
+  // Forgets every pass and resource.
+  void Reset();
+
+  // Off by default; kept across Reset.
+  void SetSplitBarriers(bool enabled) { split_barriers_ = enabled; }
+  bool split_barriers() const { return split_barriers_; }
+
+  uint32_t AddResource(uint32_t initial_state);
+  // Keeps the passes writing resource alive and returns it to final_state
+  // after the last pass.
+  void Export(uint32_t resource, uint32_t final_state);
+  // Groups are packed separately, e.g. one per heap the resources may share.
+  void SetTransient(uint32_t resource, uint64_t size, uint64_t alignment,
+                    uint32_t group);
+
+  // Read and Write declare accesses of the most recently added pass. Several
+  // reads of one resource in a pass combine their states; a pass that also
+  // writes the resource only sees the write.
+  uint32_t AddPass(bool never_cull = false);
+  void Read(uint32_t resource, uint32_t state);
+  void Write(uint32_t resource, uint32_t state);
+
+  // Compile is Schedule followed by EmitBarriers. In between, the memory of
+  // transients is known and their initial states may still be changed.
+  void Compile();
+  void Schedule();
+  void SetInitialState(uint32_t resource, uint32_t state);
+  // Also between Schedule and EmitBarriers: gives up on resource, e.g. when
+  // its memory could not be created, and drops every pass using it. Passes
+  // writing transients go with it, along with the passes later reading
+  // them, since nothing else fills them this frame. Placement is kept.
+  void DropResource(uint32_t resource);
+  void EmitBarriers();
+
+  // Surviving passes in execution order.
+  const std::vector<uint32_t>& order() const { return order_; }
+  // Barriers to issue before order()[i]. i == order().size() gives the
+  // transitions to the exported final states.
+  const GraphBarrier* barriers(size_t i) const {
+    return barriers_.data() + barrier_offsets_[i];
+  }
+  size_t barrier_count(size_t i) const {
+    return barrier_offsets_[i + 1] - barrier_offsets_[i];
+  }
+  size_t total_barrier_count() const { return barriers_.size(); }
+  SplitBarrierStats split_stats() const;
+
+  uint32_t initial_state(uint32_t resource) const {
+    return resources_[resource].initial_state;
+  }
+  // State the resource is left in once everything has run.
+  uint32_t final_state(uint32_t resource) const {
+    return resources_[resource].state;
+  }
+  // State of the first surviving access, kNoGraphResource when unused.
+  uint32_t first_state(uint32_t resource) const {
+    return resources_[resource].first_state;
+  }
+  bool dropped(uint32_t resource) const {
+    return resources_[resource].dropped;
+  }
+  bool transient(uint32_t resource) const {
+    return resources_[resource].transient;
+  }
+  uint32_t transient_group(uint32_t resource) const {
+    return resources_[resource].group;
+  }
+  uint64_t transient_offset(uint32_t resource) const {
+    return resources_[resource].offset;
+  }
+  // Memory each group needs, and what the transients would take without
+  // sharing.
+  uint64_t group_size(uint32_t group) const { return group_sizes_[group]; }
+  size_t group_count() const { return group_sizes_.size(); }
+  uint64_t unaliased_size() const { return unaliased_size_; }
+
+  size_t pass_count() const { return passes_.size(); }
+  size_t resource_count() const { return resources_.size(); }
+
+ private:
+  struct Resource {
+    uint32_t initial_state;
+    uint32_t final_state;
+    bool exported;
+    bool transient;
+    uint64_t size;
+    uint64_t alignment;
+    uint32_t group;
+    // Filled by Schedule; first and last are indices into order_.
+    uint32_t first;
+    uint32_t last;
+    uint32_t first_state;
+    uint64_t offset;
+    uint32_t alias_before;
+    bool aliased;
+    // Compile-time tracking.
+    uint32_t state;
+    uint32_t pending_reads;
+    // Barrier slot from which no pass uses the resource until its next
+    // access.
+    uint32_t idle_from;
+    bool needed;
+    bool dropped;
+    bool uav_written;
+  };
+
+  struct Pass {
+    uint32_t first_access;
+    uint32_t access_count;
+    bool never_cull;
+    bool alive;
+  };
+
+  struct Access {
+    uint32_t resource;
+    uint32_t state;
+    bool write;
+    // Reads of the same resource up to the next write, filled by Compile.
+    uint32_t read_union;
+  };
+
+  void AddAccess(uint32_t resource, uint32_t state, bool write);
+  bool PassWrites(const Pass& pass, uint32_t resource) const;
+  void Cull();
+  void CollectReads();
+  void FindLifetimes();
+  void PlaceTransients();
+  void Transition(uint32_t resource, uint32_t after, uint32_t slot);
+  void PlaceSplitBegins();
+
+  std::vector<Resource> resources_;
+  std::vector<Pass> passes_;
+  std::vector<Access> accesses_;
+
+  std::vector<uint32_t> order_;
+  std::vector<GraphBarrier> barriers_;
+  std::vector<size_t> barrier_offsets_;
+  std::vector<uint64_t> group_sizes_;
+  uint64_t unaliased_size_{0};
+  std::vector<TransientInterval> intervals_;
+  std::vector<uint32_t> interval_resources_;
+  std::vector<uint32_t> aliased_;
+  bool split_barriers_{false};
+  // Begin halves with the slot they are issued in.
+  std::vector<std::pair<uint32_t, GraphBarrier>> split_begins_;
+  std::vector<GraphBarrier> split_scratch_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__RENDER_GRAPH_COMPILER_H__
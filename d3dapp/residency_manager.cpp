@@ -0,0 +1,69 @@
+#include "residency_manager.h"
+
+namespace {
+void ToPageables(const std::vector<const void*>& objects,
+                 std::vector<ID3D12Pageable*>& pageables) {
+  pageables.clear();
+  for (const void* object : objects) {
+    pageables.push_back(
+        static_cast<ID3D12Pageable*>(const_cast<void*>(object)));
+  }
+}
+
+}  // namespace
+
+namespace d3dapp {
+ResidencyManager::ResidencyManager(
+    ID3D12Device* device, std::unique_ptr<BudgetProvider> budget_provider,
+    UINT64 headroom)
+    : device_{device},
+      budget_provider_{std::move(budget_provider)},
+      policy_{headroom} {}
+
+void ResidencyManager::Register(ID3D12Pageable* object, UINT64 size) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  policy_.Register(object, size);
+}
+
+void ResidencyManager::Unregister(ID3D12Pageable* object) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  policy_.Unregister(object);
+}
+
+void ResidencyManager::MarkUsed(ID3D12Pageable* object,
+                                uint64_t fence_value) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  policy_.MarkUsed(object, fence_value);
+}
+
+bool ResidencyManager::Update(uint64_t completed_fence) {
+  ResidencyBudget budget = budget_provider_->QueryBudget();
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  make_resident_.clear();
+  evict_.clear();
+  policy_.Plan(budget, completed_fence, make_resident_, evict_);
+
+  // Evict first so that the objects coming back have room.
+  if (!evict_.empty()) {
+    ToPageables(evict_, batch_);
+    device_->Evict(static_cast<UINT>(batch_.size()), batch_.data());
+  }
+  if (!make_resident_.empty()) {
+    ToPageables(make_resident_, batch_);
+    if (FAILED(device_->MakeResident(static_cast<UINT>(batch_.size()),
+                                     batch_.data()))) {
+      // Still evicted, so the next Update tries again.
+      policy_.CancelMakeResident(make_resident_);
+      return false;
+    }
+  }
+  return true;
+}
+
+ResidencyStats ResidencyManager::stats() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return policy_.stats();
+}
+
+}  // namespace d3dapp
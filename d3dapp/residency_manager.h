@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef __RESIDENCY_MANAGER_H__
+#define __RESIDENCY_MANAGER_H__
+
+#include <d3d12.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "framework.h"
+#include "residency_policy.h"
+
+namespace d3dapp {
+// Keeps registered heaps and committed resources within the video memory
+// budget. Each frame marks what it uses; Update, called before the frame is
+// submitted, makes evicted objects that are about to be used resident and
+// evicts the least recently used idle ones, each in one batched call.
+// Thread safe.
+class ResidencyManager {
+ public:
+  // Where the budget comes from, e.g. QueryVideoMemoryInfo or a simulation.
+  class BudgetProvider {
+   public:
+    virtual ~BudgetProvider() {}
+    virtual ResidencyBudget QueryBudget() = 0;
+  };
+
+  ResidencyManager(ID3D12Device* device,
+                   std::unique_ptr<BudgetProvider> budget_provider,
+                   UINT64 headroom = 0);
+  ResidencyManager(const ResidencyManager&) = delete;
+  ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+  // Objects must be resident when registered, which they are when created,
+  // and unregistered before they are released.
+  void Register(ID3D12Pageable* object, UINT64 size);
+  void Unregister(ID3D12Pageable* object);
+
+  // The object is used by work that completes at fence_value.
+  void MarkUsed(ID3D12Pageable* object, uint64_t fence_value);
+
+  // False when MakeResident failed, in which case the work about to be
+  // submitted may fault. The objects stay evicted and are made resident by
+  // the next Update.
+  bool Update(uint64_t completed_fence);
+
+  ResidencyStats stats() const;
+
+ private:
+  ID3D12Device* device_{nullptr};
+  std::unique_ptr<BudgetProvider> budget_provider_;
+
+  mutable std::mutex mutex_;
+  ResidencyPolicy policy_;
+  std::vector<const void*> make_resident_;
+  std::vector<const void*> evict_;
+  std::vector<ID3D12Pageable*> batch_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__RESIDENCY_MANAGER_H__
@@ -0,0 +1,130 @@
+#include "residency_policy.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace d3dapp {
+ResidencyPolicy::ResidencyPolicy(uint64_t headroom) : headroom_{headroom} {}
+
+void ResidencyPolicy::Register(const void* object, uint64_t size) {
+  if (objects_.count(object)) {
+    Unregister(object);
+  }
+  lru_.push_back(Object{object, size, 0, true, false});
+  objects_[object] = std::prev(lru_.end());
+  stats_.resident_size += size;
+  ++stats_.resident_count;
+  ++stats_.object_count;
+}
+
+void ResidencyPolicy::Unregister(const void* object) {
+  auto it = objects_.find(object);
+  if (it == objects_.end()) {
+    return;
+  }
+  Lru::iterator tracked = it->second;
+  if (tracked->requested) {
+    for (size_t i = 0; i < requested_.size(); ++i) {
+      if (requested_[i] == tracked) {
+        requested_[i] = requested_.back();
+        requested_.pop_back();
+        break;
+      }
+    }
+  }
+  if (tracked->resident) {
+    stats_.resident_size -= tracked->size;
+    --stats_.resident_count;
+  } else {
+    stats_.evicted_size -= tracked->size;
+  }
+  --stats_.object_count;
+  lru_.erase(tracked);
+  objects_.erase(it);
+}
+
+bool ResidencyPolicy::IsResident(const void* object) const {
+  auto it = objects_.find(object);
+  return it != objects_.end() && it->second->resident;
+}
+
+void ResidencyPolicy::MarkUsed(const void* object, uint64_t fence_value) {
+  auto it = objects_.find(object);
+  if (it == objects_.end()) {
+    return;
+  }
+  Lru::iterator tracked = it->second;
+  tracked->last_used = std::max(tracked->last_used, fence_value);
+  lru_.splice(lru_.end(), lru_, tracked);
+  if (!tracked->resident && !tracked->requested) {
+    tracked->requested = true;
+    requested_.push_back(tracked);
+  }
+}
+
+void ResidencyPolicy::Plan(const ResidencyBudget& budget,
+                           uint64_t completed_fence,
+                           std::vector<const void*>& make_resident,
+                           std::vector<const void*>& evict) {
+  uint64_t usage = budget.usage;
+  for (Lru::iterator tracked : requested_) {
+    tracked->requested = false;
+    tracked->resident = true;
+    make_resident.push_back(tracked->object);
+    usage += tracked->size;
+    stats_.evicted_size -= tracked->size;
+    stats_.resident_size += tracked->size;
+    ++stats_.resident_count;
+    stats_.made_resident_total += tracked->size;
+    ++stats_.made_resident_count;
+  }
+  requested_.clear();
+
+  if (usage <= budget.budget) {
+    return;
+  }
+  uint64_t target = budget.budget > headroom_ ? budget.budget - headroom_ : 0;
+  for (Object& tracked : lru_) {
+    if (usage <= target) {
+      break;
+    }
+    // The GPU may still be using it.
+    if (!tracked.resident || tracked.last_used > completed_fence) {
+      continue;
+    }
+    tracked.resident = false;
+    evict.push_back(tracked.object);
+    usage -= std::min(usage, tracked.size);
+    stats_.resident_size -= tracked.size;
+    stats_.evicted_size += tracked.size;
+    --stats_.resident_count;
+    stats_.evicted_total += tracked.size;
+    ++stats_.evicted_count;
+  }
+  if (usage > budget.budget) {
+    ++stats_.over_budget_count;
+  }
+}
+
+void ResidencyPolicy::CancelMakeResident(
+    const std::vector<const void*>& objects) {
+  for (const void* object : objects) {
+    auto it = objects_.find(object);
+    if (it == objects_.end() || !it->second->resident) {
+      continue;
+    }
+    Lru::iterator tracked = it->second;
+    tracked->resident = false;
+    stats_.resident_size -= tracked->size;
+    stats_.evicted_size += tracked->size;
+    --stats_.resident_count;
+    stats_.made_resident_total -= tracked->size;
+    --stats_.made_resident_count;
+    if (!tracked->requested) {
+      tracked->requested = true;
+      requested_.push_back(tracked);
+    }
+  }
+}
+
+}  // namespace d3dapp
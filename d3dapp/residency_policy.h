@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef __RESIDENCY_POLICY_H__
+#define __RESIDENCY_POLICY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace d3dapp {
+// Local video memory as reported by the OS, e.g. by QueryVideoMemoryInfo.
+// usage covers everything the process has resident, tracked or not.
+struct ResidencyBudget {
+  uint64_t budget{0};
+  uint64_t usage{0};
+};
+
+struct ResidencyStats {
+  uint64_t resident_size{0};
+  uint64_t evicted_size{0};
+  size_t object_count{0};
+  size_t resident_count{0};
+  // Totals over every Plan, to measure churn.
+  uint64_t made_resident_total{0};
+  uint64_t evicted_total{0};
+  size_t made_resident_count{0};
+  size_t evicted_count{0};
+  // Plans that could not get under budget because everything left was in
+  // use by the GPU.
+  size_t over_budget_count{0};
+};
+
+// Decides which objects to make resident and which to evict, least
+// recently used first. Objects are only used as keys, so this runs without
+// a device. Not thread safe.
+class ResidencyPolicy {
+ public:
+  // Evictions go headroom below the budget so that the next few frames of
+  // new objects do not evict again right away.
+  explicit ResidencyPolicy(uint64_t headroom = 0);
+
+  // New objects are resident.
+  void Register(const void* object, uint64_t size);
+  void Unregister(const void* object);
+  bool IsResident(const void* object) const;
+
+  // The object is used by work that completes at fence_value.
+  void MarkUsed(const void* object, uint64_t fence_value);
+
+  // Call before submitting the work marked used. Appends the evicted objects
+  // used since the last Plan to make_resident, and the least recently used
+  // idle objects to evict until the usage after both fits the budget. Only
+  // objects last used at or before completed_fence are evicted.
+  void Plan(const ResidencyBudget& budget, uint64_t completed_fence,
+            std::vector<const void*>& make_resident,
+            std::vector<const void*>& evict);
+  // Undoes the make_resident half of the last Plan, e.g. because
+  // MakeResident failed: the objects count as evicted again and the next
+  // Plan asks for them again.
+  void CancelMakeResident(const std::vector<const void*>& objects);
+
+  const ResidencyStats& stats() const { return stats_; }
+
+ private:
+  struct Object {
+    const void* object;
+    uint64_t size;
+    uint64_t last_used;
+    bool resident;
+    bool requested;
+  };
+
+  using Lru = std::list<Object>;
+
+  uint64_t headroom_{0};
+  // Least recently used first.
+  Lru lru_;
+  std::unordered_map<const void*, Lru::iterator> objects_;
+  std::vector<Lru::iterator> requested_;
+  ResidencyStats stats_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__RESIDENCY_POLICY_H__
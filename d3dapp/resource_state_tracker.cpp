@@ -0,0 +1,294 @@
+#include "resource_state_tracker.h"
+
+#include <algorithm>
+
+namespace {
+constexpr uint32_t kCommonState = 0;
+constexpr uint32_t kCopyDestState = 0x400;
+// Non-pixel and pixel shader resource, copy source.
+constexpr uint32_t kPromotableReadStates = 0x40 | 0x80 | 0x800;
+
+bool Uniform(const std::vector<uint32_t>& states) {
+  return std::all_of(states.begin(), states.end(),
+                     [&states](uint32_t state) { return state == states[0]; });
+}
+
+// Whether a texture without simultaneous access is promoted from the
+// common state to state.
+bool TexturePromotes(uint32_t state) {
+  return kCopyDestState == state ||
+         (kCommonState != state && 0 == (state & ~kPromotableReadStates));
+}
+
+}  // namespace
+
+namespace d3dapp {
+void ResourceStateRegistry::Register(const void* resource,
+                                     uint32_t subresource_count,
+                                     uint32_t state, bool decays) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  Entry& entry = entries_[resource];
+  entry.states.assign(std::max(subresource_count, 1u), state);
+  entry.promoted.assign(entry.states.size(), false);
+  entry.decays = decays;
+}
+
+void ResourceStateRegistry::Unregister(const void* resource) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  entries_.erase(resource);
+}
+
+uint32_t ResourceStateRegistry::SubresourceCount(const void* resource) const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto it = entries_.find(resource);
+  return it == entries_.end() ? 0
+                              : static_cast<uint32_t>(it->second.states.size());
+}
+
+uint32_t ResourceStateRegistry::State(const void* resource,
+                                      uint32_t subresource) const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto it = entries_.find(resource);
+  if (it == entries_.end() || subresource >= it->second.states.size()) {
+    return kUnknownState;
+  }
+  return it->second.states[subresource];
+}
+
+void ResourceStateRegistry::Decay() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (const void* resource : decaying_) {
+    auto it = entries_.find(resource);
+    if (it == entries_.end()) {
+      continue;
+    }
+    Entry& entry = it->second;
+    for (size_t i = 0; i < entry.states.size(); ++i) {
+      if (entry.decays || entry.promoted[i]) {
+        entry.states[i] = kCommonState;
+      }
+      entry.promoted[i] = false;
+    }
+  }
+  decaying_.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+ResourceStateTracker::ResourceStateTracker(
+    const ResourceStateRegistry* registry)
+    : registry_{registry} {}
+
+void ResourceStateTracker::Reset() {
+  resources_.clear();
+  touched_.clear();
+  barriers_.clear();
+}
+
+void ResourceStateTracker::Transition(const void* resource,
+                                      uint32_t subresource, uint32_t state) {
+  Tracked& tracked = Track(resource, subresource);
+  if (kUnknownState != tracked.split_state) {
+    EndTransition(resource, tracked.split_state);
+  }
+  std::vector<uint32_t>& states = tracked.states;
+
+  if (kAllSubresources != subresource) {
+    uint32_t& current = states[subresource];
+    if (kUnknownState == current) {
+      tracked.initial[subresource] = state;
+    } else if (current == state) {
+      ++dropped_count_;
+    } else {
+      AddTransition(resource, subresource, current, state);
+    }
+    current = state;
+    return;
+  }
+
+  bool uniform = Uniform(states);
+  if (uniform && states[0] == state) {
+    ++dropped_count_;
+    return;
+  }
+  if (uniform && kUnknownState != states[0]) {
+    AddTransition(resource, kAllSubresources, states[0], state);
+  } else {
+    for (uint32_t i = 0; i < states.size(); ++i) {
+      if (kUnknownState == states[i]) {
+        tracked.initial[i] = state;
+      } else if (states[i] != state) {
+        AddTransition(resource, i, states[i], state);
+      }
+    }
+  }
+  std::fill(states.begin(), states.end(), state);
+}
+
+void ResourceStateTracker::BeginTransition(const void* resource,
+                                           uint32_t state) {
+  Tracked& tracked = Track(resource, kAllSubresources);
+  std::vector<uint32_t>& states = tracked.states;
+  if (kUnknownState != tracked.split_state || kUnknownState == states[0] ||
+      states[0] == state || !Uniform(states)) {
+    return;
+  }
+  barriers_.push_back(TrackedBarrier{TrackedBarrier::kTransition, resource,
+                                     nullptr, kAllSubresources, states[0],
+                                     state, TrackedBarrier::kBegin});
+  tracked.split_state = state;
+}
+
+void ResourceStateTracker::EndTransition(const void* resource,
+                                         uint32_t state) {
+  Tracked& tracked = Track(resource, kAllSubresources);
+  if (tracked.split_state != state) {
+    Transition(resource, kAllSubresources, state);
+    return;
+  }
+  tracked.split_state = kUnknownState;
+  barriers_.push_back(TrackedBarrier{TrackedBarrier::kTransition, resource,
+                                     nullptr, kAllSubresources,
+                                     tracked.states[0], state,
+                                     TrackedBarrier::kEnd});
+  std::fill(tracked.states.begin(), tracked.states.end(), state);
+}
+
+void ResourceStateTracker::Assume(const void* resource, uint32_t state) {
+  Tracked& tracked = Track(resource, kAllSubresources);
+  std::fill(tracked.states.begin(), tracked.states.end(), state);
+}
+
+void ResourceStateTracker::UavBarrier(const void* resource) {
+  barriers_.push_back(TrackedBarrier{TrackedBarrier::kUav, resource, nullptr,
+                                     kAllSubresources, 0, 0});
+}
+
+void ResourceStateTracker::AliasingBarrier(const void* before,
+                                           const void* after) {
+  barriers_.push_back(TrackedBarrier{TrackedBarrier::kAliasing, after, before,
+                                     kAllSubresources, 0, 0});
+}
+
+void ResourceStateTracker::TakeBarriers(
+    std::vector<TrackedBarrier>& barriers) {
+  emitted_count_ += barriers_.size();
+  barriers.insert(barriers.end(), barriers_.begin(), barriers_.end());
+  barriers_.clear();
+}
+
+void ResourceStateTracker::Resolve(ResourceStateRegistry& registry,
+                                   std::vector<TrackedBarrier>& barriers) {
+  size_t first_barrier = barriers.size();
+  std::lock_guard<std::mutex> lock{registry.mutex_};
+  for (const void* resource : touched_) {
+    auto it = registry.entries_.find(resource);
+    if (it == registry.entries_.end()) {
+      continue;
+    }
+    ResourceStateRegistry::Entry& entry = it->second;
+    std::vector<uint32_t>& current = entry.states;
+    const Tracked& tracked = resources_[resource];
+    size_t count = std::min(current.size(), tracked.initial.size());
+    bool promoted = false;
+
+    // One barrier for the whole resource when every subresource makes the
+    // same change.
+    bool uniform = count == current.size() &&
+                   count == tracked.initial.size() &&
+                   kUnknownState != tracked.initial[0] &&
+                   Uniform(tracked.initial) && Uniform(current);
+    for (uint32_t i = 0; i < count; ++i) {
+      uint32_t needed = tracked.initial[i];
+      if (kUnknownState == needed || current[i] == needed) {
+        continue;
+      }
+      if (kCommonState == current[i] &&
+          (entry.decays || TexturePromotes(needed))) {
+        promoted = true;
+        entry.promoted[i] = kCopyDestState != needed;
+        current[i] = needed;
+      } else if (!uniform) {
+        barriers.push_back(TrackedBarrier{TrackedBarrier::kTransition,
+                                          resource, nullptr, i, current[i],
+                                          needed});
+      } else if (0 == i) {
+        barriers.push_back(TrackedBarrier{TrackedBarrier::kTransition,
+                                          resource, nullptr, kAllSubresources,
+                                          current[0], needed});
+      }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+      if (kUnknownState != tracked.states[i]) {
+        // Only what stays in the promoted state decays.
+        if (tracked.states[i] != tracked.initial[i]) {
+          entry.promoted[i] = false;
+        }
+        current[i] = tracked.states[i];
+      }
+    }
+    if (promoted || entry.decays) {
+      registry.decaying_.push_back(resource);
+    }
+  }
+  emitted_count_ += barriers.size() - first_barrier;
+}
+
+ResourceStateTracker::Tracked& ResourceStateTracker::Track(
+    const void* resource, uint32_t subresource) {
+  auto it = resources_.find(resource);
+  if (it == resources_.end()) {
+    uint32_t count = registry_ ? registry_->SubresourceCount(resource) : 0;
+    count = std::max(count, 1u);
+    Tracked tracked{};
+    tracked.states.assign(count, kUnknownState);
+    tracked.initial.assign(count, kUnknownState);
+    tracked.split_state = kUnknownState;
+    it = resources_.emplace(resource, std::move(tracked)).first;
+    touched_.push_back(resource);
+  }
+
+  // Unregistered resources grow as higher subresources show up.
+  Tracked& tracked = it->second;
+  if (kAllSubresources != subresource &&
+      subresource >= tracked.states.size()) {
+    tracked.states.resize(subresource + 1, kUnknownState);
+    tracked.initial.resize(subresource + 1, kUnknownState);
+  }
+  return tracked;
+}
+
+void ResourceStateTracker::AddTransition(const void* resource,
+                                         uint32_t subresource, uint32_t before,
+                                         uint32_t after) {
+  // Fold into a pending transition of the same subresource, as long as no
+  // other barrier on the resource sits in between.
+  for (size_t i = barriers_.size(); i > 0; --i) {
+    TrackedBarrier& barrier = barriers_[i - 1];
+    if (barrier.resource != resource) {
+      continue;
+    }
+    if (TrackedBarrier::kTransition != barrier.type ||
+        TrackedBarrier::kFull != barrier.split ||
+        (barrier.subresource != subresource &&
+         (kAllSubresources == barrier.subresource ||
+          kAllSubresources == subresource))) {
+      break;
+    }
+    if (barrier.subresource != subresource) {
+      continue;
+    }
+    ++dropped_count_;
+    if (barrier.before == after) {
+      barriers_.erase(barriers_.begin() + (i - 1));
+      ++dropped_count_;
+    } else {
+      barrier.after = after;
+    }
+    return;
+  }
+  barriers_.push_back(TrackedBarrier{TrackedBarrier::kTransition, resource,
+                                     nullptr, subresource, before, after});
+}
+
+}  // namespace d3dapp
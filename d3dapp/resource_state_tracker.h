@@ -0,0 +1,135 @@
+#pragma once
+
+#ifndef __RESOURCE_STATE_TRACKER_H__
+#define __RESOURCE_STATE_TRACKER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace d3dapp {
+// States are D3D12_RESOURCE_STATES bits and subresources are indexed as by
+// D3D12CalcSubresource; resources are only used as keys, so none of this
+// touches the device.
+constexpr uint32_t kAllSubresources = 0xffffffff;
+constexpr uint32_t kUnknownState = 0xffffffff;
+
+struct TrackedBarrier {
+  enum Type { kTransition, kUav, kAliasing };
+  enum Split { kFull, kBegin, kEnd };
+
+  Type type;
+  const void* resource;
+  // Aliasing barriers only; may be null.
+  const void* resource_before;
+  uint32_t subresource;
+  uint32_t before;
+  uint32_t after;
+  Split split{kFull};
+};
+
+// States of every registered resource as of the last submitted command
+// list. Thread safe.
+//
+// Follows D3D12's implicit state changes: a subresource in the common state
+// is promoted to the state a list first needs it in without a barrier when
+// D3D12 allows it, and Decay returns resources to the common state the way
+// the GPU does at the end of ExecuteCommandLists.
+class ResourceStateRegistry {
+ public:
+  // decays is for buffers and textures allowing simultaneous access, which
+  // are promoted to any state and decay after every ExecuteCommandLists.
+  // Other textures are only promoted to copy and shader resource states,
+  // and only decay from the read-only ones.
+  void Register(const void* resource, uint32_t subresource_count,
+                uint32_t state, bool decays = false);
+  void Unregister(const void* resource);
+
+  uint32_t SubresourceCount(const void* resource) const;
+  uint32_t State(const void* resource, uint32_t subresource) const;
+
+  // Call once the lists resolved since the last call are submitted together.
+  void Decay();
+
+ private:
+  friend class ResourceStateTracker;
+
+  struct Entry {
+    std::vector<uint32_t> states;
+    // Subresources promoted to a read-only state since the last Decay.
+    std::vector<bool> promoted;
+    bool decays;
+  };
+
+  mutable std::mutex mutex_;
+  std::unordered_map<const void*, Entry> entries_;
+  // Resolved since the last Decay, and decaying or promoted.
+  std::vector<const void*> decaying_;
+};
+
+// Per command list view of resource states. Transitions are checked against
+// what the list itself did so far; the first use of a subresource records
+// the state the list needs it in, and Resolve turns that into barriers at
+// submit time, when the state left by earlier lists is known. Recorded
+// barriers accumulate until TakeBarriers so that a pass issues them in one
+// ResourceBarrier call.
+class ResourceStateTracker {
+ public:
+  explicit ResourceStateTracker(const ResourceStateRegistry* registry);
+
+  // Forgets everything; for a list that is about to be recorded again.
+  void Reset();
+
+  void Transition(const void* resource, uint32_t subresource,
+                  uint32_t state);
+  // Split transition of the whole resource, which may not be used between
+  // the two halves. Without a known, uniform state to begin from, only
+  // EndTransition records a barrier, a full one.
+  void BeginTransition(const void* resource, uint32_t state);
+  void EndTransition(const void* resource, uint32_t state);
+  // The caller knows the resource is in state at this point of the list,
+  // e.g. because an earlier list in the same submission left it there.
+  void Assume(const void* resource, uint32_t state);
+  void UavBarrier(const void* resource);
+  void AliasingBarrier(const void* before, const void* after);
+
+  // Moves the barriers recorded since the last call into barriers.
+  void TakeBarriers(std::vector<TrackedBarrier>& barriers);
+
+  // Call for each list in submission order, right before it is submitted.
+  // Appends the barriers that must run before the list and stores the
+  // states the list leaves behind in the registry. Unregistered resources
+  // are assumed to already be in the state they are first used in, and
+  // promoted subresources need no barrier.
+  void Resolve(ResourceStateRegistry& registry,
+               std::vector<TrackedBarrier>& barriers);
+
+  size_t emitted_count() const { return emitted_count_; }
+  size_t dropped_count() const { return dropped_count_; }
+
+ private:
+  struct Tracked {
+    std::vector<uint32_t> states;
+    std::vector<uint32_t> initial;
+    // Target of a begun split transition.
+    uint32_t split_state;
+  };
+
+  Tracked& Track(const void* resource, uint32_t subresource);
+  void AddTransition(const void* resource, uint32_t subresource,
+                     uint32_t before, uint32_t after);
+
+  const ResourceStateRegistry* registry_{nullptr};
+  std::unordered_map<const void*, Tracked> resources_;
+  // Touch order, so that Resolve emits barriers deterministically.
+  std::vector<const void*> touched_;
+  std::vector<TrackedBarrier> barriers_;
+  size_t emitted_count_{0};
+  size_t dropped_count_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__RESOURCE_STATE_TRACKER_H__
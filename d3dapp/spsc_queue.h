@@ -0,0 +1,68 @@
+#pragma once
+
+#ifndef __SPSC_QUEUE_H__
+#define __SPSC_QUEUE_H__
+
+#include <atomic>
+#include <cstddef>
+
+namespace d3dapp {
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity > 0 && 0 == (Capacity & (Capacity - 1)),
+                "Capacity must be a power of two");
+
+ public:
+  SpscQueue() = default;
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer side. Returns false when the queue is full.
+  bool TryPush(const T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == Capacity) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == Capacity) {
+        return false;
+      }
+    }
+    items_[tail & (Capacity - 1)] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when the queue is empty.
+  bool TryPop(T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+    value = items_[head & (Capacity - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  // Producer and consumer state live on separate cache lines, each with a
+  // cached copy of the other side's index to avoid needless sharing.
+  std::atomic<size_t> tail_{0};
+  size_t cached_head_{0};
+  char producer_padding_[kCacheLineSize - sizeof(size_t) * 2];
+
+  std::atomic<size_t> head_{0};
+  size_t cached_tail_{0};
+  char consumer_padding_[kCacheLineSize - sizeof(size_t) * 2];
+
+  T items_[Capacity]{};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__SPSC_QUEUE_H__
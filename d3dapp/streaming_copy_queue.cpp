@@ -0,0 +1,87 @@
+#include "streaming_copy_queue.h"
+
+namespace d3dapp {
+StreamingCopyQueue::StreamingCopyQueue(ID3D12Device* device,
+                                       UINT64 staging_size)
+    : device_{device}, staging_size_{staging_size} {
+  D3D12_COMMAND_QUEUE_DESC queue_desc{D3D12_COMMAND_LIST_TYPE_COPY,
+                                      D3D12_COMMAND_QUEUE_PRIORITY_NORMAL,
+                                      D3D12_COMMAND_QUEUE_FLAG_NONE, 0};
+  device->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(&queue_));
+  device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+
+  CD3DX12_HEAP_PROPERTIES heap_properties{D3D12_HEAP_TYPE_UPLOAD};
+  CD3DX12_RESOURCE_DESC resource_desc =
+      CD3DX12_RESOURCE_DESC::Buffer(staging_size);
+  device->CreateCommittedResource(
+      &heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc,
+      D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+      IID_PPV_ARGS(&staging_buffer_));
+  CD3DX12_RANGE read_range{0, 0};
+  staging_buffer_->Map(0, &read_range,
+                       reinterpret_cast<void**>(&staging_memory_));
+}
+
+StreamingCopyQueue::~StreamingCopyQueue() {
+  // A null event blocks until the fence reaches the value.
+  if (fence_->GetCompletedValue() < fence_value_) {
+    fence_->SetEventOnCompletion(fence_value_, nullptr);
+  }
+}
+
+void StreamingCopyQueue::Begin() {
+  if (!allocators_.empty() &&
+      allocators_.front().fence_value <= fence_->GetCompletedValue()) {
+    recording_ = std::move(allocators_.front().allocator);
+    allocators_.pop_front();
+    recording_->Reset();
+  } else {
+    device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+                                    IID_PPV_ARGS(&recording_));
+  }
+
+  if (!command_list_) {
+    device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY,
+                               recording_.Get(), nullptr,
+                               IID_PPV_ARGS(&command_list_));
+  } else {
+    command_list_->Reset(recording_.Get(), nullptr);
+  }
+}
+
+uint64_t StreamingCopyQueue::Submit() {
+  command_list_->Close();
+  ID3D12CommandList* command_lists[] = {command_list_.Get()};
+  queue_->ExecuteCommandLists(1, command_lists);
+  queue_->Signal(fence_.Get(), ++fence_value_);
+  allocators_.push_back(Allocator{std::move(recording_), fence_value_});
+  return fence_value_;
+}
+
+uint64_t StreamingCopyQueue::GetCompletedValue() {
+  return fence_->GetCompletedValue();
+}
+
+void StreamingCopyQueue::CopyTexture(ID3D12Resource* dest,
+                                     UINT first_subresource,
+                                     const Footprints& footprints,
+                                     UINT64 staging_offset) {
+  for (size_t i = 0; i < footprints.layouts.size(); ++i) {
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = footprints.layouts[i];
+    layout.Offset += staging_offset;
+    CD3DX12_TEXTURE_COPY_LOCATION dest_location{
+        dest, first_subresource + static_cast<UINT>(i)};
+    CD3DX12_TEXTURE_COPY_LOCATION source_location{staging_buffer_.Get(),
+                                                  layout};
+    command_list_->CopyTextureRegion(&dest_location, 0, 0, 0,
+                                     &source_location, nullptr);
+  }
+}
+
+void StreamingCopyQueue::CopyBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                                    UINT64 staging_offset, UINT64 size) {
+  command_list_->CopyBufferRegion(dest, dest_offset, staging_buffer_.Get(),
+                                  staging_offset, size);
+}
+
+}  // namespace d3dapp
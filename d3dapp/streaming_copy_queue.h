@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef __STREAMING_COPY_QUEUE_H__
+#define __STREAMING_COPY_QUEUE_H__
+
+#include <d3dx12.h>
+
+#include <deque>
+
+#include "footprint_cache.h"
+#include "framework.h"
+#include "streaming_pipeline.h"
+
+namespace d3dapp {
+// StreamingPipeline's copy queue on a D3D12 COPY queue, staging in a
+// persistently mapped upload buffer. Queues using the streamed resources
+// wait on fence() for the value the request was delivered with. Resources
+// decay to the common state once the copies complete, so textures can be
+// read without a transition.
+class StreamingCopyQueue : public StreamingPipeline::CopyQueue {
+ public:
+  StreamingCopyQueue(ID3D12Device* device, UINT64 staging_size);
+  StreamingCopyQueue(const StreamingCopyQueue&) = delete;
+  StreamingCopyQueue& operator=(const StreamingCopyQueue&) = delete;
+  // Waits for the submitted copies.
+  ~StreamingCopyQueue() override;
+
+  uint8_t* staging_memory() override { return staging_memory_; }
+  uint64_t staging_size() override { return staging_size_; }
+  void Begin() override;
+  uint64_t Submit() override;
+  uint64_t GetCompletedValue() override;
+
+  // For record callbacks. dest must be in the common state.
+  void CopyTexture(ID3D12Resource* dest, UINT first_subresource,
+                   const Footprints& footprints, UINT64 staging_offset);
+  void CopyBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                  UINT64 staging_offset, UINT64 size);
+
+  ID3D12GraphicsCommandList* command_list() const {
+    return command_list_.Get();
+  }
+  ID3D12Fence* fence() const { return fence_.Get(); }
+
+ private:
+  struct Allocator {
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+    UINT64 fence_value;
+  };
+
+  Microsoft::WRL::ComPtr<ID3D12Device> device_;
+  Microsoft::WRL::ComPtr<ID3D12CommandQueue> queue_;
+  Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> command_list_;
+  Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
+  UINT64 fence_value_{0};
+  Microsoft::WRL::ComPtr<ID3D12Resource> staging_buffer_;
+  uint8_t* staging_memory_{nullptr};
+  UINT64 staging_size_{0};
+
+  // Oldest submission first.
+  std::deque<Allocator> allocators_;
+  Microsoft::WRL::ComPtr<ID3D12CommandAllocator> recording_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__STREAMING_COPY_QUEUE_H__
@@ -0,0 +1,260 @@
+#include "streaming_pipeline.h"
+
+#include <algorithm>
+
+namespace {
+// How often the stream thread polls the copy fence while staging memory
+// waits to be reclaimed.
+constexpr auto kReclaimInterval = std::chrono::milliseconds(1);
+
+uint64_t AlignStaging(uint64_t size) {
+  constexpr uint64_t kAlignment =
+      d3dapp::StreamingPipeline::kStagingAlignment;
+  return (std::max<uint64_t>(size, 1) + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+bool DecodeRequest(const d3dapp::StreamRequest& request, uint8_t* staging) {
+  const uint8_t* source = nullptr;
+  if (request.file) {
+    if (request.offset > request.file->size() ||
+        request.size > request.file->size() - request.offset) {
+      return false;
+    }
+    source = request.file->data() + request.offset;
+  }
+  return !request.decode || request.decode(source, staging);
+}
+
+}  // namespace
+
+namespace d3dapp {
+StreamingPipeline::StreamingPipeline(std::unique_ptr<CopyQueue> copy_queue,
+                                     JobSystem* job_system,
+                                     std::function<void()> on_ready)
+    : copy_queue_{std::move(copy_queue)},
+      job_system_{job_system && job_system->thread_count() > 1 ? job_system
+                                                               : nullptr},
+      on_ready_{std::move(on_ready)} {
+  staging_memory_ = copy_queue_->staging_memory();
+  staging_capacity_ = copy_queue_->staging_size();
+  if (job_system_) {
+    decode_jobs_.reset(
+        new JobSystem::Group{job_system_, JobSystem::kBackground});
+  }
+  stream_thread_ = std::thread{&StreamingPipeline::StreamMain, this};
+}
+
+StreamingPipeline::~StreamingPipeline() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  work_.notify_all();
+  stream_thread_.join();
+  if (decode_jobs_) {
+    decode_jobs_->Wait();
+  }
+}
+
+uint64_t StreamingPipeline::Request(StreamRequest request) {
+  if (AlignStaging(request.staging_size) > staging_capacity_) {
+    return 0;
+  }
+  std::unique_ptr<Job> job{
+      new Job{std::move(request), Clock::now(), nullptr, false}};
+  uint64_t id;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    id = next_id_++;
+    queued_.emplace(
+        std::make_pair(-static_cast<int64_t>(job->request.priority), id),
+        std::move(job));
+  }
+  work_.notify_one();
+  return id;
+}
+
+uint64_t StreamingPipeline::DeliverReady() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    delivering_.swap(ready_);
+  }
+  uint64_t fence_value = 0;
+  for (Ready& ready : delivering_) {
+    if (ready.callback) {
+      ready.callback(ready.loaded, ready.fence_value);
+    }
+    fence_value = std::max(fence_value, ready.fence_value);
+  }
+  delivering_.clear();
+  return fence_value;
+}
+
+StreamingStats StreamingPipeline::stats() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  StreamingStats stats = stats_;
+  stats.queued_count = queued_.size();
+  stats.in_flight_count = in_flight_.size();
+  stats.staging_used = staging_used_;
+  return stats;
+}
+
+bool StreamingPipeline::AllocateStaging(uint64_t size,
+                                        StagingBlock** block) {
+  if (0 == staging_used_) {
+    staging_begin_ = staging_end_ = 0;
+  }
+  uint64_t offset = staging_end_;
+  uint64_t skipped = 0;
+  // Free space is [end, capacity) and [0, begin) unless the live blocks
+  // wrap around, leaving only [end, begin).
+  bool wrapped = staging_end_ < staging_begin_ ||
+                 (staging_end_ == staging_begin_ && staging_used_ > 0);
+  if (!wrapped) {
+    if (staging_capacity_ - staging_end_ < size) {
+      if (staging_begin_ < size) {
+        return false;
+      }
+      skipped = staging_capacity_ - staging_end_;
+      offset = 0;
+    }
+  } else if (staging_begin_ - staging_end_ < size) {
+    return false;
+  }
+
+  staging_end_ = offset + size;
+  staging_used_ += skipped + size;
+  staging_blocks_.push_back(
+      StagingBlock{offset, staging_end_, skipped + size, false});
+  *block = &staging_blocks_.back();
+  stats_.staging_peak = std::max(stats_.staging_peak, staging_used_);
+  return true;
+}
+
+void StreamingPipeline::Reclaim(uint64_t completed_value) {
+  while (!submitted_.empty() && submitted_.front().first <= completed_value) {
+    submitted_.front().second->done = true;
+    submitted_.pop_front();
+  }
+  while (!staging_blocks_.empty() && staging_blocks_.front().done) {
+    staging_begin_ = staging_blocks_.front().end;
+    staging_used_ -= staging_blocks_.front().size;
+    staging_blocks_.pop_front();
+  }
+}
+
+void StreamingPipeline::Admit(std::vector<Job*>& admitted) {
+  // Strictly by priority: a request that does not fit holds back the ones
+  // behind it.
+  while (!queued_.empty()) {
+    auto it = queued_.begin();
+    Job* job = it->second.get();
+    if (!AllocateStaging(AlignStaging(job->request.staging_size),
+                         &job->staging)) {
+      return;
+    }
+    in_flight_.push_back(std::move(it->second));
+    queued_.erase(it);
+    admitted.push_back(job);
+  }
+}
+
+void StreamingPipeline::Decode(Job* job) {
+  job->decoded =
+      DecodeRequest(job->request, staging_memory_ + job->staging->offset);
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    decoded_.push_back(job);
+  }
+  work_.notify_one();
+}
+
+void StreamingPipeline::StreamMain() {
+  std::vector<Job*> admitted;
+  std::vector<Job*> decoded;
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (!stop_) {
+    Reclaim(copy_queue_->GetCompletedValue());
+    Admit(admitted);
+    decoded.swap(decoded_);
+    if (admitted.empty() && decoded.empty()) {
+      if (submitted_.empty()) {
+        work_.wait(lock);
+      } else {
+        work_.wait_for(lock, kReclaimInterval);
+      }
+      continue;
+    }
+    lock.unlock();
+
+    for (Job* job : admitted) {
+      const StreamRequest& request = job->request;
+      if (request.file) {
+        request.file->Prefetch(request.offset, request.size);
+      }
+    }
+    for (Job* job : admitted) {
+      if (decode_jobs_) {
+        decode_jobs_->Run([this, job]() { Decode(job); });
+      } else {
+        job->decoded = DecodeRequest(job->request,
+                                     staging_memory_ + job->staging->offset);
+        decoded.push_back(job);
+      }
+    }
+    admitted.clear();
+
+    // Everything decoded so far goes out in one batch.
+    bool open = false;
+    for (Job* job : decoded) {
+      if (job->decoded && job->request.record) {
+        if (!open) {
+          copy_queue_->Begin();
+          open = true;
+        }
+        job->request.record(job->staging->offset);
+      }
+    }
+    uint64_t fence_value = open ? copy_queue_->Submit() : 0;
+
+    lock.lock();
+    const bool signal = ready_.empty() && !decoded.empty();
+    Clock::time_point now = Clock::now();
+    for (Job* job : decoded) {
+      if (job->decoded) {
+        if (open) {
+          submitted_.emplace_back(fence_value, job->staging);
+        } else {
+          job->staging->done = true;
+        }
+        double latency_ms =
+            std::chrono::duration<double, std::milli>(now - job->requested)
+                .count();
+        ++stats_.submitted_count;
+        stats_.total_latency_ms += latency_ms;
+        stats_.max_latency_ms = std::max(stats_.max_latency_ms, latency_ms);
+      } else {
+        job->staging->done = true;
+        ++stats_.failed_count;
+      }
+      ready_.push_back(Ready{std::move(job->request.ready), job->decoded,
+                             job->decoded ? fence_value : 0});
+      auto it = std::find_if(
+          in_flight_.begin(), in_flight_.end(),
+          [job](const std::unique_ptr<Job>& other) {
+            return other.get() == job;
+          });
+      std::swap(*it, in_flight_.back());
+      in_flight_.pop_back();
+    }
+    decoded.clear();
+
+    if (signal && on_ready_) {
+      lock.unlock();
+      on_ready_();
+      lock.lock();
+    }
+  }
+}
+
+}  // namespace d3dapp
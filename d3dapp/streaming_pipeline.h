@@ -0,0 +1,178 @@
+#pragma once
+
+#ifndef __STREAMING_PIPELINE_H__
+#define __STREAMING_PIPELINE_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "job_system.h"
+#include "mapped_file.h"
+
+namespace d3dapp {
+struct StreamRequest {
+  // Higher first; equal priorities go in request order.
+  int priority{0};
+  // Source bytes, prefetched when the request is admitted. The file must
+  // stay open until ready is called.
+  const MappedFile* file{nullptr};
+  uint64_t offset{0};
+  uint64_t size{0};
+  // Staging memory decode fills. Requests wait until this much is free.
+  uint64_t staging_size{0};
+
+  // Worker thread: fills staging_size bytes of staging from the source
+  // bytes. Returning false drops the request.
+  std::function<bool(const uint8_t* source, uint8_t* staging)> decode;
+  // Stream thread: records the copies out of the staging memory at
+  // staging_offset into the copy queue's open list.
+  std::function<void(uint64_t staging_offset)> record;
+  // DeliverReady's thread: the copies are submitted and complete at
+  // fence_value on the copy queue's fence, 0 if nothing was recorded.
+  // loaded is false if decode failed.
+  std::function<void(bool loaded, uint64_t fence_value)> ready;
+};
+
+struct StreamingStats {
+  // Waiting for staging memory.
+  size_t queued_count{0};
+  // Admitted and not yet submitted.
+  size_t in_flight_count{0};
+  uint64_t staging_used{0};
+  uint64_t staging_peak{0};
+  size_t submitted_count{0};
+  size_t failed_count{0};
+  // From Request to submission on the copy queue.
+  double total_latency_ms{0.0};
+  double max_latency_ms{0.0};
+
+  double average_latency_ms() const {
+    return submitted_count > 0 ? total_latency_ms / submitted_count : 0.0;
+  }
+};
+
+// Streams data from mapped files to the GPU off the render thread, in
+// stages: admitted requests are prefetched, decoded straight into staging
+// memory on job_system and recorded on a copy queue by the stream thread
+// as soon as they are decoded. Staging memory is a ring, so the memory
+// in flight never exceeds its size; it is reclaimed in admission order as
+// the copy queue's fence passes. Decode jobs are background jobs, so
+// waits on the frame's job groups never run one.
+class StreamingPipeline {
+ public:
+  // Where decoded data is staged and copied from. Only the stream thread
+  // calls Begin, Submit and GetCompletedValue.
+  class CopyQueue {
+   public:
+    virtual ~CopyQueue() {}
+    virtual uint8_t* staging_memory() = 0;
+    virtual uint64_t staging_size() = 0;
+    // Opens a list for the next batch of records.
+    virtual void Begin() = 0;
+    // Submits the batch, returning the fence value it completes at.
+    virtual uint64_t Submit() = 0;
+    virtual uint64_t GetCompletedValue() = 0;
+  };
+
+  // Staging offsets are aligned for texture placement.
+  static constexpr uint64_t kStagingAlignment = 512;
+
+  // Without a job_system, or one without workers, decode runs on the
+  // stream thread. on_ready is called on the stream thread when requests
+  // become ready while none were waiting for DeliverReady, e.g. to render
+  // a frame that delivers them.
+  StreamingPipeline(std::unique_ptr<CopyQueue> copy_queue,
+                    JobSystem* job_system,
+                    std::function<void()> on_ready = nullptr);
+  StreamingPipeline(const StreamingPipeline&) = delete;
+  StreamingPipeline& operator=(const StreamingPipeline&) = delete;
+  // Requests not yet delivered are dropped.
+  ~StreamingPipeline();
+
+  // Returns an id, or 0 if the request needs more staging memory than
+  // there is.
+  uint64_t Request(StreamRequest request);
+
+  // Calls ready for every request submitted since the last call, from one
+  // thread at a time. Returns the highest fence value among them, which
+  // the queues using the data must wait for, or 0.
+  uint64_t DeliverReady();
+
+  CopyQueue* copy_queue() const { return copy_queue_.get(); }
+  StreamingStats stats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct StagingBlock {
+    uint64_t offset;
+    uint64_t end;
+    // Includes space skipped at the end of the ring.
+    uint64_t size;
+    bool done;
+  };
+
+  struct Job {
+    StreamRequest request;
+    Clock::time_point requested;
+    StagingBlock* staging;
+    bool decoded;
+  };
+
+  struct Ready {
+    std::function<void(bool, uint64_t)> callback;
+    bool loaded;
+    uint64_t fence_value;
+  };
+
+  // Called with mutex_ held.
+  bool AllocateStaging(uint64_t size, StagingBlock** block);
+  void Reclaim(uint64_t completed_value);
+  void Admit(std::vector<Job*>& admitted);
+
+  void Decode(Job* job);
+  void StreamMain();
+
+  std::unique_ptr<CopyQueue> copy_queue_;
+  JobSystem* job_system_{nullptr};
+  std::function<void()> on_ready_;
+  uint8_t* staging_memory_{nullptr};
+  uint64_t staging_capacity_{0};
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_;
+  bool stop_{false};
+  uint64_t next_id_{1};
+  // Keyed by negated priority, then id.
+  std::map<std::pair<int64_t, uint64_t>, std::unique_ptr<Job>> queued_;
+  std::vector<std::unique_ptr<Job>> in_flight_;
+  std::vector<Job*> decoded_;
+  std::vector<Ready> ready_;
+  std::vector<Ready> delivering_;
+
+  // Ring of staging memory in admission order.
+  std::deque<StagingBlock> staging_blocks_;
+  uint64_t staging_begin_{0};
+  uint64_t staging_end_{0};
+  uint64_t staging_used_{0};
+  // Staging blocks of submitted batches by fence value.
+  std::deque<std::pair<uint64_t, StagingBlock*>> submitted_;
+
+  StreamingStats stats_;
+
+  std::thread stream_thread_;
+  std::unique_ptr<JobSystem::Group> decode_jobs_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__STREAMING_PIPELINE_H__
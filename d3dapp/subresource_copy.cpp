@@ -0,0 +1,181 @@
+#include "subresource_copy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define D3DAPP_STREAM_STORES 1
+#endif
+
+#include "cpu_features.h"
+#include "job_system.h"
+
+namespace {
+// Below this, the alignment prologue costs more than streaming saves.
+constexpr size_t kMinStreamSize = 256;
+// Copies smaller than this are not worth waking workers for.
+constexpr size_t kMinParallelSize = 1024 * 1024;
+constexpr size_t kBandSize = 256 * 1024;
+
+#if D3DAPP_STREAM_STORES
+// 128 byte blocks to a 32 byte aligned dest, for CPUs with AVX2.
+D3DAPP_TARGET("avx2")
+void StreamBlocksAvx2(uint8_t* dest, const uint8_t* source,
+                      size_t block_count) {
+  for (; block_count > 0; --block_count, dest += 128, source += 128) {
+    const __m256i* from = reinterpret_cast<const __m256i*>(source);
+    __m256i* to = reinterpret_cast<__m256i*>(dest);
+    __m256i a = _mm256_loadu_si256(from);
+    __m256i b = _mm256_loadu_si256(from + 1);
+    __m256i c = _mm256_loadu_si256(from + 2);
+    __m256i d = _mm256_loadu_si256(from + 3);
+    _mm256_stream_si256(to, a);
+    _mm256_stream_si256(to + 1, b);
+    _mm256_stream_si256(to + 2, c);
+    _mm256_stream_si256(to + 3, d);
+  }
+}
+#endif
+
+// Leaves the stores unfenced; callers fence once they are done.
+void Stream(uint8_t* dest, const uint8_t* source, size_t size) {
+#if D3DAPP_STREAM_STORES
+  if (size >= kMinStreamSize) {
+    const bool avx2 = d3dapp::GetCpuFeatures().avx2;
+    const size_t alignment = avx2 ? 32 : 16;
+    size_t head = (alignment - (reinterpret_cast<uintptr_t>(dest) &
+                                (alignment - 1))) &
+                  (alignment - 1);
+    memcpy(dest, source, head);
+    dest += head;
+    source += head;
+    size -= head;
+
+    if (avx2) {
+      size_t block_count = size / 128;
+      StreamBlocksAvx2(dest, source, block_count);
+      dest += block_count * 128;
+      source += block_count * 128;
+      size -= block_count * 128;
+    }
+    for (; size >= 64; size -= 64, dest += 64, source += 64) {
+      const __m128i* from = reinterpret_cast<const __m128i*>(source);
+      __m128i* to = reinterpret_cast<__m128i*>(dest);
+      __m128i a = _mm_loadu_si128(from);
+      __m128i b = _mm_loadu_si128(from + 1);
+      __m128i c = _mm_loadu_si128(from + 2);
+      __m128i d = _mm_loadu_si128(from + 3);
+      _mm_stream_si128(to, a);
+      _mm_stream_si128(to + 1, b);
+      _mm_stream_si128(to + 2, c);
+      _mm_stream_si128(to + 3, d);
+    }
+    for (; size >= 16; size -= 16, dest += 16, source += 16) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dest), a);
+    }
+  }
+#endif
+  memcpy(dest, source, size);
+}
+
+void Fence() {
+#if D3DAPP_STREAM_STORES
+  _mm_sfence();
+#endif
+}
+
+// Rows [first, last) counted across slices. copy_run(dest, source, size)
+// copies size bytes of destination rows from source_row_size byte source
+// rows.
+template <typename CopyRun>
+void CopyRows(const d3dapp::SubresourceCopy& copy, size_t source_row_size,
+              size_t first, size_t last, CopyRun copy_run) {
+  uint8_t* dest = static_cast<uint8_t*>(copy.dest);
+  const uint8_t* source = static_cast<const uint8_t*>(copy.source);
+  bool packed_rows = copy.dest_row_pitch == copy.row_size &&
+                     copy.source_row_pitch == source_row_size;
+  if (packed_rows &&
+      copy.dest_slice_pitch == copy.row_size * copy.row_count &&
+      copy.source_slice_pitch == source_row_size * copy.row_count) {
+    copy_run(dest + first * copy.row_size, source + first * source_row_size,
+             (last - first) * copy.row_size);
+    return;
+  }
+
+  while (first < last) {
+    size_t slice = first / copy.row_count;
+    size_t row = first % copy.row_count;
+    size_t run = std::min(last - first, copy.row_count - row);
+    uint8_t* dest_row =
+        dest + copy.dest_slice_pitch * slice + copy.dest_row_pitch * row;
+    const uint8_t* source_row = source + copy.source_slice_pitch * slice +
+                                copy.source_row_pitch * row;
+    if (packed_rows) {
+      copy_run(dest_row, source_row, run * copy.row_size);
+    } else {
+      for (size_t i = 0; i < run; ++i) {
+        copy_run(dest_row + copy.dest_row_pitch * i,
+                 source_row + copy.source_row_pitch * i, copy.row_size);
+      }
+    }
+    first += run;
+  }
+}
+
+template <typename CopyRun>
+void CopyBands(const d3dapp::SubresourceCopy& copy, size_t source_row_size,
+               d3dapp::JobSystem* job_system, CopyRun copy_run) {
+  size_t row_count = static_cast<size_t>(copy.row_count) * copy.slice_count;
+  if (0 == row_count || 0 == copy.row_size) {
+    return;
+  }
+
+  if (!job_system || job_system->thread_count() < 2 ||
+      copy.row_size * row_count < kMinParallelSize) {
+    CopyRows(copy, source_row_size, 0, row_count, copy_run);
+    Fence();
+    return;
+  }
+
+  size_t band_rows = std::max<size_t>(kBandSize / copy.row_size, 1);
+  job_system->ParallelFor(
+      0, row_count, band_rows, [&](size_t first, size_t last) {
+        CopyRows(copy, source_row_size, first, last, copy_run);
+        Fence();
+      });
+}
+
+}  // namespace
+
+namespace d3dapp {
+void StreamCopy(void* dest, const void* source, size_t size) {
+  Stream(static_cast<uint8_t*>(dest), static_cast<const uint8_t*>(source),
+         size);
+  Fence();
+}
+
+void CopySubresource(const SubresourceCopy& copy, JobSystem* job_system) {
+  CopyBands(copy, copy.row_size, job_system,
+            [](uint8_t* dest, const uint8_t* source, size_t size) {
+              Stream(dest, source, size);
+            });
+}
+
+void ConvertSubresource(const SubresourceCopy& copy,
+                        const TexelConversion& conversion,
+                        JobSystem* job_system) {
+  size_t dest_texel_size = DestTexelSize(conversion.type);
+  size_t source_row_size =
+      copy.row_size / dest_texel_size * SourceTexelSize(conversion.type);
+  CopyBands(copy, source_row_size, job_system,
+            [&conversion, dest_texel_size](uint8_t* dest,
+                                           const uint8_t* source,
+                                           size_t size) {
+              ConvertTexels(conversion, dest, source,
+                            size / dest_texel_size);
+            });
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef __SUBRESOURCE_COPY_H__
+#define __SUBRESOURCE_COPY_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "texel_conversion.h"
+
+namespace d3dapp {
+class JobSystem;
+
+// Rows of one or more slices, as MemcpySubresource copies them.
+// row_size is the size of a destination row.
+struct SubresourceCopy {
+  void* dest;
+  size_t dest_row_pitch;
+  size_t dest_slice_pitch;
+  const void* source;
+  size_t source_row_pitch;
+  size_t source_slice_pitch;
+  size_t row_size;
+  uint32_t row_count;
+  uint32_t slice_count;
+};
+
+// memcpy for write-combined destinations such as upload heaps: large copies
+// use non-temporal stores, so partially written lines are never flushed and
+// the cache is left alone. The stores are 32 bytes wide on CPUs with AVX2.
+void StreamCopy(void* dest, const void* source, size_t size);
+
+// Copies runs of rows whose pitches match in one go, and splits large
+// copies into row bands run on job_system when one is given.
+void CopySubresource(const SubresourceCopy& copy,
+                     JobSystem* job_system = nullptr);
+
+// CopySubresource converting texels on the way. Each source row holds the
+// row's texels in the conversion's source format.
+void ConvertSubresource(const SubresourceCopy& copy,
+                        const TexelConversion& conversion,
+                        JobSystem* job_system = nullptr);
+
+}  // namespace d3dapp
+
+#endif  // !__SUBRESOURCE_COPY_H__
@@ -0,0 +1,461 @@
+#include "texel_conversion.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define D3DAPP_SSE2 1
+#endif
+
+#include "cpu_features.h"
+
+namespace {
+constexpr uint32_t kFloatInfinity = 0x7f800000;
+// 65536.0f, the first value that can not round to a finite half.
+constexpr uint32_t kHalfOverflow = (127 + 16) << 23;
+// 2^-14, the smallest normal half.
+constexpr uint32_t kHalfNormalMin = (127 - 14) << 23;
+// 0.5f; adding it to a denormal half value leaves the half's bits, rounded
+// to nearest even, at the bottom of the mantissa.
+constexpr uint32_t kDenormalMagic = (127 - 1) << 23;
+constexpr uint32_t kExponentRebias = (127 - 15) << 23;
+
+constexpr float kUnormScale = 1.0f / 65535.0f;
+
+constexpr float kSrgbLinearCutoff = 0.0031308f;
+constexpr float kSrgbLinearSlope = 12.92f;
+// x^(1/2.4) * 1.055 - 0.055 fitted to x^(1/2), x^(1/4) and x^(1/8); within
+// one step of the exact 8-bit result.
+constexpr float kSrgbWeight1 = 0.662002687f;
+constexpr float kSrgbWeight2 = 0.684122060f;
+constexpr float kSrgbWeight3 = -0.323583601f;
+constexpr float kSrgbWeight4 = -0.0225411470f;
+
+uint16_t FloatToHalf(float value) {
+  uint32_t f;
+  memcpy(&f, &value, sizeof(f));
+  uint32_t sign = f & 0x80000000;
+  f ^= sign;
+
+  uint32_t half;
+  if (f >= kHalfOverflow) {
+    half = f > kFloatInfinity ? 0x7e00 : 0x7c00;
+  } else if (f < kHalfNormalMin) {
+    float magic;
+    memcpy(&magic, &kDenormalMagic, sizeof(magic));
+    float denormal;
+    memcpy(&denormal, &f, sizeof(denormal));
+    denormal += magic;
+    memcpy(&half, &denormal, sizeof(half));
+    half -= kDenormalMagic;
+  } else {
+    uint32_t odd = (f >> 13) & 1;
+    f -= kExponentRebias;
+    half = (f + 0xfff + odd) >> 13;
+  }
+  return static_cast<uint16_t>(half | sign >> 16);
+}
+
+uint8_t LinearToSrgb(float linear) {
+  float x = linear > 0.0f ? linear : 0.0f;
+  x = x < 1.0f ? x : 1.0f;
+  float srgb;
+  if (x <= kSrgbLinearCutoff) {
+    srgb = kSrgbLinearSlope * x;
+  } else {
+    float s1 = std::sqrt(x);
+    float s2 = std::sqrt(s1);
+    float s3 = std::sqrt(s2);
+    srgb = kSrgbWeight1 * s1 + kSrgbWeight2 * s2 + kSrgbWeight3 * s3 +
+           kSrgbWeight4 * x;
+  }
+  return static_cast<uint8_t>(srgb * 255.0f + 0.5f);
+}
+
+#if D3DAPP_SSE2
+__m128i Select(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// FloatToHalf on four lanes. The halves are sign extended to 32 bits so
+// that _mm_packs_epi32 keeps them intact.
+__m128i FloatToHalf(__m128 value) {
+  __m128i f = _mm_castps_si128(value);
+  __m128i sign = _mm_and_si128(f, _mm_set1_epi32(0x80000000));
+  f = _mm_xor_si128(f, sign);
+
+  __m128i nan = _mm_cmpgt_epi32(f, _mm_set1_epi32(kFloatInfinity));
+  __m128i overflow_half = _mm_or_si128(
+      _mm_set1_epi32(0x7c00), _mm_and_si128(nan, _mm_set1_epi32(0x0200)));
+  __m128i overflow = _mm_cmpgt_epi32(f, _mm_set1_epi32(kHalfOverflow - 1));
+
+  __m128i magic = _mm_set1_epi32(kDenormalMagic);
+  __m128i denormal_half = _mm_sub_epi32(
+      _mm_castps_si128(
+          _mm_add_ps(_mm_castsi128_ps(f), _mm_castsi128_ps(magic))),
+      magic);
+  __m128i denormal = _mm_cmplt_epi32(f, _mm_set1_epi32(kHalfNormalMin));
+
+  __m128i odd = _mm_and_si128(_mm_srli_epi32(f, 13), _mm_set1_epi32(1));
+  __m128i normal_half = _mm_srli_epi32(
+      _mm_add_epi32(
+          _mm_add_epi32(f, _mm_set1_epi32(0xfff - kExponentRebias)), odd),
+      13);
+
+  __m128i half = Select(overflow, overflow_half,
+                        Select(denormal, denormal_half, normal_half));
+  return _mm_or_si128(half, _mm_srai_epi32(sign, 16));
+}
+
+__m128 LinearToSrgb(__m128 linear) {
+  __m128 x = _mm_min_ps(_mm_max_ps(linear, _mm_setzero_ps()),
+                        _mm_set1_ps(1.0f));
+  __m128 s1 = _mm_sqrt_ps(x);
+  __m128 s2 = _mm_sqrt_ps(s1);
+  __m128 s3 = _mm_sqrt_ps(s2);
+  __m128 curve = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kSrgbWeight1), s1),
+                 _mm_mul_ps(_mm_set1_ps(kSrgbWeight2), s2)),
+      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kSrgbWeight3), s3),
+                 _mm_mul_ps(_mm_set1_ps(kSrgbWeight4), x)));
+  __m128 line = _mm_mul_ps(_mm_set1_ps(kSrgbLinearSlope), x);
+  __m128 is_line = _mm_cmple_ps(x, _mm_set1_ps(kSrgbLinearCutoff));
+  __m128 srgb =
+      _mm_or_ps(_mm_and_ps(is_line, line), _mm_andnot_ps(is_line, curve));
+  // Alpha is not encoded.
+  __m128 alpha = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+  srgb = _mm_or_ps(_mm_and_ps(alpha, x), _mm_andnot_ps(alpha, srgb));
+  return _mm_add_ps(_mm_mul_ps(srgb, _mm_set1_ps(255.0f)),
+                    _mm_set1_ps(0.5f));
+}
+
+D3DAPP_TARGET("avx2")
+__m256 LinearToSrgb(__m256 linear) {
+  __m256 x = _mm256_min_ps(_mm256_max_ps(linear, _mm256_setzero_ps()),
+                           _mm256_set1_ps(1.0f));
+  __m256 s1 = _mm256_sqrt_ps(x);
+  __m256 s2 = _mm256_sqrt_ps(s1);
+  __m256 s3 = _mm256_sqrt_ps(s2);
+  __m256 curve = _mm256_add_ps(
+      _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kSrgbWeight1), s1),
+                    _mm256_mul_ps(_mm256_set1_ps(kSrgbWeight2), s2)),
+      _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kSrgbWeight3), s3),
+                    _mm256_mul_ps(_mm256_set1_ps(kSrgbWeight4), x)));
+  __m256 line = _mm256_mul_ps(_mm256_set1_ps(kSrgbLinearSlope), x);
+  __m256 is_line =
+      _mm256_cmp_ps(x, _mm256_set1_ps(kSrgbLinearCutoff), _CMP_LE_OQ);
+  __m256 srgb = _mm256_blendv_ps(curve, line, is_line);
+  srgb = _mm256_blend_ps(srgb, x, 0x88);
+  return _mm256_add_ps(_mm256_mul_ps(srgb, _mm256_set1_ps(255.0f)),
+                       _mm256_set1_ps(0.5f));
+}
+
+// The SIMD loops below start at texel i and return where they stopped; the
+// scalar loops finish the rest.
+
+D3DAPP_TARGET("avx2")
+size_t Rgb8ToRgba8Avx2(uint8_t* dest, const uint8_t* source, size_t count,
+                       size_t i) {
+  const __m256i expand = _mm256_setr_epi8(
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4,
+      5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha = _mm256_set1_epi32(0xff000000);
+  // Loads 32 bytes for 24, so stop while that stays inside source.
+  const __m256i split = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+  for (; i + 11 <= count; i += 8) {
+    __m256i rgb = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(source + i * 3));
+    rgb = _mm256_permutevar8x32_epi32(rgb, split);
+    __m256i rgba = _mm256_or_si256(_mm256_shuffle_epi8(rgb, expand), alpha);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 4), rgba);
+  }
+  return i;
+}
+
+D3DAPP_TARGET("ssse3")
+size_t Rgb8ToRgba8Ssse3(uint8_t* dest, const uint8_t* source, size_t count,
+                        size_t i) {
+  const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1,
+                                       9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32(0xff000000);
+  for (; i + 6 <= count; i += 4) {
+    __m128i rgb =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+    __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, expand), alpha);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), rgba);
+  }
+  return i;
+}
+
+D3DAPP_TARGET("avx,f16c")
+size_t R32FloatToR16FloatF16c(uint16_t* dest, const float* source,
+                              size_t count, size_t i) {
+  for (; i + 8 <= count; i += 8) {
+    __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(source + i),
+                                   _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), half);
+  }
+  return i;
+}
+
+size_t R32FloatToR16FloatSse2(uint16_t* dest, const float* source,
+                              size_t count, size_t i) {
+  for (; i + 8 <= count; i += 8) {
+    __m128i low = FloatToHalf(_mm_loadu_ps(source + i));
+    __m128i high = FloatToHalf(_mm_loadu_ps(source + i + 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_packs_epi32(low, high));
+  }
+  return i;
+}
+
+D3DAPP_TARGET("avx2")
+size_t R16UnormToR32FloatAvx2(float* dest, const uint16_t* source,
+                              size_t count, size_t i) {
+  const __m256 scale = _mm256_set1_ps(kUnormScale);
+  for (; i + 8 <= count; i += 8) {
+    __m256i value = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+    _mm256_storeu_ps(dest + i,
+                     _mm256_mul_ps(_mm256_cvtepi32_ps(value), scale));
+  }
+  return i;
+}
+
+size_t R16UnormToR32FloatSse2(float* dest, const uint16_t* source,
+                              size_t count, size_t i) {
+  const __m128 scale = _mm_set1_ps(kUnormScale);
+  for (; i + 8 <= count; i += 8) {
+    __m128i value =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+    __m128i low = _mm_unpacklo_epi16(value, _mm_setzero_si128());
+    __m128i high = _mm_unpackhi_epi16(value, _mm_setzero_si128());
+    _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+    _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+  }
+  return i;
+}
+
+D3DAPP_TARGET("avx2")
+size_t Rgba32FloatToRgba8SrgbAvx2(uint8_t* dest, const float* source,
+                                  size_t count, size_t i) {
+  // Packing works within 128-bit lanes; the permute restores texel order.
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  for (; i + 8 <= count; i += 8) {
+    const float* texels = source + i * 4;
+    __m256i a = _mm256_cvttps_epi32(LinearToSrgb(_mm256_loadu_ps(texels)));
+    __m256i b =
+        _mm256_cvttps_epi32(LinearToSrgb(_mm256_loadu_ps(texels + 8)));
+    __m256i c =
+        _mm256_cvttps_epi32(LinearToSrgb(_mm256_loadu_ps(texels + 16)));
+    __m256i d =
+        _mm256_cvttps_epi32(LinearToSrgb(_mm256_loadu_ps(texels + 24)));
+    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b),
+                                         _mm256_packs_epi32(c, d));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 4),
+                        _mm256_permutevar8x32_epi32(packed, order));
+  }
+  return i;
+}
+
+size_t Rgba32FloatToRgba8SrgbSse2(uint8_t* dest, const float* source,
+                                  size_t count, size_t i) {
+  for (; i + 4 <= count; i += 4) {
+    const float* texels = source + i * 4;
+    __m128i a = _mm_cvttps_epi32(LinearToSrgb(_mm_loadu_ps(texels)));
+    __m128i b = _mm_cvttps_epi32(LinearToSrgb(_mm_loadu_ps(texels + 4)));
+    __m128i c = _mm_cvttps_epi32(LinearToSrgb(_mm_loadu_ps(texels + 8)));
+    __m128i d = _mm_cvttps_epi32(LinearToSrgb(_mm_loadu_ps(texels + 12)));
+    __m128i packed =
+        _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), packed);
+  }
+  return i;
+}
+
+// shuffle holds the byte each byte of four texels comes from.
+D3DAPP_TARGET("avx2")
+size_t SwizzleRgba8Avx2(uint8_t* dest, const uint8_t* source, size_t count,
+                        const int8_t* shuffle, size_t i) {
+  const __m256i mask = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle)));
+  for (; i + 8 <= count; i += 8) {
+    __m256i rgba = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(source + i * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 4),
+                        _mm256_shuffle_epi8(rgba, mask));
+  }
+  return i;
+}
+
+D3DAPP_TARGET("ssse3")
+size_t SwizzleRgba8Ssse3(uint8_t* dest, const uint8_t* source, size_t count,
+                         const int8_t* shuffle, size_t i) {
+  const __m128i mask =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle));
+  for (; i + 4 <= count; i += 4) {
+    __m128i rgba =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4),
+                     _mm_shuffle_epi8(rgba, mask));
+  }
+  return i;
+}
+#endif
+
+void Rgb8ToRgba8(uint8_t* dest, const uint8_t* source, size_t count) {
+  size_t i = 0;
+#if D3DAPP_SSE2
+  const d3dapp::CpuFeatures& cpu = d3dapp::GetCpuFeatures();
+  if (cpu.avx2) {
+    i = Rgb8ToRgba8Avx2(dest, source, count, i);
+  }
+  if (cpu.ssse3) {
+    i = Rgb8ToRgba8Ssse3(dest, source, count, i);
+  }
+#endif
+  for (; i < count; ++i) {
+    dest[i * 4] = source[i * 3];
+    dest[i * 4 + 1] = source[i * 3 + 1];
+    dest[i * 4 + 2] = source[i * 3 + 2];
+    dest[i * 4 + 3] = 0xff;
+  }
+}
+
+void R32FloatToR16Float(uint16_t* dest, const float* source, size_t count) {
+  size_t i = 0;
+#if D3DAPP_SSE2
+  if (d3dapp::GetCpuFeatures().f16c) {
+    i = R32FloatToR16FloatF16c(dest, source, count, i);
+  }
+  i = R32FloatToR16FloatSse2(dest, source, count, i);
+#endif
+  for (; i < count; ++i) {
+    dest[i] = FloatToHalf(source[i]);
+  }
+}
+
+void R16UnormToR32Float(float* dest, const uint16_t* source, size_t count) {
+  size_t i = 0;
+#if D3DAPP_SSE2
+  if (d3dapp::GetCpuFeatures().avx2) {
+    i = R16UnormToR32FloatAvx2(dest, source, count, i);
+  }
+  i = R16UnormToR32FloatSse2(dest, source, count, i);
+#endif
+  for (; i < count; ++i) {
+    dest[i] = source[i] * kUnormScale;
+  }
+}
+
+void Rgba32FloatToRgba8Srgb(uint8_t* dest, const float* source,
+                            size_t count) {
+  size_t i = 0;
+#if D3DAPP_SSE2
+  if (d3dapp::GetCpuFeatures().avx2) {
+    i = Rgba32FloatToRgba8SrgbAvx2(dest, source, count, i);
+  }
+  i = Rgba32FloatToRgba8SrgbSse2(dest, source, count, i);
+#endif
+  for (; i < count; ++i) {
+    const float* texel = source + i * 4;
+    dest[i * 4] = LinearToSrgb(texel[0]);
+    dest[i * 4 + 1] = LinearToSrgb(texel[1]);
+    dest[i * 4 + 2] = LinearToSrgb(texel[2]);
+    float alpha = texel[3] > 0.0f ? texel[3] : 0.0f;
+    alpha = alpha < 1.0f ? alpha : 1.0f;
+    dest[i * 4 + 3] = static_cast<uint8_t>(alpha * 255.0f + 0.5f);
+  }
+}
+
+void SwizzleRgba8(uint8_t* dest, const uint8_t* source, size_t count,
+                  const uint8_t* swizzle) {
+  uint8_t channel[4];
+  for (int c = 0; c < 4; ++c) {
+    channel[c] = swizzle[c] & 3;
+  }
+  size_t i = 0;
+#if D3DAPP_SSE2
+  int8_t shuffle[16];
+  for (int b = 0; b < 16; ++b) {
+    shuffle[b] = static_cast<int8_t>((b & ~3) + channel[b & 3]);
+  }
+  const d3dapp::CpuFeatures& cpu = d3dapp::GetCpuFeatures();
+  if (cpu.avx2) {
+    i = SwizzleRgba8Avx2(dest, source, count, shuffle, i);
+  }
+  if (cpu.ssse3) {
+    i = SwizzleRgba8Ssse3(dest, source, count, shuffle, i);
+  }
+#endif
+  for (; i < count; ++i) {
+    for (int c = 0; c < 4; ++c) {
+      dest[i * 4 + c] = source[i * 4 + channel[c]];
+    }
+  }
+}
+
+}  // namespace
+
+namespace d3dapp {
+size_t SourceTexelSize(TexelConversion::Type type) {
+  switch (type) {
+    case TexelConversion::kRgb8ToRgba8:
+      return 3;
+    case TexelConversion::kR32FloatToR16Float:
+      return 4;
+    case TexelConversion::kR16UnormToR32Float:
+      return 2;
+    case TexelConversion::kRgba32FloatToRgba8Srgb:
+      return 16;
+    case TexelConversion::kSwizzleRgba8:
+      return 4;
+  }
+  return 0;
+}
+
+size_t DestTexelSize(TexelConversion::Type type) {
+  switch (type) {
+    case TexelConversion::kRgb8ToRgba8:
+      return 4;
+    case TexelConversion::kR32FloatToR16Float:
+      return 2;
+    case TexelConversion::kR16UnormToR32Float:
+      return 4;
+    case TexelConversion::kRgba32FloatToRgba8Srgb:
+      return 4;
+    case TexelConversion::kSwizzleRgba8:
+      return 4;
+  }
+  return 0;
+}
+
+void ConvertTexels(const TexelConversion& conversion, void* dest,
+                   const void* source, size_t texel_count) {
+  switch (conversion.type) {
+    case TexelConversion::kRgb8ToRgba8:
+      Rgb8ToRgba8(static_cast<uint8_t*>(dest),
+                  static_cast<const uint8_t*>(source), texel_count);
+      break;
+    case TexelConversion::kR32FloatToR16Float:
+      R32FloatToR16Float(static_cast<uint16_t*>(dest),
+                         static_cast<const float*>(source), texel_count);
+      break;
+    case TexelConversion::kR16UnormToR32Float:
+      R16UnormToR32Float(static_cast<float*>(dest),
+                         static_cast<const uint16_t*>(source), texel_count);
+      break;
+    case TexelConversion::kRgba32FloatToRgba8Srgb:
+      Rgba32FloatToRgba8Srgb(static_cast<uint8_t*>(dest),
+                             static_cast<const float*>(source), texel_count);
+      break;
+    case TexelConversion::kSwizzleRgba8:
+      SwizzleRgba8(static_cast<uint8_t*>(dest),
+                   static_cast<const uint8_t*>(source), texel_count,
+                   conversion.swizzle);
+      break;
+  }
+}
+
+}  // namespace d3dapp
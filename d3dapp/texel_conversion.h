@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef __TEXEL_CONVERSION_H__
+#define __TEXEL_CONVERSION_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace d3dapp {
+// Converts source texels while they are copied into staging memory, so
+// imagery stored in a format the GPU cannot sample is read once.
+struct TexelConversion {
+  enum Type {
+    // Alpha is set to 255.
+    kRgb8ToRgba8,
+    // Rounds to nearest even; out of range values become infinity.
+    kR32FloatToR16Float,
+    kR16UnormToR32Float,
+    // Linear RGBA32F to RGBA8 for *_UNORM_SRGB formats, clamped to [0, 1].
+    // Alpha stays linear.
+    kRgba32FloatToRgba8Srgb,
+    // Reorders RGBA8 channels, e.g. {2, 1, 0, 3} for BGRA.
+    kSwizzleRgba8,
+  };
+
+  Type type;
+  // kSwizzleRgba8 only: the source channel of each destination channel.
+  uint8_t swizzle[4]{0, 1, 2, 3};
+};
+
+size_t SourceTexelSize(TexelConversion::Type type);
+size_t DestTexelSize(TexelConversion::Type type);
+
+// Vectorized with SSE2, and with SSSE3, F16C and AVX2 on CPUs that have
+// them. dest and source need no particular alignment and must not overlap.
+void ConvertTexels(const TexelConversion& conversion, void* dest,
+                   const void* source, size_t texel_count);
+
+}  // namespace d3dapp
+
+#endif  // !__TEXEL_CONVERSION_H__
@@ -0,0 +1,83 @@
+#include "transient_packer.h"
+
+#include <algorithm>
+
+namespace {
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return alignment > 1 ? (value + alignment - 1) / alignment * alignment
+                       : value;
+}
+
+bool LiveTogether(const d3dapp::TransientInterval& a,
+                  const d3dapp::TransientInterval& b) {
+  return a.first <= b.last && b.first <= a.last;
+}
+
+bool SharesMemory(const d3dapp::TransientInterval& a,
+                  const d3dapp::TransientInterval& b) {
+  return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+}
+
+}  // namespace
+
+namespace d3dapp {
+uint64_t PackTransients(std::vector<TransientInterval>& intervals) {
+  std::vector<uint32_t> by_size(intervals.size());
+  for (uint32_t i = 0; i < by_size.size(); ++i) {
+    by_size[i] = i;
+  }
+  std::stable_sort(by_size.begin(), by_size.end(),
+                   [&intervals](uint32_t a, uint32_t b) {
+                     return intervals[a].size > intervals[b].size;
+                   });
+
+  uint64_t total = 0;
+  std::vector<uint32_t> placed;
+  std::vector<uint32_t> conflicts;
+  for (uint32_t index : by_size) {
+    TransientInterval& interval = intervals[index];
+    conflicts.clear();
+    for (uint32_t other : placed) {
+      if (LiveTogether(interval, intervals[other])) {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [&intervals](uint32_t a, uint32_t b) {
+                return intervals[a].offset < intervals[b].offset;
+              });
+
+    uint64_t offset = 0;
+    for (uint32_t other : conflicts) {
+      const TransientInterval& occupied = intervals[other];
+      if (AlignUp(offset, interval.alignment) + interval.size <=
+          occupied.offset) {
+        break;
+      }
+      offset = std::max(offset, occupied.offset + occupied.size);
+    }
+    interval.offset = AlignUp(offset, interval.alignment);
+    total = std::max(total, interval.offset + interval.size);
+    placed.push_back(index);
+  }
+
+  for (TransientInterval& interval : intervals) {
+    interval.alias_before = kNoInterval;
+    interval.aliased = false;
+    for (uint32_t other = 0; other < intervals.size(); ++other) {
+      const TransientInterval& previous = intervals[other];
+      if (&previous == &interval || !SharesMemory(interval, previous)) {
+        continue;
+      }
+      interval.aliased = true;
+      if (previous.last < interval.first &&
+          (kNoInterval == interval.alias_before ||
+           intervals[interval.alias_before].last < previous.last)) {
+        interval.alias_before = other;
+      }
+    }
+  }
+  return total;
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef __TRANSIENT_PACKER_H__
+#define __TRANSIENT_PACKER_H__
+
+#include <cstdint>
+#include <vector>
+
+namespace d3dapp {
+constexpr uint32_t kNoInterval = 0xffffffff;
+
+// A transient resource's footprint and the range of passes it is used in,
+// both ends inclusive.
+struct TransientInterval {
+  uint64_t size;
+  uint64_t alignment;
+  uint32_t first;
+  uint32_t last;
+
+  // Filled by PackTransients.
+  uint64_t offset;
+  // The interval that last occupied part of this one's memory before it
+  // becomes live, or kNoInterval.
+  uint32_t alias_before;
+  // Whether any other interval shares part of this one's memory.
+  bool aliased;
+};
+
+// Places intervals in one block of memory so that intervals live at the
+// same time never overlap, largest first into the lowest gap that fits.
+// Returns the size of the block.
+uint64_t PackTransients(std::vector<TransientInterval>& intervals);
+
+}  // namespace d3dapp
+
+#endif  // !__TRANSIENT_PACKER_H__
@@ -0,0 +1,252 @@
+#include "upload_batcher.h"
+
+#include <algorithm>
+
+#include "chunked_lz.h"
+#include "subresource_copy.h"
+
+namespace {
+// Buffer data only needs to stay aligned for the CPU copy.
+constexpr UINT64 kBufferAlignment = 16;
+
+bool GetBlockFormat(DXGI_FORMAT format,
+                    d3dapp::BlockCompression::Format* block_format) {
+  switch (format) {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+      *block_format = d3dapp::BlockCompression::kBc1;
+      return true;
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+      *block_format = d3dapp::BlockCompression::kBc3;
+      return true;
+    case DXGI_FORMAT_BC4_UNORM:
+      *block_format = d3dapp::BlockCompression::kBc4;
+      return true;
+    case DXGI_FORMAT_BC5_UNORM:
+      *block_format = d3dapp::BlockCompression::kBc5;
+      return true;
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+      *block_format = d3dapp::BlockCompression::kBc7;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// desc with MipLevels 0, which asks for a full chain when creating a
+// resource, given the number of mips that chain has.
+D3D12_RESOURCE_DESC ResolveMipLevels(const D3D12_RESOURCE_DESC& desc) {
+  D3D12_RESOURCE_DESC resolved = desc;
+  if (0 == desc.MipLevels &&
+      D3D12_RESOURCE_DIMENSION_BUFFER != desc.Dimension) {
+    UINT64 size = std::max<UINT64>(desc.Width, desc.Height);
+    if (D3D12_RESOURCE_DIMENSION_TEXTURE3D == desc.Dimension) {
+      size = std::max<UINT64>(size, desc.DepthOrArraySize);
+    }
+    resolved.MipLevels = 1;
+    for (; size > 1; size >>= 1) {
+      ++resolved.MipLevels;
+    }
+  }
+  return resolved;
+}
+
+}  // namespace
+
+namespace d3dapp {
+UploadBatcher::UploadBatcher(FootprintCache* footprint_cache,
+                             UploadRing* upload_ring, JobSystem* job_system)
+    : footprint_cache_{footprint_cache},
+      upload_ring_{upload_ring},
+      job_system_{job_system} {}
+
+void UploadBatcher::AddTexture(ID3D12Resource* dest,
+                               const D3D12_RESOURCE_DESC& dest_desc,
+                               UINT first_subresource,
+                               UINT subresource_count,
+                               const D3D12_SUBRESOURCE_DATA* data,
+                               const TexelConversion* conversion) {
+  const D3D12_RESOURCE_DESC desc = ResolveMipLevels(dest_desc);
+  const Footprints& footprints =
+      footprint_cache_->Get(desc, first_subresource, subresource_count);
+  if (footprints.layouts.empty()) {
+    return;
+  }
+
+  UploadAllocation allocation = upload_ring_->Allocate(
+      footprints.total_size, UploadRing::kTextureAlignment);
+  if (!allocation.cpu_address) {
+    return;
+  }
+  for (UINT i = 0; i < subresource_count; ++i) {
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = footprints.layouts[i];
+    size_t row_pitch = footprint.Footprint.RowPitch;
+    UINT row_count = footprints.row_counts[i];
+    SubresourceCopy copy{allocation.cpu_address + footprint.Offset,
+                         row_pitch,
+                         row_pitch * row_count,
+                         data[i].pData,
+                         static_cast<size_t>(data[i].RowPitch),
+                         static_cast<size_t>(data[i].SlicePitch),
+                         static_cast<size_t>(footprints.row_sizes[i]),
+                         row_count,
+                         footprint.Footprint.Depth};
+    if (conversion) {
+      ConvertSubresource(copy, *conversion, job_system_);
+    } else {
+      CopySubresource(copy, job_system_);
+    }
+    footprint.Offset += allocation.offset;
+    copies_.push_back(Copy{dest, allocation.resource, false,
+                           first_subresource + i, footprint, 0, 0, 0});
+  }
+  staged_size_ += footprints.total_size;
+}
+
+bool UploadBatcher::AddCompressedTexture(ID3D12Resource* dest,
+                                         const D3D12_RESOURCE_DESC& dest_desc,
+                                         UINT first_subresource,
+                                         UINT subresource_count,
+                                         const D3D12_SUBRESOURCE_DATA* data,
+                                         BlockCompression::Quality quality) {
+  const D3D12_RESOURCE_DESC desc = ResolveMipLevels(dest_desc);
+  BlockCompression compression{};
+  compression.quality = quality;
+  if (!GetBlockFormat(desc.Format, &compression.format)) {
+    return false;
+  }
+  const Footprints& footprints =
+      footprint_cache_->Get(desc, first_subresource, subresource_count);
+  if (footprints.layouts.empty()) {
+    return false;
+  }
+
+  UploadAllocation allocation = upload_ring_->Allocate(
+      footprints.total_size, UploadRing::kTextureAlignment);
+  if (!allocation.cpu_address) {
+    return false;
+  }
+  for (UINT i = 0; i < subresource_count; ++i) {
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = footprints.layouts[i];
+    UINT mip = (first_subresource + i) % desc.MipLevels;
+    UINT width = std::max(static_cast<UINT>(desc.Width >> mip), 1u);
+    UINT height = std::max(desc.Height >> mip, 1u);
+    size_t row_pitch = footprint.Footprint.RowPitch;
+    size_t slice_pitch = row_pitch * footprints.row_counts[i];
+    for (UINT slice = 0; slice < footprint.Footprint.Depth; ++slice) {
+      CompressImage(
+          compression,
+          static_cast<const BYTE*>(data[i].pData) +
+              static_cast<size_t>(data[i].SlicePitch) * slice,
+          static_cast<size_t>(data[i].RowPitch), width, height,
+          allocation.cpu_address + footprint.Offset + slice_pitch * slice,
+          row_pitch, job_system_);
+    }
+    footprint.Offset += allocation.offset;
+    copies_.push_back(Copy{dest, allocation.resource, false,
+                           first_subresource + i, footprint, 0, 0, 0});
+  }
+  staged_size_ += footprints.total_size;
+  return true;
+}
+
+void UploadBatcher::AddBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                              const void* data, UINT64 size) {
+  if (0 == size) {
+    return;
+  }
+  UploadAllocation allocation = upload_ring_->Allocate(size, kBufferAlignment);
+  if (!allocation.cpu_address) {
+    return;
+  }
+  StreamCopy(allocation.cpu_address, data, size);
+  staged_size_ += size;
+
+  // Consecutive ranges of one buffer become one copy.
+  if (!copies_.empty()) {
+    Copy& last = copies_.back();
+    if (last.buffer && last.dest == dest &&
+        last.source == allocation.resource &&
+        last.dest_offset + last.size == dest_offset &&
+        last.source_offset + last.size == allocation.offset) {
+      last.size += size;
+      return;
+    }
+  }
+  copies_.push_back(Copy{dest, allocation.resource, true, 0, {}, dest_offset,
+                         allocation.offset, size});
+}
+
+bool UploadBatcher::AddChunkedTexture(ID3D12Resource* dest,
+                                      const D3D12_RESOURCE_DESC& dest_desc,
+                                      UINT first_subresource,
+                                      UINT subresource_count,
+                                      const void* data, UINT64 size) {
+  const D3D12_RESOURCE_DESC desc = ResolveMipLevels(dest_desc);
+  const Footprints& footprints =
+      footprint_cache_->Get(desc, first_subresource, subresource_count);
+  uint64_t decompressed_size = 0;
+  if (footprints.layouts.empty() ||
+      !GetDecompressedSize(data, size, &decompressed_size) ||
+      decompressed_size != footprints.total_size) {
+    return false;
+  }
+
+  // A corrupt chunk wastes the allocation, which the ring reclaims with
+  // the frame.
+  UploadAllocation allocation = upload_ring_->Allocate(
+      footprints.total_size, UploadRing::kTextureAlignment);
+  if (!allocation.cpu_address ||
+      !DecompressChunked(data, size, allocation.cpu_address,
+                         footprints.total_size, job_system_)) {
+    return false;
+  }
+  for (UINT i = 0; i < subresource_count; ++i) {
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = footprints.layouts[i];
+    footprint.Offset += allocation.offset;
+    copies_.push_back(Copy{dest, allocation.resource, false,
+                           first_subresource + i, footprint, 0, 0, 0});
+  }
+  staged_size_ += footprints.total_size;
+  return true;
+}
+
+bool UploadBatcher::AddChunkedBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                                     const void* data, UINT64 size) {
+  uint64_t decompressed_size = 0;
+  if (!GetDecompressedSize(data, size, &decompressed_size)) {
+    return false;
+  }
+  if (0 == decompressed_size) {
+    return true;
+  }
+  UploadAllocation allocation =
+      upload_ring_->Allocate(decompressed_size, kBufferAlignment);
+  if (!allocation.cpu_address ||
+      !DecompressChunked(data, size, allocation.cpu_address,
+                         decompressed_size, job_system_)) {
+    return false;
+  }
+  staged_size_ += decompressed_size;
+  copies_.push_back(Copy{dest, allocation.resource, true, 0, {}, dest_offset,
+                         allocation.offset, decompressed_size});
+  return true;
+}
+
+void UploadBatcher::Flush(Copies* copies) {
+  for (const Copy& copy : copies_) {
+    if (copy.buffer) {
+      copies->CopyBuffer(copy.dest, copy.dest_offset, copy.source,
+                         copy.source_offset, copy.size);
+    } else {
+      copies->CopyTexture(copy.dest, copy.subresource, copy.source,
+                          copy.footprint);
+    }
+  }
+  copies_.clear();
+  staged_size_ = 0;
+}
+
+}  // namespace d3dapp
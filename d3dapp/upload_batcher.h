@@ -0,0 +1,108 @@
+#pragma once
+
+#ifndef __UPLOAD_BATCHER_H__
+#define __UPLOAD_BATCHER_H__
+
+#include <d3dx12.h>
+
+#include <vector>
+
+#include "block_compression.h"
+#include "footprint_cache.h"
+#include "framework.h"
+#include "job_system.h"
+#include "texel_conversion.h"
+#include "upload_ring.h"
+
+namespace d3dapp {
+// Replaces UpdateSubresources for many uploads a frame. Data is written
+// straight into the upload ring's persistently mapped pages as it is added
+// and the copies are recorded together by Flush. Footprints are computed
+// once per desc and nothing is allocated once the internal vectors have
+// grown to the frame's needs. Flush into a list of the frame the data was
+// added in, since the ring reclaims its pages with that frame's fence.
+// Destinations must be in the copy dest state. Data the upload ring has no
+// page for is dropped, and the functions returning bool return false.
+// Not thread safe.
+class UploadBatcher {
+ public:
+  // Where Flush records the copies, e.g. a command list; see
+  // CommandListCopies.
+  class Copies {
+   public:
+    virtual ~Copies() {}
+    virtual void CopyBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                            ID3D12Resource* source, UINT64 source_offset,
+                            UINT64 size) = 0;
+    virtual void CopyTexture(
+        ID3D12Resource* dest, UINT subresource, ID3D12Resource* source,
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint) = 0;
+  };
+
+  // Large subresources are copied in row bands on job_system when given.
+  UploadBatcher(FootprintCache* footprint_cache, UploadRing* upload_ring,
+                JobSystem* job_system = nullptr);
+  UploadBatcher(const UploadBatcher&) = delete;
+  UploadBatcher& operator=(const UploadBatcher&) = delete;
+
+  // Uploads subresource_count subresources of dest starting at
+  // first_subresource. desc is dest's, passed in to spare a GetDesc call;
+  // MipLevels may be 0 for a full chain, as when creating dest.
+  // With a conversion, data holds texels in its source format and is
+  // converted to desc's format as it is staged.
+  void AddTexture(ID3D12Resource* dest, const D3D12_RESOURCE_DESC& desc,
+                  UINT first_subresource, UINT subresource_count,
+                  const D3D12_SUBRESOURCE_DATA* data,
+                  const TexelConversion* conversion = nullptr);
+  // AddTexture for BC1, BC3, BC4, BC5 and BC7 textures from RGBA8 data,
+  // compressed straight into the upload ring. Returns false for other
+  // formats.
+  bool AddCompressedTexture(ID3D12Resource* dest,
+                            const D3D12_RESOURCE_DESC& desc,
+                            UINT first_subresource, UINT subresource_count,
+                            const D3D12_SUBRESOURCE_DATA* data,
+                            BlockCompression::Quality quality);
+  void AddBuffer(ID3D12Resource* dest, UINT64 dest_offset, const void* data,
+                 UINT64 size);
+  // AddTexture and AddBuffer for data compressed with CompressChunked, the
+  // texture's holding the subresources placed as the footprints lay them
+  // out from offset 0. Chunks are decompressed straight into the upload
+  // ring, on job_system when given. Return false, staging nothing, if the
+  // decompressed size does not match or data is corrupt.
+  bool AddChunkedTexture(ID3D12Resource* dest, const D3D12_RESOURCE_DESC& desc,
+                         UINT first_subresource, UINT subresource_count,
+                         const void* data, UINT64 size);
+  bool AddChunkedBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                        const void* data, UINT64 size);
+
+  // Records every copy added since the last Flush.
+  void Flush(Copies* copies);
+
+  size_t copy_count() const { return copies_.size(); }
+  UINT64 staged_size() const { return staged_size_; }
+
+ private:
+  struct Copy {
+    ID3D12Resource* dest;
+    ID3D12Resource* source;
+    bool buffer;
+    // Textures only.
+    UINT subresource;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+    // Buffers only.
+    UINT64 dest_offset;
+    UINT64 source_offset;
+    UINT64 size;
+  };
+
+  FootprintCache* footprint_cache_{nullptr};
+  UploadRing* upload_ring_{nullptr};
+  JobSystem* job_system_{nullptr};
+
+  std::vector<Copy> copies_;
+  UINT64 staged_size_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__UPLOAD_BATCHER_H__
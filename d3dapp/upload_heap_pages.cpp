@@ -0,0 +1,35 @@
+#include "upload_heap_pages.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace d3dapp {
+bool UploadHeapPages::Create(UINT64 size, UploadAllocation* page) {
+  CD3DX12_HEAP_PROPERTIES heap_properties{D3D12_HEAP_TYPE_UPLOAD};
+  CD3DX12_RESOURCE_DESC resource_desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+  ComPtr<ID3D12Resource> resource;
+  if (FAILED(device_->CreateCommittedResource(
+          &heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc,
+          D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+          IID_PPV_ARGS(&resource)))) {
+    return false;
+  }
+
+  // Upload heaps may stay mapped for the lifetime of the resource.
+  CD3DX12_RANGE read_range{0, 0};
+  void* cpu_address = nullptr;
+  if (FAILED(resource->Map(0, &read_range, &cpu_address))) {
+    return false;
+  }
+  page->offset = 0;
+  page->cpu_address = static_cast<BYTE*>(cpu_address);
+  page->gpu_address = resource->GetGPUVirtualAddress();
+  // The ring owns the reference until Destroy.
+  page->resource = resource.Detach();
+  return true;
+}
+
+void UploadHeapPages::Destroy(const UploadAllocation& page) {
+  page.resource->Release();
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,29 @@
+#pragma once
+
+#ifndef __UPLOAD_HEAP_PAGES_H__
+#define __UPLOAD_HEAP_PAGES_H__
+
+#include <d3dx12.h>
+
+#include "framework.h"
+#include "upload_ring.h"
+
+namespace d3dapp {
+// UploadRing's pages as committed buffers in the upload heap, mapped for
+// their whole lifetime.
+class UploadHeapPages : public UploadRing::Pages {
+ public:
+  explicit UploadHeapPages(ID3D12Device* device) : device_{device} {}
+  UploadHeapPages(const UploadHeapPages&) = delete;
+  UploadHeapPages& operator=(const UploadHeapPages&) = delete;
+
+  bool Create(UINT64 size, UploadAllocation* page) override;
+  void Destroy(const UploadAllocation& page) override;
+
+ private:
+  ID3D12Device* device_{nullptr};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__UPLOAD_HEAP_PAGES_H__
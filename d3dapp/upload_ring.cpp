@@ -0,0 +1,115 @@
+#include "upload_ring.h"
+
+namespace {
+UINT64 AlignUp(UINT64 value, UINT64 alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+namespace d3dapp {
+UploadRing::UploadRing(std::unique_ptr<Pages> pages, UINT64 page_size)
+    : pages_{std::move(pages)}, page_size_{page_size} {}
+
+UploadRing::~UploadRing() {
+  for (auto& page : free_pages_) {
+    DestroyPage(std::move(page));
+  }
+  for (auto& page : frame_pages_) {
+    DestroyPage(std::move(page));
+  }
+  for (auto& page : frame_large_pages_) {
+    DestroyPage(std::move(page));
+  }
+  for (auto& page : retired_pages_) {
+    DestroyPage(std::move(page));
+  }
+  for (auto& page : retired_large_pages_) {
+    DestroyPage(std::move(page));
+  }
+}
+
+UploadAllocation UploadRing::Allocate(UINT64 size, UINT64 alignment) {
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  Page* page = nullptr;
+  UINT64 offset = 0;
+  if (size > page_size_) {
+    std::unique_ptr<Page> large_page = CreatePage(AlignUp(size, alignment));
+    if (!large_page) {
+      return UploadAllocation{};
+    }
+    frame_large_pages_.push_back(std::move(large_page));
+    page = frame_large_pages_.back().get();
+  } else {
+    offset = AlignUp(offset_, alignment);
+    if (frame_pages_.empty() || offset + size > page_size_) {
+      if (free_pages_.empty()) {
+        std::unique_ptr<Page> new_page = CreatePage(page_size_);
+        if (!new_page) {
+          return UploadAllocation{};
+        }
+        frame_pages_.push_back(std::move(new_page));
+      } else {
+        frame_pages_.push_back(std::move(free_pages_.back()));
+        free_pages_.pop_back();
+      }
+      offset = 0;
+    }
+    page = frame_pages_.back().get();
+    offset_ = offset + size;
+  }
+
+  UploadAllocation allocation{};
+  allocation.resource = page->memory.resource;
+  allocation.offset = offset;
+  allocation.cpu_address = page->memory.cpu_address + offset;
+  allocation.gpu_address = page->memory.gpu_address + offset;
+  return allocation;
+}
+
+void UploadRing::EndFrame(uint64_t fence_value) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (auto& page : frame_pages_) {
+    page->fence_value = fence_value;
+    retired_pages_.push_back(std::move(page));
+  }
+  for (auto& page : frame_large_pages_) {
+    page->fence_value = fence_value;
+    retired_large_pages_.push_back(std::move(page));
+  }
+  frame_pages_.clear();
+  frame_large_pages_.clear();
+  offset_ = 0;
+}
+
+void UploadRing::Reclaim(uint64_t completed_value) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  while (!retired_pages_.empty() &&
+         retired_pages_.front()->fence_value <= completed_value) {
+    free_pages_.push_back(std::move(retired_pages_.front()));
+    retired_pages_.pop_front();
+  }
+  while (!retired_large_pages_.empty() &&
+         retired_large_pages_.front()->fence_value <= completed_value) {
+    DestroyPage(std::move(retired_large_pages_.front()));
+    retired_large_pages_.pop_front();
+  }
+}
+
+std::unique_ptr<UploadRing::Page> UploadRing::CreatePage(UINT64 size) {
+  std::unique_ptr<Page> page{new Page{}};
+  page->size = size;
+  if (!pages_->Create(size, &page->memory)) {
+    return nullptr;
+  }
+  ++page_count_;
+  return page;
+}
+
+void UploadRing::DestroyPage(std::unique_ptr<Page> page) {
+  pages_->Destroy(page->memory);
+  --page_count_;
+}
+
+}  // namespace d3dapp
@@ -0,0 +1,94 @@
+#pragma once
+
+#ifndef __UPLOAD_RING_H__
+#define __UPLOAD_RING_H__
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "framework.h"
+
+namespace d3dapp {
+struct UploadAllocation {
+  ID3D12Resource* resource{nullptr};
+  UINT64 offset{0};
+  BYTE* cpu_address{nullptr};
+  D3D12_GPU_VIRTUAL_ADDRESS gpu_address{0};
+};
+
+// Persistently mapped upload memory for per-frame data. Allocations are
+// bumped out of fixed-size pages; the pages a frame used are handed back once
+// the GPU passes that frame's fence. When no page is free a new one is
+// created, so running out never stalls. Allocate may be called from any
+// thread; EndFrame and Reclaim belong to the render thread.
+class UploadRing {
+ public:
+  // Where pages come from, e.g. committed upload buffers. A page is
+  // described by its allocation at offset 0.
+  class Pages {
+   public:
+    virtual ~Pages() {}
+    // A persistently mapped page of size bytes, or false.
+    virtual bool Create(UINT64 size, UploadAllocation* page) = 0;
+    // Frees a page the GPU is done with.
+    virtual void Destroy(const UploadAllocation& page) = 0;
+  };
+
+  static constexpr UINT64 kConstantAlignment =
+      D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+  static constexpr UINT64 kTextureAlignment =
+      D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+
+  UploadRing(std::unique_ptr<Pages> pages, UINT64 page_size);
+  UploadRing(const UploadRing&) = delete;
+  UploadRing& operator=(const UploadRing&) = delete;
+  ~UploadRing();
+
+  // Valid until the fence passed to the next EndFrame completes. Requests
+  // larger than a page get a dedicated buffer that is released afterwards.
+  // Returns an allocation without a cpu_address if no page can be created.
+  UploadAllocation Allocate(UINT64 size,
+                            UINT64 alignment = kConstantAlignment);
+
+  // Tags everything allocated since the last call with fence_value.
+  void EndFrame(uint64_t fence_value);
+
+  // Recycles the pages of every frame whose fence value has completed.
+  void Reclaim(uint64_t completed_value);
+
+  UINT64 page_size() const { return page_size_; }
+  size_t page_count() const { return page_count_; }
+
+ private:
+  struct Page {
+    UploadAllocation memory;
+    UINT64 size{0};
+    uint64_t fence_value{0};
+  };
+
+  // Called with mutex_ held.
+  std::unique_ptr<Page> CreatePage(UINT64 size);
+  void DestroyPage(std::unique_ptr<Page> page);
+
+  std::unique_ptr<Pages> pages_;
+  UINT64 page_size_{0};
+  size_t page_count_{0};
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Page>> free_pages_;
+  // Pages used by the frame being recorded; the last one is current.
+  std::vector<std::unique_ptr<Page>> frame_pages_;
+  std::vector<std::unique_ptr<Page>> frame_large_pages_;
+  std::deque<std::unique_ptr<Page>> retired_pages_;
+  std::deque<std::unique_ptr<Page>> retired_large_pages_;
+  UINT64 offset_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__UPLOAD_RING_H__
@@ -0,0 +1,111 @@
+#include "virtual_texture.h"
+
+namespace d3dapp {
+VirtualTexture::VirtualTexture(ID3D12Device* device,
+                               const D3D12_RESOURCE_DESC& desc,
+                               D3D12_RESOURCE_STATES initial_state,
+                               UINT pool_tile_count)
+    : table_{new VirtualTextureTable{{}, 0}} {
+  // The table pages one slice; arrays would need a packed tail and a table
+  // per slice.
+  if (D3D12_RESOURCE_DIMENSION_TEXTURE2D != desc.Dimension ||
+      1 != desc.DepthOrArraySize) {
+    return;
+  }
+  D3D12_RESOURCE_DESC reserved_desc = desc;
+  reserved_desc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+  if (FAILED(device->CreateReservedResource(&reserved_desc, initial_state,
+                                            nullptr,
+                                            IID_PPV_ARGS(&resource_)))) {
+    resource_.Reset();
+    return;
+  }
+
+  UINT tile_count = 0;
+  // MipLevels 0 in desc asks for the full chain; the resource has the count.
+  UINT tiling_count = resource_->GetDesc().MipLevels;
+  std::vector<D3D12_SUBRESOURCE_TILING> tilings(tiling_count);
+  device->GetResourceTiling(resource_.Get(), &tile_count, &packed_mip_info_,
+                            &tile_shape_, &tiling_count, 0, tilings.data());
+
+  // The packed tail takes the first tiles of the heap.
+  D3D12_HEAP_DESC heap_desc{};
+  heap_desc.SizeInBytes =
+      static_cast<UINT64>(pool_tile_count +
+                          packed_mip_info_.NumTilesForPackedMips) *
+      D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+  heap_desc.Properties = CD3DX12_HEAP_PROPERTIES{D3D12_HEAP_TYPE_DEFAULT};
+  heap_desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+  if (FAILED(device->CreateHeap(&heap_desc, IID_PPV_ARGS(&heap_)))) {
+    resource_.Reset();
+    return;
+  }
+
+  std::vector<VirtualMipLevel> mips;
+  for (UINT mip = 0; mip < packed_mip_info_.NumStandardMips; ++mip) {
+    mips.push_back(VirtualMipLevel{tilings[mip].WidthInTiles,
+                                   tilings[mip].HeightInTiles});
+  }
+  table_.reset(new VirtualTextureTable{mips, pool_tile_count});
+}
+
+void VirtualTexture::Update(ID3D12CommandQueue* command_queue,
+                            uint64_t completed_fence, size_t max_mappings) {
+  mappings_.clear();
+  if (!resource_) {
+    return;
+  }
+  table_->Update(completed_fence, max_mappings, mappings_);
+
+  coordinates_.clear();
+  region_sizes_.clear();
+  range_flags_.clear();
+  range_offsets_.clear();
+  range_tile_counts_.clear();
+  UINT packed_tile_count = packed_mip_info_.NumTilesForPackedMips;
+  if (!packed_mapped_ && packed_tile_count > 0) {
+    coordinates_.push_back(CD3DX12_TILED_RESOURCE_COORDINATE{
+        0, 0, 0, packed_mip_info_.NumStandardMips});
+    region_sizes_.push_back(
+        CD3DX12_TILE_REGION_SIZE{packed_tile_count, false, 0, 0, 0});
+    range_flags_.push_back(D3D12_TILE_RANGE_FLAG_NONE);
+    range_offsets_.push_back(0);
+    range_tile_counts_.push_back(packed_tile_count);
+  }
+  packed_mapped_ = true;
+
+  for (const TileMapping& mapping : mappings_) {
+    coordinates_.push_back(CD3DX12_TILED_RESOURCE_COORDINATE{
+        mapping.page.x, mapping.page.y, 0, mapping.page.mip});
+    region_sizes_.push_back(CD3DX12_TILE_REGION_SIZE{1, false, 0, 0, 0});
+    if (kNoTile == mapping.tile) {
+      range_flags_.push_back(D3D12_TILE_RANGE_FLAG_NULL);
+      range_offsets_.push_back(0);
+    } else {
+      range_flags_.push_back(D3D12_TILE_RANGE_FLAG_NONE);
+      range_offsets_.push_back(packed_tile_count + mapping.tile);
+    }
+    range_tile_counts_.push_back(1);
+  }
+  if (coordinates_.empty()) {
+    return;
+  }
+
+  UINT count = static_cast<UINT>(coordinates_.size());
+  command_queue->UpdateTileMappings(
+      resource_.Get(), count, coordinates_.data(), region_sizes_.data(),
+      heap_.Get(), count, range_flags_.data(), range_offsets_.data(),
+      range_tile_counts_.data(), D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+void VirtualTexture::CopyTile(ID3D12GraphicsCommandList* command_list,
+                              const VirtualPage& page,
+                              ID3D12Resource* buffer, UINT64 offset) {
+  CD3DX12_TILED_RESOURCE_COORDINATE coordinate{page.x, page.y, 0, page.mip};
+  CD3DX12_TILE_REGION_SIZE region_size{1, false, 0, 0, 0};
+  command_list->CopyTiles(
+      resource_.Get(), &coordinate, &region_size, buffer, offset,
+      D3D12_TILE_COPY_FLAG_LINEAR_BUFFER_TO_SWIZZLED_TILED_RESOURCE);
+}
+
+}  // namespace d3dapp
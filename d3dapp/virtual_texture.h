@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef __VIRTUAL_TEXTURE_H__
+#define __VIRTUAL_TEXTURE_H__
+
+#include <d3dx12.h>
+
+#include <memory>
+#include <vector>
+
+#include "framework.h"
+#include "virtual_texture_table.h"
+
+namespace d3dapp {
+// Reserved 2D texture, not an array, whose standard mips are paged into a
+// fixed pool of 64KB tiles, e.g. for terrain albedo and normal sets far
+// larger than video memory. The packed mip tail gets its own tiles and
+// stays mapped. Feed sampler feedback into table(), then call Update once
+// per frame before submitting; it issues every map and unmap in one
+// UpdateTileMappings call. Newly mapped tiles hold garbage until filled,
+// e.g. with CopyTile, before the work sampling them runs.
+class VirtualTexture {
+ public:
+  VirtualTexture(ID3D12Device* device, const D3D12_RESOURCE_DESC& desc,
+                 D3D12_RESOURCE_STATES initial_state, UINT pool_tile_count);
+  VirtualTexture(const VirtualTexture&) = delete;
+  VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+  // Maps at most max_mappings pages; evictions wait for completed_fence to
+  // pass the last frame that requested the page.
+  void Update(ID3D12CommandQueue* command_queue, uint64_t completed_fence,
+              size_t max_mappings);
+
+  // Copies one tile of data, laid out linearly, into page. The texture must
+  // be in the copy dest state.
+  void CopyTile(ID3D12GraphicsCommandList* command_list,
+                const VirtualPage& page, ID3D12Resource* buffer,
+                UINT64 offset);
+
+  // Null when creation failed or desc is not a single 2D texture.
+  ID3D12Resource* resource() const { return resource_.Get(); }
+  VirtualTextureTable& table() { return *table_; }
+  const VirtualTextureTable& table() const { return *table_; }
+  // Changes made by the last Update; maps need their data copied.
+  const std::vector<TileMapping>& mappings() const { return mappings_; }
+  // Mapped by the first Update and filled like any other subresources.
+  const D3D12_PACKED_MIP_INFO& packed_mip_info() const {
+    return packed_mip_info_;
+  }
+  const D3D12_TILE_SHAPE& tile_shape() const { return tile_shape_; }
+
+ private:
+  Microsoft::WRL::ComPtr<ID3D12Resource> resource_;
+  Microsoft::WRL::ComPtr<ID3D12Heap> heap_;
+  D3D12_PACKED_MIP_INFO packed_mip_info_{};
+  D3D12_TILE_SHAPE tile_shape_{};
+  std::unique_ptr<VirtualTextureTable> table_;
+  bool packed_mapped_{false};
+
+  std::vector<TileMapping> mappings_;
+  std::vector<D3D12_TILED_RESOURCE_COORDINATE> coordinates_;
+  std::vector<D3D12_TILE_REGION_SIZE> region_sizes_;
+  std::vector<D3D12_TILE_RANGE_FLAGS> range_flags_;
+  std::vector<UINT> range_offsets_;
+  std::vector<UINT> range_tile_counts_;
+};
+
+}  // namespace d3dapp
+
+#endif  // !__VIRTUAL_TEXTURE_H__
@@ -0,0 +1,192 @@
+#include "virtual_texture_table.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace d3dapp {
+VirtualTextureTable::VirtualTextureTable(
+    const std::vector<VirtualMipLevel>& mips, uint32_t tile_count)
+    : mips_{mips} {
+  uint32_t page_count = 0;
+  for (const VirtualMipLevel& level : mips_) {
+    mip_offsets_.push_back(page_count);
+    page_count += level.width * level.height;
+  }
+  page_tiles_.assign(page_count, kNoTile);
+  page_pending_.assign(page_count, 0);
+
+  tiles_.resize(tile_count);
+  for (uint32_t i = tile_count; i > 0; --i) {
+    free_tiles_.push_back(i - 1);
+  }
+
+  if (!mips_.empty()) {
+    min_mip_map_.assign(mips_[0].width * mips_[0].height,
+                        static_cast<uint8_t>(mips_.size()));
+  }
+}
+
+void VirtualTextureTable::ProcessFeedback(const uint32_t* feedback,
+                                          size_t count,
+                                          uint64_t fence_value) {
+  for (size_t i = 0; i < count; ++i) {
+    if (kNoFeedback != feedback[i]) {
+      Request(feedback[i] >> 28, feedback[i] & 0x3fff,
+              feedback[i] >> 14 & 0x3fff, fence_value);
+    }
+  }
+}
+
+void VirtualTextureTable::Request(uint32_t mip, uint32_t x, uint32_t y,
+                                  uint64_t fence_value) {
+  if (mip >= mips_.size() || x >= mips_[mip].width ||
+      y >= mips_[mip].height) {
+    return;
+  }
+
+  last_request_ = std::max(last_request_, fence_value);
+  for (; mip < mips_.size() && x < mips_[mip].width && y < mips_[mip].height;
+       ++mip, x /= 2, y /= 2) {
+    uint32_t page = PageIndex(mip, x, y);
+    if (kNoTile != page_tiles_[page]) {
+      Touch(page_tiles_[page], fence_value);
+    } else if (!page_pending_[page]) {
+      page_pending_[page] = 1;
+      pending_.push_back(page);
+    }
+  }
+}
+
+void VirtualTextureTable::Update(uint64_t completed_fence,
+                                 size_t max_mappings,
+                                 std::vector<TileMapping>& mappings) {
+  // Page indices grow with the mip, so coarse pages sort first.
+  std::sort(pending_.begin(), pending_.end(), std::greater<uint32_t>());
+
+  size_t mapped = 0;
+  size_t kept = 0;
+  // New tiles go in front of the ones mapped before them, which leaves the
+  // coarse pages most recently used.
+  uint32_t first_mapped = kNoTile;
+  for (size_t i = 0; i < pending_.size(); ++i) {
+    uint32_t page = pending_[i];
+    uint32_t tile = kNoTile;
+    if (mapped < max_mappings) {
+      if (!free_tiles_.empty()) {
+        tile = free_tiles_.back();
+        free_tiles_.pop_back();
+      } else if (kNoTile != lru_head_ &&
+                 tiles_[lru_head_].last_used <= completed_fence) {
+        tile = lru_head_;
+        Unlink(tile);
+        VirtualPage evicted = PageAt(tiles_[tile].page);
+        page_tiles_[tiles_[tile].page] = kNoTile;
+        mappings.push_back(TileMapping{evicted, kNoTile});
+        UpdateMinMip(evicted);
+        ++evicted_total_;
+      }
+    }
+    if (kNoTile == tile) {
+      pending_[kept++] = page;
+      continue;
+    }
+
+    page_pending_[page] = 0;
+    page_tiles_[page] = tile;
+    tiles_[tile].page = page;
+    // Filled and sampled by work submitted after this, so it cannot be
+    // taken over again until that completes.
+    tiles_[tile].last_used = std::max(last_request_, completed_fence + 1);
+    Link(tile, first_mapped);
+    first_mapped = tile;
+    VirtualPage virtual_page = PageAt(page);
+    mappings.push_back(TileMapping{virtual_page, tile});
+    UpdateMinMip(virtual_page);
+    ++mapped;
+    ++mapped_total_;
+  }
+  if (mapped < max_mappings && kept > 0) {
+    ++starved_count_;
+  }
+  pending_.resize(kept);
+}
+
+VirtualTextureStats VirtualTextureTable::stats() const {
+  VirtualTextureStats stats{};
+  stats.page_count = page_tiles_.size();
+  stats.resident_count = tiles_.size() - free_tiles_.size();
+  stats.pending_count = pending_.size();
+  stats.mapped_total = mapped_total_;
+  stats.evicted_total = evicted_total_;
+  stats.starved_count = starved_count_;
+  return stats;
+}
+
+VirtualPage VirtualTextureTable::PageAt(uint32_t page) const {
+  uint32_t mip = static_cast<uint32_t>(
+      std::upper_bound(mip_offsets_.begin(), mip_offsets_.end(), page) -
+      mip_offsets_.begin() - 1);
+  uint32_t index = page - mip_offsets_[mip];
+  return VirtualPage{mip, index % mips_[mip].width, index / mips_[mip].width};
+}
+
+void VirtualTextureTable::Touch(uint32_t tile, uint64_t fence_value) {
+  tiles_[tile].last_used = std::max(tiles_[tile].last_used, fence_value);
+  if (lru_tail_ != tile) {
+    Unlink(tile);
+    Link(tile, kNoTile);
+  }
+}
+
+void VirtualTextureTable::Unlink(uint32_t tile) {
+  Tile& unlinked = tiles_[tile];
+  if (kNoTile != unlinked.prev) {
+    tiles_[unlinked.prev].next = unlinked.next;
+  } else {
+    lru_head_ = unlinked.next;
+  }
+  if (kNoTile != unlinked.next) {
+    tiles_[unlinked.next].prev = unlinked.prev;
+  } else {
+    lru_tail_ = unlinked.prev;
+  }
+}
+
+void VirtualTextureTable::Link(uint32_t tile, uint32_t before) {
+  uint32_t prev = kNoTile != before ? tiles_[before].prev : lru_tail_;
+  tiles_[tile].prev = prev;
+  tiles_[tile].next = before;
+  if (kNoTile != prev) {
+    tiles_[prev].next = tile;
+  } else {
+    lru_head_ = tile;
+  }
+  if (kNoTile != before) {
+    tiles_[before].prev = tile;
+  } else {
+    lru_tail_ = tile;
+  }
+}
+
+void VirtualTextureTable::UpdateMinMip(const VirtualPage& page) {
+  const VirtualMipLevel& finest = mips_[0];
+  uint32_t x_end = std::min((page.x + 1) << page.mip, finest.width);
+  uint32_t y_end = std::min((page.y + 1) << page.mip, finest.height);
+  for (uint32_t y = page.y << page.mip; y < y_end; ++y) {
+    for (uint32_t x = page.x << page.mip; x < x_end; ++x) {
+      uint32_t min_mip = mip_count();
+      for (; min_mip > 0; --min_mip) {
+        uint32_t mip = min_mip - 1;
+        if ((x >> mip) >= mips_[mip].width ||
+            (y >> mip) >= mips_[mip].height ||
+            kNoTile == tile(mip, x >> mip, y >> mip)) {
+          break;
+        }
+      }
+      min_mip_map_[y * finest.width + x] = static_cast<uint8_t>(min_mip);
+    }
+  }
+  min_mip_dirty_ = true;
+}
+
+}  // namespace d3dapp
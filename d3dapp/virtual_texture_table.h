@@ -0,0 +1,128 @@
+#pragma once
+
+#ifndef __VIRTUAL_TEXTURE_TABLE_H__
+#define __VIRTUAL_TEXTURE_TABLE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace d3dapp {
+constexpr uint32_t kNoTile = 0xffffffff;
+// Cleared feedback entries; anything else is PackFeedback output.
+constexpr uint32_t kNoFeedback = 0xffffffff;
+
+// Size of a paged mip level in tiles.
+struct VirtualMipLevel {
+  uint32_t width;
+  uint32_t height;
+};
+
+struct VirtualPage {
+  uint32_t mip;
+  uint32_t x;
+  uint32_t y;
+};
+
+// Maps page to pool tile, or unmaps it when tile is kNoTile.
+struct TileMapping {
+  VirtualPage page;
+  uint32_t tile;
+};
+
+struct VirtualTextureStats {
+  size_t page_count{0};
+  size_t resident_count{0};
+  size_t pending_count{0};
+  // Totals over every Update.
+  size_t mapped_total{0};
+  size_t evicted_total{0};
+  // Updates that left requests pending because every tile was in use.
+  size_t starved_count{0};
+};
+
+// Page table and physical tile pool of a virtual texture. Pages requested
+// through feedback are mapped to pool tiles, coarse mips first, taking the
+// least recently used tile once the pool is full; a tile is only taken once
+// the GPU is done with its page. Requesting a page also requests the
+// coarser pages covering it, so sampling always has a resident mip to fall
+// back to. Fence values stand in for frames. Not thread safe.
+class VirtualTextureTable {
+ public:
+  // Mip tails packed into fewer tiles are not paged; map them separately.
+  VirtualTextureTable(const std::vector<VirtualMipLevel>& mips,
+                      uint32_t tile_count);
+
+  // 4 bits of mip and 14 bits each of x and y.
+  static uint32_t PackFeedback(uint32_t mip, uint32_t x, uint32_t y) {
+    return mip << 28 | (y & 0x3fff) << 14 | (x & 0x3fff);
+  }
+  void ProcessFeedback(const uint32_t* feedback, size_t count,
+                       uint64_t fence_value);
+  // Out of range pages are ignored.
+  void Request(uint32_t mip, uint32_t x, uint32_t y, uint64_t fence_value);
+
+  // Appends up to max_mappings mappings; an evicted page's unmap comes right
+  // before the map of the page taking over its tile and counts as one.
+  // Pages left over stay pending.
+  void Update(uint64_t completed_fence, size_t max_mappings,
+              std::vector<TileMapping>& mappings);
+
+  uint32_t tile(uint32_t mip, uint32_t x, uint32_t y) const {
+    return page_tiles_[PageIndex(mip, x, y)];
+  }
+  uint32_t mip_count() const { return static_cast<uint32_t>(mips_.size()); }
+  const VirtualMipLevel& mip(uint32_t mip) const { return mips_[mip]; }
+  uint32_t tile_count() const { return static_cast<uint32_t>(tiles_.size()); }
+
+  // Finest mip with a resident chain up to the packed tail, one texel per
+  // tile of mip 0; mip_count() where only the tail is resident. Shaders
+  // clamp their LOD to it.
+  const std::vector<uint8_t>& min_mip_map() const { return min_mip_map_; }
+  bool min_mip_dirty() const { return min_mip_dirty_; }
+  void ClearMinMipDirty() { min_mip_dirty_ = false; }
+
+  VirtualTextureStats stats() const;
+
+ private:
+  struct Tile {
+    uint32_t page;
+    uint64_t last_used;
+    // Least recently used list of mapped tiles.
+    uint32_t prev;
+    uint32_t next;
+  };
+
+  uint32_t PageIndex(uint32_t mip, uint32_t x, uint32_t y) const {
+    return mip_offsets_[mip] + y * mips_[mip].width + x;
+  }
+  VirtualPage PageAt(uint32_t page) const;
+  void Touch(uint32_t tile, uint64_t fence_value);
+  void Unlink(uint32_t tile);
+  // Before kNoTile appends.
+  void Link(uint32_t tile, uint32_t before);
+  void UpdateMinMip(const VirtualPage& page);
+
+  std::vector<VirtualMipLevel> mips_;
+  std::vector<uint32_t> mip_offsets_;
+  std::vector<uint32_t> page_tiles_;
+  std::vector<uint8_t> page_pending_;
+  std::vector<uint32_t> pending_;
+  uint64_t last_request_{0};
+
+  std::vector<Tile> tiles_;
+  std::vector<uint32_t> free_tiles_;
+  uint32_t lru_head_{kNoTile};
+  uint32_t lru_tail_{kNoTile};
+
+  std::vector<uint8_t> min_mip_map_;
+  bool min_mip_dirty_{true};
+
+  size_t mapped_total_{0};
+  size_t evicted_total_{0};
+  size_t starved_count_{0};
+};
+
+}  // namespace d3dapp
+
+#endif  // !__VIRTUAL_TEXTURE_TABLE_H__
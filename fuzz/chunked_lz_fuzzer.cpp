@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "chunked_lz.h"
+
+namespace {
+// Decompressing into more than this is not interesting, only slow.
+constexpr uint64_t kMaxDecompressedSize = 16 * 1024 * 1024;
+constexpr uint32_t kDeltaStrides[] = {0, 1, 2, 3, 4, 8};
+
+}  // namespace
+
+// The first byte picks what to do with the rest: decompress it as a
+// container, which must fail cleanly or fill dest, or compress it and
+// check that it decompresses back.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (0 == size) {
+    return 0;
+  }
+  const uint8_t mode = data[0];
+  ++data;
+  --size;
+
+  if (mode & 1) {
+    uint64_t decompressed_size = 0;
+    if (!d3dapp::GetDecompressedSize(data, size, &decompressed_size) ||
+        decompressed_size > kMaxDecompressedSize) {
+      return 0;
+    }
+    std::vector<uint8_t> dest(static_cast<size_t>(decompressed_size));
+    d3dapp::DecompressChunked(data, size, dest.data(), dest.size());
+    // A wrong size is always rejected before anything is written.
+    if (d3dapp::DecompressChunked(data, size, dest.data(), dest.size() + 1)) {
+      std::abort();
+    }
+    return 0;
+  }
+
+  const uint32_t delta_stride =
+      kDeltaStrides[(mode >> 1) % (sizeof(kDeltaStrides) / sizeof(uint32_t))];
+  std::vector<uint8_t> compressed;
+  d3dapp::CompressChunked(data, size, delta_stride, &compressed);
+  std::vector<uint8_t> decompressed(size);
+  if (!d3dapp::DecompressChunked(compressed.data(), compressed.size(),
+                                 decompressed.data(), size) ||
+      0 != std::memcmp(decompressed.data(), data, size)) {
+    std::abort();
+  }
+  return 0;
+}
@@ -0,0 +1,274 @@
+#include "asset_package.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "asset_package_writer.h"
+#include "block_compression.h"
+#include "footprint_cache.h"
+
+namespace {
+using d3dapp::AssetEntry;
+using d3dapp::AssetPackage;
+using d3dapp::AssetPackageHeader;
+using d3dapp::AssetPackageWriter;
+
+D3D12_RESOURCE_DESC Texture2D(UINT width, UINT height, UINT16 array_size,
+                              UINT16 mip_levels, DXGI_FORMAT format) {
+  D3D12_RESOURCE_DESC desc{};
+  desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+  desc.Width = width;
+  desc.Height = height;
+  desc.DepthOrArraySize = array_size;
+  desc.MipLevels = mip_levels;
+  desc.Format = format;
+  desc.SampleDesc.Count = 1;
+  return desc;
+}
+
+// Tightly packed texels of every subresource, with data pointing at them.
+struct SourceTexture {
+  SourceTexture(const D3D12_RESOURCE_DESC& desc, size_t texel_size) {
+    UINT count = desc.DepthOrArraySize * desc.MipLevels;
+    std::vector<size_t> offsets;
+    for (UINT i = 0; i < count; ++i) {
+      UINT mip = i % desc.MipLevels;
+      size_t width = std::max<size_t>(desc.Width >> mip, 1);
+      size_t height = std::max<size_t>(desc.Height >> mip, 1);
+      offsets.push_back(texels.size());
+      row_pitches.push_back(width * texel_size);
+      rows.push_back(height);
+      texels.resize(texels.size() + width * height * texel_size);
+    }
+    for (size_t i = 0; i < texels.size(); ++i) {
+      texels[i] = static_cast<uint8_t>(i * 7 + i / 251);
+    }
+    for (UINT i = 0; i < count; ++i) {
+      data.push_back(D3D12_SUBRESOURCE_DATA{
+          texels.data() + offsets[i], static_cast<LONG_PTR>(row_pitches[i]),
+          static_cast<LONG_PTR>(row_pitches[i] * rows[i])});
+    }
+  }
+
+  std::vector<uint8_t> texels;
+  std::vector<size_t> row_pitches;
+  std::vector<size_t> rows;
+  std::vector<D3D12_SUBRESOURCE_DATA> data;
+};
+
+std::vector<uint8_t> ReadFile(const std::string& path) {
+  std::ifstream file{path, std::ios::binary};
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file),
+                              std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+// The payload of entry, decompressed as a streamed request would be.
+std::vector<uint8_t> Load(const AssetPackage& package,
+                          const AssetEntry& entry) {
+  std::vector<uint8_t> staging(static_cast<size_t>(entry.data_size));
+  d3dapp::StreamRequest request = d3dapp::MakeAssetRequest(package, entry);
+  EXPECT_TRUE(request.decode(package.data(entry), staging.data()));
+  return staging;
+}
+
+class AssetPackageTest : public ::testing::TestWithParam<bool> {
+ protected:
+  AssetPackageTest()
+      : path_{::testing::TempDir() + "asset_package_test.pkg"} {}
+  ~AssetPackageTest() override { std::remove(path_.c_str()); }
+
+  std::string path_;
+};
+
+}  // namespace
+
+// With and without compressing the payloads.
+TEST_P(AssetPackageTest, RoundTripsBuffersAndTextures) {
+  std::vector<uint8_t> buffer(10000);
+  for (size_t i = 0; i < buffer.size(); ++i) {
+    buffer[i] = static_cast<uint8_t>(i % 13);
+  }
+  const D3D12_RESOURCE_DESC desc =
+      Texture2D(37, 20, 2, 3, DXGI_FORMAT_R8G8B8A8_UNORM);
+  SourceTexture texture{desc, 4};
+
+  AssetPackageWriter writer{nullptr, GetParam()};
+  ASSERT_TRUE(writer.AddBuffer("buffer", buffer.data(), buffer.size()));
+  ASSERT_TRUE(writer.AddTexture("textures/array", desc, texture.data.data()));
+  EXPECT_FALSE(writer.AddBuffer("buffer", buffer.data(), 1));
+  ASSERT_TRUE(writer.Write(path_.c_str()));
+
+  AssetPackage package;
+  ASSERT_TRUE(package.Open(path_.c_str()));
+  EXPECT_EQ(2u, package.entry_count());
+  EXPECT_EQ(nullptr, package.Find("missing"));
+  EXPECT_EQ(nullptr, package.Find("buffe"));
+
+  const AssetEntry* entry = package.Find("buffer");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_STREQ("buffer", package.name(*entry));
+  EXPECT_EQ(AssetEntry::kBuffer, entry->type);
+  EXPECT_EQ(GetParam() ? AssetEntry::kChunkedLz : AssetEntry::kUncompressed,
+            entry->compression);
+  EXPECT_EQ(buffer, Load(package, *entry));
+
+  entry = package.Find("textures/array");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(0u, entry->data_offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+  EXPECT_TRUE(desc == d3dapp::GetAssetDesc(*entry));
+  const UINT count = d3dapp::GetAssetSubresourceCount(*entry);
+  ASSERT_EQ(6u, count);
+  std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(count);
+  std::vector<UINT> row_counts(count);
+  std::vector<UINT64> row_sizes(count);
+  UINT64 total_size = 0;
+  ASSERT_TRUE(d3dapp::CalculateFootprints(desc, 0, count, 0, layouts.data(),
+                                          row_counts.data(), row_sizes.data(),
+                                          &total_size));
+  EXPECT_EQ(total_size, entry->data_size);
+  // Rows land at the footprints' pitch, ready to copy as they are.
+  const std::vector<uint8_t> payload = Load(package, *entry);
+  for (UINT i = 0; i < count; ++i) {
+    for (UINT row = 0; row < row_counts[i]; ++row) {
+      const uint8_t* expected =
+          static_cast<const uint8_t*>(texture.data[i].pData) +
+          row * texture.row_pitches[i];
+      ASSERT_EQ(0, std::memcmp(payload.data() + layouts[i].Offset +
+                                   row * layouts[i].Footprint.RowPitch,
+                               expected, static_cast<size_t>(row_sizes[i])))
+          << "subresource " << i << " row " << row;
+    }
+  }
+}
+
+TEST_P(AssetPackageTest, CompressesTexturesToBlocks) {
+  const D3D12_RESOURCE_DESC desc =
+      Texture2D(16, 12, 1, 2, DXGI_FORMAT_BC1_UNORM);
+  SourceTexture texture{desc, 4};
+  AssetPackageWriter writer{nullptr, GetParam()};
+  d3dapp::BlockCompression compression{d3dapp::BlockCompression::kBc1};
+  ASSERT_TRUE(writer.AddTexture("bc1", desc, texture.data.data(),
+                                &compression));
+  ASSERT_TRUE(writer.Write(path_.c_str()));
+
+  AssetPackage package;
+  ASSERT_TRUE(package.Open(path_.c_str()));
+  const AssetEntry* entry = package.Find("bc1");
+  ASSERT_NE(nullptr, entry);
+  std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(2);
+  ASSERT_TRUE(d3dapp::CalculateFootprints(desc, 0, 2, 0, layouts.data(),
+                                          nullptr, nullptr, nullptr));
+  // The top mip is 4x3 blocks of 8 bytes.
+  const std::vector<uint8_t> payload = Load(package, *entry);
+  std::vector<uint8_t> blocks(layouts[0].Footprint.RowPitch * 3);
+  d3dapp::CompressImage(compression, texture.texels.data(), 16 * 4, 16, 12,
+                        blocks.data(), layouts[0].Footprint.RowPitch);
+  for (UINT row = 0; row < 3; ++row) {
+    const size_t offset = row * layouts[0].Footprint.RowPitch;
+    EXPECT_EQ(0, std::memcmp(payload.data() + offset, blocks.data() + offset,
+                             4 * 8));
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(Compress, AssetPackageTest, ::testing::Bool());
+
+class AssetPackageCorruptionTest : public ::testing::Test {
+ protected:
+  AssetPackageCorruptionTest()
+      : path_{::testing::TempDir() + "asset_package_corrupt.pkg"} {
+    AssetPackageWriter writer;
+    const uint8_t data[700] = {};
+    const char* names[] = {"a", "b", "c", "d", "e"};
+    for (const char* name : names) {
+      writer.AddBuffer(name, data, sizeof(data));
+    }
+    writer.Write(path_.c_str());
+    bytes_ = ReadFile(path_);
+    std::memcpy(&header_, bytes_.data(), sizeof(header_));
+  }
+  ~AssetPackageCorruptionTest() override { std::remove(path_.c_str()); }
+
+  uint32_t* slots() {
+    return reinterpret_cast<uint32_t*>(bytes_.data() + header_.slots_offset);
+  }
+  AssetEntry* entries() {
+    return reinterpret_cast<AssetEntry*>(bytes_.data() +
+                                         header_.entries_offset);
+  }
+  bool Opens() {
+    WriteFile(path_, bytes_);
+    AssetPackage package;
+    return package.Open(path_.c_str());
+  }
+
+  std::string path_;
+  std::vector<uint8_t> bytes_;
+  AssetPackageHeader header_;
+};
+
+TEST_F(AssetPackageCorruptionTest, OpensWhenIntact) {
+  EXPECT_TRUE(Opens());
+}
+
+TEST_F(AssetPackageCorruptionTest, RejectsBadHeaders) {
+  bytes_[0] ^= 1;
+  EXPECT_FALSE(Opens());
+  bytes_[0] ^= 1;
+  // A table with no room left to end a probe.
+  AssetPackageHeader header = header_;
+  header.slot_count = header.entry_count;
+  std::memcpy(bytes_.data(), &header, sizeof(header));
+  EXPECT_FALSE(Opens());
+}
+
+// Find probes until an empty slot, so a table whose every slot is taken
+// would loop forever.
+TEST_F(AssetPackageCorruptionTest, RejectsSlotsNamingAnEntryTwice) {
+  for (uint32_t i = 0; i < header_.slot_count; ++i) {
+    if (0 == slots()[i]) {
+      slots()[i] = 1;
+    }
+  }
+  EXPECT_FALSE(Opens());
+}
+
+TEST_F(AssetPackageCorruptionTest, RejectsEntriesWithoutASlot) {
+  for (uint32_t i = 0; i < header_.slot_count; ++i) {
+    if (3 == slots()[i]) {
+      slots()[i] = 0;
+    }
+  }
+  EXPECT_FALSE(Opens());
+}
+
+TEST_F(AssetPackageCorruptionTest, RejectsSlotsPastTheEntries) {
+  for (uint32_t i = 0; i < header_.slot_count; ++i) {
+    if (0 == slots()[i]) {
+      slots()[i] = header_.entry_count + 1;
+      break;
+    }
+  }
+  EXPECT_FALSE(Opens());
+}
+
+TEST_F(AssetPackageCorruptionTest, RejectsPayloadsOutsideTheFile) {
+  entries()[4].data_offset = bytes_.size();
+  EXPECT_FALSE(Opens());
+}
+
+TEST_F(AssetPackageCorruptionTest, RejectsUnterminatedNames) {
+  entries()[0].name_size = 2;
+  EXPECT_FALSE(Opens());
+}
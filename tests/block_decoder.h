@@ -0,0 +1,214 @@
+#pragma once
+
+#ifndef __BLOCK_DECODER_H__
+#define __BLOCK_DECODER_H__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "block_compression.h"
+
+namespace d3dapp {
+namespace testing {
+// Reference decoding of what CompressImage writes, per the D3D block
+// compression specs, to check it against the source image. BC7 handles
+// mode 6 only.
+class BlockDecoder {
+ public:
+  // Decodes a 4x4 block into 16 RGBA8 texels. Channels the format does not
+  // store are 0, and alpha is 255 for formats without it.
+  static bool DecodeBlock(BlockCompression::Format format,
+                          const uint8_t* block, uint8_t* texels) {
+    std::memset(texels, 0, 64);
+    for (int i = 0; i < 16; ++i) {
+      texels[i * 4 + 3] = 255;
+    }
+    switch (format) {
+      case BlockCompression::kBc1:
+        DecodeColor(block, true, texels);
+        return true;
+      case BlockCompression::kBc3:
+        DecodeAlpha(block, texels + 3);
+        DecodeColor(block + 8, false, texels);
+        return true;
+      case BlockCompression::kBc4:
+        DecodeAlpha(block, texels);
+        return true;
+      case BlockCompression::kBc5:
+        DecodeAlpha(block, texels);
+        DecodeAlpha(block + 8, texels + 1);
+        return true;
+      case BlockCompression::kBc7:
+        return DecodeBc7Mode6(block, texels);
+    }
+    return false;
+  }
+
+  // Decodes width x height texels from rows of blocks row_pitch apart.
+  static bool DecodeImage(BlockCompression::Format format,
+                          const uint8_t* blocks, size_t row_pitch,
+                          uint32_t width, uint32_t height,
+                          std::vector<uint8_t>* image) {
+    image->assign(static_cast<size_t>(width) * height * 4, 0);
+    const size_t block_size = BlockSize(format);
+    uint8_t texels[64];
+    for (uint32_t y = 0; y < height; y += 4) {
+      for (uint32_t x = 0; x < width; x += 4) {
+        if (!DecodeBlock(format, blocks + row_pitch * (y / 4) +
+                                     block_size * (x / 4),
+                         texels)) {
+          return false;
+        }
+        for (uint32_t i = 0; i < 16; ++i) {
+          uint32_t texel_x = x + i % 4;
+          uint32_t texel_y = y + i / 4;
+          if (texel_x < width && texel_y < height) {
+            std::memcpy(image->data() + (texel_y * width + texel_x) * 4,
+                        texels + i * 4, 4);
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  // Over the channels the format stores.
+  static double Psnr(BlockCompression::Format format,
+                     const std::vector<uint8_t>& expected,
+                     const std::vector<uint8_t>& actual) {
+    int channel_count = 4;
+    if (BlockCompression::kBc1 == format) {
+      channel_count = 3;
+    } else if (BlockCompression::kBc4 == format) {
+      channel_count = 1;
+    } else if (BlockCompression::kBc5 == format) {
+      channel_count = 2;
+    }
+    double error = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < expected.size(); i += 4) {
+      for (int c = 0; c < channel_count; ++c) {
+        double difference =
+            static_cast<double>(expected[i + c]) - actual[i + c];
+        error += difference * difference;
+        ++count;
+      }
+    }
+    if (0.0 == error) {
+      return 99.0;
+    }
+    return 10.0 * std::log10(255.0 * 255.0 * count / error);
+  }
+
+ private:
+  static int Expand(int value, int bits) {
+    return value << (8 - bits) | value >> (2 * bits - 8);
+  }
+
+  // BC1 color block; BC3's is always in four color mode.
+  static void DecodeColor(const uint8_t* block, bool three_color_mode,
+                          uint8_t* texels) {
+    const int color0 = block[0] | block[1] << 8;
+    const int color1 = block[2] | block[3] << 8;
+    int palette[4][4];
+    const int packed[2] = {color0, color1};
+    for (int e = 0; e < 2; ++e) {
+      palette[e][0] = Expand(packed[e] >> 11, 5);
+      palette[e][1] = Expand(packed[e] >> 5 & 63, 6);
+      palette[e][2] = Expand(packed[e] & 31, 5);
+      palette[e][3] = 255;
+    }
+    for (int c = 0; c < 4; ++c) {
+      if (color0 > color1 || !three_color_mode) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+      } else {
+        palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        palette[3][c] = 0;
+      }
+    }
+    uint32_t bits;
+    std::memcpy(&bits, block + 4, sizeof(bits));
+    for (int i = 0; i < 16; ++i) {
+      const int* color = palette[bits >> (i * 2) & 3];
+      for (int c = 0; c < 3; ++c) {
+        texels[i * 4 + c] = static_cast<uint8_t>(color[c]);
+      }
+      if (three_color_mode) {
+        texels[i * 4 + 3] = static_cast<uint8_t>(color[3]);
+      }
+    }
+  }
+
+  // BC4 block into every fourth byte of texels.
+  static void DecodeAlpha(const uint8_t* block, uint8_t* texels) {
+    const int e0 = block[0];
+    const int e1 = block[1];
+    int palette[8] = {e0, e1};
+    for (int i = 2; i < 8; ++i) {
+      if (e0 > e1) {
+        palette[i] = ((8 - i) * e0 + (i - 1) * e1 + 3) / 7;
+      } else if (i < 6) {
+        palette[i] = ((6 - i) * e0 + (i - 1) * e1 + 2) / 5;
+      } else {
+        palette[i] = 6 == i ? 0 : 255;
+      }
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) {
+      bits |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+    }
+    for (int i = 0; i < 16; ++i) {
+      texels[i * 4] = static_cast<uint8_t>(palette[bits >> (i * 3) & 7]);
+    }
+  }
+
+  static uint32_t ReadBits(const uint8_t* block, int* position, int count) {
+    uint32_t value = 0;
+    for (int i = 0; i < count; ++i, ++*position) {
+      value |= static_cast<uint32_t>(block[*position >> 3] >>
+                                     (*position & 7) & 1)
+               << i;
+    }
+    return value;
+  }
+
+  static bool DecodeBc7Mode6(const uint8_t* block, uint8_t* texels) {
+    static const int kWeights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                     34, 38, 43, 47, 51, 55, 60, 64};
+    int position = 0;
+    if (64 != ReadBits(block, &position, 7)) {
+      return false;
+    }
+    int endpoints[2][4];
+    for (int c = 0; c < 4; ++c) {
+      endpoints[0][c] = static_cast<int>(ReadBits(block, &position, 7));
+      endpoints[1][c] = static_cast<int>(ReadBits(block, &position, 7));
+    }
+    for (int e = 0; e < 2; ++e) {
+      const int parity = static_cast<int>(ReadBits(block, &position, 1));
+      for (int c = 0; c < 4; ++c) {
+        endpoints[e][c] = endpoints[e][c] << 1 | parity;
+      }
+    }
+    for (int i = 0; i < 16; ++i) {
+      const int weight =
+          kWeights[ReadBits(block, &position, 0 == i ? 3 : 4)];
+      for (int c = 0; c < 4; ++c) {
+        texels[i * 4 + c] = static_cast<uint8_t>(
+            ((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] +
+             32) >>
+            6);
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace testing
+}  // namespace d3dapp
+
+#endif  // !__BLOCK_DECODER_H__
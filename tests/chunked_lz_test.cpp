@@ -0,0 +1,197 @@
+#include "chunked_lz.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "job_system.h"
+
+namespace {
+using d3dapp::ChunkedLzHeader;
+
+constexpr uint64_t kChunkSize = ChunkedLzHeader::kChunkSize;
+
+// Kinds of payload the container sees, from incompressible to runs.
+enum Corpus { kRandom, kVertices, kHeightmap, kRuns };
+
+std::vector<uint8_t> MakeCorpus(Corpus corpus, size_t size) {
+  std::vector<uint8_t> data(size);
+  std::mt19937 random{static_cast<uint32_t>(corpus) + 1};
+  for (size_t i = 0; i < size; ++i) {
+    switch (corpus) {
+      case kRandom:
+        data[i] = static_cast<uint8_t>(random());
+        break;
+      case kVertices:
+        // 32 byte vertices: a varying position, a repeated normal and uv.
+        data[i] = i % 32 < 12 ? static_cast<uint8_t>(random() % 4 + i / 97)
+                              : static_cast<uint8_t>(i % 32);
+        break;
+      case kHeightmap: {
+        // Smooth R16 texels.
+        const uint16_t height = static_cast<uint16_t>(
+            32768 + 20000 * std::sin(static_cast<double>(i / 2) / 300.0));
+        data[i] = static_cast<uint8_t>(i % 2 ? height >> 8 : height);
+        break;
+      }
+      case kRuns:
+        data[i] = static_cast<uint8_t>(i / 5000);
+        break;
+    }
+  }
+  return data;
+}
+
+std::vector<uint8_t> Compress(const std::vector<uint8_t>& data,
+                              uint32_t delta_stride,
+                              d3dapp::JobSystem* job_system = nullptr) {
+  std::vector<uint8_t> compressed;
+  d3dapp::CompressChunked(data.data(), data.size(), delta_stride, &compressed,
+                          job_system);
+  return compressed;
+}
+
+}  // namespace
+
+TEST(ChunkedLzTest, RoundTripsEveryCorpusAndStride) {
+  const size_t sizes[] = {0, 1, 15, 1000, kChunkSize, kChunkSize + 1,
+                          3 * kChunkSize + 777};
+  const uint32_t strides[] = {0, 1, 2, 3, 4, 8};
+  for (Corpus corpus : {kRandom, kVertices, kHeightmap, kRuns}) {
+    for (size_t size : sizes) {
+      const std::vector<uint8_t> data = MakeCorpus(corpus, size);
+      for (uint32_t stride : strides) {
+        const std::vector<uint8_t> compressed = Compress(data, stride);
+        uint64_t decompressed_size = 0;
+        ASSERT_TRUE(d3dapp::GetDecompressedSize(
+            compressed.data(), compressed.size(), &decompressed_size));
+        ASSERT_EQ(size, decompressed_size);
+        std::vector<uint8_t> decompressed(size);
+        ASSERT_TRUE(d3dapp::DecompressChunked(compressed.data(),
+                                              compressed.size(),
+                                              decompressed.data(), size))
+            << "corpus " << corpus << " size " << size << " stride "
+            << stride;
+        ASSERT_EQ(data, decompressed) << "corpus " << corpus << " size "
+                                      << size << " stride " << stride;
+      }
+    }
+  }
+}
+
+TEST(ChunkedLzTest, CompressesWhatIsCompressible) {
+  const size_t size = 8 * kChunkSize;
+  EXPECT_LT(Compress(MakeCorpus(kRuns, size), 0).size(), size / 50);
+  EXPECT_LT(Compress(MakeCorpus(kVertices, size), 0).size(), size / 2);
+  // Delta coding is what makes smooth data compress.
+  const std::vector<uint8_t> heightmap = MakeCorpus(kHeightmap, size);
+  EXPECT_LT(Compress(heightmap, 2).size(), Compress(heightmap, 0).size());
+  // Chunks that do not shrink are stored, so random data barely grows.
+  const size_t table_size =
+      sizeof(ChunkedLzHeader) + 8 * sizeof(uint64_t);
+  EXPECT_EQ(size + table_size, Compress(MakeCorpus(kRandom, size), 0).size());
+}
+
+TEST(ChunkedLzTest, JobsProduceTheSameContainer) {
+  d3dapp::JobSystem job_system{3};
+  const std::vector<uint8_t> data = MakeCorpus(kVertices, 9 * kChunkSize + 5);
+  const std::vector<uint8_t> compressed = Compress(data, 4);
+  EXPECT_EQ(compressed, Compress(data, 4, &job_system));
+  std::vector<uint8_t> decompressed(data.size());
+  ASSERT_TRUE(d3dapp::DecompressChunked(compressed.data(), compressed.size(),
+                                        decompressed.data(),
+                                        decompressed.size(), &job_system));
+  EXPECT_EQ(data, decompressed);
+}
+
+TEST(ChunkedLzTest, RejectsTheWrongDestSize) {
+  const std::vector<uint8_t> data = MakeCorpus(kVertices, 5000);
+  const std::vector<uint8_t> compressed = Compress(data, 0);
+  std::vector<uint8_t> decompressed(data.size() + 1);
+  EXPECT_FALSE(d3dapp::DecompressChunked(compressed.data(), compressed.size(),
+                                         decompressed.data(), data.size() + 1));
+  EXPECT_FALSE(d3dapp::DecompressChunked(compressed.data(), compressed.size(),
+                                         decompressed.data(), data.size() - 1));
+}
+
+TEST(ChunkedLzTest, RejectsBrokenHeadersAndTables) {
+  const std::vector<uint8_t> data = MakeCorpus(kVertices, 3 * kChunkSize);
+  const std::vector<uint8_t> compressed = Compress(data, 0);
+  std::vector<uint8_t> decompressed(data.size());
+  auto decompress = [&](const std::vector<uint8_t>& container) {
+    return d3dapp::DecompressChunked(container.data(), container.size(),
+                                     decompressed.data(), data.size());
+  };
+  uint64_t size = 0;
+  EXPECT_FALSE(d3dapp::GetDecompressedSize(compressed.data(), 23, &size));
+
+  std::vector<uint8_t> broken = compressed;
+  broken[0] ^= 1;
+  EXPECT_FALSE(d3dapp::GetDecompressedSize(broken.data(), broken.size(),
+                                           &size));
+  EXPECT_FALSE(decompress(broken));
+
+  ChunkedLzHeader header;
+  std::memcpy(&header, compressed.data(), sizeof(header));
+  broken = compressed;
+  ChunkedLzHeader bad = header;
+  bad.chunk_size = 4096;
+  std::memcpy(broken.data(), &bad, sizeof(bad));
+  EXPECT_FALSE(decompress(broken));
+  bad = header;
+  bad.chunk_count = 2;
+  std::memcpy(broken.data(), &bad, sizeof(bad));
+  EXPECT_FALSE(decompress(broken));
+
+  // Chunk ends that go backwards or past the data.
+  broken = compressed;
+  uint64_t end = 0;
+  std::memcpy(broken.data() + sizeof(header) + 8, &end, sizeof(end));
+  EXPECT_FALSE(decompress(broken));
+  broken = compressed;
+  end = compressed.size();
+  std::memcpy(broken.data() + sizeof(header) + 16, &end, sizeof(end));
+  EXPECT_FALSE(decompress(broken));
+
+  // Truncated anywhere.
+  for (size_t size : {sizeof(header), sizeof(header) + 20,
+                      compressed.size() / 2, compressed.size() - 1}) {
+    broken.assign(compressed.begin(), compressed.begin() + size);
+    EXPECT_FALSE(decompress(broken)) << "size " << size;
+  }
+}
+
+// Random damage to the compressed chunks must make decompression fail or
+// produce some dest_size bytes, never read or write out of bounds. Build
+// with D3DAPP_SANITIZE to have ASan and UBSan check that; fuzz/ has a
+// libFuzzer target for going further.
+TEST(ChunkedLzTest, SurvivesCorruptChunks) {
+  std::mt19937 random{7};
+  for (Corpus corpus : {kVertices, kHeightmap, kRuns}) {
+    const std::vector<uint8_t> data = MakeCorpus(corpus, 2 * kChunkSize + 999);
+    const std::vector<uint8_t> compressed = Compress(data, corpus == kHeightmap
+                                                               ? 2
+                                                               : 0);
+    const size_t data_offset = sizeof(ChunkedLzHeader) + 3 * sizeof(uint64_t);
+    std::vector<uint8_t> decompressed(data.size());
+    for (int trial = 0; trial < 300; ++trial) {
+      std::vector<uint8_t> broken = compressed;
+      const int damage = 1 + static_cast<int>(random() % 8);
+      for (int i = 0; i < damage; ++i) {
+        const size_t at =
+            data_offset + random() % (broken.size() - data_offset);
+        if (random() % 2) {
+          broken[at] ^= static_cast<uint8_t>(1u << (random() % 8));
+        } else {
+          broken[at] = static_cast<uint8_t>(random());
+        }
+      }
+      d3dapp::DecompressChunked(broken.data(), broken.size(),
+                                decompressed.data(), decompressed.size());
+    }
+  }
+}
@@ -0,0 +1,238 @@
+#include "command_list_sequence.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+constexpr uint32_t kCommon = 0;
+constexpr uint32_t kRenderTarget = 0x4;
+constexpr uint32_t kShaderResource = 0x40;
+
+struct FakeList {
+  int id;
+  bool open;
+  std::vector<d3dapp::TrackedBarrier> barriers;
+};
+
+// Records what the sequence asks of its lists.
+class FakeLists : public d3dapp::CommandListSequence::Lists {
+ public:
+  explicit FakeLists(std::vector<std::string>* log) : log_{log} {}
+  ~FakeLists() override {
+    for (FakeList* list : lists_) {
+      delete list;
+    }
+  }
+
+  void* Create() override {
+    lists_.push_back(new FakeList{static_cast<int>(lists_.size()), true, {}});
+    log_->push_back("create " + std::to_string(lists_.back()->id));
+    return lists_.back();
+  }
+
+  void Recycle(void* list) override {
+    log_->push_back("recycle " + std::to_string(ToList(list)->id));
+  }
+
+  void Reopen(void* list) override {
+    ToList(list)->open = true;
+    ToList(list)->barriers.clear();
+    log_->push_back("reopen " + std::to_string(ToList(list)->id));
+  }
+
+  void IssueBarriers(void* list, const d3dapp::TrackedBarrier* barriers,
+                     size_t count) override {
+    ToList(list)->barriers.insert(ToList(list)->barriers.end(), barriers,
+                                  barriers + count);
+    log_->push_back("barriers " + std::to_string(ToList(list)->id));
+  }
+
+  static FakeList* ToList(void* list) { return static_cast<FakeList*>(list); }
+
+ private:
+  std::vector<std::string>* log_;
+  std::vector<FakeList*> lists_;
+};
+
+std::unique_ptr<d3dapp::CommandListSequence::Lists> MakeLists(
+    std::vector<std::string>* log) {
+  return std::unique_ptr<d3dapp::CommandListSequence::Lists>{
+      new FakeLists{log}};
+}
+
+int Id(void* list) { return FakeLists::ToList(list)->id; }
+
+}  // namespace
+
+TEST(CommandListSequenceTest, SubmitsInAcquisitionOrder) {
+  std::vector<std::string> log;
+  d3dapp::CommandListSequence sequence{MakeLists(&log)};
+  void* a = sequence.Acquire();
+  void* b = sequence.Acquire();
+  void* c = sequence.Acquire();
+
+  std::vector<void*> submission;
+  sequence.Execute(submission);
+  EXPECT_EQ((std::vector<void*>{a, b, c}), submission);
+}
+
+TEST(CommandListSequenceTest, ReusesListsAfterReset) {
+  std::vector<std::string> log;
+  d3dapp::CommandListSequence sequence{MakeLists(&log)};
+  void* a = sequence.Acquire();
+  void* b = sequence.Acquire();
+  std::vector<void*> submission;
+  sequence.Execute(submission);
+
+  sequence.Reset();
+  EXPECT_EQ(0, sequence.size());
+  EXPECT_EQ(a, sequence.Acquire());
+  EXPECT_EQ(1, sequence.size());
+  EXPECT_EQ(2, sequence.created_count());
+
+  // Only the lists used by the previous frame are recycled.
+  sequence.Execute(submission);
+  sequence.Reset();
+  EXPECT_EQ(a, sequence.Acquire());
+  EXPECT_EQ(b, sequence.Acquire());
+  void* c = sequence.Acquire();
+  EXPECT_EQ(3, sequence.created_count());
+  EXPECT_EQ((std::vector<std::string>{"create 0", "create 1", "recycle 0",
+                                      "recycle 1", "reopen 0", "recycle 0",
+                                      "reopen 0", "reopen 1", "create 2"}),
+            log);
+  EXPECT_EQ(2, Id(c));
+}
+
+TEST(CommandListSequenceTest, ResetClearsStateTrackers) {
+  std::vector<std::string> log;
+  d3dapp::ResourceStateRegistry registry;
+  int resource = 0;
+  registry.Register(&resource, 1, kCommon);
+  d3dapp::CommandListSequence sequence{MakeLists(&log), &registry};
+
+  void* list = sequence.Acquire();
+  sequence.state_tracker(list)->Transition(&resource, d3dapp::kAllSubresources,
+                                           kShaderResource);
+  sequence.Reset();
+  EXPECT_EQ(nullptr, sequence.state_tracker(list));
+
+  list = sequence.Acquire();
+  std::vector<void*> submission;
+  sequence.Execute(submission);
+  EXPECT_EQ(1u, submission.size());
+  EXPECT_TRUE(FakeLists::ToList(list)->barriers.empty());
+}
+
+TEST(CommandListSequenceTest, FlushBarriersIssuesTrackedBarriers) {
+  std::vector<std::string> log;
+  d3dapp::CommandListSequence sequence{MakeLists(&log)};
+  int resource = 0;
+  void* list = sequence.Acquire();
+  d3dapp::ResourceStateTracker* tracker = sequence.state_tracker(list);
+  tracker->Assume(&resource, kCommon);
+  tracker->Transition(&resource, d3dapp::kAllSubresources, kRenderTarget);
+  tracker->UavBarrier(&resource);
+
+  sequence.FlushBarriers(list);
+  const std::vector<d3dapp::TrackedBarrier>& barriers =
+      FakeLists::ToList(list)->barriers;
+  ASSERT_EQ(2u, barriers.size());
+  EXPECT_EQ(d3dapp::TrackedBarrier::kTransition, barriers[0].type);
+  EXPECT_EQ(kCommon, barriers[0].before);
+  EXPECT_EQ(kRenderTarget, barriers[0].after);
+  EXPECT_EQ(d3dapp::TrackedBarrier::kUav, barriers[1].type);
+
+  // Nothing left to flush.
+  log.clear();
+  sequence.FlushBarriers(list);
+  EXPECT_TRUE(log.empty());
+}
+
+TEST(CommandListSequenceTest, ResolvedBarriersGoAtEndOfPreviousList) {
+  std::vector<std::string> log;
+  d3dapp::ResourceStateRegistry registry;
+  int resource = 0;
+  registry.Register(&resource, 1, kRenderTarget);
+  d3dapp::CommandListSequence sequence{MakeLists(&log), &registry};
+
+  void* first = sequence.Acquire();
+  void* second = sequence.Acquire();
+  sequence.state_tracker(second)->Transition(
+      &resource, d3dapp::kAllSubresources, kShaderResource);
+  sequence.FlushBarriers(second);
+
+  std::vector<void*> submission;
+  sequence.Execute(submission);
+  EXPECT_EQ((std::vector<void*>{first, second}), submission);
+  const std::vector<d3dapp::TrackedBarrier>& barriers =
+      FakeLists::ToList(first)->barriers;
+  ASSERT_EQ(1u, barriers.size());
+  EXPECT_EQ(&resource, barriers[0].resource);
+  EXPECT_EQ(kRenderTarget, barriers[0].before);
+  EXPECT_EQ(kShaderResource, barriers[0].after);
+  EXPECT_TRUE(FakeLists::ToList(second)->barriers.empty());
+  EXPECT_EQ(kShaderResource, registry.State(&resource, 0));
+}
+
+TEST(CommandListSequenceTest, FirstListBarriersGetAHeadList) {
+  std::vector<std::string> log;
+  d3dapp::ResourceStateRegistry registry;
+  int resource = 0;
+  registry.Register(&resource, 1, kCommon);
+  d3dapp::CommandListSequence sequence{MakeLists(&log), &registry};
+
+  void* first = sequence.Acquire();
+  void* second = sequence.Acquire();
+  sequence.state_tracker(first)->Transition(
+      &resource, d3dapp::kAllSubresources, kRenderTarget);
+  sequence.state_tracker(second)->Transition(
+      &resource, d3dapp::kAllSubresources, kRenderTarget);
+
+  std::vector<void*> submission;
+  sequence.Execute(submission);
+  ASSERT_EQ(3u, submission.size());
+  void* head = submission[0];
+  EXPECT_EQ(first, submission[1]);
+  EXPECT_EQ(second, submission[2]);
+  ASSERT_EQ(1u, FakeLists::ToList(head)->barriers.size());
+  EXPECT_EQ(kRenderTarget, FakeLists::ToList(head)->barriers[0].after);
+  // The second list finds the resource where the first left it.
+  EXPECT_TRUE(FakeLists::ToList(first)->barriers.empty());
+
+  // The head list is recycled and reused like any other.
+  sequence.Reset();
+  EXPECT_EQ(first, sequence.Acquire());
+  EXPECT_EQ(second, sequence.Acquire());
+  EXPECT_EQ(head, sequence.Acquire());
+  EXPECT_EQ(3, sequence.created_count());
+}
+
+TEST(CommandListSequenceTest, LaterListsChainThroughTheRegistry) {
+  std::vector<std::string> log;
+  d3dapp::ResourceStateRegistry registry;
+  int resource = 0;
+  registry.Register(&resource, 1, kCommon);
+  d3dapp::CommandListSequence sequence{MakeLists(&log), &registry};
+
+  void* lists[3];
+  const uint32_t states[3]{kCommon, kRenderTarget, kShaderResource};
+  for (int i = 0; i < 3; ++i) {
+    lists[i] = sequence.Acquire();
+    sequence.state_tracker(lists[i])->Transition(
+        &resource, d3dapp::kAllSubresources, states[i]);
+  }
+
+  std::vector<void*> submission;
+  sequence.Execute(submission);
+  EXPECT_EQ((std::vector<void*>{lists[0], lists[1], lists[2]}), submission);
+  ASSERT_EQ(1u, FakeLists::ToList(lists[0])->barriers.size());
+  EXPECT_EQ(kCommon, FakeLists::ToList(lists[0])->barriers[0].before);
+  EXPECT_EQ(kRenderTarget, FakeLists::ToList(lists[0])->barriers[0].after);
+  ASSERT_EQ(1u, FakeLists::ToList(lists[1])->barriers.size());
+  EXPECT_EQ(kRenderTarget, FakeLists::ToList(lists[1])->barriers[0].before);
+  EXPECT_EQ(kShaderResource, FakeLists::ToList(lists[1])->barriers[0].after);
+  EXPECT_EQ(kShaderResource, registry.State(&resource, 0));
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef __COMPAT_D3DX12_H__
+#define __COMPAT_D3DX12_H__
+
+// The d3dx12.h helpers the device-free sources use. See windows.h.
+
+#include "d3d12.h"
+
+inline bool operator==(const D3D12_RESOURCE_DESC& l,
+                       const D3D12_RESOURCE_DESC& r) {
+  return l.Dimension == r.Dimension && l.Alignment == r.Alignment &&
+         l.Width == r.Width && l.Height == r.Height &&
+         l.DepthOrArraySize == r.DepthOrArraySize &&
+         l.MipLevels == r.MipLevels && l.Format == r.Format &&
+         l.SampleDesc.Count == r.SampleDesc.Count &&
+         l.SampleDesc.Quality == r.SampleDesc.Quality &&
+         l.Layout == r.Layout && l.Flags == r.Flags;
+}
+
+inline bool operator!=(const D3D12_RESOURCE_DESC& l,
+                       const D3D12_RESOURCE_DESC& r) {
+  return !(l == r);
+}
+
+struct CD3DX12_RESOURCE_DESC : D3D12_RESOURCE_DESC {
+  CD3DX12_RESOURCE_DESC() = default;
+  CD3DX12_RESOURCE_DESC(D3D12_RESOURCE_DIMENSION dimension, UINT64 alignment,
+                        UINT64 width, UINT height, UINT16 depth_or_array_size,
+                        UINT16 mip_levels, DXGI_FORMAT format,
+                        UINT sample_count, UINT sample_quality,
+                        D3D12_TEXTURE_LAYOUT layout,
+                        D3D12_RESOURCE_FLAGS flags) {
+    Dimension = dimension;
+    Alignment = alignment;
+    Width = width;
+    Height = height;
+    DepthOrArraySize = depth_or_array_size;
+    MipLevels = mip_levels;
+    Format = format;
+    SampleDesc.Count = sample_count;
+    SampleDesc.Quality = sample_quality;
+    Layout = layout;
+    Flags = flags;
+  }
+
+  static CD3DX12_RESOURCE_DESC Buffer(
+      UINT64 width, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE,
+      UINT64 alignment = 0) {
+    return CD3DX12_RESOURCE_DESC{D3D12_RESOURCE_DIMENSION_BUFFER,
+                                 alignment,
+                                 width,
+                                 1,
+                                 1,
+                                 1,
+                                 DXGI_FORMAT_UNKNOWN,
+                                 1,
+                                 0,
+                                 D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+                                 flags};
+  }
+};
+
+#endif  // !__COMPAT_D3DX12_H__
@@ -0,0 +1,8 @@
+#pragma once
+
+#ifndef __COMPAT_TCHAR_H__
+#define __COMPAT_TCHAR_H__
+
+// See windows.h.
+
+#endif  // !__COMPAT_TCHAR_H__
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifndef __COMPAT_WINDOWS_H__
+#define __COMPAT_WINDOWS_H__
+
+// Just enough of windows.h for the device-free sources and their tests to
+// build on other platforms. Never used on Windows.
+
+#include <cstdint>
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef uint32_t DWORD;
+typedef long HRESULT;
+typedef intptr_t LONG_PTR;
+typedef unsigned int UINT;
+typedef uint16_t UINT16;
+typedef uint64_t UINT64;
+typedef unsigned long ULONG;
+
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+#define S_OK static_cast<HRESULT>(0)
+#define E_FAIL static_cast<HRESULT>(0x80004005L)
+#define E_OUTOFMEMORY static_cast<HRESULT>(0x8007000EL)
+#define E_INVALIDARG static_cast<HRESULT>(0x80070057L)
+
+struct IUnknown {
+  virtual ULONG AddRef() = 0;
+  virtual ULONG Release() = 0;
+};
+
+#endif  // !__COMPAT_WINDOWS_H__
@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef __COMPAT_WRL_H__
+#define __COMPAT_WRL_H__
+
+// ComPtr as far as the device-free sources and their tests use it. See
+// windows.h.
+
+#include <cstddef>
+#include <utility>
+
+#include "windows.h"
+
+namespace Microsoft {
+namespace WRL {
+template <typename T>
+class ComPtr {
+ public:
+  ComPtr() = default;
+  ComPtr(std::nullptr_t) {}
+  ComPtr(T* object) : object_{object} { AddRef(); }
+  ComPtr(const ComPtr& other) : object_{other.object_} { AddRef(); }
+  ComPtr(ComPtr&& other) : object_{other.Detach()} {}
+  ~ComPtr() { Reset(); }
+
+  ComPtr& operator=(ComPtr other) {
+    std::swap(object_, other.object_);
+    return *this;
+  }
+
+  T* Get() const { return object_; }
+  T* operator->() const { return object_; }
+  explicit operator bool() const { return nullptr != object_; }
+
+  T** GetAddressOf() { return &object_; }
+  T** ReleaseAndGetAddressOf() {
+    Reset();
+    return &object_;
+  }
+  T** operator&() { return ReleaseAndGetAddressOf(); }
+
+  T* Detach() {
+    T* object = object_;
+    object_ = nullptr;
+    return object;
+  }
+
+  ULONG Reset() {
+    ULONG count = 0;
+    if (object_) {
+      count = object_->Release();
+      object_ = nullptr;
+    }
+    return count;
+  }
+
+ private:
+  void AddRef() {
+    if (object_) {
+      object_->AddRef();
+    }
+  }
+
+  T* object_{nullptr};
+};
+
+}  // namespace WRL
+}  // namespace Microsoft
+
+#endif  // !__COMPAT_WRL_H__
@@ -0,0 +1,167 @@
+#include "deferred_release_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+// Counts its references and checks that the last one goes only once the
+// fence value it was dropped at has completed.
+class FakeObject final : public IUnknown {
+ public:
+  FakeObject(const std::atomic<uint64_t>* completed, uint64_t dropped_at,
+             std::atomic<int>* freed, std::atomic<int>* early)
+      : completed_{completed},
+        dropped_at_{dropped_at},
+        freed_{freed},
+        early_{early} {}
+
+  ULONG AddRef() override { return ++references_; }
+
+  ULONG Release() override {
+    ULONG references = --references_;
+    if (0 == references) {
+      if (completed_->load() < dropped_at_) {
+        early_->fetch_add(1);
+      }
+      freed_->fetch_add(1);
+      delete this;
+    }
+    return references;
+  }
+
+ private:
+  const std::atomic<uint64_t>* completed_;
+  uint64_t dropped_at_;
+  std::atomic<int>* freed_;
+  std::atomic<int>* early_;
+  std::atomic<ULONG> references_{1};
+};
+
+}  // namespace
+
+TEST(DeferredReleaseQueueTest, FreesOnceTheFenceValueCompletes) {
+  std::atomic<uint64_t> completed{0};
+  std::atomic<int> freed{0};
+  std::atomic<int> early{0};
+  d3dapp::DeferredReleaseQueue queue;
+
+  int deleted = 0;
+  for (uint64_t value = 1; value <= 3; ++value) {
+    queue.SetFenceValue(value);
+    queue.Release(new FakeObject{&completed, value, &freed, &early});
+    queue.Release(new FakeObject{&completed, value, &freed, &early});
+    queue.Release([&deleted]() { ++deleted; });
+  }
+
+  EXPECT_EQ(0u, queue.Collect(0));
+  completed = 1;
+  EXPECT_EQ(3u, queue.Collect(1));
+  EXPECT_EQ(2, freed.load());
+  EXPECT_EQ(1, deleted);
+  EXPECT_EQ(0u, queue.Collect(1));
+
+  completed = 3;
+  EXPECT_EQ(6u, queue.Collect(3));
+  EXPECT_EQ(6, freed.load());
+  EXPECT_EQ(3, deleted);
+  EXPECT_EQ(0, early.load());
+}
+
+TEST(DeferredReleaseQueueTest, ComPtrReleaseTakesTheReference) {
+  std::atomic<uint64_t> completed{0};
+  std::atomic<int> freed{0};
+  std::atomic<int> early{0};
+  d3dapp::DeferredReleaseQueue queue;
+  queue.SetFenceValue(1);
+
+  Microsoft::WRL::ComPtr<IUnknown> object;
+  *object.GetAddressOf() = new FakeObject{&completed, 1, &freed, &early};
+  queue.Release(object);
+  EXPECT_FALSE(object);
+  Microsoft::WRL::ComPtr<IUnknown> empty;
+  queue.Release(empty);
+
+  completed = 1;
+  EXPECT_EQ(1u, queue.Collect(1));
+  EXPECT_EQ(1, freed.load());
+}
+
+TEST(DeferredReleaseQueueTest, DestructionFlushes) {
+  std::atomic<uint64_t> completed{UINT64_MAX};
+  std::atomic<int> freed{0};
+  std::atomic<int> early{0};
+  int deleted = 0;
+  {
+    d3dapp::DeferredReleaseQueue queue;
+    queue.SetFenceValue(100);
+    queue.Release(new FakeObject{&completed, 100, &freed, &early});
+    queue.Release([&deleted]() { ++deleted; });
+  }
+  EXPECT_EQ(1, freed.load());
+  EXPECT_EQ(1, deleted);
+}
+
+// Producers drop objects while the render thread advances the fence value
+// and collects with the GPU a few frames behind. Nothing may be freed
+// before the frame it was dropped in completes, and everything is freed by
+// the final Flush.
+TEST(DeferredReleaseQueueTest, ConcurrentReleaseAndCollect) {
+  constexpr int kProducers = 4;
+  constexpr int kPerProducer = 20000;
+  constexpr uint64_t kFramesInFlight = 3;
+
+  std::atomic<uint64_t> completed{0};
+  std::atomic<uint64_t> frame{1};
+  std::atomic<int> freed{0};
+  std::atomic<int> early{0};
+  std::atomic<int> deleted{0};
+  std::atomic<int> producing{kProducers};
+  d3dapp::DeferredReleaseQueue queue;
+  queue.SetFenceValue(1);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p]() {
+      for (int i = 0; i < kPerProducer; ++i) {
+        // The queue tags with this value or a later one.
+        uint64_t dropped_at = frame.load();
+        if ((i + p) % 4) {
+          queue.Release(new FakeObject{&completed, dropped_at, &freed,
+                                       &early});
+        } else {
+          queue.Release([&, dropped_at]() {
+            if (completed.load() < dropped_at) {
+              early.fetch_add(1);
+            }
+            deleted.fetch_add(1);
+          });
+        }
+      }
+      producing.fetch_sub(1);
+    });
+  }
+
+  size_t collected = 0;
+  while (producing.load() > 0) {
+    uint64_t next = frame.load() + 1;
+    queue.SetFenceValue(next);
+    frame = next;
+    if (next > kFramesInFlight) {
+      completed = next - kFramesInFlight;
+      collected += queue.Collect(completed.load());
+    }
+    std::this_thread::yield();
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  completed = UINT64_MAX;
+  collected += queue.Flush();
+
+  EXPECT_EQ(0, early.load());
+  EXPECT_EQ(size_t{kProducers} * kPerProducer, collected);
+  EXPECT_EQ(kProducers * kPerProducer, freed.load() + deleted.load());
+}
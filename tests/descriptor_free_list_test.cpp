@@ -0,0 +1,120 @@
+#include "descriptor_allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+TEST(DescriptorFreeListTest, HandsOutEverySlotOnce) {
+  d3dapp::DescriptorFreeList list{8};
+  std::vector<uint32_t> indices;
+  uint32_t index = 0;
+  while (list.Allocate(&index)) {
+    indices.push_back(index);
+  }
+  // In order while nothing has been freed.
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 2, 3, 4, 5, 6, 7}), indices);
+  EXPECT_EQ(0u, list.free_count());
+}
+
+TEST(DescriptorFreeListTest, ExhaustionFails) {
+  d3dapp::DescriptorFreeList list{2};
+  uint32_t index = 0;
+  ASSERT_TRUE(list.Allocate(&index));
+  ASSERT_TRUE(list.Allocate(&index));
+  index = 99;
+  EXPECT_FALSE(list.Allocate(&index));
+  EXPECT_EQ(99u, index);
+
+  list.Free(0);
+  ASSERT_TRUE(list.Allocate(&index));
+  EXPECT_EQ(0u, index);
+  EXPECT_FALSE(list.Allocate(&index));
+
+  d3dapp::DescriptorFreeList empty{0};
+  EXPECT_FALSE(empty.Allocate(&index));
+}
+
+// The slot freed last comes back first, so descriptors that churn stay in
+// the same few cache lines.
+TEST(DescriptorFreeListTest, ReusesTheLastFreedSlotFirst) {
+  d3dapp::DescriptorFreeList list{8};
+  uint32_t index = 0;
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_TRUE(list.Allocate(&index));
+  }
+  list.Free(4);
+  list.Free(1);
+  list.Free(3);
+  EXPECT_EQ(5u, list.free_count());
+  ASSERT_TRUE(list.Allocate(&index));
+  EXPECT_EQ(3u, index);
+  ASSERT_TRUE(list.Allocate(&index));
+  EXPECT_EQ(1u, index);
+  ASSERT_TRUE(list.Allocate(&index));
+  EXPECT_EQ(4u, index);
+  ASSERT_TRUE(list.Allocate(&index));
+  EXPECT_EQ(6u, index);
+}
+
+TEST(DescriptorBlockListTest, CarvesSlotsOutOfWholeBlocks) {
+  d3dapp::DescriptorBlockList list{4};
+  EXPECT_EQ(0u, list.block_count());
+
+  std::vector<uint32_t> indices;
+  for (int i = 0; i < 4; ++i) {
+    indices.push_back(list.Allocate());
+    EXPECT_EQ(1u, list.block_count());
+  }
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 2, 3}), indices);
+  EXPECT_EQ(0u, list.free_count());
+
+  // The fifth slot takes a new block and leaves the rest of it free.
+  const uint32_t index = list.Allocate();
+  EXPECT_EQ(4u, index);
+  EXPECT_EQ(2u, list.block_count());
+  EXPECT_EQ(1u, list.block(index));
+  EXPECT_EQ(0u, list.offset(index));
+  EXPECT_EQ(3u, list.free_count());
+  EXPECT_EQ(1u, list.block(7));
+  EXPECT_EQ(3u, list.offset(7));
+}
+
+TEST(DescriptorBlockListTest, ReusesFreedSlotsBeforeGrowing) {
+  d3dapp::DescriptorBlockList list{4};
+  for (int i = 0; i < 4; ++i) {
+    list.Allocate();
+  }
+  list.Free(2);
+  list.Free(0);
+  EXPECT_EQ(0u, list.Allocate());
+  EXPECT_EQ(2u, list.Allocate());
+  EXPECT_EQ(1u, list.block_count());
+  EXPECT_EQ(4u, list.Allocate());
+  EXPECT_EQ(2u, list.block_count());
+}
+
+// Blocks are never given back, so slots never move: after any churn every
+// slot ever handed out is in a block and no two live slots collide.
+TEST(DescriptorBlockListTest, SlotsNeverMove) {
+  d3dapp::DescriptorBlockList list{16};
+  std::vector<uint32_t> live;
+  for (int round = 0; round < 64; ++round) {
+    for (int i = 0; i < 10; ++i) {
+      live.push_back(list.Allocate());
+    }
+    for (int i = 0; i < 7; ++i) {
+      list.Free(live[(round * 5 + i * 3) % live.size()]);
+      live.erase(live.begin() + (round * 5 + i * 3) % live.size());
+    }
+  }
+  std::vector<uint32_t> sorted = live;
+  std::sort(sorted.begin(), sorted.end());
+  EXPECT_EQ(sorted.end(), std::adjacent_find(sorted.begin(), sorted.end()));
+  for (uint32_t index : live) {
+    EXPECT_LT(list.block(index), list.block_count());
+  }
+  EXPECT_EQ(list.block_count() * list.block_size(),
+            live.size() + list.free_count());
+}
@@ -0,0 +1,154 @@
+#include "descriptor_allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+TEST(DescriptorRingTest, AllocatesContiguousRanges) {
+  d3dapp::DescriptorRing ring{16};
+  uint32_t offset = 0;
+  ASSERT_TRUE(ring.Allocate(4, &offset));
+  EXPECT_EQ(0u, offset);
+  ASSERT_TRUE(ring.Allocate(5, &offset));
+  EXPECT_EQ(4u, offset);
+  ASSERT_TRUE(ring.Allocate(7, &offset));
+  EXPECT_EQ(9u, offset);
+  EXPECT_EQ(16u, ring.used_count());
+  EXPECT_FALSE(ring.Allocate(1, &offset));
+}
+
+TEST(DescriptorRingTest, FramesInFlightHoldTheirRanges) {
+  d3dapp::DescriptorRing ring{16};
+  uint32_t offset = 0;
+  ASSERT_TRUE(ring.Allocate(10, &offset));
+  ring.EndFrame(1);
+  ASSERT_TRUE(ring.Allocate(6, &offset));
+  ring.EndFrame(2);
+  EXPECT_FALSE(ring.Allocate(1, &offset));
+
+  // Nothing completes out of fence order.
+  ring.Reclaim(0);
+  EXPECT_FALSE(ring.Allocate(1, &offset));
+  ring.Reclaim(1);
+  EXPECT_EQ(6u, ring.used_count());
+  ASSERT_TRUE(ring.Allocate(10, &offset));
+  EXPECT_EQ(0u, offset);
+  EXPECT_FALSE(ring.Allocate(1, &offset));
+}
+
+TEST(DescriptorRingTest, SkipsTheTailInsteadOfWrapping) {
+  d3dapp::DescriptorRing ring{10};
+  uint32_t offset = 0;
+  ASSERT_TRUE(ring.Allocate(6, &offset));
+  ring.EndFrame(1);
+  ASSERT_TRUE(ring.Allocate(2, &offset));
+  EXPECT_EQ(6u, offset);
+  ring.EndFrame(2);
+  ring.Reclaim(1);
+
+  // [8, 10) is too short for three, so they come from the front and the
+  // two skipped slots count as used until the frame completes.
+  ASSERT_TRUE(ring.Allocate(3, &offset));
+  EXPECT_EQ(0u, offset);
+  EXPECT_EQ(7u, ring.used_count());
+  ring.EndFrame(3);
+  // Up to the frame still holding [6, 8).
+  EXPECT_FALSE(ring.Allocate(4, &offset));
+  ASSERT_TRUE(ring.Allocate(3, &offset));
+  EXPECT_EQ(3u, offset);
+  ring.EndFrame(4);
+
+  ring.Reclaim(2);
+  EXPECT_EQ(8u, ring.used_count());
+  ring.Reclaim(4);
+  EXPECT_EQ(0u, ring.used_count());
+}
+
+TEST(DescriptorRingTest, RangeLongerThanEitherSideFails) {
+  d3dapp::DescriptorRing ring{10};
+  uint32_t offset = 0;
+  ASSERT_TRUE(ring.Allocate(4, &offset));
+  ring.EndFrame(1);
+  ASSERT_TRUE(ring.Allocate(2, &offset));
+  ring.EndFrame(2);
+  ring.Reclaim(1);
+  // Four free at the end, four at the front, but not five in a row.
+  EXPECT_FALSE(ring.Allocate(5, &offset));
+  EXPECT_EQ(2u, ring.used_count());
+  ASSERT_TRUE(ring.Allocate(4, &offset));
+  EXPECT_EQ(6u, offset);
+}
+
+TEST(DescriptorRingTest, EmptyRingStartsOver) {
+  d3dapp::DescriptorRing ring{10};
+  uint32_t offset = 0;
+  ASSERT_TRUE(ring.Allocate(7, &offset));
+  ring.EndFrame(1);
+  ring.Reclaim(1);
+  // The whole ring is free again, not just what follows the last frame.
+  ASSERT_TRUE(ring.Allocate(10, &offset));
+  EXPECT_EQ(0u, offset);
+}
+
+// Random frames checked against the ranges they were given: live ranges
+// never overlap, and a ring with nothing in flight always has room.
+TEST(DescriptorRingTest, RandomFramesNeverOverlap) {
+  constexpr uint32_t kCapacity = 64;
+  constexpr int kFramesInFlight = 3;
+  d3dapp::DescriptorRing ring{kCapacity};
+  std::mt19937 random{7};
+  std::uniform_int_distribution<uint32_t> counts{1, 12};
+  std::uniform_int_distribution<int> ranges_per_frame{0, 6};
+
+  using Range = std::pair<uint32_t, uint32_t>;
+  std::deque<std::vector<Range>> in_flight;
+  std::vector<Range> frame;
+  uint64_t completed = 0;
+  int failures = 0;
+  for (uint64_t fence_value = 1; fence_value <= 20000; ++fence_value) {
+    for (int i = ranges_per_frame(random); i > 0; --i) {
+      const uint32_t count = counts(random);
+      uint32_t offset = 0;
+      if (!ring.Allocate(count, &offset)) {
+        ++failures;
+        EXPECT_NE(0u, ring.used_count());
+        continue;
+      }
+      ASSERT_LE(offset + count, kCapacity);
+      for (const std::vector<Range>& ranges : in_flight) {
+        for (const Range& range : ranges) {
+          ASSERT_TRUE(offset + count <= range.first ||
+                      range.first + range.second <= offset);
+        }
+      }
+      for (const Range& range : frame) {
+        ASSERT_TRUE(offset + count <= range.first ||
+                    range.first + range.second <= offset);
+      }
+      frame.push_back(Range{offset, count});
+    }
+    ring.EndFrame(fence_value);
+    in_flight.push_back(std::move(frame));
+    frame.clear();
+
+    // The GPU finishes frames in order, sometimes several at once.
+    if (in_flight.size() > kFramesInFlight || random() % 4 == 0) {
+      const uint64_t done = fence_value - in_flight.size() + 1 +
+                            random() % in_flight.size();
+      while (completed < done) {
+        ++completed;
+        in_flight.pop_front();
+      }
+      ring.Reclaim(completed);
+    }
+  }
+  // Tight enough that the ring does fill up.
+  EXPECT_GT(failures, 0);
+
+  ring.Reclaim(completed + in_flight.size());
+  EXPECT_EQ(0u, ring.used_count());
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#ifndef __FAKE_CLOCK_H__
+#define __FAKE_CLOCK_H__
+
+#include <cstdint>
+
+#include "frame_pacer.h"
+
+namespace d3dapp {
+namespace testing {
+// Simulated time for FramePacer. Every Now costs now_cost, like the spin
+// loop would, and sleeps round up to the OS granularity and then overshoot
+// by up to jitter, varying deterministically.
+class FakeClock : public FramePacer::Clock {
+ public:
+  struct State {
+    int64_t now{0};
+    int64_t now_cost{0};
+    int64_t granularity{0};
+    int64_t jitter{0};
+    int sleep_count{0};
+    int now_count{0};
+    uint32_t seed{1};
+  };
+
+  explicit FakeClock(State* state) : state_{state} {}
+
+  int64_t Now() override {
+    ++state_->now_count;
+    state_->now += state_->now_cost;
+    return state_->now;
+  }
+
+  void SleepFor(int64_t duration) override {
+    ++state_->sleep_count;
+    if (state_->granularity > 0) {
+      duration = (duration + state_->granularity - 1) / state_->granularity *
+                 state_->granularity;
+    }
+    if (state_->jitter > 0) {
+      state_->seed = state_->seed * 1664525u + 1013904223u;
+      duration += static_cast<int64_t>(state_->seed >> 8) % state_->jitter;
+    }
+    state_->now += duration;
+  }
+
+ private:
+  State* state_;
+};
+
+}  // namespace testing
+}  // namespace d3dapp
+
+#endif  // !__FAKE_CLOCK_H__
@@ -0,0 +1,52 @@
+#pragma once
+
+#ifndef __FAKE_COPY_QUEUE_H__
+#define __FAKE_COPY_QUEUE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "streaming_pipeline.h"
+
+namespace d3dapp {
+namespace testing {
+// StreamingPipeline's copy queue with staging in plain memory. Record
+// callbacks copy out of staging_memory() themselves; a batch completes as
+// soon as it is submitted unless completion is held back.
+class MemoryCopyQueue : public StreamingPipeline::CopyQueue {
+ public:
+  explicit MemoryCopyQueue(uint64_t staging_size)
+      : staging_(static_cast<size_t>(staging_size)) {}
+
+  uint8_t* staging_memory() override { return staging_.data(); }
+  uint64_t staging_size() override { return staging_.size(); }
+  void Begin() override { ++begin_count_; }
+  uint64_t Submit() override { return ++submitted_; }
+  uint64_t GetCompletedValue() override {
+    return hold_ ? completed_.load() : submitted_.load();
+  }
+
+  // While held, GetCompletedValue stays at what Complete last set.
+  void Hold() {
+    completed_ = submitted_.load();
+    hold_ = true;
+  }
+  void Complete(uint64_t value) { completed_ = value; }
+  void Release() { hold_ = false; }
+
+  uint64_t submitted() const { return submitted_; }
+  int begin_count() const { return begin_count_; }
+
+ private:
+  std::vector<uint8_t> staging_;
+  std::atomic<int> begin_count_{0};
+  std::atomic<uint64_t> submitted_{0};
+  std::atomic<uint64_t> completed_{0};
+  std::atomic<bool> hold_{false};
+};
+
+}  // namespace testing
+}  // namespace d3dapp
+
+#endif  // !__FAKE_COPY_QUEUE_H__
@@ -0,0 +1,71 @@
+#pragma once
+
+#ifndef __FAKE_UPLOAD_H__
+#define __FAKE_UPLOAD_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "upload_batcher.h"
+#include "upload_ring.h"
+
+namespace d3dapp {
+namespace testing {
+// Upload pages in plain memory. A page's resource stands for its memory,
+// so recorded copies can be read back with SourceData.
+class MemoryPages : public UploadRing::Pages {
+ public:
+  bool Create(UINT64 size, UploadAllocation* page) override {
+    BYTE* memory = new BYTE[size];
+    page->resource = reinterpret_cast<ID3D12Resource*>(memory);
+    page->offset = 0;
+    page->cpu_address = memory;
+    page->gpu_address = reinterpret_cast<uintptr_t>(memory);
+    return true;
+  }
+
+  void Destroy(const UploadAllocation& page) override {
+    delete[] page.cpu_address;
+  }
+};
+
+// The copies UploadBatcher::Flush records, in order.
+class RecordedCopies : public UploadBatcher::Copies {
+ public:
+  struct Copy {
+    ID3D12Resource* dest;
+    ID3D12Resource* source;
+    bool buffer;
+    UINT subresource;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+    UINT64 dest_offset;
+    UINT64 source_offset;
+    UINT64 size;
+  };
+
+  void CopyBuffer(ID3D12Resource* dest, UINT64 dest_offset,
+                  ID3D12Resource* source, UINT64 source_offset,
+                  UINT64 size) override {
+    copies.push_back(
+        Copy{dest, source, true, 0, {}, dest_offset, source_offset, size});
+  }
+
+  void CopyTexture(
+      ID3D12Resource* dest, UINT subresource, ID3D12Resource* source,
+      const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint) override {
+    copies.push_back(Copy{dest, source, false, subresource, footprint, 0,
+                          footprint.Offset, 0});
+  }
+
+  // Where a copy reads from, given MemoryPages.
+  static const BYTE* SourceData(const Copy& copy) {
+    return reinterpret_cast<const BYTE*>(copy.source) + copy.source_offset;
+  }
+
+  std::vector<Copy> copies;
+};
+
+}  // namespace testing
+}  // namespace d3dapp
+
+#endif  // !__FAKE_UPLOAD_H__
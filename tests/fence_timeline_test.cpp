@@ -0,0 +1,226 @@
+#include "fence_timeline.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+// A fence the test signals by hand. Shared with the FakeFence the timeline
+// owns.
+class FakeFenceState {
+ public:
+  void Signal(uint64_t value) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      value_ = value;
+    }
+    changed_.notify_all();
+  }
+
+  uint64_t value() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return value_;
+  }
+
+  // Blocks until value or a wake, like SetEventOnCompletion plus a wait on
+  // the fence and wake events.
+  void Wait(uint64_t value) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    waiting_for_ = value;
+    changed_.notify_all();
+    changed_.wait(lock, [this, value]() { return woken_ || value <= value_; });
+    woken_ = false;
+    waiting_for_ = 0;
+  }
+
+  void Wake() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      woken_ = true;
+      ++wake_count_;
+    }
+    changed_.notify_all();
+  }
+
+  // Blocks until the timeline's waiter thread waits on the fence for value.
+  bool WaitUntilWaitingFor(uint64_t value) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    return changed_.wait_for(lock, std::chrono::seconds{10}, [this, value]() {
+      return waiting_for_ == value;
+    });
+  }
+
+  int wake_count() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return wake_count_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  uint64_t value_{0};
+  uint64_t waiting_for_{0};
+  bool woken_{false};
+  int wake_count_{0};
+};
+
+class FakeFence : public d3dapp::FenceTimeline::Fence {
+ public:
+  explicit FakeFence(std::shared_ptr<FakeFenceState> state)
+      : state_{std::move(state)} {}
+
+  uint64_t GetCompletedValue() override { return state_->value(); }
+  void Wait(uint64_t value) override { state_->Wait(value); }
+  void Wake() override { state_->Wake(); }
+
+ private:
+  std::shared_ptr<FakeFenceState> state_;
+};
+
+// Callbacks run on the waiter thread; this collects them in order.
+class Log {
+ public:
+  std::function<void()> Append(int entry) {
+    return [this, entry]() {
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        entries_.push_back(entry);
+      }
+      changed_.notify_all();
+    };
+  }
+
+  // Entries once there are at least count of them, or after a timeout.
+  std::vector<int> Take(size_t count) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    changed_.wait_for(lock, std::chrono::seconds{10},
+                      [this, count]() { return entries_.size() >= count; });
+    return entries_;
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return entries_.size();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<int> entries_;
+};
+
+class FenceTimelineTest : public ::testing::Test {
+ protected:
+  FenceTimelineTest()
+      : fence_{std::make_shared<FakeFenceState>()},
+        timeline_{new d3dapp::FenceTimeline{
+            std::unique_ptr<d3dapp::FenceTimeline::Fence>{
+                new FakeFence{fence_}}}} {}
+
+  std::shared_ptr<FakeFenceState> fence_;
+  std::unique_ptr<d3dapp::FenceTimeline> timeline_;
+};
+
+}  // namespace
+
+TEST_F(FenceTimelineTest, CompletedValuesRunInline) {
+  fence_->Signal(4);
+  const std::thread::id caller = std::this_thread::get_id();
+  std::thread::id ran_on;
+  timeline_->WhenComplete(4, [&ran_on]() {
+    ran_on = std::this_thread::get_id();
+  });
+  EXPECT_EQ(caller, ran_on);
+  EXPECT_TRUE(timeline_->IsComplete(3));
+  EXPECT_EQ(4u, timeline_->completed_value());
+  EXPECT_FALSE(timeline_->IsComplete(5));
+}
+
+TEST_F(FenceTimelineTest, CallbacksRunInValueOrder) {
+  Log log;
+  timeline_->WhenComplete(3, log.Append(3));
+  timeline_->WhenComplete(1, log.Append(1));
+  timeline_->WhenComplete(2, log.Append(20));
+  timeline_->WhenComplete(2, log.Append(21));
+  ASSERT_TRUE(fence_->WaitUntilWaitingFor(1));
+  fence_->Signal(3);
+  // Equal values keep the order they were added in.
+  EXPECT_EQ((std::vector<int>{1, 20, 21, 3}), log.Take(4));
+}
+
+TEST_F(FenceTimelineTest, CallbacksWaitForTheirValue) {
+  Log log;
+  timeline_->WhenComplete(1, log.Append(1));
+  timeline_->WhenComplete(2, log.Append(2));
+  timeline_->WhenComplete(3, log.Append(3));
+
+  fence_->Signal(1);
+  EXPECT_EQ((std::vector<int>{1}), log.Take(1));
+  ASSERT_TRUE(fence_->WaitUntilWaitingFor(2));
+  EXPECT_EQ(1u, log.size());
+
+  fence_->Signal(2);
+  EXPECT_EQ((std::vector<int>{1, 2}), log.Take(2));
+  ASSERT_TRUE(fence_->WaitUntilWaitingFor(3));
+  EXPECT_EQ(2u, log.size());
+  EXPECT_FALSE(timeline_->IsComplete(3));
+
+  fence_->Signal(3);
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), log.Take(3));
+}
+
+// The waiter is blocked on a later value when an earlier one is added; it
+// has to be woken to watch the earlier one instead.
+TEST_F(FenceTimelineTest, EarlierValueWakesTheWaiter) {
+  Log log;
+  timeline_->WhenComplete(5, log.Append(5));
+  ASSERT_TRUE(fence_->WaitUntilWaitingFor(5));
+
+  timeline_->WhenComplete(2, log.Append(2));
+  EXPECT_EQ(1, fence_->wake_count());
+  ASSERT_TRUE(fence_->WaitUntilWaitingFor(2));
+
+  fence_->Signal(2);
+  EXPECT_EQ((std::vector<int>{2}), log.Take(1));
+  ASSERT_TRUE(fence_->WaitUntilWaitingFor(5));
+  fence_->Signal(5);
+  EXPECT_EQ((std::vector<int>{2, 5}), log.Take(2));
+}
+
+TEST_F(FenceTimelineTest, WaitBlocksUntilSignaled) {
+  std::thread signaler{[this]() {
+    fence_->WaitUntilWaitingFor(7);
+    fence_->Signal(6);
+    fence_->Signal(7);
+  }};
+  timeline_->Wait(7);
+  EXPECT_TRUE(timeline_->IsComplete(7));
+  EXPECT_GE(timeline_->completed_value(), 7u);
+  signaler.join();
+}
+
+TEST_F(FenceTimelineTest, WaitAndCallbacksOnTheSameValue) {
+  Log log;
+  timeline_->WhenComplete(2, log.Append(2));
+  std::thread signaler{[this]() {
+    fence_->WaitUntilWaitingFor(2);
+    fence_->Signal(2);
+  }};
+  timeline_->Wait(2);
+  EXPECT_EQ((std::vector<int>{2}), log.Take(1));
+  signaler.join();
+}
+
+TEST_F(FenceTimelineTest, PendingCallbacksAreDroppedOnDestruction) {
+  Log log;
+  timeline_->WhenComplete(9, log.Append(9));
+  ASSERT_TRUE(fence_->WaitUntilWaitingFor(9));
+  timeline_.reset();
+  fence_->Signal(9);
+  EXPECT_EQ(0u, log.size());
+}
@@ -0,0 +1,133 @@
+#include "footprint_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+namespace {
+D3D12_RESOURCE_DESC Texture2D(UINT width, UINT height, UINT16 mip_levels,
+                              DXGI_FORMAT format) {
+  D3D12_RESOURCE_DESC desc{};
+  desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+  desc.Width = width;
+  desc.Height = height;
+  desc.DepthOrArraySize = 1;
+  desc.MipLevels = mip_levels;
+  desc.Format = format;
+  desc.SampleDesc.Count = 1;
+  return desc;
+}
+
+// Answers with CalculateFootprints, failing the way the runtime does: the
+// total size becomes UINT64_MAX.
+class FakeDevice : public ID3D12Device {
+ public:
+  ULONG AddRef() override { return 1; }
+  ULONG Release() override { return 1; }
+
+  void GetCopyableFootprints(const D3D12_RESOURCE_DESC* desc,
+                             UINT first_subresource, UINT subresource_count,
+                             UINT64 base_offset,
+                             D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+                             UINT* row_counts, UINT64* row_sizes,
+                             UINT64* total_size) override {
+    ++call_count;
+    if (!d3dapp::CalculateFootprints(*desc, first_subresource,
+                                     subresource_count, base_offset, layouts,
+                                     row_counts, row_sizes, total_size)) {
+      *total_size = UINT64_MAX;
+    }
+  }
+
+  int call_count{0};
+};
+
+}  // namespace
+
+TEST(FootprintCacheTest, CalculatesPitchedMipChains) {
+  D3D12_RESOURCE_DESC desc =
+      Texture2D(100, 30, 3, DXGI_FORMAT_R8G8B8A8_UNORM);
+  D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[3];
+  UINT row_counts[3];
+  UINT64 row_sizes[3];
+  UINT64 total_size = 0;
+  ASSERT_TRUE(d3dapp::CalculateFootprints(desc, 0, 3, 0, layouts, row_counts,
+                                          row_sizes, &total_size));
+  EXPECT_EQ(0u, layouts[0].Offset);
+  EXPECT_EQ(512u, layouts[0].Footprint.RowPitch);
+  EXPECT_EQ(30u, row_counts[0]);
+  EXPECT_EQ(400u, row_sizes[0]);
+  // 30 rows of 512 bytes, placed at the next 512 byte boundary.
+  EXPECT_EQ(15360u, layouts[1].Offset);
+  EXPECT_EQ(256u, layouts[1].Footprint.RowPitch);
+  EXPECT_EQ(15u, row_counts[1]);
+  EXPECT_EQ(19456u, layouts[2].Offset);
+  EXPECT_EQ(7u, row_counts[2]);
+  // The last row is not padded.
+  EXPECT_EQ(19456u + 6 * 256 + 100, total_size);
+}
+
+TEST(FootprintCacheTest, CalculatesBlockCompressedRows) {
+  D3D12_RESOURCE_DESC desc = Texture2D(10, 10, 1, DXGI_FORMAT_BC1_UNORM);
+  D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+  UINT row_count = 0;
+  UINT64 row_size = 0;
+  ASSERT_TRUE(d3dapp::CalculateFootprints(desc, 0, 1, 0, &layout, &row_count,
+                                          &row_size, nullptr));
+  EXPECT_EQ(3u, row_count);
+  EXPECT_EQ(24u, row_size);
+  EXPECT_EQ(12u, layout.Footprint.Width);
+  EXPECT_EQ(12u, layout.Footprint.Height);
+}
+
+TEST(FootprintCacheTest, RejectsWhatItCannotLayOut) {
+  EXPECT_FALSE(d3dapp::CalculateFootprints(
+      Texture2D(16, 16, 0, DXGI_FORMAT_R8G8B8A8_UNORM), 0, 1, 0, nullptr,
+      nullptr, nullptr, nullptr));
+  EXPECT_FALSE(d3dapp::CalculateFootprints(
+      Texture2D(16, 16, 2, DXGI_FORMAT_R8G8B8A8_UNORM), 1, 2, 0, nullptr,
+      nullptr, nullptr, nullptr));
+  EXPECT_FALSE(d3dapp::CalculateFootprints(
+      Texture2D(16, 16, 1, DXGI_FORMAT_D24_UNORM_S8_UINT), 0, 1, 0, nullptr,
+      nullptr, nullptr, nullptr));
+}
+
+TEST(FootprintCacheTest, QueriesEachShapeOnce) {
+  FakeDevice device;
+  d3dapp::FootprintCache cache{&device};
+  D3D12_RESOURCE_DESC desc =
+      Texture2D(256, 256, 9, DXGI_FORMAT_R8G8B8A8_UNORM);
+  const d3dapp::Footprints& first = cache.Get(desc, 0, 9);
+  ASSERT_EQ(9u, first.layouts.size());
+  EXPECT_EQ(&first, &cache.Get(desc, 0, 9));
+  cache.Get(desc, 1, 8);
+  EXPECT_EQ(2, device.call_count);
+
+  d3dapp::FootprintCacheStats stats = cache.stats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(2u, stats.misses);
+  EXPECT_EQ(2u, stats.entry_count);
+
+  cache.Clear();
+  cache.Get(desc, 0, 9);
+  EXPECT_EQ(3, device.call_count);
+}
+
+TEST(FootprintCacheTest, DoesNotCacheFailures) {
+  FakeDevice device;
+  d3dapp::FootprintCache cache{&device};
+  // Past the last subresource.
+  D3D12_RESOURCE_DESC desc =
+      Texture2D(256, 256, 2, DXGI_FORMAT_R8G8B8A8_UNORM);
+  const d3dapp::Footprints& footprints = cache.Get(desc, 0, 3);
+  EXPECT_TRUE(footprints.layouts.empty());
+  EXPECT_EQ(0u, footprints.total_size);
+  EXPECT_TRUE(cache.Get(desc, 0, 3).layouts.empty());
+  EXPECT_EQ(2, device.call_count);
+  EXPECT_EQ(0u, cache.stats().entry_count);
+
+  // Nor without a device.
+  d3dapp::FootprintCache calculated{nullptr};
+  EXPECT_TRUE(calculated.Get(desc, 0, 3).layouts.empty());
+  EXPECT_EQ(0u, calculated.stats().entry_count);
+}
@@ -0,0 +1,152 @@
+#include "frame_pacer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "fake_clock.h"
+
+namespace {
+using d3dapp::testing::FakeClock;
+
+constexpr int64_t kMillisecond = 1000000;
+constexpr int64_t kMicrosecond = 1000;
+
+std::unique_ptr<d3dapp::FramePacer> MakePacer(double target_fps,
+                                              int64_t spin_threshold,
+                                              FakeClock::State* state) {
+  d3dapp::FramePacer::Desc desc{};
+  desc.target_fps = target_fps;
+  desc.spin_threshold = spin_threshold;
+  return std::unique_ptr<d3dapp::FramePacer>{new d3dapp::FramePacer{
+      desc, std::unique_ptr<d3dapp::FramePacer::Clock>{
+                new FakeClock{state}}}};
+}
+
+}  // namespace
+
+TEST(FramePacerTest, UnlimitedNeverWaits) {
+  FakeClock::State state;
+  auto pacer = MakePacer(0.0, 2 * kMillisecond, &state);
+  EXPECT_EQ(0, pacer->frame_period());
+  for (int i = 0; i < 10; ++i) {
+    state.now += 3 * kMillisecond;
+    pacer->WaitForNextFrame();
+    EXPECT_EQ(0, state.sleep_count);
+    EXPECT_EQ(0, pacer->last_overshoot());
+  }
+  EXPECT_EQ(3 * kMillisecond, pacer->last_interval());
+}
+
+TEST(FramePacerTest, HoldsTheTargetRate) {
+  FakeClock::State state;
+  state.now_cost = kMicrosecond;
+  auto pacer = MakePacer(100.0, 2 * kMillisecond, &state);
+  EXPECT_EQ(10 * kMillisecond, pacer->frame_period());
+
+  pacer->WaitForNextFrame();
+  int64_t start = state.now;
+  for (int i = 0; i < 100; ++i) {
+    state.now += 4 * kMillisecond;
+    pacer->WaitForNextFrame();
+    EXPECT_GE(pacer->last_overshoot(), 0);
+    EXPECT_LE(pacer->last_overshoot(), state.now_cost);
+    EXPECT_NEAR(10 * kMillisecond, pacer->last_interval(), 2 * state.now_cost);
+  }
+  // No drift: deadlines are absolute, not relative to the last frame.
+  EXPECT_NEAR(100 * 10 * kMillisecond, state.now - start, 2 * state.now_cost);
+}
+
+// Sleeps overshoot by up to granularity plus jitter; stopping them
+// spin_threshold early and spinning the rest keeps frames on time.
+TEST(FramePacerTest, SpinAbsorbsCoarseSleeps) {
+  FakeClock::State state;
+  state.now_cost = kMicrosecond;
+  state.granularity = kMillisecond;
+  state.jitter = 500 * kMicrosecond;
+  auto pacer = MakePacer(60.0, 2 * kMillisecond, &state);
+
+  int64_t max_overshoot = 0;
+  pacer->WaitForNextFrame();
+  for (int i = 0; i < 200; ++i) {
+    state.now += 5 * kMillisecond;
+    pacer->WaitForNextFrame();
+    max_overshoot = std::max(max_overshoot, pacer->last_overshoot());
+  }
+  EXPECT_LE(max_overshoot, state.now_cost);
+  EXPECT_GE(state.sleep_count, 200);
+}
+
+// Without the spin margin the same sleeps make frames late.
+TEST(FramePacerTest, SleepingAllTheWayOvershoots) {
+  FakeClock::State state;
+  state.now_cost = kMicrosecond;
+  state.granularity = kMillisecond;
+  state.jitter = 500 * kMicrosecond;
+  auto pacer = MakePacer(60.0, 0, &state);
+
+  int64_t max_overshoot = 0;
+  pacer->WaitForNextFrame();
+  for (int i = 0; i < 200; ++i) {
+    state.now += 5 * kMillisecond;
+    pacer->WaitForNextFrame();
+    max_overshoot = std::max(max_overshoot, pacer->last_overshoot());
+  }
+  EXPECT_GT(max_overshoot, 100 * kMicrosecond);
+}
+
+// Spinning is only for the last stretch; most of the wait is slept.
+TEST(FramePacerTest, SpinsOnlyBelowTheThreshold) {
+  FakeClock::State state;
+  state.now_cost = 1000;
+  auto pacer = MakePacer(50.0, 2 * kMillisecond, &state);
+  pacer->WaitForNextFrame();
+  state.now_count = 0;
+  pacer->WaitForNextFrame();
+  // 2ms of spinning at 1us a call, plus the calls around the sleep.
+  EXPECT_LE(state.now_count, 2 * kMillisecond / state.now_cost + 4);
+  EXPECT_EQ(1, state.sleep_count);
+}
+
+TEST(FramePacerTest, LateFrameCatchesUp) {
+  FakeClock::State state;
+  auto pacer = MakePacer(100.0, 0, &state);
+  pacer->WaitForNextFrame();
+  // Half a frame late: the next deadline stays put, so the frame after
+  // comes early and the average rate holds.
+  state.now += 15 * kMillisecond;
+  pacer->WaitForNextFrame();
+  EXPECT_EQ(5 * kMillisecond, pacer->last_overshoot());
+  state.now += 1 * kMillisecond;
+  pacer->WaitForNextFrame();
+  EXPECT_EQ(20 * kMillisecond, state.now);
+  EXPECT_EQ(5 * kMillisecond, pacer->last_interval());
+}
+
+TEST(FramePacerTest, FallingFarBehindRestartsTheSchedule) {
+  FakeClock::State state;
+  auto pacer = MakePacer(100.0, 0, &state);
+  pacer->WaitForNextFrame();
+  // A 50ms hitch, e.g. a breakpoint or a window drag.
+  state.now += 50 * kMillisecond;
+  pacer->WaitForNextFrame();
+  // The following frames are a full period apart instead of bursting to
+  // make up for the missed ones.
+  for (int i = 0; i < 5; ++i) {
+    pacer->WaitForNextFrame();
+    EXPECT_EQ(10 * kMillisecond, pacer->last_interval());
+  }
+}
+
+TEST(FramePacerTest, SetTargetFps) {
+  FakeClock::State state;
+  auto pacer = MakePacer(30.0, 0, &state);
+  EXPECT_EQ(33333333, pacer->frame_period());
+  pacer->SetTargetFps(0.0);
+  EXPECT_EQ(0, pacer->frame_period());
+  pacer->WaitForNextFrame();
+  EXPECT_EQ(0, state.sleep_count);
+  pacer->SetTargetFps(250.0);
+  EXPECT_EQ(4 * kMillisecond, pacer->frame_period());
+}
@@ -0,0 +1,114 @@
+#include "frame_schedule.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace {
+// The swap chain hands out back buffers round robin, whatever the frame
+// slots do.
+class FakeSwapChain {
+ public:
+  explicit FakeSwapChain(int back_buffer_count)
+      : back_buffer_count_{back_buffer_count} {}
+  int GetCurrentBackBufferIndex() const { return index_; }
+  void Present() { index_ = (index_ + 1) % back_buffer_count_; }
+
+ private:
+  int back_buffer_count_;
+  int index_{0};
+};
+
+// frame_count x back_buffer_count x max_queued_frames.
+class FrameScheduleTest
+    : public ::testing::TestWithParam<std::tuple<int, int, int>> {
+ protected:
+  int frame_count() const { return std::get<0>(GetParam()); }
+  int back_buffer_count() const { return std::get<1>(GetParam()); }
+  int max_queued_frames() const { return std::get<2>(GetParam()); }
+
+  // Frames in flight the schedule allows, including the one being
+  // submitted.
+  int QueueLimit() const {
+    return max_queued_frames() > 0
+               ? std::min(frame_count(), max_queued_frames())
+               : frame_count();
+  }
+
+  // Runs frames against a GPU that finishes work only when the CPU waits
+  // for it if lagging, or right away otherwise, and checks every frame.
+  void Run(bool lagging) {
+    constexpr int kFrames = 64;
+    d3dapp::FrameSchedule schedule{frame_count(), max_queued_frames()};
+    FakeSwapChain swap_chain{back_buffer_count()};
+    std::vector<uint64_t> slot_values(frame_count(), 0);
+    uint64_t completed = 0;
+    bool decoupled = false;
+
+    for (int n = 0; n < kFrames; ++n) {
+      SCOPED_TRACE(n);
+      const int slot = schedule.frame_index();
+      EXPECT_EQ(n % frame_count(), slot);
+      EXPECT_EQ(static_cast<uint64_t>(n), schedule.fence_value());
+      EXPECT_EQ(static_cast<uint64_t>(n + 1), schedule.next_fence_value());
+
+      uint64_t wait_value = schedule.WaitValue();
+      EXPECT_LE(wait_value, schedule.fence_value());
+      completed = std::max(completed, wait_value);
+
+      // The slot's resources are free again.
+      EXPECT_GE(completed, slot_values[slot]);
+      // The queue stays within its bound, including this frame.
+      uint64_t in_flight = schedule.fence_value() - completed + 1;
+      EXPECT_LE(in_flight, static_cast<uint64_t>(QueueLimit()));
+      // A lagging GPU fills the queue; waiting for more than needed would
+      // leave it shorter.
+      if (lagging && n >= QueueLimit()) {
+        EXPECT_EQ(static_cast<uint64_t>(QueueLimit()), in_flight);
+      }
+
+      int back_buffer = swap_chain.GetCurrentBackBufferIndex();
+      EXPECT_EQ(n % back_buffer_count(), back_buffer);
+      decoupled |= back_buffer != slot;
+      swap_chain.Present();
+
+      uint64_t fence_value = schedule.EndFrame();
+      EXPECT_EQ(static_cast<uint64_t>(n + 1), fence_value);
+      slot_values[slot] = fence_value;
+      if (!lagging) {
+        completed = fence_value;
+      }
+    }
+    EXPECT_EQ(frame_count() != back_buffer_count(), decoupled);
+  }
+};
+
+}  // namespace
+
+TEST_P(FrameScheduleTest, LaggingGpu) { Run(true); }
+
+TEST_P(FrameScheduleTest, IdleGpu) { Run(false); }
+
+INSTANTIATE_TEST_CASE_P(Matrix, FrameScheduleTest,
+                        ::testing::Combine(::testing::Range(1, 5),
+                                           ::testing::Range(2, 5),
+                                           ::testing::Range(0, 5)));
+
+TEST(FrameScheduleEdgeTest, FirstFramesNeverWait) {
+  d3dapp::FrameSchedule schedule{3, 0};
+  for (int n = 0; n < 3; ++n) {
+    EXPECT_EQ(0u, schedule.WaitValue());
+    schedule.EndFrame();
+  }
+  EXPECT_EQ(1u, schedule.WaitValue());
+}
+
+TEST(FrameScheduleEdgeTest, NonPositiveCountsAreClamped) {
+  d3dapp::FrameSchedule schedule{0, -1};
+  EXPECT_EQ(1, schedule.frame_count());
+  schedule.EndFrame();
+  EXPECT_EQ(0, schedule.frame_index());
+  EXPECT_EQ(1u, schedule.WaitValue());
+}
@@ -0,0 +1,209 @@
+#include "job_system.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+// Sums [begin, end) by splitting it in halves down to leaf elements.
+void SumRange(d3dapp::JobSystem* job_system, size_t begin, size_t end,
+              size_t leaf, std::atomic<uint64_t>* sum) {
+  if (end - begin <= leaf) {
+    uint64_t local = 0;
+    for (size_t i = begin; i < end; ++i) {
+      local += i;
+    }
+    sum->fetch_add(local, std::memory_order_relaxed);
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  d3dapp::JobSystem::Group group{job_system};
+  group.Run([=]() { SumRange(job_system, begin, middle, leaf, sum); });
+  SumRange(job_system, middle, end, leaf, sum);
+  group.Wait();
+}
+
+class JobSystemTest : public ::testing::TestWithParam<int> {};
+
+}  // namespace
+
+TEST_P(JobSystemTest, ParallelForVisitsEachIndexOnce) {
+  d3dapp::JobSystem job_system{GetParam()};
+  EXPECT_EQ(GetParam() + 1, job_system.thread_count());
+
+  const size_t grains[]{0, 1, 7, 1000, 5000};
+  for (size_t grain : grains) {
+    std::vector<std::atomic<int>> visits(4099);
+    for (std::atomic<int>& visit : visits) {
+      visit = 0;
+    }
+    std::atomic<size_t> max_chunk{0};
+    job_system.ParallelFor(3, visits.size(), grain,
+                           [&](size_t begin, size_t end) {
+                             ASSERT_LT(begin, end);
+                             size_t chunk = end - begin;
+                             size_t seen = max_chunk.load();
+                             while (chunk > seen &&
+                                    !max_chunk.compare_exchange_weak(seen,
+                                                                     chunk)) {
+                             }
+                             for (size_t i = begin; i < end; ++i) {
+                               visits[i].fetch_add(1);
+                             }
+                           });
+    for (size_t i = 0; i < visits.size(); ++i) {
+      EXPECT_EQ(i < 3 ? 0 : 1, visits[i].load()) << "grain " << grain;
+    }
+    if (grain > 0) {
+      EXPECT_LE(max_chunk.load(), grain);
+    }
+  }
+}
+
+TEST_P(JobSystemTest, ParallelForOfEmptyRangeCallsNothing) {
+  d3dapp::JobSystem job_system{GetParam()};
+  int calls = 0;
+  job_system.ParallelFor(5, 5, 0, [&](size_t, size_t) { ++calls; });
+  job_system.ParallelFor(6, 5, 1, [&](size_t, size_t) { ++calls; });
+  EXPECT_EQ(0, calls);
+}
+
+TEST_P(JobSystemTest, NestedParallelForCompletes) {
+  d3dapp::JobSystem job_system{GetParam()};
+  std::atomic<int> count{0};
+  job_system.ParallelFor(0, 16, 1, [&](size_t, size_t) {
+    job_system.ParallelFor(0, 64, 4, [&](size_t begin, size_t end) {
+      count.fetch_add(static_cast<int>(end - begin));
+    });
+  });
+  EXPECT_EQ(16 * 64, count.load());
+}
+
+TEST_P(JobSystemTest, RecursiveGroupsSumCorrectly) {
+  d3dapp::JobSystem job_system{GetParam()};
+  const size_t n = 1 << 16;
+  std::atomic<uint64_t> sum{0};
+  SumRange(&job_system, 0, n, 64, &sum);
+  EXPECT_EQ(uint64_t{n} * (n - 1) / 2, sum.load());
+}
+
+TEST_P(JobSystemTest, GroupWaitRunsEveryJob) {
+  d3dapp::JobSystem job_system{GetParam()};
+  std::atomic<int> count{0};
+  {
+    d3dapp::JobSystem::Group group{&job_system};
+    for (int i = 0; i < 1000; ++i) {
+      group.Run([&count]() { count.fetch_add(1); });
+    }
+  }
+  // The destructor waits.
+  EXPECT_EQ(1000, count.load());
+}
+
+INSTANTIATE_TEST_CASE_P(WorkerCounts, JobSystemTest,
+                        ::testing::Values(0, 1, 3));
+
+// A worker blocked in a job does not run the jobs it pushed; they only
+// complete if another thread steals them from the front of its queue.
+TEST(JobSystemStealTest, BlockedWorkersJobsAreStolen) {
+  d3dapp::JobSystem job_system{2};
+  std::atomic<int> stolen{0};
+  std::atomic<bool> timed_out{false};
+
+  d3dapp::JobSystem::Group outer{&job_system};
+  outer.Run([&]() {
+    d3dapp::JobSystem::Group inner{&job_system};
+    const std::thread::id owner = std::this_thread::get_id();
+    for (int i = 0; i < 8; ++i) {
+      inner.Run([&, owner]() {
+        if (std::this_thread::get_id() != owner) {
+          stolen.fetch_add(1);
+        }
+      });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (stolen.load() < 8) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        timed_out = true;
+        break;
+      }
+      std::this_thread::yield();
+    }
+    inner.Wait();
+  });
+  outer.Wait();
+
+  EXPECT_FALSE(timed_out.load());
+  EXPECT_EQ(8, stolen.load());
+}
+
+// Jobs pushed from the calling thread go to the shared queue, which workers
+// steal from.
+TEST(JobSystemStealTest, WorkersRunJobsOfTheCallingThread) {
+  d3dapp::JobSystem job_system{1};
+  std::atomic<bool> ran_on_worker{false};
+  const std::thread::id caller = std::this_thread::get_id();
+  d3dapp::JobSystem::Group group{&job_system};
+  group.Run([&]() {
+    if (std::this_thread::get_id() != caller) {
+      ran_on_worker = true;
+    }
+  });
+  // Give the worker a chance before the caller helps out.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+  while (!ran_on_worker && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  group.Wait();
+  EXPECT_TRUE(ran_on_worker.load());
+}
+
+// Background jobs are left to idle workers and waits on background groups;
+// a normal wait on the calling thread never runs one.
+TEST(JobSystemBackgroundTest, NormalWaitsSkipBackgroundJobs) {
+  d3dapp::JobSystem job_system{0};
+  std::atomic<bool> ran{false};
+  d3dapp::JobSystem::Group background{&job_system,
+                                      d3dapp::JobSystem::kBackground};
+  background.Run([&ran]() { ran = true; });
+
+  std::atomic<int> count{0};
+  job_system.ParallelFor(0, 100, 1, [&count](size_t begin, size_t end) {
+    count.fetch_add(static_cast<int>(end - begin));
+  });
+  EXPECT_EQ(100, count.load());
+  EXPECT_FALSE(ran.load());
+
+  background.Wait();
+  EXPECT_TRUE(ran.load());
+}
+
+TEST(JobSystemBackgroundTest, IdleWorkersRunBackgroundJobs) {
+  d3dapp::JobSystem job_system{2};
+  std::atomic<int> count{0};
+  const std::thread::id caller = std::this_thread::get_id();
+  std::atomic<bool> ran_on_caller{false};
+  d3dapp::JobSystem::Group background{&job_system,
+                                      d3dapp::JobSystem::kBackground};
+  for (int i = 0; i < 100; ++i) {
+    background.Run([&]() {
+      if (std::this_thread::get_id() == caller) {
+        ran_on_caller = true;
+      }
+      // Nested normal work completes from inside a background job.
+      job_system.ParallelFor(0, 4, 1, [&count](size_t, size_t) {
+        count.fetch_add(1);
+      });
+    });
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+  while (count.load() < 400 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(400, count.load());
+  EXPECT_FALSE(ran_on_caller.load());
+  background.Wait();
+}
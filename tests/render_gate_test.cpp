@@ -0,0 +1,98 @@
+#include "render_gate.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+namespace {
+bool NotOccluded() { return false; }
+
+}  // namespace
+
+TEST(RenderGateTest, ContinuousAlwaysRenders) {
+  d3dapp::RenderGate gate;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(gate.ShouldRender(NotOccluded));
+  }
+}
+
+TEST(RenderGateTest, OnDemandRendersOncePerInvalidate) {
+  d3dapp::RenderGate gate{true};
+  // The first frame is always drawn.
+  EXPECT_TRUE(gate.ShouldRender(NotOccluded));
+  EXPECT_FALSE(gate.ShouldRender(NotOccluded));
+  gate.Invalidate();
+  gate.Invalidate();
+  EXPECT_TRUE(gate.ShouldRender(NotOccluded));
+  EXPECT_FALSE(gate.ShouldRender(NotOccluded));
+  // Waking is not invalidating.
+  gate.Wake();
+  EXPECT_FALSE(gate.ShouldRender(NotOccluded));
+}
+
+TEST(RenderGateTest, MinimizedNeverRenders) {
+  d3dapp::RenderGate gate;
+  gate.SetMinimized(true);
+  gate.Invalidate();
+  EXPECT_FALSE(gate.ShouldRender(NotOccluded));
+  gate.SetMinimized(false);
+  EXPECT_TRUE(gate.ShouldRender(NotOccluded));
+}
+
+TEST(RenderGateTest, OccludedRendersOnceVisibleAgain) {
+  d3dapp::RenderGate gate{true};
+  EXPECT_TRUE(gate.ShouldRender(NotOccluded));
+  gate.SetOccluded();
+  int probes = 0;
+  bool occluded = true;
+  auto probe = [&]() {
+    ++probes;
+    return occluded;
+  };
+  gate.Invalidate();
+  EXPECT_FALSE(gate.ShouldRender(probe));
+  EXPECT_FALSE(gate.ShouldRender(probe));
+  EXPECT_EQ(2, probes);
+  occluded = false;
+  EXPECT_TRUE(gate.ShouldRender(probe));
+  // No longer occluded, so the probe is not asked again.
+  EXPECT_TRUE(gate.ShouldRender(probe));
+  EXPECT_EQ(3, probes);
+}
+
+TEST(RenderGateTest, WaitTimesOut) {
+  d3dapp::RenderGate gate{true};
+  auto start = std::chrono::steady_clock::now();
+  gate.WaitForWork(std::chrono::milliseconds{20});
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds{20});
+}
+
+TEST(RenderGateTest, WakeBeforeWaitIsNotLost) {
+  d3dapp::RenderGate gate{true};
+  gate.Invalidate();
+  auto start = std::chrono::steady_clock::now();
+  gate.WaitForWork(std::chrono::seconds{10});
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{5});
+  // Consumed by the wait.
+  start = std::chrono::steady_clock::now();
+  gate.WaitForWork(std::chrono::milliseconds{20});
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds{20});
+}
+
+TEST(RenderGateTest, InvalidateFromAnotherThreadWakesTheWaiter) {
+  d3dapp::RenderGate gate{true};
+  EXPECT_TRUE(gate.ShouldRender(NotOccluded));
+  std::thread input{[&gate]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    gate.Invalidate();
+  }};
+  auto start = std::chrono::steady_clock::now();
+  while (!gate.ShouldRender(NotOccluded)) {
+    gate.WaitForWork(std::chrono::seconds{10});
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{5});
+  input.join();
+}
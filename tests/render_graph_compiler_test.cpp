@@ -0,0 +1,504 @@
+#include "render_graph_compiler.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr uint32_t kCommon = 0;
+constexpr uint32_t kRenderTarget = 0x4;
+constexpr uint32_t kUnorderedAccess = 0x8;
+constexpr uint32_t kNonPixelShaderResource = 0x40;
+constexpr uint32_t kPixelShaderResource = 0x80;
+
+std::vector<d3dapp::GraphBarrier> BarriersBefore(
+    const d3dapp::RenderGraphCompiler& compiler, size_t i) {
+  return std::vector<d3dapp::GraphBarrier>(
+      compiler.barriers(i), compiler.barriers(i) + compiler.barrier_count(i));
+}
+
+void ExpectTransition(const d3dapp::GraphBarrier& barrier, uint32_t resource,
+                      uint32_t before, uint32_t after) {
+  EXPECT_EQ(d3dapp::GraphBarrier::kTransition, barrier.type);
+  EXPECT_EQ(resource, barrier.resource);
+  EXPECT_EQ(before, barrier.before);
+  EXPECT_EQ(after, barrier.after);
+}
+
+}  // namespace
+
+TEST(RenderGraphCompilerTest, CullsPassesNobodyConsumes) {
+  d3dapp::RenderGraphCompiler compiler;
+  uint32_t unused = compiler.AddResource(kCommon);
+  uint32_t scene = compiler.AddResource(kCommon);
+  uint32_t debug = compiler.AddResource(kCommon);
+  uint32_t back_buffer = compiler.AddResource(kCommon);
+  compiler.Export(back_buffer, kCommon);
+
+  compiler.AddPass();  // 0: writes what nobody reads.
+  compiler.Write(unused, kRenderTarget);
+  compiler.AddPass();  // 1: feeds 3.
+  compiler.Write(scene, kRenderTarget);
+  compiler.AddPass();  // 2: reads scene, but its own output is unused.
+  compiler.Read(scene, kPixelShaderResource);
+  compiler.Write(debug, kRenderTarget);
+  compiler.AddPass();  // 3: the exported output.
+  compiler.Read(scene, kPixelShaderResource);
+  compiler.Write(back_buffer, kRenderTarget);
+  compiler.AddPass(true);  // 4: kept regardless.
+  compiler.Compile();
+
+  EXPECT_EQ((std::vector<uint32_t>{1, 3, 4}), compiler.order());
+  EXPECT_EQ(d3dapp::kNoGraphResource, compiler.first_state(unused));
+  EXPECT_EQ(d3dapp::kNoGraphResource, compiler.first_state(debug));
+  EXPECT_EQ(kRenderTarget, compiler.first_state(scene));
+}
+
+TEST(RenderGraphCompilerTest, LiveWritersKeepEarlierWritersAlive) {
+  d3dapp::RenderGraphCompiler compiler;
+  uint32_t target = compiler.AddResource(kCommon);
+  uint32_t other = compiler.AddResource(kCommon);
+  compiler.Export(target, kCommon);
+
+  compiler.AddPass();  // 0: clears target.
+  compiler.Write(target, kRenderTarget);
+  compiler.AddPass();  // 1: unrelated and unused.
+  compiler.Write(other, kRenderTarget);
+  compiler.AddPass();  // 2: draws on top of the clear.
+  compiler.Write(target, kRenderTarget);
+  compiler.Compile();
+
+  EXPECT_EQ((std::vector<uint32_t>{0, 2}), compiler.order());
+}
+
+TEST(RenderGraphCompilerTest, NothingExportedCullsEverything) {
+  d3dapp::RenderGraphCompiler compiler;
+  uint32_t resource = compiler.AddResource(kCommon);
+  compiler.AddPass();
+  compiler.Write(resource, kRenderTarget);
+  compiler.AddPass();
+  compiler.Read(resource, kPixelShaderResource);
+  compiler.Compile();
+
+  EXPECT_TRUE(compiler.order().empty());
+  EXPECT_EQ(0u, compiler.total_barrier_count());
+  EXPECT_EQ(0u, compiler.barrier_count(0));
+}
+
+TEST(RenderGraphCompilerTest, TransitionsBetweenPassesAndToTheFinalState) {
+  d3dapp::RenderGraphCompiler compiler;
+  uint32_t scene = compiler.AddResource(kCommon);
+  uint32_t back_buffer = compiler.AddResource(kCommon);
+  compiler.Export(scene, kCommon);
+  compiler.Export(back_buffer, kCommon);
+
+  compiler.AddPass();
+  compiler.Write(scene, kRenderTarget);
+  compiler.AddPass();
+  compiler.Read(scene, kPixelShaderResource);
+  compiler.Write(back_buffer, kRenderTarget);
+  compiler.Compile();
+
+  ASSERT_EQ(2u, compiler.order().size());
+  std::vector<d3dapp::GraphBarrier> first = BarriersBefore(compiler, 0);
+  ASSERT_EQ(1u, first.size());
+  ExpectTransition(first[0], scene, kCommon, kRenderTarget);
+
+  std::vector<d3dapp::GraphBarrier> second = BarriersBefore(compiler, 1);
+  ASSERT_EQ(2u, second.size());
+  ExpectTransition(second[0], scene, kRenderTarget, kPixelShaderResource);
+  ExpectTransition(second[1], back_buffer, kCommon, kRenderTarget);
+
+  std::vector<d3dapp::GraphBarrier> last = BarriersBefore(compiler, 2);
+  ASSERT_EQ(2u, last.size());
+  ExpectTransition(last[0], scene, kPixelShaderResource, kCommon);
+  ExpectTransition(last[1], back_buffer, kRenderTarget, kCommon);
+  EXPECT_EQ(kCommon, compiler.final_state(scene));
+  EXPECT_EQ(5u, compiler.total_barrier_count());
+}
+
+TEST(RenderGraphCompilerTest, ReadsUpToTheNextWriteShareOneTransition) {
+  d3dapp::RenderGraphCompiler compiler;
+  uint32_t depth = compiler.AddResource(kCommon);
+  uint32_t output = compiler.AddResource(kCommon);
+  compiler.Export(output, kUnorderedAccess);
+
+  compiler.AddPass();
+  compiler.Write(depth, kRenderTarget);
+  compiler.AddPass();
+  compiler.Read(depth, kNonPixelShaderResource);
+  compiler.Write(output, kUnorderedAccess);
+  compiler.AddPass();
+  compiler.Read(depth, kPixelShaderResource);
+  compiler.Write(output, kUnorderedAccess);
+  compiler.Compile();
+
+  std::vector<d3dapp::GraphBarrier> second = BarriersBefore(compiler, 1);
+  ASSERT_EQ(2u, second.size());
+  ExpectTransition(second[0], depth, kRenderTarget,
+                   kNonPixelShaderResource | kPixelShaderResource);
+
+  // depth is already readable; output only needs its UAV barrier.
+  std::vector<d3dapp::GraphBarrier> third = BarriersBefore(compiler, 2);
+  ASSERT_EQ(1u, third.size());
+  EXPECT_EQ(d3dapp::GraphBarrier::kUav, third[0].type);
+  EXPECT_EQ(output, third[0].resource);
+  EXPECT_EQ(0u, compiler.barrier_count(3));
+}
+
+TEST(RenderGraphCompilerTest, PassReadingAndWritingOnlySeesTheWrite) {
+  d3dapp::RenderGraphCompiler compiler;
+  uint32_t buffer = compiler.AddResource(kUnorderedAccess);
+  compiler.Export(buffer, kUnorderedAccess);
+
+  compiler.AddPass();
+  compiler.Read(buffer, kNonPixelShaderResource);
+  compiler.Write(buffer, kUnorderedAccess);
+  compiler.Compile();
+
+  EXPECT_EQ(kUnorderedAccess, compiler.first_state(buffer));
+  EXPECT_EQ(0u, compiler.total_barrier_count());
+}
+
+TEST(RenderGraphCompilerTest, TransientsShareMemoryBehindAliasingBarriers) {
+  d3dapp::RenderGraphCompiler compiler;
+  uint32_t first = compiler.AddResource(kCommon);
+  uint32_t second = compiler.AddResource(kCommon);
+  uint32_t output = compiler.AddResource(kCommon);
+  compiler.SetTransient(first, 1024, 256, 0);
+  compiler.SetTransient(second, 1024, 256, 0);
+  compiler.Export(output, kCommon);
+
+  compiler.AddPass();  // 0
+  compiler.Write(first, kRenderTarget);
+  compiler.AddPass();  // 1
+  compiler.Read(first, kPixelShaderResource);
+  compiler.Write(output, kRenderTarget);
+  compiler.AddPass();  // 2
+  compiler.Write(second, kRenderTarget);
+  compiler.AddPass();  // 3
+  compiler.Read(second, kPixelShaderResource);
+  compiler.Write(output, kRenderTarget);
+  compiler.Compile();
+
+  ASSERT_EQ(4u, compiler.order().size());
+  EXPECT_EQ(1u, compiler.group_count());
+  EXPECT_EQ(1024u, compiler.group_size(0));
+  EXPECT_EQ(2048u, compiler.unaliased_size());
+  EXPECT_EQ(compiler.transient_offset(first),
+            compiler.transient_offset(second));
+  // Transients start out in the state of their first use.
+  EXPECT_EQ(kRenderTarget, compiler.initial_state(second));
+
+  std::vector<d3dapp::GraphBarrier> before_first = BarriersBefore(compiler, 0);
+  ASSERT_EQ(1u, before_first.size());
+  EXPECT_EQ(d3dapp::GraphBarrier::kAliasing, before_first[0].type);
+  EXPECT_EQ(first, before_first[0].resource);
+  EXPECT_EQ(d3dapp::kNoGraphResource, before_first[0].before);
+
+  std::vector<d3dapp::GraphBarrier> before_second =
+      BarriersBefore(compiler, 2);
+  ASSERT_EQ(1u, before_second.size());
+  EXPECT_EQ(d3dapp::GraphBarrier::kAliasing, before_second[0].type);
+  EXPECT_EQ(second, before_second[0].resource);
+  EXPECT_EQ(first, before_second[0].before);
+}
+
+// What the graph does when it cannot create a transient: the passes that
+// need it go, and so do the ones reading what those passes would have
+// written, without a barrier left for either transient.
+TEST(RenderGraphCompilerTest, DroppedTransientsTakeTheirPassesAlong) {
+  d3dapp::RenderGraphCompiler compiler;
+  uint32_t first = compiler.AddResource(kCommon);
+  uint32_t second = compiler.AddResource(kCommon);
+  uint32_t blurred = compiler.AddResource(kCommon);
+  uint32_t output = compiler.AddResource(kCommon);
+  compiler.SetTransient(first, 1024, 256, 0);
+  compiler.SetTransient(second, 1024, 256, 0);
+  compiler.SetTransient(blurred, 1024, 256, 0);
+  compiler.Export(output, kCommon);
+
+  compiler.AddPass();  // 0
+  compiler.Write(first, kRenderTarget);
+  compiler.AddPass();  // 1
+  compiler.Read(first, kPixelShaderResource);
+  compiler.Write(output, kRenderTarget);
+  compiler.AddPass();  // 2
+  compiler.Write(second, kRenderTarget);
+  compiler.AddPass(true);  // 3: never culled, but cannot run without second.
+  compiler.Read(second, kPixelShaderResource);
+  compiler.Write(blurred, kUnorderedAccess);
+  compiler.AddPass();  // 4
+  compiler.Read(blurred, kPixelShaderResource);
+  compiler.Write(output, kRenderTarget);
+  compiler.Schedule();
+  ASSERT_EQ(5u, compiler.order().size());
+  const uint64_t first_offset = compiler.transient_offset(first);
+
+  compiler.DropResource(second);
+  compiler.EmitBarriers();
+
+  EXPECT_EQ((std::vector<uint32_t>{0, 1}), compiler.order());
+  EXPECT_TRUE(compiler.dropped(second));
+  EXPECT_TRUE(compiler.dropped(blurred));
+  EXPECT_FALSE(compiler.dropped(first));
+  EXPECT_FALSE(compiler.dropped(output));
+  EXPECT_EQ(d3dapp::kNoGraphResource, compiler.first_state(second));
+  EXPECT_EQ(d3dapp::kNoGraphResource, compiler.first_state(blurred));
+  EXPECT_EQ(first_offset, compiler.transient_offset(first));
+
+  for (size_t i = 0; i <= compiler.order().size(); ++i) {
+    for (const d3dapp::GraphBarrier& barrier : BarriersBefore(compiler, i)) {
+      EXPECT_NE(second, barrier.resource);
+      EXPECT_NE(blurred, barrier.resource);
+    }
+  }
+  std::vector<d3dapp::GraphBarrier> final_barriers =
+      BarriersBefore(compiler, 2);
+  ASSERT_EQ(1u, final_barriers.size());
+  ExpectTransition(final_barriers[0], output, kRenderTarget, kCommon);
+}
+
+TEST(RenderGraphCompilerTest, ResetForgetsTheGraph) {
+  d3dapp::RenderGraphCompiler compiler;
+  compiler.SetSplitBarriers(true);
+  uint32_t resource = compiler.AddResource(kCommon);
+  compiler.Export(resource, kCommon);
+  compiler.AddPass();
+  compiler.Write(resource, kRenderTarget);
+  compiler.Compile();
+  EXPECT_EQ(1u, compiler.order().size());
+
+  compiler.Reset();
+  EXPECT_EQ(0u, compiler.pass_count());
+  EXPECT_EQ(0u, compiler.resource_count());
+  EXPECT_TRUE(compiler.split_barriers());
+  compiler.Compile();
+  EXPECT_TRUE(compiler.order().empty());
+}
+
+TEST(RenderGraphCompilerTest, SplitBarriersAreOffByDefault) {
+  d3dapp::RenderGraphCompiler compiler;
+  EXPECT_FALSE(compiler.split_barriers());
+  uint32_t scene = compiler.AddResource(kCommon);
+  uint32_t other = compiler.AddResource(kCommon);
+  compiler.Export(scene, kCommon);
+  compiler.Export(other, kCommon);
+  compiler.AddPass();
+  compiler.Write(scene, kRenderTarget);
+  compiler.AddPass();
+  compiler.Write(other, kRenderTarget);
+  compiler.AddPass();
+  compiler.Read(scene, kPixelShaderResource);
+  compiler.Write(other, kRenderTarget);
+  compiler.Compile();
+
+  std::vector<d3dapp::GraphBarrier> third = BarriersBefore(compiler, 2);
+  ASSERT_EQ(1u, third.size());
+  EXPECT_EQ(d3dapp::GraphBarrier::kFull, third[0].split);
+  // The window is reported either way.
+  EXPECT_EQ(1u, third[0].window);
+  EXPECT_EQ(0u, compiler.split_stats().split_count);
+}
+
+TEST(RenderGraphCompilerTest, SplitsTransitionsAcrossIdlePasses) {
+  d3dapp::RenderGraphCompiler compiler;
+  compiler.SetSplitBarriers(true);
+  uint32_t shadow = compiler.AddResource(kCommon);
+  uint32_t scene = compiler.AddResource(kCommon);
+  compiler.Export(scene, kCommon);
+
+  compiler.AddPass();  // 0: renders the shadow map.
+  compiler.Write(shadow, kRenderTarget);
+  compiler.AddPass();  // 1
+  compiler.Write(scene, kRenderTarget);
+  compiler.AddPass();  // 2
+  compiler.Write(scene, kRenderTarget);
+  compiler.AddPass();  // 3: samples it.
+  compiler.Read(shadow, kPixelShaderResource);
+  compiler.Write(scene, kRenderTarget);
+  compiler.Compile();
+
+  // scene is idle during pass 0, so even its first transition splits.
+  std::vector<d3dapp::GraphBarrier> first = BarriersBefore(compiler, 0);
+  ASSERT_EQ(2u, first.size());
+  ExpectTransition(first[0], scene, kCommon, kRenderTarget);
+  EXPECT_EQ(d3dapp::GraphBarrier::kBegin, first[0].split);
+
+  // Begin halves go first: shadow's begins right after pass 0 and ends
+  // right before pass 3.
+  std::vector<d3dapp::GraphBarrier> second = BarriersBefore(compiler, 1);
+  ASSERT_EQ(2u, second.size());
+  ExpectTransition(second[0], shadow, kRenderTarget, kPixelShaderResource);
+  EXPECT_EQ(d3dapp::GraphBarrier::kBegin, second[0].split);
+  ExpectTransition(second[1], scene, kCommon, kRenderTarget);
+  EXPECT_EQ(d3dapp::GraphBarrier::kEnd, second[1].split);
+
+  std::vector<d3dapp::GraphBarrier> fourth = BarriersBefore(compiler, 3);
+  ASSERT_EQ(1u, fourth.size());
+  ExpectTransition(fourth[0], shadow, kRenderTarget, kPixelShaderResource);
+  EXPECT_EQ(d3dapp::GraphBarrier::kEnd, fourth[0].split);
+  EXPECT_EQ(2u, fourth[0].window);
+
+  // scene is used up to the last pass, so its final transition is whole.
+  std::vector<d3dapp::GraphBarrier> last = BarriersBefore(compiler, 4);
+  ASSERT_EQ(1u, last.size());
+  EXPECT_EQ(d3dapp::GraphBarrier::kFull, last[0].split);
+
+  d3dapp::SplitBarrierStats stats = compiler.split_stats();
+  EXPECT_EQ(2u, stats.split_count);
+  // shadow's first transition and scene's final one.
+  EXPECT_EQ(2u, stats.full_count);
+  EXPECT_EQ(3u, stats.total_window);
+  EXPECT_EQ(2u, stats.max_window);
+}
+
+TEST(RenderGraphCompilerTest, FinalTransitionsSplitAfterTheLastUse) {
+  d3dapp::RenderGraphCompiler compiler;
+  compiler.SetSplitBarriers(true);
+  uint32_t back_buffer = compiler.AddResource(kCommon);
+  uint32_t overlay = compiler.AddResource(kCommon);
+  compiler.Export(back_buffer, kCommon);
+  compiler.Export(overlay, kCommon);
+
+  compiler.AddPass();
+  compiler.Write(back_buffer, kRenderTarget);
+  compiler.AddPass();
+  compiler.Write(overlay, kRenderTarget);
+  compiler.Compile();
+
+  std::vector<d3dapp::GraphBarrier> second = BarriersBefore(compiler, 1);
+  ASSERT_EQ(2u, second.size());
+  EXPECT_EQ(back_buffer, second[0].resource);
+  EXPECT_EQ(d3dapp::GraphBarrier::kBegin, second[0].split);
+  std::vector<d3dapp::GraphBarrier> last = BarriersBefore(compiler, 2);
+  ASSERT_EQ(2u, last.size());
+  EXPECT_EQ(back_buffer, last[0].resource);
+  EXPECT_EQ(d3dapp::GraphBarrier::kEnd, last[0].split);
+  EXPECT_EQ(overlay, last[1].resource);
+  EXPECT_EQ(d3dapp::GraphBarrier::kFull, last[1].split);
+}
+
+// Random graphs compiled with and without split barriers: every begin half
+// is ended exactly once, later, with nothing using the resource in
+// between, and the transitions are the same as without splitting.
+TEST(RenderGraphCompilerTest, RandomSplitBarriersPairUp) {
+  const uint32_t kStates[] = {kRenderTarget, kUnorderedAccess,
+                              kNonPixelShaderResource, kPixelShaderResource};
+  std::mt19937 random{11};
+  for (int round = 0; round < 100; ++round) {
+    d3dapp::RenderGraphCompiler split;
+    d3dapp::RenderGraphCompiler whole;
+    split.SetSplitBarriers(true);
+    const uint32_t resource_count = 2 + random() % 6;
+    const uint32_t pass_count = 1 + random() % 20;
+    // Resources each pass touches, by pass index.
+    std::vector<std::vector<uint32_t>> touches(pass_count);
+    for (d3dapp::RenderGraphCompiler* compiler : {&split, &whole}) {
+      for (uint32_t r = 0; r < resource_count; ++r) {
+        compiler->AddResource(kCommon);
+        if (r % 3 == 0) {
+          compiler->SetTransient(r, 1024, 256, 0);
+        } else {
+          compiler->Export(r, kCommon);
+        }
+      }
+    }
+    for (uint32_t p = 0; p < pass_count; ++p) {
+      split.AddPass();
+      whole.AddPass();
+      for (int a = 1 + random() % 3; a > 0; --a) {
+        uint32_t resource = random() % resource_count;
+        uint32_t state = kStates[random() % 4];
+        bool write = random() % 2 || kUnorderedAccess == state ||
+                     kRenderTarget == state;
+        for (d3dapp::RenderGraphCompiler* compiler : {&split, &whole}) {
+          if (write) {
+            compiler->Write(resource, state);
+          } else {
+            compiler->Read(resource, state);
+          }
+        }
+        touches[p].push_back(resource);
+      }
+    }
+    split.Compile();
+    whole.Compile();
+    ASSERT_EQ(whole.order(), split.order());
+
+    struct Pending {
+      uint32_t before;
+      uint32_t after;
+    };
+    std::vector<bool> pending(resource_count, false);
+    std::vector<Pending> halves(resource_count);
+    std::vector<std::vector<uint32_t>> split_transitions(resource_count);
+    std::vector<std::vector<uint32_t>> whole_transitions(resource_count);
+    for (size_t i = 0; i <= split.order().size(); ++i) {
+      for (const d3dapp::GraphBarrier& barrier : BarriersBefore(split, i)) {
+        if (d3dapp::GraphBarrier::kTransition != barrier.type) {
+          continue;
+        }
+        if (d3dapp::GraphBarrier::kBegin == barrier.split) {
+          ASSERT_FALSE(pending[barrier.resource]) << "round " << round;
+          pending[barrier.resource] = true;
+          halves[barrier.resource] = Pending{barrier.before, barrier.after};
+          continue;
+        }
+        if (d3dapp::GraphBarrier::kEnd == barrier.split) {
+          ASSERT_TRUE(pending[barrier.resource]) << "round " << round;
+          EXPECT_EQ(halves[barrier.resource].before, barrier.before);
+          EXPECT_EQ(halves[barrier.resource].after, barrier.after);
+          pending[barrier.resource] = false;
+        }
+        split_transitions[barrier.resource].push_back(barrier.after);
+      }
+      for (const d3dapp::GraphBarrier& barrier : BarriersBefore(whole, i)) {
+        if (d3dapp::GraphBarrier::kTransition == barrier.type) {
+          whole_transitions[barrier.resource].push_back(barrier.after);
+        }
+      }
+      // Whatever the pass touches is not in the middle of a transition.
+      if (i < split.order().size()) {
+        for (uint32_t resource : touches[split.order()[i]]) {
+          ASSERT_FALSE(pending[resource])
+              << "round " << round << ": pass " << split.order()[i];
+        }
+      }
+    }
+    for (uint32_t r = 0; r < resource_count; ++r) {
+      EXPECT_FALSE(pending[r]) << "round " << round;
+    }
+    EXPECT_EQ(whole_transitions, split_transitions) << "round " << round;
+    EXPECT_EQ(whole.total_barrier_count() + split.split_stats().split_count,
+              split.total_barrier_count());
+  }
+}
+
+TEST(RenderGraphCompilerTest, SecondTransitionInAPassWaitsForTheFirst) {
+  d3dapp::RenderGraphCompiler compiler;
+  compiler.SetSplitBarriers(true);
+  uint32_t target = compiler.AddResource(kCommon);
+  uint32_t other = compiler.AddResource(kCommon);
+  compiler.Export(target, kCommon);
+  compiler.Export(other, kCommon);
+  compiler.AddPass();
+  compiler.Write(target, kUnorderedAccess);
+  compiler.AddPass();
+  compiler.Write(other, kRenderTarget);
+  compiler.AddPass();
+  compiler.Write(target, kRenderTarget);
+  compiler.Write(target, kPixelShaderResource);
+  compiler.Compile();
+
+  // After other's begin half, target's two transitions in order.
+  std::vector<d3dapp::GraphBarrier> third = BarriersBefore(compiler, 2);
+  ASSERT_EQ(3u, third.size());
+  EXPECT_EQ(other, third[0].resource);
+  ExpectTransition(third[1], target, kUnorderedAccess, kRenderTarget);
+  EXPECT_EQ(d3dapp::GraphBarrier::kEnd, third[1].split);
+  ExpectTransition(third[2], target, kRenderTarget, kPixelShaderResource);
+  EXPECT_EQ(d3dapp::GraphBarrier::kFull, third[2].split);
+}
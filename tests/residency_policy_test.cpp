@@ -0,0 +1,125 @@
+#include "residency_policy.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+constexpr uint64_t kMiB = 1024 * 1024;
+
+using Objects = std::vector<const void*>;
+
+}  // namespace
+
+TEST(ResidencyPolicyTest, EvictsLeastRecentlyUsedIdleObjects) {
+  d3dapp::ResidencyPolicy policy;
+  int a = 0, b = 0, c = 0;
+  policy.Register(&a, 10 * kMiB);
+  policy.Register(&b, 10 * kMiB);
+  policy.Register(&c, 10 * kMiB);
+  policy.MarkUsed(&a, 1);
+  policy.MarkUsed(&b, 2);
+  policy.MarkUsed(&c, 3);
+  policy.MarkUsed(&a, 4);
+
+  Objects make_resident;
+  Objects evict;
+  policy.Plan(d3dapp::ResidencyBudget{25 * kMiB, 30 * kMiB}, 4,
+              make_resident, evict);
+  EXPECT_TRUE(make_resident.empty());
+  EXPECT_EQ(Objects{&b}, evict);
+  EXPECT_FALSE(policy.IsResident(&b));
+  EXPECT_EQ(20 * kMiB, policy.stats().resident_size);
+}
+
+TEST(ResidencyPolicyTest, NeverEvictsWhatTheGpuMayBeUsing) {
+  d3dapp::ResidencyPolicy policy;
+  int a = 0, b = 0;
+  policy.Register(&a, 10 * kMiB);
+  policy.Register(&b, 10 * kMiB);
+  policy.MarkUsed(&a, 5);
+  policy.MarkUsed(&b, 6);
+
+  Objects make_resident;
+  Objects evict;
+  policy.Plan(d3dapp::ResidencyBudget{5 * kMiB, 20 * kMiB}, 5,
+              make_resident, evict);
+  EXPECT_EQ(Objects{&a}, evict);
+  EXPECT_EQ(1u, policy.stats().over_budget_count);
+}
+
+TEST(ResidencyPolicyTest, UsedEvictedObjectsComeBack) {
+  d3dapp::ResidencyPolicy policy;
+  int a = 0, b = 0;
+  policy.Register(&a, 10 * kMiB);
+  policy.Register(&b, 10 * kMiB);
+  Objects make_resident;
+  Objects evict;
+  policy.Plan(d3dapp::ResidencyBudget{10 * kMiB, 20 * kMiB}, 0,
+              make_resident, evict);
+  ASSERT_EQ(Objects{&a}, evict);
+
+  // Coming back pushes out the other one.
+  policy.MarkUsed(&a, 1);
+  evict.clear();
+  policy.Plan(d3dapp::ResidencyBudget{10 * kMiB, 10 * kMiB}, 0,
+              make_resident, evict);
+  EXPECT_EQ(Objects{&a}, make_resident);
+  EXPECT_EQ(Objects{&b}, evict);
+  EXPECT_EQ(1u, policy.stats().made_resident_count);
+  EXPECT_EQ(2u, policy.stats().evicted_count);
+}
+
+TEST(ResidencyPolicyTest, CancelledMakeResidentIsRetried) {
+  d3dapp::ResidencyPolicy policy;
+  int a = 0;
+  policy.Register(&a, 10 * kMiB);
+  Objects make_resident;
+  Objects evict;
+  policy.Plan(d3dapp::ResidencyBudget{0, 10 * kMiB}, 0, make_resident,
+              evict);
+  ASSERT_EQ(Objects{&a}, evict);
+
+  policy.MarkUsed(&a, 1);
+  evict.clear();
+  policy.Plan(d3dapp::ResidencyBudget{100 * kMiB, 0}, 0, make_resident,
+              evict);
+  ASSERT_EQ(Objects{&a}, make_resident);
+  EXPECT_TRUE(policy.IsResident(&a));
+
+  // MakeResident failed.
+  policy.CancelMakeResident(make_resident);
+  EXPECT_FALSE(policy.IsResident(&a));
+  EXPECT_EQ(0u, policy.stats().resident_size);
+  EXPECT_EQ(10 * kMiB, policy.stats().evicted_size);
+  EXPECT_EQ(0u, policy.stats().made_resident_count);
+  EXPECT_EQ(0u, policy.stats().made_resident_total);
+
+  // Asked for again without being used again, once only.
+  make_resident.clear();
+  policy.CancelMakeResident(Objects{&a});
+  policy.Plan(d3dapp::ResidencyBudget{100 * kMiB, 0}, 0, make_resident,
+              evict);
+  EXPECT_EQ(Objects{&a}, make_resident);
+  EXPECT_TRUE(policy.IsResident(&a));
+  EXPECT_EQ(10 * kMiB, policy.stats().resident_size);
+  EXPECT_EQ(0u, policy.stats().evicted_size);
+}
+
+TEST(ResidencyPolicyTest, UnregisterForgetsPendingRequests) {
+  d3dapp::ResidencyPolicy policy;
+  int a = 0;
+  policy.Register(&a, 10 * kMiB);
+  Objects make_resident;
+  Objects evict;
+  policy.Plan(d3dapp::ResidencyBudget{0, 10 * kMiB}, 0, make_resident,
+              evict);
+  policy.MarkUsed(&a, 1);
+  policy.Unregister(&a);
+  policy.Plan(d3dapp::ResidencyBudget{100 * kMiB, 0}, 0, make_resident,
+              evict);
+  EXPECT_TRUE(make_resident.empty());
+  EXPECT_EQ(0u, policy.stats().object_count);
+  EXPECT_EQ(0u, policy.stats().evicted_size);
+}
@@ -0,0 +1,327 @@
+#include "resource_state_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+constexpr uint32_t kCommon = 0;
+constexpr uint32_t kRenderTarget = 0x4;
+constexpr uint32_t kUnorderedAccess = 0x8;
+constexpr uint32_t kNonPixelShaderResource = 0x40;
+constexpr uint32_t kPixelShaderResource = 0x80;
+constexpr uint32_t kCopyDest = 0x400;
+constexpr uint32_t kCopySource = 0x800;
+
+std::vector<d3dapp::TrackedBarrier> Take(
+    d3dapp::ResourceStateTracker& tracker) {
+  std::vector<d3dapp::TrackedBarrier> barriers;
+  tracker.TakeBarriers(barriers);
+  return barriers;
+}
+
+std::vector<d3dapp::TrackedBarrier> Resolve(
+    d3dapp::ResourceStateTracker& tracker,
+    d3dapp::ResourceStateRegistry& registry) {
+  std::vector<d3dapp::TrackedBarrier> barriers;
+  tracker.Resolve(registry, barriers);
+  return barriers;
+}
+
+// One list using resource in state, resolved against the registry and
+// submitted on its own.
+std::vector<d3dapp::TrackedBarrier> Submit(
+    d3dapp::ResourceStateRegistry& registry, const void* resource,
+    uint32_t state) {
+  d3dapp::ResourceStateTracker tracker{&registry};
+  tracker.Transition(resource, d3dapp::kAllSubresources, state);
+  std::vector<d3dapp::TrackedBarrier> barriers = Resolve(tracker, registry);
+  registry.Decay();
+  return barriers;
+}
+
+}  // namespace
+
+TEST(ResourceStateTrackerTest, DropsAndFoldsRedundantTransitions) {
+  d3dapp::ResourceStateTracker tracker{nullptr};
+  int resource = 0;
+  tracker.Assume(&resource, kCommon);
+  tracker.Transition(&resource, d3dapp::kAllSubresources, kCommon);
+  EXPECT_TRUE(Take(tracker).empty());
+
+  // A->B->C is one barrier.
+  tracker.Transition(&resource, d3dapp::kAllSubresources, kRenderTarget);
+  tracker.Transition(&resource, d3dapp::kAllSubresources,
+                     kPixelShaderResource);
+  std::vector<d3dapp::TrackedBarrier> barriers = Take(tracker);
+  ASSERT_EQ(1u, barriers.size());
+  EXPECT_EQ(kCommon, barriers[0].before);
+  EXPECT_EQ(kPixelShaderResource, barriers[0].after);
+
+  // A->B->A is none.
+  tracker.Transition(&resource, d3dapp::kAllSubresources, kCopySource);
+  tracker.Transition(&resource, d3dapp::kAllSubresources,
+                     kPixelShaderResource);
+  EXPECT_TRUE(Take(tracker).empty());
+  EXPECT_EQ(1u, tracker.emitted_count());
+  EXPECT_EQ(4u, tracker.dropped_count());
+}
+
+TEST(ResourceStateTrackerTest, UavBarrierKeepsTransitionsApart) {
+  d3dapp::ResourceStateTracker tracker{nullptr};
+  int resource = 0;
+  tracker.Assume(&resource, kCommon);
+  tracker.Transition(&resource, d3dapp::kAllSubresources, kUnorderedAccess);
+  tracker.UavBarrier(&resource);
+  tracker.Transition(&resource, d3dapp::kAllSubresources, kCommon);
+  std::vector<d3dapp::TrackedBarrier> barriers = Take(tracker);
+  ASSERT_EQ(3u, barriers.size());
+  EXPECT_EQ(d3dapp::TrackedBarrier::kUav, barriers[1].type);
+}
+
+TEST(ResourceStateTrackerTest, TracksSubresourcesSeparately) {
+  d3dapp::ResourceStateRegistry registry;
+  int texture = 0;
+  registry.Register(&texture, 3, kPixelShaderResource);
+  d3dapp::ResourceStateTracker tracker{&registry};
+
+  // Rendering into mip 1 while reading mip 0.
+  tracker.Transition(&texture, 1, kRenderTarget);
+  tracker.Transition(&texture, 1, kPixelShaderResource);
+  tracker.Transition(&texture, 2, kRenderTarget);
+  std::vector<d3dapp::TrackedBarrier> barriers = Take(tracker);
+  ASSERT_EQ(1u, barriers.size());
+  EXPECT_EQ(1u, barriers[0].subresource);
+  EXPECT_EQ(kRenderTarget, barriers[0].before);
+
+  // First uses resolve per subresource; mip 0 was never touched.
+  barriers = Resolve(tracker, registry);
+  ASSERT_EQ(2u, barriers.size());
+  EXPECT_EQ(1u, barriers[0].subresource);
+  EXPECT_EQ(kPixelShaderResource, barriers[0].before);
+  EXPECT_EQ(kRenderTarget, barriers[0].after);
+  EXPECT_EQ(2u, barriers[1].subresource);
+  EXPECT_EQ(kPixelShaderResource, registry.State(&texture, 0));
+  EXPECT_EQ(kPixelShaderResource, registry.State(&texture, 1));
+  EXPECT_EQ(kRenderTarget, registry.State(&texture, 2));
+}
+
+TEST(ResourceStateTrackerTest, WholeResourceFromMixedStates) {
+  d3dapp::ResourceStateTracker tracker{nullptr};
+  int texture = 0;
+  tracker.Transition(&texture, 0, kPixelShaderResource);
+  tracker.Transition(&texture, 1, kRenderTarget);
+  tracker.Transition(&texture, 2, kPixelShaderResource);
+  tracker.Transition(&texture, d3dapp::kAllSubresources, kRenderTarget);
+  std::vector<d3dapp::TrackedBarrier> barriers = Take(tracker);
+  ASSERT_EQ(2u, barriers.size());
+  EXPECT_EQ(0u, barriers[0].subresource);
+  EXPECT_EQ(2u, barriers[1].subresource);
+
+  // Uniform again, so the next one covers all of it.
+  tracker.Transition(&texture, d3dapp::kAllSubresources, kCopySource);
+  barriers = Take(tracker);
+  ASSERT_EQ(1u, barriers.size());
+  EXPECT_EQ(d3dapp::kAllSubresources, barriers[0].subresource);
+}
+
+TEST(ResourceStateTrackerTest, ResolvesWholeResourcesInOneBarrier) {
+  d3dapp::ResourceStateRegistry registry;
+  int texture = 0;
+  registry.Register(&texture, 4, kRenderTarget);
+  std::vector<d3dapp::TrackedBarrier> barriers =
+      Submit(registry, &texture, kPixelShaderResource);
+  ASSERT_EQ(1u, barriers.size());
+  EXPECT_EQ(d3dapp::kAllSubresources, barriers[0].subresource);
+  EXPECT_EQ(kRenderTarget, barriers[0].before);
+  EXPECT_EQ(kPixelShaderResource, barriers[0].after);
+  // An explicit transition does not decay.
+  EXPECT_EQ(kPixelShaderResource, registry.State(&texture, 3));
+}
+
+TEST(ResourceStateTrackerTest, BuffersPromoteToAnyStateAndDecay) {
+  d3dapp::ResourceStateRegistry registry;
+  int buffer = 0;
+  registry.Register(&buffer, 1, kCommon, true);
+
+  EXPECT_TRUE(Submit(registry, &buffer, kUnorderedAccess).empty());
+  EXPECT_EQ(kCommon, registry.State(&buffer, 0));
+  EXPECT_TRUE(Submit(registry, &buffer, kCopyDest).empty());
+  EXPECT_TRUE(Submit(registry, &buffer, kNonPixelShaderResource).empty());
+
+  // Within one submission the promoted state carries over to later lists.
+  d3dapp::ResourceStateTracker first{&registry};
+  d3dapp::ResourceStateTracker second{&registry};
+  first.Transition(&buffer, d3dapp::kAllSubresources, kUnorderedAccess);
+  second.Transition(&buffer, d3dapp::kAllSubresources, kCopySource);
+  EXPECT_TRUE(Resolve(first, registry).empty());
+  std::vector<d3dapp::TrackedBarrier> barriers = Resolve(second, registry);
+  ASSERT_EQ(1u, barriers.size());
+  EXPECT_EQ(kUnorderedAccess, barriers[0].before);
+  EXPECT_EQ(kCopySource, barriers[0].after);
+  EXPECT_EQ(kCopySource, registry.State(&buffer, 0));
+  registry.Decay();
+  EXPECT_EQ(kCommon, registry.State(&buffer, 0));
+}
+
+TEST(ResourceStateTrackerTest, TexturesPromoteOnlyToCopyAndShaderStates) {
+  d3dapp::ResourceStateRegistry registry;
+  int texture = 0;
+  registry.Register(&texture, 1, kCommon);
+
+  EXPECT_TRUE(Submit(registry, &texture,
+                     kPixelShaderResource | kNonPixelShaderResource)
+                  .empty());
+  EXPECT_TRUE(Submit(registry, &texture, kCopySource).empty());
+
+  std::vector<d3dapp::TrackedBarrier> barriers =
+      Submit(registry, &texture, kRenderTarget);
+  ASSERT_EQ(1u, barriers.size());
+  EXPECT_EQ(kCommon, barriers[0].before);
+  EXPECT_EQ(kRenderTarget, registry.State(&texture, 0));
+}
+
+TEST(ResourceStateTrackerTest, TexturesDecayOnlyFromPromotedReadStates) {
+  d3dapp::ResourceStateRegistry registry;
+  int read = 0;
+  int copied = 0;
+  int rendered = 0;
+  registry.Register(&read, 1, kCommon);
+  registry.Register(&copied, 1, kCommon);
+  registry.Register(&rendered, 1, kCommon);
+
+  EXPECT_TRUE(Submit(registry, &read, kPixelShaderResource).empty());
+  EXPECT_EQ(kCommon, registry.State(&read, 0));
+
+  // Promoted to a write state: stays.
+  EXPECT_TRUE(Submit(registry, &copied, kCopyDest).empty());
+  EXPECT_EQ(kCopyDest, registry.State(&copied, 0));
+
+  // Promoted, then moved on explicitly: stays where the list left it.
+  d3dapp::ResourceStateTracker tracker{&registry};
+  tracker.Transition(&rendered, d3dapp::kAllSubresources,
+                     kPixelShaderResource);
+  tracker.Transition(&rendered, d3dapp::kAllSubresources, kRenderTarget);
+  std::vector<d3dapp::TrackedBarrier> recorded = Take(tracker);
+  ASSERT_EQ(1u, recorded.size());
+  EXPECT_EQ(kPixelShaderResource, recorded[0].before);
+  EXPECT_TRUE(Resolve(tracker, registry).empty());
+  registry.Decay();
+  EXPECT_EQ(kRenderTarget, registry.State(&rendered, 0));
+}
+
+TEST(ResourceStateTrackerTest, OnlyCommonSubresourcesPromote) {
+  d3dapp::ResourceStateRegistry registry;
+  int texture = 0;
+  registry.Register(&texture, 2, kCommon);
+  {
+    d3dapp::ResourceStateTracker tracker{&registry};
+    tracker.Transition(&texture, 1, kRenderTarget);
+    Take(tracker);
+    ASSERT_EQ(1u, Resolve(tracker, registry).size());
+    registry.Decay();
+  }
+
+  d3dapp::ResourceStateTracker tracker{&registry};
+  tracker.Transition(&texture, d3dapp::kAllSubresources,
+                     kPixelShaderResource);
+  std::vector<d3dapp::TrackedBarrier> barriers = Resolve(tracker, registry);
+  ASSERT_EQ(1u, barriers.size());
+  EXPECT_EQ(1u, barriers[0].subresource);
+  EXPECT_EQ(kRenderTarget, barriers[0].before);
+  registry.Decay();
+  EXPECT_EQ(kCommon, registry.State(&texture, 0));
+  EXPECT_EQ(kPixelShaderResource, registry.State(&texture, 1));
+}
+
+TEST(ResourceStateTrackerTest, UnregisteredResourcesNeedNoBarriers) {
+  d3dapp::ResourceStateRegistry registry;
+  int resource = 0;
+  EXPECT_TRUE(Submit(registry, &resource, kRenderTarget).empty());
+  EXPECT_EQ(d3dapp::kUnknownState, registry.State(&resource, 0));
+}
+
+TEST(ResourceStateTrackerTest, SplitTransitionsPairUp) {
+  d3dapp::ResourceStateTracker tracker{nullptr};
+  int resource = 0;
+  tracker.Assume(&resource, kRenderTarget);
+  tracker.BeginTransition(&resource, kPixelShaderResource);
+  tracker.EndTransition(&resource, kPixelShaderResource);
+  // Not folded into the end half.
+  tracker.Transition(&resource, d3dapp::kAllSubresources, kCopySource);
+
+  std::vector<d3dapp::TrackedBarrier> barriers = Take(tracker);
+  ASSERT_EQ(3u, barriers.size());
+  EXPECT_EQ(d3dapp::TrackedBarrier::kBegin, barriers[0].split);
+  EXPECT_EQ(d3dapp::TrackedBarrier::kEnd, barriers[1].split);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(kRenderTarget, barriers[i].before);
+    EXPECT_EQ(kPixelShaderResource, barriers[i].after);
+    EXPECT_EQ(d3dapp::kAllSubresources, barriers[i].subresource);
+  }
+  EXPECT_EQ(d3dapp::TrackedBarrier::kFull, barriers[2].split);
+  EXPECT_EQ(kPixelShaderResource, barriers[2].before);
+}
+
+TEST(ResourceStateTrackerTest, UsingASplitResourceEndsTheSplitFirst) {
+  d3dapp::ResourceStateTracker tracker{nullptr};
+  int resource = 0;
+  tracker.Assume(&resource, kRenderTarget);
+  tracker.BeginTransition(&resource, kPixelShaderResource);
+  // A second begin while one is pending is ignored.
+  tracker.BeginTransition(&resource, kCopySource);
+  tracker.Transition(&resource, 0, kCopySource);
+
+  std::vector<d3dapp::TrackedBarrier> barriers = Take(tracker);
+  ASSERT_EQ(3u, barriers.size());
+  EXPECT_EQ(d3dapp::TrackedBarrier::kBegin, barriers[0].split);
+  EXPECT_EQ(d3dapp::TrackedBarrier::kEnd, barriers[1].split);
+  EXPECT_EQ(kPixelShaderResource, barriers[1].after);
+  EXPECT_EQ(d3dapp::TrackedBarrier::kFull, barriers[2].split);
+  EXPECT_EQ(kPixelShaderResource, barriers[2].before);
+  EXPECT_EQ(kCopySource, barriers[2].after);
+
+  // An end for another state ends the pending split and moves on.
+  tracker.BeginTransition(&resource, kRenderTarget);
+  tracker.EndTransition(&resource, kUnorderedAccess);
+  barriers = Take(tracker);
+  ASSERT_EQ(3u, barriers.size());
+  EXPECT_EQ(d3dapp::TrackedBarrier::kBegin, barriers[0].split);
+  EXPECT_EQ(d3dapp::TrackedBarrier::kEnd, barriers[1].split);
+  EXPECT_EQ(kRenderTarget, barriers[1].after);
+  EXPECT_EQ(kRenderTarget, barriers[2].before);
+  EXPECT_EQ(kUnorderedAccess, barriers[2].after);
+}
+
+TEST(ResourceStateTrackerTest, SplitWithoutAKnownStateIsOneFullBarrier) {
+  d3dapp::ResourceStateRegistry registry;
+  int first_use = 0;
+  int mixed = 0;
+  registry.Register(&first_use, 1, kRenderTarget);
+  registry.Register(&mixed, 2, kRenderTarget);
+  d3dapp::ResourceStateTracker tracker{&registry};
+
+  // The state before the list is only known at submit time.
+  tracker.BeginTransition(&first_use, kPixelShaderResource);
+  tracker.EndTransition(&first_use, kPixelShaderResource);
+  // Subresources in different states cannot take one split barrier.
+  tracker.Transition(&mixed, 0, kCopySource);
+  tracker.Transition(&mixed, 1, kPixelShaderResource);
+  Take(tracker);
+  tracker.BeginTransition(&mixed, kUnorderedAccess);
+  tracker.EndTransition(&mixed, kUnorderedAccess);
+
+  std::vector<d3dapp::TrackedBarrier> barriers = Take(tracker);
+  ASSERT_EQ(2u, barriers.size());
+  for (const d3dapp::TrackedBarrier& barrier : barriers) {
+    EXPECT_EQ(d3dapp::TrackedBarrier::kFull, barrier.split);
+    EXPECT_EQ(&mixed, barrier.resource);
+    EXPECT_EQ(kUnorderedAccess, barrier.after);
+  }
+  barriers = Resolve(tracker, registry);
+  ASSERT_EQ(3u, barriers.size());
+  EXPECT_EQ(&first_use, barriers[0].resource);
+  EXPECT_EQ(kPixelShaderResource, barriers[0].after);
+  EXPECT_EQ(d3dapp::TrackedBarrier::kFull, barriers[0].split);
+}
@@ -0,0 +1,85 @@
+#include "spsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+TEST(SpscQueueTest, FifoWithinOneThread) {
+  d3dapp::SpscQueue<int, 4> queue;
+  int value = 0;
+  EXPECT_FALSE(queue.TryPop(value));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.TryPush(i));
+  }
+  EXPECT_FALSE(queue.TryPush(4));
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(SpscQueueTest, WrapsAround) {
+  d3dapp::SpscQueue<int, 4> queue;
+  int value = 0;
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(queue.TryPush(i));
+    ASSERT_TRUE(queue.TryPush(-i));
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(i, value);
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(-i, value);
+  }
+  EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(SpscQueueTest, FullQueueTakesMoreOnceDrained) {
+  d3dapp::SpscQueue<int, 2> queue;
+  int value = 0;
+  EXPECT_TRUE(queue.TryPush(1));
+  EXPECT_TRUE(queue.TryPush(2));
+  EXPECT_FALSE(queue.TryPush(3));
+  ASSERT_TRUE(queue.TryPop(value));
+  EXPECT_TRUE(queue.TryPush(3));
+  EXPECT_FALSE(queue.TryPush(4));
+  ASSERT_TRUE(queue.TryPop(value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(queue.TryPop(value));
+  EXPECT_EQ(3, value);
+}
+
+// Like the window thread handing messages to the render thread: every item
+// arrives once, in order, whole.
+TEST(SpscQueueTest, HandsOffBetweenThreadsInOrder) {
+  struct Message {
+    uint64_t sequence;
+    uint64_t check;
+  };
+  constexpr uint64_t kCount = 1000000;
+  d3dapp::SpscQueue<Message, 64> queue;
+
+  std::thread producer{[&queue]() {
+    for (uint64_t i = 0; i < kCount; ++i) {
+      while (!queue.TryPush(Message{i, ~i})) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  uint64_t expected = 0;
+  uint64_t torn = 0;
+  Message message{};
+  while (expected < kCount) {
+    if (!queue.TryPop(message)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(expected, message.sequence);
+    torn += message.check != ~message.sequence;
+    ++expected;
+  }
+  producer.join();
+  EXPECT_EQ(0u, torn);
+  EXPECT_FALSE(queue.TryPop(message));
+}
@@ -0,0 +1,299 @@
+#include "streaming_pipeline.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fake_copy_queue.h"
+#include "job_system.h"
+#include "mapped_file.h"
+
+namespace {
+using d3dapp::StreamingPipeline;
+using d3dapp::StreamRequest;
+using d3dapp::testing::MemoryCopyQueue;
+
+constexpr uint64_t kStagingSize = 64 * 1024;
+
+// Delivers until done returns true, for at most ten seconds.
+bool DeliverUntil(StreamingPipeline* pipeline,
+                  const std::function<bool()>& done) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    pipeline->DeliverReady();
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+// A request that fills size bytes of staging with value and copies them
+// into dest when recorded.
+StreamRequest FillRequest(MemoryCopyQueue* queue, uint8_t value,
+                          uint64_t size, std::vector<uint8_t>* dest,
+                          std::atomic<int>* delivered) {
+  StreamRequest request;
+  request.staging_size = size;
+  request.decode = [value, size](const uint8_t*, uint8_t* staging) {
+    std::memset(staging, value, static_cast<size_t>(size));
+    return true;
+  };
+  request.record = [queue, size, dest](uint64_t staging_offset) {
+    const uint8_t* staging = queue->staging_memory() + staging_offset;
+    dest->assign(staging, staging + size);
+  };
+  request.ready = [delivered](bool loaded, uint64_t) {
+    if (loaded) {
+      delivered->fetch_add(1);
+    }
+  };
+  return request;
+}
+
+class StreamingPipelineTest : public ::testing::TestWithParam<int> {
+ protected:
+  StreamingPipelineTest() : job_system_{GetParam()} {}
+
+  d3dapp::JobSystem job_system_;
+};
+
+}  // namespace
+
+TEST_P(StreamingPipelineTest, CopiesDecodedData) {
+  MemoryCopyQueue* queue = new MemoryCopyQueue{kStagingSize};
+  StreamingPipeline pipeline{
+      std::unique_ptr<StreamingPipeline::CopyQueue>{queue}, &job_system_};
+  std::vector<std::vector<uint8_t>> dests(16);
+  std::atomic<int> delivered{0};
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_NE(0u, pipeline.Request(FillRequest(
+                      queue, static_cast<uint8_t>(i), 1000 + i * 100,
+                      &dests[i], &delivered)));
+  }
+  ASSERT_TRUE(DeliverUntil(&pipeline, [&]() { return delivered == 16; }));
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(std::vector<uint8_t>(1000 + i * 100, static_cast<uint8_t>(i)),
+              dests[i]);
+  }
+  d3dapp::StreamingStats stats = pipeline.stats();
+  EXPECT_EQ(16u, stats.submitted_count);
+  EXPECT_EQ(0u, stats.failed_count);
+  EXPECT_LE(stats.staging_peak, kStagingSize);
+}
+
+TEST_P(StreamingPipelineTest, StagingBoundsTheDataInFlight) {
+  MemoryCopyQueue* queue = new MemoryCopyQueue{kStagingSize};
+  StreamingPipeline pipeline{
+      std::unique_ptr<StreamingPipeline::CopyQueue>{queue}, &job_system_};
+  std::vector<std::vector<uint8_t>> dests(64);
+  std::atomic<int> delivered{0};
+  for (int i = 0; i < 64; ++i) {
+    pipeline.Request(FillRequest(queue, static_cast<uint8_t>(i), 5000,
+                                 &dests[i], &delivered));
+  }
+  ASSERT_TRUE(DeliverUntil(&pipeline, [&]() { return delivered == 64; }));
+  for (int i = 0; i < 64; ++i) {
+    ASSERT_EQ(std::vector<uint8_t>(5000, static_cast<uint8_t>(i)), dests[i]);
+  }
+  EXPECT_LE(pipeline.stats().staging_peak, kStagingSize);
+}
+
+TEST_P(StreamingPipelineTest, ReportsFailedDecodes) {
+  MemoryCopyQueue* queue = new MemoryCopyQueue{kStagingSize};
+  StreamingPipeline pipeline{
+      std::unique_ptr<StreamingPipeline::CopyQueue>{queue}, &job_system_};
+  std::atomic<int> failed{0};
+  StreamRequest request;
+  request.staging_size = 100;
+  request.decode = [](const uint8_t*, uint8_t*) { return false; };
+  request.record = [](uint64_t) { ADD_FAILURE() << "recorded"; };
+  request.ready = [&failed](bool loaded, uint64_t fence_value) {
+    EXPECT_FALSE(loaded);
+    EXPECT_EQ(0u, fence_value);
+    failed.fetch_add(1);
+  };
+  pipeline.Request(std::move(request));
+  ASSERT_TRUE(DeliverUntil(&pipeline, [&]() { return failed == 1; }));
+  EXPECT_EQ(1u, pipeline.stats().failed_count);
+  EXPECT_EQ(0, queue->begin_count());
+}
+
+TEST_P(StreamingPipelineTest, SignalsWhenRequestsBecomeReady) {
+  MemoryCopyQueue* queue = new MemoryCopyQueue{kStagingSize};
+  std::atomic<int> signals{0};
+  StreamingPipeline pipeline{
+      std::unique_ptr<StreamingPipeline::CopyQueue>{queue}, &job_system_,
+      [&signals]() { signals.fetch_add(1); }};
+  std::vector<uint8_t> dest;
+  std::atomic<int> delivered{0};
+  for (int i = 1; i <= 3; ++i) {
+    pipeline.Request(FillRequest(queue, 1, 100, &dest, &delivered));
+    // Without a DeliverReady in between, nothing would signal again.
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (signals < i && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ(i, signals.load());
+    ASSERT_TRUE(DeliverUntil(&pipeline, [&]() { return delivered == i; }));
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(WorkerCounts, StreamingPipelineTest,
+                        ::testing::Values(0, 3));
+
+TEST(StreamingPipelineOrderTest, AdmitsByPriority) {
+  MemoryCopyQueue* queue = new MemoryCopyQueue{4096};
+  queue->Hold();
+  StreamingPipeline pipeline{
+      std::unique_ptr<StreamingPipeline::CopyQueue>{queue}, nullptr};
+  std::mutex mutex;
+  std::vector<int> order;
+  std::atomic<int> delivered{0};
+  auto request = [&](int priority) {
+    StreamRequest request;
+    request.priority = priority;
+    // Each one takes all of staging.
+    request.staging_size = 4096;
+    request.record = [&, priority](uint64_t) {
+      std::lock_guard<std::mutex> lock{mutex};
+      order.push_back(priority);
+    };
+    request.ready = [&delivered](bool, uint64_t) { delivered.fetch_add(1); };
+    return request;
+  };
+
+  // The first request holds staging until its copies complete.
+  pipeline.Request(request(0));
+  ASSERT_TRUE(DeliverUntil(&pipeline, [&]() { return delivered == 1; }));
+  pipeline.Request(request(1));
+  pipeline.Request(request(5));
+  pipeline.Request(request(3));
+  EXPECT_EQ(3u, pipeline.stats().queued_count);
+
+  queue->Release();
+  ASSERT_TRUE(DeliverUntil(&pipeline, [&]() { return delivered == 4; }));
+  EXPECT_EQ((std::vector<int>{0, 5, 3, 1}), order);
+}
+
+TEST(StreamingPipelineOrderTest, RejectsRequestsLargerThanStaging) {
+  StreamingPipeline pipeline{std::unique_ptr<StreamingPipeline::CopyQueue>{
+                                 new MemoryCopyQueue{4096}},
+                             nullptr};
+  StreamRequest request;
+  request.staging_size = 4097;
+  EXPECT_EQ(0u, pipeline.Request(std::move(request)));
+}
+
+TEST(StreamingPipelineFileTest, DecodesFromMappedFiles) {
+  const std::string path = ::testing::TempDir() + "streaming_pipeline_test";
+  std::vector<uint8_t> contents(100000);
+  for (size_t i = 0; i < contents.size(); ++i) {
+    contents[i] = static_cast<uint8_t>(i * 31);
+  }
+  FILE* file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(nullptr, file);
+  std::fwrite(contents.data(), 1, contents.size(), file);
+  std::fclose(file);
+
+  d3dapp::MappedFile mapped;
+  ASSERT_TRUE(mapped.Open(path.c_str()));
+  MemoryCopyQueue* queue = new MemoryCopyQueue{kStagingSize};
+  StreamingPipeline pipeline{
+      std::unique_ptr<StreamingPipeline::CopyQueue>{queue}, nullptr};
+  std::vector<uint8_t> dest;
+  std::atomic<int> results{0};
+  std::atomic<int> loaded{0};
+  StreamRequest request;
+  request.file = &mapped;
+  request.offset = 1234;
+  request.size = 40000;
+  request.staging_size = 40000;
+  request.decode = [](const uint8_t* source, uint8_t* staging) {
+    std::memcpy(staging, source, 40000);
+    return true;
+  };
+  request.record = [queue, &dest](uint64_t staging_offset) {
+    const uint8_t* staging = queue->staging_memory() + staging_offset;
+    dest.assign(staging, staging + 40000);
+  };
+  request.ready = [&](bool ok, uint64_t) {
+    loaded.fetch_add(ok ? 1 : 0);
+    results.fetch_add(1);
+  };
+  StreamRequest past_the_end = request;
+  past_the_end.offset = contents.size() - 100;
+  pipeline.Request(std::move(request));
+  pipeline.Request(std::move(past_the_end));
+
+  ASSERT_TRUE(DeliverUntil(&pipeline, [&]() { return results == 2; }));
+  EXPECT_EQ(1, loaded.load());
+  EXPECT_EQ(std::vector<uint8_t>(contents.begin() + 1234,
+                                 contents.begin() + 1234 + 40000),
+            dest);
+  mapped.Close();
+  std::remove(path.c_str());
+}
+
+// Decodes are background jobs: a frame waiting on its own jobs never picks
+// one up, even while the only worker is busy with the frame.
+TEST(StreamingPipelineJobsTest, FrameWaitsDoNotRunDecodes) {
+  d3dapp::JobSystem job_system{1};
+  MemoryCopyQueue* queue = new MemoryCopyQueue{kStagingSize};
+  StreamingPipeline pipeline{
+      std::unique_ptr<StreamingPipeline::CopyQueue>{queue}, &job_system};
+  const std::thread::id caller = std::this_thread::get_id();
+  std::atomic<bool> started{false};
+  std::atomic<bool> finish{false};
+  std::atomic<bool> ran_on_caller{false};
+  std::atomic<int> delivered{0};
+
+  // The worker takes the frame's job and holds on to it.
+  d3dapp::JobSystem::Group frame{&job_system};
+  frame.Run([&]() {
+    started = true;
+    while (!finish) {
+      std::this_thread::yield();
+    }
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    StreamRequest request;
+    request.staging_size = 100;
+    request.decode = [&](const uint8_t*, uint8_t*) {
+      if (std::this_thread::get_id() == caller) {
+        ran_on_caller = true;
+      }
+      return true;
+    };
+    request.ready = [&delivered](bool, uint64_t) { delivered.fetch_add(1); };
+    pipeline.Request(std::move(request));
+  }
+  // The frame finishes a while after the decodes were queued, and the
+  // caller waits for it meanwhile.
+  std::thread finisher{[&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    finish = true;
+  }};
+  frame.Wait();
+  finisher.join();
+  EXPECT_FALSE(ran_on_caller.load());
+
+  ASSERT_TRUE(DeliverUntil(&pipeline, [&]() { return delivered == 4; }));
+  EXPECT_FALSE(ran_on_caller.load());
+}
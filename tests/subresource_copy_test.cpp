@@ -0,0 +1,104 @@
+#include "subresource_copy.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "cpu_features.h"
+#include "job_system.h"
+
+namespace {
+std::vector<uint8_t> Pattern(size_t size, uint8_t seed) {
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<uint8_t>(i * 31 + seed);
+  }
+  return data;
+}
+
+// Runs each test once as detected and once without the optional
+// instruction sets.
+class SubresourceCopyTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    detected_ = d3dapp::GetCpuFeatures();
+    if (!GetParam()) {
+      d3dapp::SetCpuFeaturesForTesting(d3dapp::CpuFeatures{});
+    }
+  }
+
+  void TearDown() override { d3dapp::SetCpuFeaturesForTesting(detected_); }
+
+  d3dapp::CpuFeatures detected_;
+};
+
+}  // namespace
+
+TEST_P(SubresourceCopyTest, StreamCopyHandlesAnyAlignmentAndSize) {
+  const std::vector<uint8_t> source = Pattern(4096 + 64, 1);
+  for (size_t size : {0, 1, 15, 255, 256, 257, 1000, 4096}) {
+    for (size_t dest_offset = 0; dest_offset < 33; dest_offset += 7) {
+      for (size_t source_offset = 0; source_offset < 33; source_offset += 11) {
+        std::vector<uint8_t> dest(size + 64, 0xcd);
+        d3dapp::StreamCopy(dest.data() + dest_offset,
+                           source.data() + source_offset, size);
+        ASSERT_EQ(0, std::memcmp(dest.data() + dest_offset,
+                                 source.data() + source_offset, size))
+            << size << " bytes at " << dest_offset << " from "
+            << source_offset;
+        // Nothing around it is touched.
+        for (size_t i = 0; i < dest_offset; ++i) {
+          ASSERT_EQ(0xcd, dest[i]);
+        }
+        for (size_t i = dest_offset + size; i < dest.size(); ++i) {
+          ASSERT_EQ(0xcd, dest[i]);
+        }
+      }
+    }
+  }
+}
+
+TEST_P(SubresourceCopyTest, CopiesRowsIntoPitchedSlices) {
+  const size_t row_size = 300;
+  const uint32_t row_count = 5;
+  const uint32_t slice_count = 3;
+  const std::vector<uint8_t> source =
+      Pattern(row_size * row_count * slice_count, 2);
+  const size_t dest_row_pitch = 512;
+  const size_t dest_slice_pitch = dest_row_pitch * (row_count + 1);
+  std::vector<uint8_t> dest(dest_slice_pitch * slice_count);
+  d3dapp::SubresourceCopy copy{dest.data(),   dest_row_pitch,
+                               dest_slice_pitch, source.data(),
+                               row_size,      row_size * row_count,
+                               row_size,      row_count,
+                               slice_count};
+  d3dapp::CopySubresource(copy);
+
+  for (uint32_t slice = 0; slice < slice_count; ++slice) {
+    for (uint32_t row = 0; row < row_count; ++row) {
+      EXPECT_EQ(0, std::memcmp(
+                       dest.data() + slice * dest_slice_pitch +
+                           row * dest_row_pitch,
+                       source.data() + (slice * row_count + row) * row_size,
+                       row_size))
+          << "slice " << slice << " row " << row;
+    }
+  }
+}
+
+TEST_P(SubresourceCopyTest, BandsOnJobsMatchASingleCopy) {
+  const size_t row_size = 4096;
+  const uint32_t row_count = 1024;
+  const std::vector<uint8_t> source = Pattern(row_size * row_count, 3);
+  std::vector<uint8_t> dest(source.size());
+  d3dapp::SubresourceCopy copy{dest.data(), row_size, source.size(),
+                               source.data(), row_size, source.size(),
+                               row_size, row_count, 1};
+  d3dapp::JobSystem job_system{4};
+  d3dapp::CopySubresource(copy, &job_system);
+  EXPECT_EQ(source, dest);
+}
+
+INSTANTIATE_TEST_SUITE_P(Detected, SubresourceCopyTest, ::testing::Bool());
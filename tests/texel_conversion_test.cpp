@@ -0,0 +1,229 @@
+#include "texel_conversion.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "cpu_features.h"
+
+namespace {
+// Covers every vector width and every tail length.
+constexpr size_t kTexelCount = 1000 + 37;
+
+// The instruction sets to compare, from none up to what the CPU has.
+std::vector<d3dapp::CpuFeatures> FeatureLevels() {
+  const d3dapp::CpuFeatures detected = d3dapp::GetCpuFeatures();
+  std::vector<d3dapp::CpuFeatures> levels{d3dapp::CpuFeatures{}};
+  d3dapp::CpuFeatures level;
+  if (detected.ssse3) {
+    level.ssse3 = true;
+    levels.push_back(level);
+  }
+  if (detected.f16c) {
+    level.f16c = true;
+    levels.push_back(level);
+  }
+  if (detected.avx2) {
+    level.avx2 = true;
+    levels.push_back(level);
+  }
+  return levels;
+}
+
+// Converts one texel at a time, which only the scalar code handles.
+std::vector<uint8_t> ConvertScalar(const d3dapp::TexelConversion& conversion,
+                                   const std::vector<uint8_t>& source) {
+  const size_t source_size = d3dapp::SourceTexelSize(conversion.type);
+  const size_t dest_size = d3dapp::DestTexelSize(conversion.type);
+  const size_t count = source.size() / source_size;
+  std::vector<uint8_t> dest(count * dest_size);
+  for (size_t i = 0; i < count; ++i) {
+    d3dapp::ConvertTexels(conversion, dest.data() + i * dest_size,
+                          source.data() + i * source_size, 1);
+  }
+  return dest;
+}
+
+std::vector<uint8_t> Convert(const d3dapp::TexelConversion& conversion,
+                             const std::vector<uint8_t>& source) {
+  const size_t count = source.size() / d3dapp::SourceTexelSize(conversion.type);
+  std::vector<uint8_t> dest(count * d3dapp::DestTexelSize(conversion.type));
+  d3dapp::ConvertTexels(conversion, dest.data(), source.data(), count);
+  return dest;
+}
+
+template <typename T>
+std::vector<uint8_t> Bytes(const std::vector<T>& values) {
+  std::vector<uint8_t> bytes(values.size() * sizeof(T));
+  std::memcpy(bytes.data(), values.data(), bytes.size());
+  return bytes;
+}
+
+std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed) {
+  std::mt19937 random{seed};
+  std::vector<uint8_t> bytes(size);
+  for (uint8_t& byte : bytes) {
+    byte = static_cast<uint8_t>(random());
+  }
+  return bytes;
+}
+
+// Floats across the half range and its edges: denormals, ties, overflow,
+// infinities and signed zeros.
+std::vector<float> HalfTestFloats() {
+  std::mt19937 random{3};
+  std::vector<float> values{0.0f,      -0.0f,     1.0f,       -1.0f,
+                            65504.0f,  65519.0f,  65520.0f,   1e9f,
+                            -1e9f,     6.1e-5f,   5.96e-8f,   2.98e-8f,
+                            1e-10f,    1.0009765625f, 1.00048828125f,
+                            std::numeric_limits<float>::infinity(),
+                            -std::numeric_limits<float>::infinity()};
+  std::uniform_int_distribution<int> exponent{-30, 20};
+  std::uniform_real_distribution<float> mantissa{-2.0f, 2.0f};
+  while (values.size() < kTexelCount) {
+    values.push_back(std::ldexp(mantissa(random), exponent(random)));
+  }
+  return values;
+}
+
+// Linear values in and around [0, 1], including the linear segment.
+std::vector<float> SrgbTestFloats() {
+  std::mt19937 random{4};
+  std::uniform_real_distribution<float> value{-0.1f, 1.1f};
+  std::uniform_real_distribution<float> dark{0.0f, 0.004f};
+  std::vector<float> values;
+  while (values.size() < kTexelCount * 4) {
+    values.push_back(values.size() % 3 ? value(random) : dark(random));
+  }
+  return values;
+}
+
+class TexelConversionTest : public ::testing::Test {
+ protected:
+  void SetUp() override { detected_ = d3dapp::GetCpuFeatures(); }
+  void TearDown() override { d3dapp::SetCpuFeaturesForTesting(detected_); }
+
+  // Every feature level converts source exactly as the scalar code does.
+  void ExpectMatchesScalar(const d3dapp::TexelConversion& conversion,
+                           const std::vector<uint8_t>& source) {
+    for (const d3dapp::CpuFeatures& level : FeatureLevels()) {
+      d3dapp::SetCpuFeaturesForTesting(level);
+      std::vector<uint8_t> expected = ConvertScalar(conversion, source);
+      EXPECT_EQ(expected, Convert(conversion, source))
+          << "ssse3 " << level.ssse3 << " f16c " << level.f16c << " avx2 "
+          << level.avx2;
+    }
+  }
+
+  d3dapp::CpuFeatures detected_;
+};
+
+}  // namespace
+
+TEST_F(TexelConversionTest, Rgb8ToRgba8MatchesScalar) {
+  ExpectMatchesScalar(
+      d3dapp::TexelConversion{d3dapp::TexelConversion::kRgb8ToRgba8},
+      RandomBytes(kTexelCount * 3, 1));
+}
+
+TEST_F(TexelConversionTest, SwizzleRgba8MatchesScalar) {
+  d3dapp::TexelConversion conversion{d3dapp::TexelConversion::kSwizzleRgba8,
+                                     {2, 1, 0, 3}};
+  ExpectMatchesScalar(conversion, RandomBytes(kTexelCount * 4, 2));
+  // Channels may repeat.
+  conversion.swizzle[0] = conversion.swizzle[1] = conversion.swizzle[2] = 3;
+  ExpectMatchesScalar(conversion, RandomBytes(kTexelCount * 4, 3));
+}
+
+TEST_F(TexelConversionTest, R16UnormToR32FloatMatchesScalar) {
+  std::vector<uint16_t> values{0, 1, 32767, 32768, 65534, 65535};
+  std::vector<uint8_t> random = RandomBytes(kTexelCount * 2, 4);
+  std::memcpy(random.data(), values.data(), values.size() * 2);
+  ExpectMatchesScalar(
+      d3dapp::TexelConversion{d3dapp::TexelConversion::kR16UnormToR32Float},
+      random);
+}
+
+TEST_F(TexelConversionTest, R32FloatToR16FloatMatchesScalar) {
+  ExpectMatchesScalar(
+      d3dapp::TexelConversion{d3dapp::TexelConversion::kR32FloatToR16Float},
+      Bytes(HalfTestFloats()));
+}
+
+TEST_F(TexelConversionTest, R32FloatToR16FloatRoundsToNearestEven) {
+  // 1 + 2^-11 ties to 1, 1 + 3 * 2^-11 ties up to 1 + 2^-9.
+  std::vector<float> values{1.00048828125f, 1.00146484375f, 65520.0f,
+                            5.96046448e-8f, -0.0f};
+  std::vector<uint16_t> expected{0x3c00, 0x3c02, 0x7c00, 0x0001, 0x8000};
+  for (const d3dapp::CpuFeatures& level : FeatureLevels()) {
+    d3dapp::SetCpuFeaturesForTesting(level);
+    // Padded so the vector loops run.
+    std::vector<float> padded(values);
+    padded.resize(16, 0.0f);
+    std::vector<uint16_t> halves(padded.size());
+    d3dapp::ConvertTexels(
+        d3dapp::TexelConversion{d3dapp::TexelConversion::kR32FloatToR16Float},
+        halves.data(), padded.data(), padded.size());
+    halves.resize(values.size());
+    EXPECT_EQ(expected, halves);
+  }
+}
+
+TEST_F(TexelConversionTest, R32FloatToR16FloatKeepsNaN) {
+  std::vector<float> values(16, std::numeric_limits<float>::quiet_NaN());
+  for (const d3dapp::CpuFeatures& level : FeatureLevels()) {
+    d3dapp::SetCpuFeaturesForTesting(level);
+    std::vector<uint16_t> halves(values.size());
+    d3dapp::ConvertTexels(
+        d3dapp::TexelConversion{d3dapp::TexelConversion::kR32FloatToR16Float},
+        halves.data(), values.data(), values.size());
+    for (uint16_t half : halves) {
+      EXPECT_EQ(0x7c00, half & 0x7c00);
+      EXPECT_NE(0, half & 0x3ff);
+    }
+  }
+}
+
+// The vector sRGB curves sum their terms in a different order, so they may
+// round to the neighbouring step.
+TEST_F(TexelConversionTest, Rgba32FloatToRgba8SrgbMatchesScalarWithinAStep) {
+  const d3dapp::TexelConversion conversion{
+      d3dapp::TexelConversion::kRgba32FloatToRgba8Srgb};
+  const std::vector<uint8_t> source = Bytes(SrgbTestFloats());
+  for (const d3dapp::CpuFeatures& level : FeatureLevels()) {
+    d3dapp::SetCpuFeaturesForTesting(level);
+    std::vector<uint8_t> expected = ConvertScalar(conversion, source);
+    std::vector<uint8_t> actual = Convert(conversion, source);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_LE(std::abs(expected[i] - actual[i]), 1) << "byte " << i;
+    }
+  }
+}
+
+TEST_F(TexelConversionTest, LinearToSrgbIsWithinAStepOfTheExactCurve) {
+  std::vector<float> linear;
+  for (int i = 0; i <= 4096; ++i) {
+    float x = i / 4096.0f;
+    linear.insert(linear.end(), {x, x, x, x});
+  }
+  std::vector<uint8_t> srgb(linear.size());
+  d3dapp::ConvertTexels(
+      d3dapp::TexelConversion{d3dapp::TexelConversion::kRgba32FloatToRgba8Srgb},
+      srgb.data(), linear.data(), linear.size() / 4);
+  for (size_t i = 0; i < linear.size(); i += 4) {
+    float x = linear[i];
+    float exact = x <= 0.0031308f ? 12.92f * x
+                                  : 1.055f * std::pow(x, 1.0f / 2.4f) - 0.055f;
+    ASSERT_LE(std::abs(srgb[i] - static_cast<int>(exact * 255.0f + 0.5f)), 1)
+        << x;
+    // Alpha stays linear.
+    ASSERT_EQ(static_cast<int>(x * 255.0f + 0.5f), srgb[i + 3]) << x;
+  }
+}
@@ -0,0 +1,140 @@
+#include "transient_packer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+d3dapp::TransientInterval Interval(uint64_t size, uint64_t alignment,
+                                   uint32_t first, uint32_t last) {
+  return d3dapp::TransientInterval{size, alignment, first, last,
+                                   0,    d3dapp::kNoInterval, false};
+}
+
+bool LiveTogether(const d3dapp::TransientInterval& a,
+                  const d3dapp::TransientInterval& b) {
+  return a.first <= b.last && b.first <= a.last;
+}
+
+bool SharesMemory(const d3dapp::TransientInterval& a,
+                  const d3dapp::TransientInterval& b) {
+  return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+}
+
+}  // namespace
+
+TEST(TransientPackerTest, EmptyNeedsNoMemory) {
+  std::vector<d3dapp::TransientInterval> intervals;
+  EXPECT_EQ(0u, d3dapp::PackTransients(intervals));
+}
+
+TEST(TransientPackerTest, OverlappingLifetimesGetTheirOwnMemory) {
+  std::vector<d3dapp::TransientInterval> intervals{
+      Interval(1000, 256, 0, 2), Interval(3000, 256, 1, 3),
+      Interval(500, 256, 2, 2)};
+  // Largest first: 3000 at 0, 1000 after it, 500 after that.
+  EXPECT_EQ(4596u, d3dapp::PackTransients(intervals));
+  EXPECT_EQ(3072u, intervals[0].offset);
+  EXPECT_EQ(0u, intervals[1].offset);
+  EXPECT_EQ(4096u, intervals[2].offset);
+  for (const d3dapp::TransientInterval& interval : intervals) {
+    EXPECT_FALSE(interval.aliased);
+    EXPECT_EQ(d3dapp::kNoInterval, interval.alias_before);
+  }
+}
+
+TEST(TransientPackerTest, DisjointLifetimesShareMemory) {
+  std::vector<d3dapp::TransientInterval> intervals{
+      Interval(4096, 256, 0, 1), Interval(4096, 256, 2, 3),
+      Interval(4096, 256, 4, 4)};
+  EXPECT_EQ(4096u, d3dapp::PackTransients(intervals));
+  for (const d3dapp::TransientInterval& interval : intervals) {
+    EXPECT_EQ(0u, interval.offset);
+    EXPECT_TRUE(interval.aliased);
+  }
+  // Each takes the memory over from the one last live before it.
+  EXPECT_EQ(d3dapp::kNoInterval, intervals[0].alias_before);
+  EXPECT_EQ(0u, intervals[1].alias_before);
+  EXPECT_EQ(1u, intervals[2].alias_before);
+}
+
+TEST(TransientPackerTest, FillsGapsBetweenLiveIntervals) {
+  std::vector<d3dapp::TransientInterval> intervals{
+      Interval(4096, 1, 0, 3),  // Lives throughout.
+      Interval(2048, 1, 0, 1),  // Next to it early on.
+      Interval(1024, 1, 2, 3),  // Reuses the early one's space.
+  };
+  EXPECT_EQ(6144u, d3dapp::PackTransients(intervals));
+  EXPECT_EQ(0u, intervals[0].offset);
+  EXPECT_EQ(4096u, intervals[1].offset);
+  EXPECT_EQ(4096u, intervals[2].offset);
+  EXPECT_FALSE(intervals[0].aliased);
+  EXPECT_TRUE(intervals[1].aliased);
+  EXPECT_EQ(1u, intervals[2].alias_before);
+}
+
+TEST(TransientPackerTest, HonorsAlignment) {
+  std::vector<d3dapp::TransientInterval> intervals{
+      Interval(100, 1, 0, 1), Interval(50, 65536, 0, 1)};
+  EXPECT_EQ(65536u + 50, d3dapp::PackTransients(intervals));
+  EXPECT_EQ(0u, intervals[0].offset);
+  EXPECT_EQ(65536u, intervals[1].offset);
+}
+
+TEST(TransientPackerTest, AliasBeforeIsTheLatestEarlierOccupant) {
+  // Both earlier intervals overlap the memory of the last one; the barrier
+  // must name the one that was live most recently.
+  std::vector<d3dapp::TransientInterval> intervals{
+      Interval(1024, 1, 0, 0), Interval(1024, 1, 0, 2),
+      Interval(2048, 1, 3, 4)};
+  d3dapp::PackTransients(intervals);
+  EXPECT_EQ(0u, intervals[2].offset);
+  EXPECT_EQ(1u, intervals[2].alias_before);
+  // Later occupants do not count.
+  EXPECT_EQ(d3dapp::kNoInterval, intervals[1].alias_before);
+}
+
+// Random lifetimes checked for the packer's promises: aligned, within the
+// returned size, no memory shared while live together, and aliasing
+// reported exactly where memory is shared.
+TEST(TransientPackerTest, RandomIntervalsNeverOverlapWhileLive) {
+  std::mt19937 random{3};
+  for (int round = 0; round < 200; ++round) {
+    std::vector<d3dapp::TransientInterval> intervals;
+    const int count = 1 + random() % 40;
+    for (int i = 0; i < count; ++i) {
+      uint32_t first = random() % 30;
+      uint32_t last = first + random() % 8;
+      uint64_t alignment = uint64_t{1} << (random() % 17);
+      intervals.push_back(
+          Interval(1 + random() % 100000, alignment, first, last));
+    }
+
+    uint64_t total = d3dapp::PackTransients(intervals);
+    uint64_t unaliased = 0;
+    for (size_t i = 0; i < intervals.size(); ++i) {
+      const d3dapp::TransientInterval& a = intervals[i];
+      unaliased += a.size;
+      ASSERT_EQ(0u, a.offset % a.alignment);
+      ASSERT_LE(a.offset + a.size, total);
+      bool shares = false;
+      for (size_t j = 0; j < intervals.size(); ++j) {
+        if (i == j || !SharesMemory(a, intervals[j])) {
+          continue;
+        }
+        shares = true;
+        ASSERT_FALSE(LiveTogether(a, intervals[j]))
+            << "round " << round << ": " << i << " and " << j;
+      }
+      EXPECT_EQ(shares, a.aliased);
+      if (d3dapp::kNoInterval != a.alias_before) {
+        const d3dapp::TransientInterval& before = intervals[a.alias_before];
+        EXPECT_LT(before.last, a.first);
+        EXPECT_TRUE(SharesMemory(a, before));
+      }
+    }
+    EXPECT_LE(total, unaliased + uint64_t{65536} * intervals.size());
+  }
+}
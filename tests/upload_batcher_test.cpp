@@ -0,0 +1,242 @@
+#include "upload_batcher.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "chunked_lz.h"
+#include "fake_upload.h"
+
+namespace {
+constexpr UINT64 kPageSize = 64 * 1024;
+
+D3D12_RESOURCE_DESC Texture2D(UINT width, UINT height, UINT16 mip_levels,
+                              DXGI_FORMAT format) {
+  D3D12_RESOURCE_DESC desc{};
+  desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+  desc.Width = width;
+  desc.Height = height;
+  desc.DepthOrArraySize = 1;
+  desc.MipLevels = mip_levels;
+  desc.Format = format;
+  desc.SampleDesc.Count = 1;
+  return desc;
+}
+
+ID3D12Resource* FakeResource(int id) {
+  return reinterpret_cast<ID3D12Resource*>(static_cast<uintptr_t>(id));
+}
+
+// Pages that cannot be created.
+class NoPages : public d3dapp::UploadRing::Pages {
+ public:
+  bool Create(UINT64, d3dapp::UploadAllocation*) override {
+    return false;
+  }
+  void Destroy(const d3dapp::UploadAllocation&) override {}
+};
+
+class UploadBatcherTest : public ::testing::Test {
+ protected:
+  UploadBatcherTest()
+      : footprint_cache_{nullptr},
+        upload_ring_{std::unique_ptr<d3dapp::UploadRing::Pages>{
+                         new d3dapp::testing::MemoryPages},
+                     kPageSize},
+        batcher_{&footprint_cache_, &upload_ring_} {}
+
+  d3dapp::FootprintCache footprint_cache_;
+  d3dapp::UploadRing upload_ring_;
+  d3dapp::UploadBatcher batcher_;
+  d3dapp::testing::RecordedCopies recorded_;
+};
+
+using Copy = d3dapp::testing::RecordedCopies::Copy;
+
+}  // namespace
+
+TEST_F(UploadBatcherTest, ConsecutiveBufferRangesBecomeOneCopy) {
+  std::vector<uint8_t> data(96);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+  batcher_.AddBuffer(FakeResource(1), 0, data.data(), 64);
+  batcher_.AddBuffer(FakeResource(1), 64, data.data() + 64, 32);
+  batcher_.AddBuffer(FakeResource(2), 0, data.data(), 16);
+  EXPECT_EQ(2u, batcher_.copy_count());
+  EXPECT_EQ(112u, batcher_.staged_size());
+
+  batcher_.Flush(&recorded_);
+  ASSERT_EQ(2u, recorded_.copies.size());
+  const Copy& copy = recorded_.copies[0];
+  EXPECT_TRUE(copy.buffer);
+  EXPECT_EQ(FakeResource(1), copy.dest);
+  EXPECT_EQ(0u, copy.dest_offset);
+  EXPECT_EQ(96u, copy.size);
+  EXPECT_EQ(0, std::memcmp(data.data(),
+                           d3dapp::testing::RecordedCopies::SourceData(copy),
+                           96));
+  EXPECT_EQ(FakeResource(2), recorded_.copies[1].dest);
+  EXPECT_EQ(16u, recorded_.copies[1].size);
+
+  // Flush starts the next batch.
+  EXPECT_EQ(0u, batcher_.copy_count());
+  EXPECT_EQ(0u, batcher_.staged_size());
+}
+
+TEST_F(UploadBatcherTest, TextureRowsLandAtTheFootprintPitch) {
+  const UINT width = 10;
+  const UINT height = 6;
+  D3D12_RESOURCE_DESC desc =
+      Texture2D(width, height, 2, DXGI_FORMAT_R8G8B8A8_UNORM);
+  std::vector<uint8_t> mip0(width * 4 * height);
+  std::vector<uint8_t> mip1(width / 2 * 4 * height / 2);
+  for (size_t i = 0; i < mip0.size(); ++i) {
+    mip0[i] = static_cast<uint8_t>(i * 7);
+  }
+  for (size_t i = 0; i < mip1.size(); ++i) {
+    mip1[i] = static_cast<uint8_t>(i * 3 + 1);
+  }
+  D3D12_SUBRESOURCE_DATA data[2]{
+      {mip0.data(), width * 4, static_cast<LONG_PTR>(mip0.size())},
+      {mip1.data(), width / 2 * 4, static_cast<LONG_PTR>(mip1.size())}};
+  batcher_.AddTexture(FakeResource(1), desc, 0, 2, data);
+  batcher_.Flush(&recorded_);
+
+  ASSERT_EQ(2u, recorded_.copies.size());
+  const std::vector<uint8_t>* mips[2]{&mip0, &mip1};
+  for (UINT mip = 0; mip < 2; ++mip) {
+    const Copy& copy = recorded_.copies[mip];
+    EXPECT_FALSE(copy.buffer);
+    EXPECT_EQ(mip, copy.subresource);
+    EXPECT_EQ(0u,
+              copy.footprint.Offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    EXPECT_EQ(256u, copy.footprint.Footprint.RowPitch);
+    EXPECT_EQ(width >> mip, copy.footprint.Footprint.Width);
+    EXPECT_EQ(height >> mip, copy.footprint.Footprint.Height);
+    const BYTE* staged = d3dapp::testing::RecordedCopies::SourceData(copy);
+    const size_t row_size = (width >> mip) * 4;
+    for (UINT row = 0; row < height >> mip; ++row) {
+      EXPECT_EQ(0, std::memcmp(mips[mip]->data() + row * row_size,
+                               staged + row * 256, row_size))
+          << "mip " << mip << " row " << row;
+    }
+  }
+}
+
+TEST_F(UploadBatcherTest, ConvertsTexelsWhileStaging) {
+  D3D12_RESOURCE_DESC desc = Texture2D(4, 2, 1, DXGI_FORMAT_R8G8B8A8_UNORM);
+  std::vector<uint8_t> rgb(4 * 3 * 2);
+  for (size_t i = 0; i < rgb.size(); ++i) {
+    rgb[i] = static_cast<uint8_t>(i + 1);
+  }
+  D3D12_SUBRESOURCE_DATA data{rgb.data(), 4 * 3,
+                              static_cast<LONG_PTR>(rgb.size())};
+  d3dapp::TexelConversion conversion{d3dapp::TexelConversion::kRgb8ToRgba8};
+  batcher_.AddTexture(FakeResource(1), desc, 0, 1, &data, &conversion);
+  batcher_.Flush(&recorded_);
+
+  ASSERT_EQ(1u, recorded_.copies.size());
+  const BYTE* staged =
+      d3dapp::testing::RecordedCopies::SourceData(recorded_.copies[0]);
+  for (int row = 0; row < 2; ++row) {
+    for (int x = 0; x < 4; ++x) {
+      const BYTE* texel = staged + row * 256 + x * 4;
+      const uint8_t* source = rgb.data() + row * 12 + x * 3;
+      EXPECT_EQ(source[0], texel[0]);
+      EXPECT_EQ(source[1], texel[1]);
+      EXPECT_EQ(source[2], texel[2]);
+      EXPECT_EQ(255, texel[3]);
+    }
+  }
+}
+
+TEST_F(UploadBatcherTest, CompressesOnlyBlockFormats) {
+  std::vector<uint8_t> rgba(8 * 8 * 4, 0x80);
+  D3D12_SUBRESOURCE_DATA data{rgba.data(), 8 * 4,
+                              static_cast<LONG_PTR>(rgba.size())};
+  EXPECT_FALSE(batcher_.AddCompressedTexture(
+      FakeResource(1), Texture2D(8, 8, 1, DXGI_FORMAT_R8G8B8A8_UNORM), 0, 1,
+      &data, d3dapp::BlockCompression::kFast));
+  EXPECT_EQ(0u, batcher_.copy_count());
+
+  ASSERT_TRUE(batcher_.AddCompressedTexture(
+      FakeResource(1), Texture2D(8, 8, 1, DXGI_FORMAT_BC1_UNORM), 0, 1, &data,
+      d3dapp::BlockCompression::kFast));
+  batcher_.Flush(&recorded_);
+  ASSERT_EQ(1u, recorded_.copies.size());
+  EXPECT_EQ(8u, recorded_.copies[0].footprint.Footprint.Height);
+  EXPECT_EQ(256u, recorded_.copies[0].footprint.Footprint.RowPitch);
+}
+
+TEST_F(UploadBatcherTest, ZeroMipLevelsMeansAFullChain) {
+  std::vector<uint8_t> rgba(16 * 16 * 4, 0x80);
+  D3D12_SUBRESOURCE_DATA data[5];
+  for (UINT mip = 0; mip < 5; ++mip) {
+    data[mip] = {rgba.data(), static_cast<LONG_PTR>((16 >> mip) * 4),
+                 static_cast<LONG_PTR>(rgba.size())};
+  }
+  ASSERT_TRUE(batcher_.AddCompressedTexture(
+      FakeResource(1), Texture2D(16, 16, 0, DXGI_FORMAT_BC1_UNORM), 0, 5,
+      data, d3dapp::BlockCompression::kFast));
+  batcher_.Flush(&recorded_);
+  ASSERT_EQ(5u, recorded_.copies.size());
+  for (UINT mip = 0; mip < 5; ++mip) {
+    EXPECT_EQ(mip, recorded_.copies[mip].subresource);
+  }
+  EXPECT_EQ(4u, recorded_.copies[4].footprint.Footprint.Height);
+}
+
+TEST_F(UploadBatcherTest, ChunkedBufferRoundTrips) {
+  std::vector<uint8_t> source(200 * 1024);
+  for (size_t i = 0; i < source.size(); ++i) {
+    source[i] = static_cast<uint8_t>(i / 64);
+  }
+  std::vector<uint8_t> compressed;
+  d3dapp::CompressChunked(source.data(), source.size(), 0, &compressed);
+  ASSERT_TRUE(batcher_.AddChunkedBuffer(FakeResource(1), 256,
+                                        compressed.data(), compressed.size()));
+  batcher_.Flush(&recorded_);
+
+  ASSERT_EQ(1u, recorded_.copies.size());
+  const Copy& copy = recorded_.copies[0];
+  EXPECT_EQ(256u, copy.dest_offset);
+  ASSERT_EQ(source.size(), copy.size);
+  EXPECT_EQ(0, std::memcmp(source.data(),
+                           d3dapp::testing::RecordedCopies::SourceData(copy),
+                           source.size()));
+}
+
+TEST_F(UploadBatcherTest, RejectsChunkedTexturesOfTheWrongSize) {
+  std::vector<uint8_t> source(1000);
+  std::vector<uint8_t> compressed;
+  d3dapp::CompressChunked(source.data(), source.size(), 0, &compressed);
+  EXPECT_FALSE(batcher_.AddChunkedTexture(
+      FakeResource(1), Texture2D(16, 16, 1, DXGI_FORMAT_R8G8B8A8_UNORM), 0, 1,
+      compressed.data(), compressed.size()));
+  EXPECT_FALSE(batcher_.AddChunkedBuffer(FakeResource(1), 0, source.data(),
+                                         source.size()));
+  EXPECT_EQ(0u, batcher_.copy_count());
+}
+
+TEST(UploadBatcherNoPagesTest, StagesNothingWithoutUploadMemory) {
+  d3dapp::FootprintCache footprint_cache{nullptr};
+  d3dapp::UploadRing upload_ring{
+      std::unique_ptr<d3dapp::UploadRing::Pages>{new NoPages}, kPageSize};
+  d3dapp::UploadBatcher batcher{&footprint_cache, &upload_ring};
+  std::vector<uint8_t> source(1024);
+  batcher.AddBuffer(FakeResource(1), 0, source.data(), source.size());
+  D3D12_SUBRESOURCE_DATA data{source.data(), 64, 1024};
+  batcher.AddTexture(FakeResource(1),
+                     Texture2D(16, 16, 1, DXGI_FORMAT_R8G8B8A8_UNORM), 0, 1,
+                     &data);
+  std::vector<uint8_t> compressed;
+  d3dapp::CompressChunked(source.data(), source.size(), 0, &compressed);
+  EXPECT_FALSE(batcher.AddChunkedBuffer(FakeResource(1), 0, compressed.data(),
+                                        compressed.size()));
+  EXPECT_EQ(0u, batcher.copy_count());
+  EXPECT_EQ(0u, batcher.staged_size());
+}
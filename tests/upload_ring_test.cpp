@@ -0,0 +1,122 @@
+#include "upload_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+// Pages in plain memory, with fake GPU addresses to check offsets against.
+class MemoryPages : public d3dapp::UploadRing::Pages {
+ public:
+  struct Counts {
+    int created{0};
+    int destroyed{0};
+    // Create fails once this many pages exist, if nonzero.
+    int limit{0};
+  };
+
+  explicit MemoryPages(Counts* counts) : counts_{counts} {}
+
+  bool Create(UINT64 size, d3dapp::UploadAllocation* page) override {
+    if (counts_->limit && counts_->created - counts_->destroyed ==
+                              counts_->limit) {
+      return false;
+    }
+    BYTE* memory = new BYTE[size];
+    page->resource = nullptr;
+    page->offset = 0;
+    page->cpu_address = memory;
+    page->gpu_address = 0x100000ull * ++counts_->created;
+    return true;
+  }
+
+  void Destroy(const d3dapp::UploadAllocation& page) override {
+    delete[] page.cpu_address;
+    ++counts_->destroyed;
+  }
+
+ private:
+  Counts* counts_;
+};
+
+std::unique_ptr<d3dapp::UploadRing::Pages> MakePages(
+    MemoryPages::Counts* counts) {
+  return std::unique_ptr<d3dapp::UploadRing::Pages>{new MemoryPages{counts}};
+}
+
+}  // namespace
+
+TEST(UploadRingTest, BumpsAlignedAllocationsWithinAPage) {
+  MemoryPages::Counts counts;
+  d3dapp::UploadRing ring{MakePages(&counts), 4096};
+  d3dapp::UploadAllocation a = ring.Allocate(100);
+  d3dapp::UploadAllocation b = ring.Allocate(100);
+  d3dapp::UploadAllocation c = ring.Allocate(10, 512);
+  EXPECT_EQ(0u, a.offset);
+  EXPECT_EQ(256u, b.offset);
+  EXPECT_EQ(512u, c.offset);
+  EXPECT_EQ(a.cpu_address + 256, b.cpu_address);
+  EXPECT_EQ(a.gpu_address + 512, c.gpu_address);
+  EXPECT_EQ(1u, ring.page_count());
+}
+
+TEST(UploadRingTest, RecyclesPagesOnceTheFencePasses) {
+  MemoryPages::Counts counts;
+  d3dapp::UploadRing ring{MakePages(&counts), 1024};
+  for (uint64_t frame = 1; frame <= 3; ++frame) {
+    ring.Allocate(1024);
+    ring.Allocate(1024);
+    ring.EndFrame(frame);
+  }
+  EXPECT_EQ(6, counts.created);
+
+  // Frames 1 and 2 are done; the next two frames run out of their pages.
+  ring.Reclaim(2);
+  for (uint64_t frame = 4; frame <= 5; ++frame) {
+    ring.Allocate(1024);
+    ring.Allocate(1024);
+    ring.EndFrame(frame);
+  }
+  EXPECT_EQ(6, counts.created);
+  EXPECT_EQ(6u, ring.page_count());
+  EXPECT_EQ(0, counts.destroyed);
+}
+
+TEST(UploadRingTest, LargeAllocationsGetTheirOwnPage) {
+  MemoryPages::Counts counts;
+  {
+    d3dapp::UploadRing ring{MakePages(&counts), 1024};
+    d3dapp::UploadAllocation small = ring.Allocate(16);
+    d3dapp::UploadAllocation large = ring.Allocate(5000);
+    EXPECT_EQ(0u, large.offset);
+    EXPECT_NE(small.gpu_address, large.gpu_address);
+    EXPECT_EQ(2u, ring.page_count());
+
+    // The small page keeps taking allocations.
+    EXPECT_EQ(256u, ring.Allocate(16).offset);
+    ring.EndFrame(1);
+    ring.Reclaim(0);
+    EXPECT_EQ(0, counts.destroyed);
+    ring.Reclaim(1);
+    EXPECT_EQ(1, counts.destroyed);
+    EXPECT_EQ(1u, ring.page_count());
+  }
+  EXPECT_EQ(counts.created, counts.destroyed);
+}
+
+TEST(UploadRingTest, ReportsPagesThatCannotBeCreated) {
+  MemoryPages::Counts counts;
+  counts.limit = 1;
+  d3dapp::UploadRing ring{MakePages(&counts), 1024};
+  EXPECT_NE(nullptr, ring.Allocate(1024).cpu_address);
+  EXPECT_EQ(nullptr, ring.Allocate(1024).cpu_address);
+  EXPECT_EQ(nullptr, ring.Allocate(4096).cpu_address);
+  EXPECT_EQ(1u, ring.page_count());
+
+  // Once the page comes back it is reused.
+  ring.EndFrame(1);
+  ring.Reclaim(1);
+  EXPECT_NE(nullptr, ring.Allocate(1024).cpu_address);
+}
@@ -0,0 +1,196 @@
+#include "virtual_texture_table.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace {
+using d3dapp::TileMapping;
+using d3dapp::VirtualTextureTable;
+using d3dapp::kNoTile;
+
+// 4x4, 2x2 and 1x1 pages.
+const std::vector<d3dapp::VirtualMipLevel> kMips = {{4, 4}, {2, 2}, {1, 1}};
+
+struct Page {
+  uint32_t mip;
+  uint32_t x;
+  uint32_t y;
+  bool mapped;
+};
+
+bool operator==(const Page& a, const Page& b) {
+  return a.mip == b.mip && a.x == b.x && a.y == b.y && a.mapped == b.mapped;
+}
+
+std::ostream& operator<<(std::ostream& out, const Page& page) {
+  return out << (page.mapped ? "map " : "unmap ") << page.mip << " ("
+             << page.x << ", " << page.y << ")";
+}
+
+std::vector<Page> Pages(const std::vector<TileMapping>& mappings) {
+  std::vector<Page> pages;
+  for (const TileMapping& mapping : mappings) {
+    pages.push_back({mapping.page.mip, mapping.page.x, mapping.page.y,
+                     mapping.tile != kNoTile});
+  }
+  return pages;
+}
+
+}  // namespace
+
+// A fine page drags in the pages covering it, and the coarsest is mapped
+// first so there is always something to fall back to.
+TEST(VirtualTextureTableTest, MapsCoarseMipsFirst) {
+  VirtualTextureTable table{kMips, 16};
+  table.Request(0, 3, 3, 1);
+  EXPECT_EQ(3u, table.stats().pending_count);
+
+  std::vector<TileMapping> mappings;
+  table.Update(0, 16, mappings);
+  EXPECT_EQ((std::vector<Page>{{2, 0, 0, true}, {1, 1, 1, true},
+                               {0, 3, 3, true}}),
+            Pages(mappings));
+  EXPECT_EQ(0u, table.tile(2, 0, 0));
+  EXPECT_EQ(1u, table.tile(1, 1, 1));
+  EXPECT_EQ(2u, table.tile(0, 3, 3));
+  EXPECT_EQ(kNoTile, table.tile(0, 0, 0));
+  EXPECT_EQ(3u, table.stats().resident_count);
+  EXPECT_EQ(0u, table.stats().pending_count);
+}
+
+TEST(VirtualTextureTableTest, LimitsMappingsPerUpdate) {
+  VirtualTextureTable table{kMips, 16};
+  table.Request(0, 0, 0, 1);
+
+  std::vector<TileMapping> mappings;
+  table.Update(0, 2, mappings);
+  EXPECT_EQ((std::vector<Page>{{2, 0, 0, true}, {1, 0, 0, true}}),
+            Pages(mappings));
+  EXPECT_EQ(1u, table.stats().pending_count);
+  // Running short of the budget is not starvation.
+  EXPECT_EQ(0u, table.stats().starved_count);
+
+  mappings.clear();
+  table.Update(0, 2, mappings);
+  EXPECT_EQ((std::vector<Page>{{0, 0, 0, true}}), Pages(mappings));
+  EXPECT_EQ(0u, table.stats().pending_count);
+}
+
+TEST(VirtualTextureTableTest, DecodesFeedback) {
+  VirtualTextureTable table{kMips, 16};
+  const uint32_t feedback[] = {
+      d3dapp::kNoFeedback,
+      VirtualTextureTable::PackFeedback(1, 1, 0),
+      d3dapp::kNoFeedback,
+      VirtualTextureTable::PackFeedback(0, 2, 3),
+      // Out of range pages are dropped.
+      VirtualTextureTable::PackFeedback(0, 4, 0),
+      VirtualTextureTable::PackFeedback(3, 0, 0),
+  };
+  table.ProcessFeedback(feedback, sizeof(feedback) / sizeof(feedback[0]), 1);
+
+  std::vector<TileMapping> mappings;
+  table.Update(0, 16, mappings);
+  EXPECT_EQ((std::vector<Page>{{2, 0, 0, true}, {1, 1, 1, true},
+                               {1, 1, 0, true}, {0, 2, 3, true}}),
+            Pages(mappings));
+}
+
+// Feedback written this frame may name pages the GPU is still sampling
+// from earlier frames, so their tiles are only reused once the fence of
+// their last request has completed.
+TEST(VirtualTextureTableTest, EvictsOnlyPagesTheGpuIsDoneWith) {
+  VirtualTextureTable table{kMips, 3};
+  std::vector<TileMapping> mappings;
+  table.Request(0, 0, 0, 1);
+  table.Update(0, 16, mappings);
+  ASSERT_EQ(3u, mappings.size());
+
+  table.Request(0, 3, 3, 2);
+  mappings.clear();
+  table.Update(0, 16, mappings);
+  EXPECT_TRUE(mappings.empty());
+  EXPECT_EQ(2u, table.stats().pending_count);
+
+  // The least recently used page goes first; the shared mip 2 page was
+  // requested again and stays.
+  mappings.clear();
+  table.Update(1, 16, mappings);
+  EXPECT_EQ((std::vector<Page>{{0, 0, 0, false}, {1, 1, 1, true},
+                               {1, 0, 0, false}, {0, 3, 3, true}}),
+            Pages(mappings));
+  EXPECT_EQ(kNoTile, table.tile(0, 0, 0));
+  EXPECT_EQ(kNoTile, table.tile(1, 0, 0));
+  EXPECT_NE(kNoTile, table.tile(2, 0, 0));
+  EXPECT_EQ(2u, table.stats().evicted_total);
+  EXPECT_EQ(5u, table.stats().mapped_total);
+}
+
+TEST(VirtualTextureTableTest, CountsStarvedUpdates) {
+  VirtualTextureTable table{kMips, 2};
+  std::vector<TileMapping> mappings;
+  table.Request(0, 1, 1, 1);
+  table.Update(0, 16, mappings);
+  EXPECT_EQ(2u, mappings.size());
+  EXPECT_EQ(1u, table.stats().pending_count);
+  EXPECT_EQ(1u, table.stats().starved_count);
+
+  // Every tile is still in flight.
+  mappings.clear();
+  table.Update(0, 16, mappings);
+  EXPECT_TRUE(mappings.empty());
+  EXPECT_EQ(2u, table.stats().starved_count);
+}
+
+TEST(VirtualTextureTableTest, TracksTheFinestResidentMip) {
+  VirtualTextureTable table{kMips, 16};
+  EXPECT_EQ(std::vector<uint8_t>(16, 3), table.min_mip_map());
+  EXPECT_TRUE(table.min_mip_dirty());
+  table.ClearMinMipDirty();
+
+  std::vector<TileMapping> mappings;
+  table.Request(0, 1, 0, 1);
+  table.Update(0, 2, mappings);
+  EXPECT_TRUE(table.min_mip_dirty());
+  // Mip 1 (0, 0) covers the top left 2x2 texels.
+  EXPECT_EQ((std::vector<uint8_t>{1, 1, 2, 2,
+                                  1, 1, 2, 2,
+                                  2, 2, 2, 2,
+                                  2, 2, 2, 2}),
+            table.min_mip_map());
+  table.ClearMinMipDirty();
+
+  mappings.clear();
+  table.Update(0, 2, mappings);
+  EXPECT_TRUE(table.min_mip_dirty());
+  EXPECT_EQ((std::vector<uint8_t>{1, 0, 2, 2,
+                                  1, 1, 2, 2,
+                                  2, 2, 2, 2,
+                                  2, 2, 2, 2}),
+            table.min_mip_map());
+  table.ClearMinMipDirty();
+
+  mappings.clear();
+  table.Update(1, 2, mappings);
+  EXPECT_TRUE(mappings.empty());
+  EXPECT_FALSE(table.min_mip_dirty());
+}
+
+// Texels of evicted pages fall back to the finest mip still resident.
+TEST(VirtualTextureTableTest, EvictionRaisesTheMinMip) {
+  VirtualTextureTable table{kMips, 3};
+  std::vector<TileMapping> mappings;
+  table.Request(0, 0, 0, 1);
+  table.Update(0, 16, mappings);
+  EXPECT_EQ(0u, table.min_mip_map()[0]);
+
+  table.Request(0, 3, 3, 2);
+  table.Update(1, 16, mappings);
+  EXPECT_EQ(2u, table.min_mip_map()[0]);
+  EXPECT_EQ(2u, table.min_mip_map()[5]);
+  EXPECT_EQ(0u, table.min_mip_map()[15]);
+  EXPECT_EQ(1u, table.min_mip_map()[10]);
+}